@@ -30,14 +30,30 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/stream_executor_no_cuda.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/stream_executor_util.h"
 
 namespace gpu = perftools::gputools;
 
 namespace tensorflow {
 
+namespace {
+
+auto* fallback_count = monitoring::Counter<0>::New(
+    "/tensorflow/xla/launch_op/fallback_count",
+    "The number of _XlaLaunch executions that ran the TensorFlow function "
+    "while its XLA executable was being compiled.");
+
+auto* fallback_time_usecs = monitoring::Counter<0>::New(
+    "/tensorflow/xla/launch_op/fallback_time_usecs",
+    "The total time in microseconds spent running the TensorFlow function "
+    "of an _XlaLaunch op while its XLA executable was being compiled.");
+
+}  // namespace
+
 // Adapter class that wraps a Tensorflow allocator as an XLA allocator.
 // Assumes that the Tensorflow allocator permits asynchronous deallocation:
 // see comment on `AllowsAsynchronousDeallocation()`.
@@ -135,7 +151,7 @@ Status XlaAllocator::MakeTensorFromBuffer(gpu::DeviceMemoryBase buffer,
 }
 
 XlaLocalLaunchOp::XlaLocalLaunchOp(OpKernelConstruction* ctx)
-    : OpKernel(ctx), device_type_(ctx->device_type()) {
+    : AsyncOpKernel(ctx), device_type_(ctx->device_type()) {
   const NameAttrList* func;
   OP_REQUIRES_OK(ctx, ctx->GetAttr("function", &func));
   function_ = *func;
@@ -148,6 +164,8 @@ XlaLocalLaunchOp::XlaLocalLaunchOp(OpKernelConstruction* ctx)
   OP_REQUIRES(ctx, num_resource_args == 0,
               errors::Unimplemented(
                   "XlaLocalLaunchOp does not support resource variables"));
+  OP_REQUIRES_OK(ctx, ReadBoolFromEnvVar("TF_XLA_ASYNC_COMPILATION", false,
+                                         &async_compilation_));
   if (device_type_ == DeviceType(DEVICE_CPU)) {
     platform_id_ = gpu::host::kHostPlatformId;
   } else if (device_type_ == DeviceType(DEVICE_GPU)) {
@@ -186,23 +204,22 @@ Status XlaLocalLaunchOp::BuildCompilationCache(OpKernelContext* ctx,
   return Status::OK();
 }
 
-void XlaLocalLaunchOp::Compute(OpKernelContext* ctx) {
+void XlaLocalLaunchOp::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
   VLOG(1) << "XlaLocalLaunchOp::Compute "
           << Canonicalize(function_.name(), AttrSlice(&function_.attr()));
   // We store information about the JIT-compiled XLA computation
   // in the ResourceMgr.
   ResourceMgr* rm = ctx->resource_manager();
-  OP_REQUIRES(ctx, rm, errors::Internal("No resource manager."));
-
-  gpu::Stream* stream =
-      ctx->op_device_context() ? ctx->op_device_context()->stream() : nullptr;
+  OP_REQUIRES_ASYNC(ctx, rm, errors::Internal("No resource manager."), done);
 
   XlaCompilationCache* cache;
-  OP_REQUIRES_OK(ctx, rm->LookupOrCreate<XlaCompilationCache>(
-                          rm->default_container(), "xla_cache", &cache,
-                          [this, ctx](XlaCompilationCache** cache) {
-                            return BuildCompilationCache(ctx, cache);
-                          }));
+  OP_REQUIRES_OK_ASYNC(ctx,
+                       rm->LookupOrCreate<XlaCompilationCache>(
+                           rm->default_container(), "xla_cache", &cache,
+                           [this, ctx](XlaCompilationCache** cache) {
+                             return BuildCompilationCache(ctx, cache);
+                           }),
+                       done);
   // Hold the reference to the JIT during evaluation. (We could probably
   // free it sooner because the ResourceMgr will retain a reference, but
   // this is more obviously correct.)
@@ -220,8 +237,80 @@ void XlaLocalLaunchOp::Compute(OpKernelContext* ctx) {
 
   const XlaCompiler::CompilationResult* kernel;
   xla::LocalExecutable* executable;
-  OP_REQUIRES_OK(ctx, cache->Compile(options, function_, num_constant_args_, {},
-                                     ctx, &kernel, &executable));
+  if (async_compilation_) {
+    OP_REQUIRES_OK_ASYNC(
+        ctx, cache->CompileAsync(options, function_, num_constant_args_, {},
+                                 ctx, &kernel, &executable),
+        done);
+    if (kernel == nullptr) {
+      RunFallback(ctx, std::move(done));
+      return;
+    }
+  } else {
+    OP_REQUIRES_OK_ASYNC(
+        ctx, cache->Compile(options, function_, num_constant_args_, {}, ctx,
+                            &kernel, &executable),
+        done);
+  }
+
+  RunExecutable(ctx, client, kernel, executable);
+  done();
+}
+
+void XlaLocalLaunchOp::RunFallback(OpKernelContext* ctx, DoneCallback done) {
+  VLOG(1) << "Executing TensorFlow function while XLA compiles...";
+  FunctionLibraryRuntime* lib = ctx->function_library();
+  OP_REQUIRES_ASYNC(ctx, lib != nullptr,
+                    errors::Internal("No function library is provided."),
+                    done);
+
+  FunctionLibraryRuntime::Handle handle;
+  OP_REQUIRES_OK_ASYNC(
+      ctx,
+      lib->Instantiate(function_.name(), AttrSlice(&function_.attr()),
+                       &handle),
+      done);
+
+  FunctionLibraryRuntime::Options opts;
+  opts.step_id = ctx->step_id();
+  opts.cancellation_manager = ctx->cancellation_manager();
+  opts.step_container = ctx->step_container();
+  opts.stats_collector = ctx->stats_collector();
+  opts.runner = ctx->runner();
+  std::vector<Tensor> args;
+  args.reserve(ctx->num_inputs());
+  for (int i = 0; i < ctx->num_inputs(); ++i) {
+    args.push_back(ctx->input(i));
+  }
+  std::vector<Tensor>* rets = new std::vector<Tensor>;
+  const uint64 start_time = Env::Default()->NowMicros();
+  lib->Run(opts, handle, args, rets,
+           [ctx, done, rets, start_time](const Status& status) {
+             fallback_count->GetCell()->IncrementBy(1);
+             fallback_time_usecs->GetCell()->IncrementBy(
+                 Env::Default()->NowMicros() - start_time);
+             if (!status.ok()) {
+               ctx->SetStatus(status);
+             } else if (rets->size() != ctx->num_outputs()) {
+               ctx->SetStatus(errors::Internal(
+                   "_XlaLaunch fallback expected ", ctx->num_outputs(),
+                   " results, got ", rets->size()));
+             } else {
+               for (int i = 0; i < rets->size(); ++i) {
+                 ctx->set_output(i, (*rets)[i]);
+               }
+             }
+             delete rets;
+             done();
+           });
+}
+
+void XlaLocalLaunchOp::RunExecutable(
+    OpKernelContext* ctx, xla::LocalClient* client,
+    const XlaCompiler::CompilationResult* kernel,
+    xla::LocalExecutable* executable) {
+  gpu::Stream* stream =
+      ctx->op_device_context() ? ctx->op_device_context()->stream() : nullptr;
 
   VLOG(1) << "Executing XLA Computation...";
 
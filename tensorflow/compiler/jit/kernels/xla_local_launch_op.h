@@ -17,6 +17,8 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_JIT_KERNELS_XLA_LOCAL_LAUNCH_OP_H_
 
 #include "tensorflow/compiler/jit/xla_compilation_cache.h"
+#include "tensorflow/compiler/tf2xla/xla_compiler.h"
+#include "tensorflow/compiler/xla/client/local_client.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -35,21 +37,36 @@ namespace tensorflow {
 // XlaLocalLaunchOp uses xla::LocalClient::Compile() and
 // xla::LocalExecutable::Run(), and passes arguments into/out of XLA in device
 // memory.
-class XlaLocalLaunchOp : public OpKernel {
+//
+// If the TF_XLA_ASYNC_COMPILATION environment variable is true, a new set of
+// input shapes is compiled on a background thread instead of blocking the
+// step, and the op runs the original TensorFlow function until the
+// executable is ready.
+class XlaLocalLaunchOp : public AsyncOpKernel {
  public:
   explicit XlaLocalLaunchOp(OpKernelConstruction* ctx);
   ~XlaLocalLaunchOp() override;
 
-  void Compute(OpKernelContext* ctx) override;
+  void ComputeAsync(OpKernelContext* ctx, DoneCallback done) override;
 
  private:
   // Builds a XlaCompilationCache class suitable for the current device.
   Status BuildCompilationCache(OpKernelContext* ctx,
                                XlaCompilationCache** compiler);
 
+  // Runs the compiled `kernel` and sets the outputs of `ctx`.
+  void RunExecutable(OpKernelContext* ctx, xla::LocalClient* client,
+                     const XlaCompiler::CompilationResult* kernel,
+                     xla::LocalExecutable* executable);
+
+  // Runs `function_` with the TensorFlow executor, while it is being
+  // compiled in the background.
+  void RunFallback(OpKernelContext* ctx, DoneCallback done);
+
   DeviceType device_type_;
   NameAttrList function_;
   int num_constant_args_;
+  bool async_compilation_;
 
   perftools::gputools::Platform::Id platform_id_;
 
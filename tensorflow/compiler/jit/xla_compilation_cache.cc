@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/xla_compilation_cache.h"
 
+#include <algorithm>
+#include <memory>
 #include <numeric>
 
 #include "tensorflow/compiler/tf2xla/dump_graph.h"
@@ -30,7 +32,9 @@ limitations under the License.
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/kernels/variable_ops.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/public/version.h"
@@ -206,8 +210,28 @@ Status BuildArguments(int num_constant_args,
   return Status::OK();
 }
 
+// Returns the thread pool on which background compilations run. It is shared
+// by all caches and never destroyed, so that a compilation can outlive the
+// kernel and the session that scheduled it.
+thread::ThreadPool* BackgroundCompilationPool() {
+  static thread::ThreadPool* pool = new thread::ThreadPool(
+      Env::Default(), "xla_compile",
+      std::max(1, port::NumSchedulableCPUs() / 4));
+  return pool;
+}
+
 }  // namespace
 
+XlaCompilationCache::Entry* XlaCompilationCache::LookupOrCreateEntry(
+    const Signature& signature) {
+  mutex_lock lock(mu_);
+  std::unique_ptr<Entry>& e = cache_[signature];
+  if (!e) {
+    e.reset(new Entry);
+  }
+  return e.get();
+}
+
 Status XlaCompilationCache::Compile(
     const XlaCompiler::Options& options, const NameAttrList& function,
     int num_constant_args, const std::vector<OptionalTensor>& variable_args,
@@ -246,16 +270,7 @@ Status XlaCompilationCache::Compile(
   VLOG(2) << "Signature: " << SignatureDebugString(signature);
   // The outer lock protects the existence of the cache entry. It does not
   // protect the contents of the cache entry.
-  Entry* entry;
-  {
-    mutex_lock lock(mu_);
-    // Find or create a cache entry.
-    std::unique_ptr<Entry>& e = cache_[signature];
-    if (!e) {
-      e.reset(new Entry);
-    }
-    entry = e.get();
-  }
+  Entry* entry = LookupOrCreateEntry(signature);
 
   // Acquire the cache entry lock and compile, if necessary.
   // TODO(phawkins): this locking will need to be restructured when we implement
@@ -289,4 +304,90 @@ Status XlaCompilationCache::Compile(
   return status;
 }
 
+Status XlaCompilationCache::CompileAsync(
+    const XlaCompiler::Options& options, const NameAttrList& function,
+    int num_constant_args, const std::vector<OptionalTensor>& variable_args,
+    OpKernelContext* ctx,
+    const XlaCompiler::CompilationResult** compilation_result,
+    xla::LocalExecutable** executable) {
+  TF_RET_CHECK(options.populate_resource_manager == nullptr);
+  TF_RET_CHECK(num_constant_args + variable_args.size() <= ctx->num_inputs());
+
+  Signature signature;
+  TF_RETURN_IF_ERROR(BuildSignature(function, num_constant_args, variable_args,
+                                    ctx, &signature));
+  Entry* entry = LookupOrCreateEntry(signature);
+
+  *compilation_result = nullptr;
+  *executable = nullptr;
+  {
+    mutex_lock entry_lock(entry->mu);
+    if (entry->compiled) {
+      // The background compilation also built the executable, if any.
+      *compilation_result = &entry->compilation_result;
+      *executable = entry->executable.get();
+      return entry->compilation_status;
+    }
+    if (entry->compiling) {
+      return Status::OK();
+    }
+    entry->compiling = true;
+  }
+
+  VLOG(1) << "Scheduling background compilation of "
+          << SignatureDebugString(signature);
+  std::vector<XlaCompiler::Argument> args;
+  Status status = BuildArguments(num_constant_args, variable_args, ctx, &args);
+  if (!status.ok()) {
+    mutex_lock entry_lock(entry->mu);
+    entry->compiling = false;
+    return status;
+  }
+  // The caller's function library may be modified or destroyed as soon as
+  // this returns, so the compilation runs against a copy made now and owned
+  // by the closure.
+  auto flib_def =
+      std::make_shared<FunctionLibraryDefinition>(*options.flib_def);
+  XlaCompiler::Options background_options = options;
+  background_options.flib_def = flib_def.get();
+  // The entry is owned by this cache, which is kept alive until the
+  // compilation has finished.
+  Ref();
+  BackgroundCompilationPool()->Schedule(
+      [this, background_options, flib_def, function, args, entry]() {
+        CompileInBackground(background_options, function, args, entry);
+        Unref();
+      });
+  return Status::OK();
+}
+
+void XlaCompilationCache::CompileInBackground(
+    XlaCompiler::Options options, const NameAttrList& function,
+    std::vector<XlaCompiler::Argument> args, Entry* entry) {
+  // Compile without holding the entry lock, so that callers can keep
+  // checking on the entry and fall back in the meantime.
+  XlaCompiler compiler(options);
+  XlaCompiler::CompilationResult compilation_result;
+  std::unique_ptr<xla::LocalExecutable> executable;
+  Status status = compiler.CompileFunction(XlaCompiler::CompileOptions(),
+                                           function, args, &compilation_result);
+  if (status.ok() && !compilation_result.computation->IsNull()) {
+    status = compiler.BuildExecutable(compilation_result, &executable);
+  }
+  VLOG(1) << "Background compilation of " << function.name()
+          << " finished: " << status;
+
+  mutex_lock entry_lock(entry->mu);
+  entry->compiling = false;
+  if (entry->compiled) {
+    // A synchronous Compile() got there first, and its callers may still be
+    // reading the results.
+    return;
+  }
+  entry->compiled = true;
+  entry->compilation_status = status;
+  entry->compilation_result = std::move(compilation_result);
+  entry->executable = std::move(executable);
+}
+
 }  // namespace tensorflow
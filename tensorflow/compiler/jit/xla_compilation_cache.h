@@ -44,6 +44,10 @@ struct OptionalTensor {
 //
 // Currently no cache eviction policy is implemented and the cache grows without
 // bound.
+//
+// The cache lives for the duration of the process. On CPU, the generated
+// object code can also be persisted across processes by setting
+// --xla_cpu_object_cache_dir in XLA_FLAGS.
 class XlaCompilationCache : public ResourceBase {
  public:
   XlaCompilationCache(xla::Client* client, DeviceType device_type);
@@ -68,6 +72,22 @@ class XlaCompilationCache : public ResourceBase {
                  const XlaCompiler::CompilationResult** compilation_result,
                  xla::LocalExecutable** executable);
 
+  // Like Compile(), but does not block the caller on the compilation of a
+  // new signature. The first call for a signature schedules the compilation
+  // and the building of the executable on a background thread pool; it, and
+  // any call made while that compilation is in flight, returns OK with
+  // `*compilation_result` and `*executable` set to null. The caller is then
+  // expected to run `function` some other way, e.g. with the TensorFlow
+  // executor. Once the compilation has finished, behaves like Compile().
+  // `options.flib_def` is copied before returning, so it only needs to outlive
+  // the call; `options.populate_resource_manager` must be null.
+  Status CompileAsync(const XlaCompiler::Options& options,
+                      const NameAttrList& function, int num_constant_args,
+                      const std::vector<OptionalTensor>& variable_args,
+                      OpKernelContext* ctx,
+                      const XlaCompiler::CompilationResult** compilation_result,
+                      xla::LocalExecutable** executable);
+
   xla::Client* client() const { return client_; }
   const DeviceType& device_type() const { return device_type_; }
 
@@ -106,7 +126,10 @@ class XlaCompilationCache : public ResourceBase {
     mutex mu;
 
     // Have we tried compiling this entry?
-    bool compiled = false;
+    bool compiled GUARDED_BY(mu) = false;
+
+    // Is a background compilation of this entry in flight?
+    bool compiling GUARDED_BY(mu) = false;
 
     // Did compilation succeed?
     Status compilation_status GUARDED_BY(mu);
@@ -119,6 +142,17 @@ class XlaCompilationCache : public ResourceBase {
     std::unique_ptr<xla::LocalExecutable> executable GUARDED_BY(mu);
   };
 
+  // Returns the cache entry for `signature`, creating it if necessary.
+  Entry* LookupOrCreateEntry(const Signature& signature);
+
+  // Compiles `function` and builds its executable, on a background thread,
+  // then publishes the results in `entry` unless a synchronous Compile() has
+  // done so first. `options.flib_def` must be owned by the caller's closure.
+  void CompileInBackground(XlaCompiler::Options options,
+                           const NameAttrList& function,
+                           std::vector<XlaCompiler::Argument> args,
+                           Entry* entry);
+
   mutex mu_;
   std::unordered_map<Signature, std::unique_ptr<Entry>, Signature::Hash> cache_
       GUARDED_BY(mu_);
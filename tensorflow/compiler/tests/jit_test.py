@@ -18,6 +18,9 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import os
+import time
+
 import numpy as np
 
 from tensorflow.contrib.compiler import jit
@@ -271,6 +274,42 @@ class JitLaunchTest(test.TestCase):
         expected = np.square(np.dot(dx, dw) + db)
         self.assertAllClose(expected, output, rtol=1e-1)
 
+  def testAsyncCompilation(self):
+    """Runs the TensorFlow function until the background compilation ends."""
+    os.environ["TF_XLA_ASYNC_COMPILATION"] = "true"
+    try:
+      with session_lib.Session() as sess:
+        x = array_ops.placeholder(dtypes.float32, [4, 8])
+        w = array_ops.placeholder(dtypes.float32, [8, 2])
+        y = CompiledKernel(
+            lambda x, w: math_ops.tanh(math_ops.matmul(x, w)), x, w)
+        dx = np.random.random_sample((4, 8)).astype(np.float32)
+        dw = np.random.random_sample((8, 2)).astype(np.float32)
+        expected = np.tanh(np.dot(dx, dw))
+
+        # The first run starts the compilation and runs the function with the
+        # TensorFlow executor, whose nodes then show up in the step stats.
+        # Later runs switch to the executable once it is ready.
+        fell_back = False
+        deadline = time.time() + 60
+        while True:
+          run_metadata = config_pb2.RunMetadata()
+          output = sess.run(y, {x: dx, w: dw},
+                            run_metadata=run_metadata,
+                            options=config_pb2.RunOptions(
+                                trace_level=config_pb2.RunOptions.FULL_TRACE))
+          self.assertAllClose(expected, output, rtol=1e-3)
+          labels = RunMetadataLabels(run_metadata)
+          self.assertTrue(InLabels(labels, "_XlaLaunch"))
+          if not InLabels(labels, "MatMul"):
+            break
+          fell_back = True
+          self.assertLess(time.time(), deadline)
+          time.sleep(0.1)
+        self.assertTrue(fell_back)
+    finally:
+      del os.environ["TF_XLA_ASYNC_COMPILATION"]
+
 
 class XlaCompilationTest(test.TestCase):
   """Tests for auto-compilation on CPU/GPU devices."""
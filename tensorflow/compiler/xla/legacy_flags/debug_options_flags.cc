@@ -44,6 +44,8 @@ struct DebugOptionsFlags {
   bool xla_eliminate_hlo_implicit_broadcast;
 
   bool xla_cpu_multi_thread_eigen;
+  string xla_cpu_object_cache_dir;
+  bool xla_cpu_tiled_dot;
 
   string xla_gpu_cuda_data_dir;
   bool xla_gpu_ftz;
@@ -82,6 +84,8 @@ void AllocateFlags() {
   flag_values->xla_dump_debug_json_to = "";
   flag_values->xla_eliminate_hlo_implicit_broadcast = false;
   flag_values->xla_cpu_multi_thread_eigen = true;
+  flag_values->xla_cpu_object_cache_dir = "";
+  flag_values->xla_cpu_tiled_dot = true;
   flag_values->xla_gpu_cuda_data_dir = "./cuda_sdk_lib";
   flag_values->xla_gpu_ftz = false;
   flag_values->xla_test_all_output_layouts = false;
@@ -154,6 +158,15 @@ void AllocateFlags() {
                         &flag_values->xla_cpu_multi_thread_eigen,
                         "When generating calls to Eigen in the CPU backend, "
                         "use multi-threaded Eigen mode."),
+       tensorflow::Flag("xla_cpu_object_cache_dir",
+                        &flag_values->xla_cpu_object_cache_dir,
+                        "If non-empty, the CPU backend caches compiled object "
+                        "code in this directory and reuses it across "
+                        "processes."),
+       tensorflow::Flag("xla_cpu_tiled_dot", &flag_values->xla_cpu_tiled_dot,
+                        "In the CPU backend, emit small and skinny matrix "
+                        "products as tiled, vectorized loops instead of calls "
+                        "to Eigen."),
        tensorflow::Flag("xla_gpu_cuda_data_dir",
                         &flag_values->xla_gpu_cuda_data_dir,
                         "If non-empty, speficies a local directory containing "
@@ -225,6 +238,8 @@ xla::DebugOptions GetDebugOptionsFromFlags() {
 
   options.set_xla_cpu_multi_thread_eigen(
       flag_values->xla_cpu_multi_thread_eigen);
+  options.set_xla_cpu_object_cache_dir(flag_values->xla_cpu_object_cache_dir);
+  options.set_xla_cpu_tiled_dot(flag_values->xla_cpu_tiled_dot);
   options.set_xla_gpu_cuda_data_dir(flag_values->xla_gpu_cuda_data_dir);
   options.set_xla_gpu_ftz(flag_values->xla_gpu_ftz);
   options.set_xla_llvm_enable_alias_scope_metadata(
@@ -54,6 +54,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/cpu/ir_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/layout_assignment.h"
+#include "tensorflow/compiler/xla/service/cpu/object_cache.h"
 #include "tensorflow/compiler/xla/service/cpu/parallel_cpu_executable.h"
 #include "tensorflow/compiler/xla/service/cpu/simple_orc_jit.h"
 #include "tensorflow/compiler/xla/service/dfs_hlo_visitor_with_default.h"
@@ -85,6 +86,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/public/version.h"
 
 namespace se = ::perftools::gputools;
 
@@ -292,8 +294,12 @@ Status CpuCompiler::RunHloPasses(HloModule* module) {
       module->config().intra_op_parallelism_threads() > 0
           ? module->config().intra_op_parallelism_threads()
           : tensorflow::port::NumSchedulableCPUs();
+  // ParallelCpuExecutable groups partitions into tasks based on their
+  // measured cost, and idle threads steal tasks from busy ones, so allow a
+  // few partitions per thread to leave room for load balancing.
+  const int max_parallel_tasks = 4 * max_parallelism;
   if (CpuParallelBackendRequested(module->config())) {
-    pipeline.AddPass<ParallelizationPreparation>(max_parallelism,
+    pipeline.AddPass<ParallelizationPreparation>(max_parallel_tasks,
                                                  ShapeSizeBytesFunction());
   }
   // Copy insertion should be performed immediately before IR emission to avoid
@@ -307,7 +313,7 @@ Status CpuCompiler::RunHloPasses(HloModule* module) {
   if (CpuParallelBackendRequested(module->config())) {
     // Re-run the outlining, in case any copies were inserted into the entry
     // computation.
-    pipeline.AddPass<ParallelizationPreparation>(max_parallelism,
+    pipeline.AddPass<ParallelizationPreparation>(max_parallel_tasks,
                                                  ShapeSizeBytesFunction());
   }
   pipeline.AddPass<HloDCE>();
@@ -398,6 +404,63 @@ Status InitializeIRDumpHooks(
   return Status::OK();
 }
 
+// Returns the key of `llvm_module` in the persistent object cache. The emitted
+// IR already reflects the optimized HLO module, its argument shapes and the
+// flags that affect IR emission; the key adds the target machine and the
+// flags that affect LLVM's code generation.
+string ObjectCacheKey(const HloModuleConfig& module_config,
+                      const SimpleOrcJIT& jit,
+                      const llvm::Module& llvm_module) {
+  const DebugOptions& debug_options = module_config.debug_options();
+  string key = tensorflow::strings::StrCat(
+      "version=", TF_VERSION_STRING, "\ntriple=", jit.target_triple().str(),
+      "\ncpu=", jit.target_machine().getTargetCPU().str(),
+      "\nfeatures=", jit.target_machine().getTargetFeatureString().str(),
+      "\nopt_level=", debug_options.xla_backend_optimization_level(),
+      "\nfast_math=", debug_options.xla_enable_fast_math(), "\n");
+  std::map<string, string> extra_options(
+      debug_options.xla_backend_extra_options().begin(),
+      debug_options.xla_backend_extra_options().end());
+  for (const auto& option : extra_options) {
+    tensorflow::strings::StrAppend(&key, "option=", option.first, "=",
+                                   option.second, "\n");
+  }
+  tensorflow::strings::StrAppend(&key,
+                                 llvm_ir::DumpModuleToString(llvm_module));
+  return key;
+}
+
+// JIT compiles `llvm_module`. If a persistent object cache is configured,
+// loads the object code from the cache when it has an entry for the module,
+// and stores the newly compiled object code otherwise.
+void AddModuleToJit(const HloModuleConfig& module_config,
+                    std::unique_ptr<llvm::Module> llvm_module,
+                    SimpleOrcJIT* jit) {
+  const string& cache_dir =
+      module_config.debug_options().xla_cpu_object_cache_dir();
+  if (cache_dir.empty()) {
+    jit->AddModule(std::move(llvm_module));
+    return;
+  }
+
+  ObjectCache cache(cache_dir);
+  const string key = ObjectCacheKey(module_config, *jit, *llvm_module);
+  string object_code;
+  if (cache.Lookup(key, &object_code)) {
+    if (jit->AddObjectFile(object_code).ok()) {
+      VLOG(1) << "Loaded object code from the persistent object cache";
+      return;
+    }
+    LOG(WARNING) << "Ignoring invalid object code in " << cache_dir;
+  }
+  jit->AddModule(std::move(llvm_module), &object_code);
+  Status status = cache.Insert(key, object_code);
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to write to the XLA object cache in " << cache_dir
+                 << ": " << status;
+  }
+}
+
 }  // namespace
 
 StatusOr<std::unique_ptr<Executable>> CpuCompiler::Compile(
@@ -529,7 +592,7 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::Compile(
     }
 
     // JIT compile the LLVM IR module to in-memory machine code.
-    jit->AddModule(std::move(llvm_module));
+    AddModuleToJit(module->config(), std::move(llvm_module), jit.get());
     cpu_executable.reset(new ParallelCpuExecutable(
         std::move(jit), std::move(assignment), std::move(module),
         std::move(function_names), std::move(hlo_to_profile_idx),
@@ -596,7 +659,7 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::Compile(
     }
 
     // JIT compile the LLVM IR module to in-memory machine code.
-    jit->AddModule(std::move(llvm_module));
+    AddModuleToJit(module->config(), std::move(llvm_module), jit.get());
     cpu_executable.reset(new CpuExecutable(
         std::move(jit), std::move(assignment), std::move(module), function_name,
         std::move(hlo_to_profile_idx)));
@@ -23,6 +23,7 @@ limitations under the License.
 #include "external/llvm/include/llvm/IR/Module.h"
 #include "external/llvm/include/llvm/IR/Value.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime.h"
+#include "tensorflow/compiler/xla/layout_util.h"
 #include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
 #include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_util.h"
@@ -38,6 +39,25 @@ using llvm_ir::SetToFirstInsertPoint;
 
 namespace cpu {
 
+namespace {
+
+// The tiled GEMM keeps a tile of kTileRows x kTileVectors vectors of the
+// output in registers. With 32-byte vectors a tile uses 8 of the 16 AVX
+// registers, which leaves room for the rhs vectors and the lhs broadcast.
+constexpr int64 kTileRows = 4;
+constexpr int64 kTileVectors = 2;
+constexpr int64 kVectorSizeInBytes = 32;
+
+// Dots with at most this many multiply-adds are emitted inline.
+constexpr int64 kMaxTiledGemmFlops = 64 * 64 * 64;
+
+// Dots with at most kMaxSkinnyGemmRows output rows are emitted inline up to
+// this many multiply-adds; the runtime cannot block such shapes well.
+constexpr int64 kMaxSkinnyGemmRows = 16;
+constexpr int64 kMaxSkinnyGemmFlops = int64{1} << 22;
+
+}  // namespace
+
 DotOpEmitter::DotOpEmitter(const HloInstruction& dot, bool transpose_lhs,
                            bool transpose_rhs,
                            const llvm_ir::IrArray& target_array,
@@ -106,6 +126,9 @@ tensorflow::Status DotOpEmitter::Emit() {
   }
 
   if (PotentiallyImplementedAsEigenDot(dot_)) {
+    if (ShouldEmitTiledGemm()) {
+      return EmitTiledGemm();
+    }
     return EmitCallToRuntime();
   }
 
@@ -315,6 +338,222 @@ tensorflow::Status DotOpEmitter::EmitCallToRuntime() {
   return tensorflow::Status::OK();
 }
 
+bool DotOpEmitter::ShouldEmitTiledGemm() const {
+  if (!hlo_module_config_.debug_options().xla_cpu_tiled_dot()) {
+    return false;
+  }
+  // The tiled loops read whole rows of the rhs and write whole rows of the
+  // output as vectors, so both must be row major. The lhs is only read one
+  // element at a time and may have either layout.
+  const Shape& lhs_shape = lhs_array_.GetShape();
+  const Shape& rhs_shape = rhs_array_.GetShape();
+  const Shape& target_shape = target_array_.GetShape();
+  if (transpose_rhs_ || ShapeUtil::Rank(lhs_shape) != 2 ||
+      ShapeUtil::Rank(rhs_shape) != 2 || ShapeUtil::Rank(target_shape) != 2 ||
+      !LayoutUtil::IsMonotonicWithDim0Major(rhs_shape.layout()) ||
+      !LayoutUtil::IsMonotonicWithDim0Major(target_shape.layout())) {
+    return false;
+  }
+  const int64 m = target_shape.dimensions(0);
+  const int64 n = target_shape.dimensions(1);
+  const int64 k = lhs_shape.dimensions(transpose_lhs_ ? 0 : 1);
+  const int64 flops = m * n * k;
+  return flops <= kMaxTiledGemmFlops ||
+         (m <= kMaxSkinnyGemmRows && flops <= kMaxSkinnyGemmFlops);
+}
+
+llvm::Value* DotOpEmitter::EmitReadLhsElement(llvm::Value* row,
+                                              llvm::Value* col) {
+  llvm_ir::IrArray::Index index(2);
+  index[transpose_lhs_ ? 1 : 0] = row;
+  index[transpose_lhs_ ? 0 : 1] = col;
+  return lhs_array_.EmitReadArrayElement(index, ir_builder_);
+}
+
+tensorflow::Status DotOpEmitter::EmitTiledGemm() {
+  const Shape& target_shape = target_array_.GetShape();
+  const int64 m = target_shape.dimensions(0);
+  const int64 n = target_shape.dimensions(1);
+  const int64 k = lhs_array_.GetShape().dimensions(transpose_lhs_ ? 0 : 1);
+  TF_RET_CHECK(k == rhs_array_.GetShape().dimensions(0));
+
+  const int64 vector_width =
+      kVectorSizeInBytes /
+      ShapeUtil::ByteSizeOfPrimitiveType(target_shape.element_type());
+  const int64 tile_cols = kTileVectors * vector_width;
+  const int64 tiled_rows = m - m % kTileRows;
+  const int64 tiled_cols = n - n % tile_cols;
+
+  if (tiled_rows > 0 && tiled_cols > 0) {
+    EmitVectorTiles(tiled_rows, tiled_cols, k, vector_width);
+  }
+  // The columns to the right of the tiles, then the rows below them.
+  EmitScalarGemm(0, tiled_rows, tiled_cols, n, k);
+  EmitScalarGemm(tiled_rows, m, 0, n, k);
+  return tensorflow::Status::OK();
+}
+
+void DotOpEmitter::EmitVectorTiles(int64 tiled_rows, int64 tiled_cols,
+                                   int64 k, int64 vector_width) {
+  const int64 n = target_array_.GetShape().dimensions(1);
+  llvm::Type* element_type = target_array_.GetElementLlvmType();
+  llvm::Type* vector_type = llvm::VectorType::get(element_type, vector_width);
+  llvm::Type* element_ptr_type = element_type->getPointerTo();
+  llvm::Type* vector_ptr_type = vector_type->getPointerTo();
+  // The buffers are only guaranteed to be aligned to the element size.
+  const unsigned alignment = ShapeUtil::ByteSizeOfPrimitiveType(
+      target_array_.GetShape().element_type());
+
+  // Function entry basic block.
+  // - Emit one alloca per vector of the tile. LLVM promotes them to
+  //   registers.
+  std::vector<llvm::Value*> accumulators;
+  {
+    llvm::IRBuilder<>::InsertPointGuard guard(*ir_builder_);
+    llvm::Function* func = ir_builder_->GetInsertBlock()->getParent();
+    SetToFirstInsertPoint(&func->getEntryBlock(), ir_builder_);
+    for (int64 i = 0; i < kTileRows * kTileVectors; ++i) {
+      accumulators.push_back(ir_builder_->CreateAlloca(
+          vector_type, /*ArraySize=*/nullptr, "tile_accum_address"));
+    }
+  }
+
+  llvm::Value* rhs_base = ir_builder_->CreateBitCast(
+      rhs_array_.GetBasePointer(), element_ptr_type);
+  llvm::Value* target_base = ir_builder_->CreateBitCast(
+      target_array_.GetBasePointer(), element_ptr_type);
+  // Returns a pointer to the vector starting at 'offset' elements past
+  // 'base'.
+  auto vector_address = [&](llvm::Value* base, llvm::Value* offset) {
+    return ir_builder_->CreateBitCast(
+        ir_builder_->CreateInBoundsGEP(base, offset), vector_ptr_type);
+  };
+
+  std::unique_ptr<llvm_ir::ForLoop> row_loop = llvm_ir::ForLoop::EmitForLoop(
+      "tile_row", ir_builder_->getInt64(0), ir_builder_->getInt64(tiled_rows),
+      ir_builder_->getInt64(kTileRows), ir_builder_);
+  SetToFirstInsertPoint(row_loop->GetBodyBasicBlock(), ir_builder_);
+  std::unique_ptr<llvm_ir::ForLoop> col_loop = llvm_ir::ForLoop::EmitForLoop(
+      "tile_col", ir_builder_->getInt64(0), ir_builder_->getInt64(tiled_cols),
+      ir_builder_->getInt64(kTileVectors * vector_width), ir_builder_);
+  SetToFirstInsertPoint(col_loop->GetBodyBasicBlock(), ir_builder_);
+  llvm::Value* row = row_loop->GetIndVarValue();
+  llvm::Value* col = col_loop->GetIndVarValue();
+
+  // Preheader of the reduction loop:
+  // - Initialize the tile to zero.
+  llvm::Value* zero = llvm::ConstantFP::get(vector_type, 0.0);
+  for (llvm::Value* accum_address : accumulators) {
+    ir_builder_->CreateStore(zero, accum_address);
+  }
+
+  // Body of the reduction loop over 'p':
+  // - Load kTileVectors vectors from row 'p' of the rhs.
+  // - For each row of the tile, broadcast the lhs element in column 'p' and
+  //   multiply-add it into the accumulators.
+  std::unique_ptr<llvm_ir::ForLoop> reduction_loop =
+      llvm_ir::ForLoop::EmitForLoop(
+          "tile_reduction", ir_builder_->getInt64(0), ir_builder_->getInt64(k),
+          ir_builder_->getInt64(1), ir_builder_);
+  SetToFirstInsertPoint(reduction_loop->GetBodyBasicBlock(), ir_builder_);
+  llvm::Value* p = reduction_loop->GetIndVarValue();
+
+  llvm::Value* rhs_row_offset = ir_builder_->CreateAdd(
+      ir_builder_->CreateMul(p, ir_builder_->getInt64(n)), col);
+  std::vector<llvm::Value*> rhs_vectors;
+  for (int64 v = 0; v < kTileVectors; ++v) {
+    llvm::Value* offset = ir_builder_->CreateAdd(
+        rhs_row_offset, ir_builder_->getInt64(v * vector_width));
+    llvm::LoadInst* load = ir_builder_->CreateAlignedLoad(
+        vector_address(rhs_base, offset), alignment, "rhs_vector");
+    rhs_array_.AnnotateLoadStoreInstructionWithMetadata(load);
+    rhs_vectors.push_back(load);
+  }
+  for (int64 r = 0; r < kTileRows; ++r) {
+    llvm::Value* lhs_element = EmitReadLhsElement(
+        ir_builder_->CreateAdd(row, ir_builder_->getInt64(r)), p);
+    llvm::Value* lhs_splat =
+        ir_builder_->CreateVectorSplat(vector_width, lhs_element);
+    for (int64 v = 0; v < kTileVectors; ++v) {
+      llvm::Value* accum_address = accumulators[r * kTileVectors + v];
+      llvm::Value* product = ir_builder_->CreateFMul(lhs_splat, rhs_vectors[v]);
+      llvm::Value* accum = ir_builder_->CreateLoad(accum_address);
+      ir_builder_->CreateStore(ir_builder_->CreateFAdd(accum, product),
+                               accum_address);
+    }
+  }
+
+  // Exit of the reduction loop:
+  // - Store the tile into the output.
+  SetToFirstInsertPoint(reduction_loop->GetExitBasicBlock(), ir_builder_);
+  for (int64 r = 0; r < kTileRows; ++r) {
+    llvm::Value* target_row_offset = ir_builder_->CreateAdd(
+        ir_builder_->CreateMul(
+            ir_builder_->CreateAdd(row, ir_builder_->getInt64(r)),
+            ir_builder_->getInt64(n)),
+        col);
+    for (int64 v = 0; v < kTileVectors; ++v) {
+      llvm::Value* offset = ir_builder_->CreateAdd(
+          target_row_offset, ir_builder_->getInt64(v * vector_width));
+      llvm::StoreInst* store = ir_builder_->CreateAlignedStore(
+          ir_builder_->CreateLoad(accumulators[r * kTileVectors + v]),
+          vector_address(target_base, offset), alignment);
+      target_array_.AnnotateLoadStoreInstructionWithMetadata(store);
+    }
+  }
+
+  ir_builder_->SetInsertPoint(row_loop->GetExitBasicBlock());
+}
+
+void DotOpEmitter::EmitScalarGemm(int64 row_begin, int64 row_end,
+                                  int64 col_begin, int64 col_end, int64 k) {
+  if (row_begin >= row_end || col_begin >= col_end) {
+    return;
+  }
+
+  llvm::Type* accum_type = target_array_.GetElementLlvmType();
+  llvm::Value* accum_address;
+  {
+    llvm::IRBuilder<>::InsertPointGuard guard(*ir_builder_);
+    llvm::Function* func = ir_builder_->GetInsertBlock()->getParent();
+    SetToFirstInsertPoint(&func->getEntryBlock(), ir_builder_);
+    accum_address = ir_builder_->CreateAlloca(
+        accum_type, /*ArraySize=*/nullptr, "accum_address");
+  }
+
+  llvm_ir::ForLoopNest loop_nest(ir_builder_);
+  std::unique_ptr<llvm_ir::ForLoop> row_loop =
+      loop_nest.AddLoop(row_begin, row_end, "scalar_row");
+  std::unique_ptr<llvm_ir::ForLoop> col_loop =
+      loop_nest.AddLoop(col_begin, col_end, "scalar_col");
+  std::unique_ptr<llvm_ir::ForLoop> reduction_loop =
+      loop_nest.AddLoop(0, k, "scalar_reduction");
+  llvm::Value* row = row_loop->GetIndVarValue();
+  llvm::Value* col = col_loop->GetIndVarValue();
+  llvm::Value* p = reduction_loop->GetIndVarValue();
+
+  ir_builder_->SetInsertPoint(
+      reduction_loop->GetPreheaderBasicBlock()->getTerminator());
+  ir_builder_->CreateStore(llvm::ConstantFP::get(accum_type, 0.0),
+                           accum_address);
+
+  SetToFirstInsertPoint(reduction_loop->GetBodyBasicBlock(), ir_builder_);
+  llvm::Value* lhs_element = EmitReadLhsElement(row, p);
+  llvm::Value* rhs_element = rhs_array_.EmitReadArrayElement(
+      llvm_ir::IrArray::Index({p, col}), ir_builder_);
+  llvm::Value* product = ir_builder_->CreateFMul(lhs_element, rhs_element);
+  llvm::Value* accum = ir_builder_->CreateLoad(accum_address);
+  ir_builder_->CreateStore(ir_builder_->CreateFAdd(accum, product),
+                           accum_address);
+
+  SetToFirstInsertPoint(reduction_loop->GetExitBasicBlock(), ir_builder_);
+  target_array_.EmitWriteArrayElement(llvm_ir::IrArray::Index({row, col}),
+                                      ir_builder_->CreateLoad(accum_address),
+                                      ir_builder_);
+
+  ir_builder_->SetInsertPoint(loop_nest.GetOuterLoopExitBasicBlock());
+}
+
 llvm_ir::IrArray::Index DotOpEmitter::EmitOperandArrayLoopNest(
     llvm_ir::ForLoopNest* loop_nest, const llvm_ir::IrArray& operand_array,
     int64 reduction_dimension, tensorflow::StringPiece name_suffix) {
@@ -62,6 +62,33 @@ class DotOpEmitter {
   // Emits a call to the CPU runtime to perform the matrix multiply.
   tensorflow::Status EmitCallToRuntime();
 
+  // Returns true if the matrix multiply is small or skinny enough that
+  // emitting it inline with EmitTiledGemm is cheaper than calling into the
+  // runtime, and the operand layouts allow it.
+  bool ShouldEmitTiledGemm() const;
+
+  // Emits the matrix multiply as a loop nest over tiles of the output. Each
+  // tile of kTileRows rows by kTileVectors vectors is accumulated in vector
+  // registers while the reduction loop streams rows of the rhs. Rows and
+  // columns of the output that do not fill a whole tile are computed by
+  // EmitScalarGemm.
+  tensorflow::Status EmitTiledGemm();
+
+  // Emits the tiled part of EmitTiledGemm: output rows [0, tiled_rows) and
+  // columns [0, tiled_cols), where both bounds are multiples of the tile size.
+  void EmitVectorTiles(int64 tiled_rows, int64 tiled_cols, int64 k,
+                       int64 vector_width);
+
+  // Emits scalar loops computing the output elements in rows
+  // [row_begin, row_end) and columns [col_begin, col_end) of the matrix
+  // multiply. Emits nothing if either range is empty.
+  void EmitScalarGemm(int64 row_begin, int64 row_end, int64 col_begin,
+                      int64 col_end, int64 k);
+
+  // Returns the lhs element at row 'row' and column 'col' of the lhs matrix as
+  // it is used by the multiply, i.e. after applying transpose_lhs_.
+  llvm::Value* EmitReadLhsElement(llvm::Value* row, llvm::Value* col);
+
   // Emits a series of nested loops for iterating over an operand array in the
   // dot operation. Loops are constructed in major to minor dimension layout
   // order. No loop is emitted for the given reduction_dimension. The function
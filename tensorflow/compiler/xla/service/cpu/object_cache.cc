@@ -0,0 +1,112 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/object_cache.h"
+
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+auto* object_cache_hits = tensorflow::monitoring::Counter<0>::New(
+    "/tensorflow/xla/cpu/object_cache/hits",
+    "The number of CPU compilations whose object code was loaded from the "
+    "persistent object cache.");
+
+auto* object_cache_misses = tensorflow::monitoring::Counter<0>::New(
+    "/tensorflow/xla/cpu/object_cache/misses",
+    "The number of CPU compilations whose object code was not found in the "
+    "persistent object cache.");
+
+// Each entry is the magic string, the fingerprint of the object code and the
+// object code itself.
+constexpr char kMagic[] = "XLAOBJ01";
+constexpr size_t kMagicSize = sizeof(kMagic) - 1;
+constexpr size_t kEntryHeaderSize = kMagicSize + sizeof(uint64);
+
+}  // namespace
+
+ObjectCache::ObjectCache(const string& directory) : directory_(directory) {}
+
+string ObjectCache::FileName(const string& key) const {
+  const tensorflow::Fprint128 fingerprint = tensorflow::Fingerprint128(key);
+  return tensorflow::io::JoinPath(
+      directory_,
+      tensorflow::strings::Printf("%016llx%016llx.o",
+                                  static_cast<unsigned long long>(
+                                      fingerprint.high64),
+                                  static_cast<unsigned long long>(
+                                      fingerprint.low64)));
+}
+
+bool ObjectCache::Lookup(const string& key, string* object_code) const {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  const string file_name = FileName(key);
+  string contents;
+  if (!env->FileExists(file_name).ok() ||
+      !tensorflow::ReadFileToString(env, file_name, &contents).ok()) {
+    object_cache_misses->GetCell()->IncrementBy(1);
+    return false;
+  }
+  if (contents.size() < kEntryHeaderSize ||
+      contents.compare(0, kMagicSize, kMagic) != 0 ||
+      tensorflow::core::DecodeFixed64(contents.data() + kMagicSize) !=
+          tensorflow::Fingerprint64(contents.substr(kEntryHeaderSize))) {
+    LOG(WARNING) << "Ignoring corrupted XLA object cache entry " << file_name;
+    object_cache_misses->GetCell()->IncrementBy(1);
+    return false;
+  }
+  object_code->assign(contents, kEntryHeaderSize, string::npos);
+  object_cache_hits->GetCell()->IncrementBy(1);
+  return true;
+}
+
+tensorflow::Status ObjectCache::Insert(const string& key,
+                                       const string& object_code) const {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  if (!env->IsDirectory(directory_).ok()) {
+    TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(directory_));
+  }
+  string contents(kMagic, kMagicSize);
+  tensorflow::core::PutFixed64(&contents,
+                               tensorflow::Fingerprint64(object_code));
+  contents.append(object_code);
+
+  // Write to a file of our own and rename it, so that concurrent writers and
+  // readers never see a partially written entry.
+  const string file_name = FileName(key);
+  const string tmp_file_name = tensorflow::strings::Printf(
+      "%s.tmp%016llx", file_name.c_str(),
+      static_cast<unsigned long long>(tensorflow::random::New64()));
+  TF_RETURN_IF_ERROR(
+      tensorflow::WriteStringToFile(env, tmp_file_name, contents));
+  tensorflow::Status status = env->RenameFile(tmp_file_name, file_name);
+  if (!status.ok()) {
+    env->DeleteFile(tmp_file_name).IgnoreError();
+  }
+  return status;
+}
+
+}  // namespace cpu
+}  // namespace xla
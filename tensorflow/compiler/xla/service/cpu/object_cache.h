@@ -0,0 +1,63 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_CPU_OBJECT_CACHE_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_OBJECT_CACHE_H_
+
+#include <string>
+
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace xla {
+namespace cpu {
+
+// A persistent cache of the object code generated by the CPU backend, so that
+// a process can reuse the code compiled by an earlier one instead of running
+// LLVM again.
+//
+// Entries are stored as files in a directory, named by a fingerprint of their
+// key. The key must describe everything that the object code depends on.
+// Entries are written to a temporary file and then renamed, so several
+// processes may share a directory.
+//
+// Lookups are counted in the /tensorflow/xla/cpu/object_cache/{hits,misses}
+// monitoring counters.
+class ObjectCache {
+ public:
+  explicit ObjectCache(const string& directory);
+
+  // Looks up the object code stored for `key`. Returns false if there is none,
+  // or if the stored entry is corrupted.
+  bool Lookup(const string& key, string* object_code) const;
+
+  // Stores `object_code` for `key`, replacing any existing entry.
+  tensorflow::Status Insert(const string& key,
+                            const string& object_code) const;
+
+ private:
+  // Returns the name of the file that holds the entry for `key`.
+  string FileName(const string& key) const;
+
+  const string directory_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ObjectCache);
+};
+
+}  // namespace cpu
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_CPU_OBJECT_CACHE_H_
@@ -0,0 +1,180 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/object_cache.h"
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/compiler/xla/legacy_flags/debug_options_flags.h"
+#include "tensorflow/compiler/xla/literal_util.h"
+#include "tensorflow/compiler/xla/ptr_util.h"
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_module_config.h"
+#include "tensorflow/compiler/xla/service/versioned_computation_handle.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+#include "tensorflow/compiler/xla/tests/literal_test_util.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace xla {
+namespace cpu {
+namespace {
+
+string CacheDir(const string& name) {
+  return tensorflow::io::JoinPath(tensorflow::testing::TmpDir(), name);
+}
+
+TEST(ObjectCacheTest, InsertAndLookup) {
+  ObjectCache cache(CacheDir("insert_and_lookup"));
+  string object_code;
+  EXPECT_FALSE(cache.Lookup("key", &object_code));
+
+  const string code("object\0code", 11);
+  TF_ASSERT_OK(cache.Insert("key", code));
+  ASSERT_TRUE(cache.Lookup("key", &object_code));
+  EXPECT_EQ(code, object_code);
+  EXPECT_FALSE(cache.Lookup("other key", &object_code));
+
+  // Entries are visible to other instances, as they would be to other
+  // processes.
+  ObjectCache other_cache(CacheDir("insert_and_lookup"));
+  ASSERT_TRUE(other_cache.Lookup("key", &object_code));
+  EXPECT_EQ(code, object_code);
+
+  TF_ASSERT_OK(cache.Insert("key", "new code"));
+  ASSERT_TRUE(cache.Lookup("key", &object_code));
+  EXPECT_EQ("new code", object_code);
+}
+
+TEST(ObjectCacheTest, CorruptedEntryIsIgnored) {
+  const string dir = CacheDir("corrupted_entry");
+  ObjectCache cache(dir);
+  TF_ASSERT_OK(cache.Insert("key", "object code"));
+
+  tensorflow::Env* env = tensorflow::Env::Default();
+  std::vector<string> children;
+  TF_ASSERT_OK(env->GetChildren(dir, &children));
+  ASSERT_EQ(1, children.size());
+  const string file_name = tensorflow::io::JoinPath(dir, children[0]);
+  string contents;
+  TF_ASSERT_OK(tensorflow::ReadFileToString(env, file_name, &contents));
+  contents.back() ^= 1;
+  TF_ASSERT_OK(tensorflow::WriteStringToFile(env, file_name, contents));
+
+  string object_code;
+  EXPECT_FALSE(cache.Lookup("key", &object_code));
+}
+
+// Returns the number of persistent object cache hits so far.
+int64 ObjectCacheHits() {
+  const auto metrics =
+      tensorflow::monitoring::CollectionRegistry::Default()->CollectMetrics(
+          {});
+  const auto it =
+      metrics->point_set_map.find("/tensorflow/xla/cpu/object_cache/hits");
+  if (it == metrics->point_set_map.end() || it->second->points.empty()) {
+    return 0;
+  }
+  return it->second->points[0]->int64_value;
+}
+
+// Returns the path of the only entry in the object cache in `dir`.
+string EntryFileName(const string& dir) {
+  std::vector<string> children;
+  TF_CHECK_OK(tensorflow::Env::Default()->GetChildren(dir, &children));
+  CHECK_EQ(1, children.size());
+  return tensorflow::io::JoinPath(dir, children[0]);
+}
+
+class ObjectCacheCompileTest : public HloTestBase {
+ protected:
+  // Compiles and runs a module that adds two constant vectors, with the
+  // object cache in `dir`, and checks the result. Every compilation creates a
+  // fresh SimpleOrcJIT, into which the object code is loaded with
+  // AddObjectFile on a cache hit.
+  void CompileAndRun(const string& dir) {
+    auto builder = HloComputation::Builder(TestName());
+    auto lhs = builder.AddInstruction(HloInstruction::CreateConstant(
+        Literal::CreateR1<float>({1.f, 2.f, 3.f})));
+    auto rhs = builder.AddInstruction(HloInstruction::CreateConstant(
+        Literal::CreateR1<float>({10.f, 20.f, 30.f})));
+    builder.AddInstruction(
+        HloInstruction::CreateBinary(lhs->shape(), HloOpcode::kAdd, lhs, rhs));
+
+    DebugOptions debug_options = legacy_flags::GetDebugOptionsFromFlags();
+    debug_options.add_xla_disable_hlo_passes("constant_folding");
+    debug_options.set_xla_cpu_object_cache_dir(dir);
+    HloModuleConfig config;
+    config.set_debug_options(debug_options);
+    auto module = MakeUnique<HloModule>(TestName(),
+                                        VersionedComputationHandle(), config);
+    module->AddEntryComputation(builder.Build());
+
+    LiteralTestUtil::ExpectEqual(
+        *Literal::CreateR1<float>({11.f, 22.f, 33.f}),
+        *ExecuteAndTransfer(std::move(module), {}));
+  }
+};
+
+TEST_F(ObjectCacheCompileTest, CompiledObjectCodeRoundTrips) {
+  const string dir = CacheDir("compile_round_trip");
+  CompileAndRun(dir);
+  const string file_name = EntryFileName(dir);
+
+  // The second compilation runs the object code stored by the first one.
+  const int64 hits = ObjectCacheHits();
+  CompileAndRun(dir);
+  EXPECT_EQ(hits + 1, ObjectCacheHits());
+  EXPECT_EQ(file_name, EntryFileName(dir));
+}
+
+TEST_F(ObjectCacheCompileTest, InvalidEntriesFallBackToCompiling) {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  const string dir = CacheDir("compile_fallback");
+  CompileAndRun(dir);
+  const string file_name = EntryFileName(dir);
+  string contents;
+  TF_ASSERT_OK(tensorflow::ReadFileToString(env, file_name, &contents));
+
+  string corrupted = contents;
+  corrupted.back() ^= 1;
+  // An entry that passes the checksum, but whose object code is not an object
+  // file.
+  const string scratch_dir = CacheDir("compile_fallback_scratch");
+  TF_ASSERT_OK(ObjectCache(scratch_dir).Insert("key", "not an object file"));
+  string not_an_object;
+  TF_ASSERT_OK(tensorflow::ReadFileToString(env, EntryFileName(scratch_dir),
+                                            &not_an_object));
+
+  for (const string& invalid_entry :
+       {contents.substr(0, contents.size() / 2), corrupted, not_an_object}) {
+    TF_ASSERT_OK(tensorflow::WriteStringToFile(env, file_name, invalid_entry));
+    // Compiles the module again, and replaces the invalid entry.
+    CompileAndRun(dir);
+    const int64 hits = ObjectCacheHits();
+    CompileAndRun(dir);
+    EXPECT_EQ(hits + 1, ObjectCacheHits());
+  }
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
@@ -17,7 +17,7 @@ limitations under the License.
 
 #include <stdint.h>
 #include <algorithm>
-#include <deque>
+#include <atomic>
 #include <iterator>
 #include <list>
 #include <unordered_set>
@@ -47,6 +47,7 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace se = ::perftools::gputools;
@@ -67,7 +68,18 @@ ParallelCpuExecutable::ParallelCpuExecutable(
       assignment_(std::move(assignment)),
       functions_names_(std::move(function_names)),
       hlo_to_profile_idx_(std::move(hlo_to_profile_idx)),
-      aligned_constants_(std::move(aligned_constants)) {}
+      aligned_constants_(std::move(aligned_constants)) {
+  for (const auto& instruction : module().entry_computation()->instructions()) {
+    if (instruction->opcode() == HloOpcode::kCall &&
+        !instruction->to_apply()
+             ->root_instruction()
+             ->outer_dimension_partitions()
+             .empty()) {
+      // Value-initialized to 0, i.e. not measured yet.
+      partition_costs_[instruction.get()];
+    }
+  }
+}
 
 // Type of the computation function we expect in the JIT.
 using ComputeFunctionType = void (*)(void*, const void*, const void**, void**,
@@ -98,15 +110,29 @@ static void MarkLiveAddressesInOutput(
 
 namespace {
 
+// Tasks that do less work than this, in nanoseconds, are grouped with
+// neighbouring partitions of the same instruction once the cost of the
+// instruction has been measured.
+constexpr uint64 kMinTaskNanos = 50000;
+
 // Executor manages the concurrent execution of 'functions' for instructions
-// in 'pending' on 'thread_pool' (storing resulting data in 'results').
+// in 'pending' on 'thread_pool'.
+//
+// Each pending instruction counts its unfinished operands. The worker that
+// finishes the last operand of an instruction runs that instruction itself,
+// and schedules any other instructions that became ready on the thread pool.
+// The pool queues work scheduled by a worker on that worker's own queue, and
+// idle workers steal from the queues of busy ones, so the calling thread only
+// waits for the whole computation to finish.
 class Executor {
  public:
   Executor(const std::map<HloInstruction*, ComputeFunctionType>& functions,
            const ServiceExecutableRunOptions* run_options,
-           std::list<HloInstruction*>* pending,
-           std::map<HloInstruction*, const void*>* results, void** temps_array,
-           uint64* profile_counters_array, BufferAssignment* assignment)
+           const std::list<HloInstruction*>& pending,
+           const std::map<HloInstruction*, const void*>& results,
+           void** temps_array, uint64* profile_counters_array,
+           BufferAssignment* assignment,
+           ParallelCpuExecutable::PartitionCostMap* partition_costs)
       : functions_(functions),
         run_options_(run_options),
         pending_(pending),
@@ -114,187 +140,277 @@ class Executor {
         temps_array_(temps_array),
         profile_counters_array_(profile_counters_array),
         thread_pool_(CHECK_NOTNULL(run_options_->xla_intra_op_thread_pool())),
-        assignment_(assignment) {}
+        assignment_(assignment),
+        partition_costs_(partition_costs) {}
 
   // Executes pending list of instructions on thread pool.
   // Returns OK status on success, error status otherwise.
   Status Run();
 
  private:
-  // Schedules a parallel invocation of compute function for 'instruction' on
-  // 'thread_pool_', storing result in 'result_buffer'.
-  // If 'partition_buffers' is non-null, parallel task will be invoked on
-  // per-dimension partition [start, limit) values stored in
-  // 'partition_buffers'.
-  void Schedule(HloInstruction* instruction, int64* partition_buffers,
-                void* result_buffer);
+  // The execution state of a pending instruction.
+  struct Node {
+    HloInstruction* instruction = nullptr;
+    ComputeFunctionType function = nullptr;
+    void* result_buffer = nullptr;
+    std::vector<const void*> operand_buffers;
+
+    // The pending instructions that use the result of this instruction.
+    std::vector<Node*> users;
+
+    // The number of pending operands of this instruction that have not
+    // finished yet.
+    std::atomic<int64> pending_operands{0};
+
+    // For an instruction with parallel tasks: the number of partitions, and
+    // the [start, limit) of each partitioned dimension for each partition.
+    int64 partition_count = 0;
+    int64 partition_dimensions = 0;
+    std::vector<int64> partition_buffers;
+
+    // For an instruction with parallel tasks: the smoothed cost of one
+    // partition in previous executions, in nanoseconds, or 0 if it has not
+    // been measured yet. Owned by the executable.
+    std::atomic<uint64>* partition_cost_nanos = nullptr;
+
+    // The number of tasks of this instruction that have not finished yet,
+    // and the time taken by the finished ones.
+    std::atomic<int64> pending_tasks{0};
+    std::atomic<uint64> elapsed_micros{0};
+  };
+
+  // Runs the partitions [partition_begin, partition_end) of 'node'. Nodes
+  // without parallel tasks have a single task.
+  struct Task {
+    Node* node;
+    int64 partition_begin;
+    int64 partition_end;
+  };
+
+  // Builds 'nodes_' from 'pending_'.
+  Status BuildNodes();
+
+  // Appends the tasks of the ready 'node' to 'tasks'. Partitions are
+  // grouped so that each task does at least kMinTaskNanos of work, based on
+  // the cost measured in previous executions.
+  void AppendTasks(Node* node, std::vector<Task>* tasks);
+
+  // Schedules 'task' on 'thread_pool_'.
+  void Schedule(const Task& task);
+
+  // Runs 'task' and, if it finished its instruction, any instructions that
+  // became ready as a result.
+  void Execute(Task task);
 
   // Returns true if 'instruction' has been assigned parallel tasks (returns
   // false otherwise).
   bool HasParallelTasks(HloInstruction* instruction);
 
-  // Returns in 'partition_buffers' the partition [size, limit) for each
-  // dimension.
-  int64* GetPartitionBuffers(
-      const std::vector<std::pair<int64, int64>>& partition);
-
-  // Returns array of result buffers for all operands in 'instruction'.
-  const void** GetOperandBuffers(HloInstruction* instruction);
-
   // Arguments passed into Executor.
   const std::map<HloInstruction*, ComputeFunctionType>& functions_;
   const ServiceExecutableRunOptions* run_options_;
-  std::list<HloInstruction*>* pending_;
-  std::map<HloInstruction*, const void*>* results_;
+  const std::list<HloInstruction*>& pending_;
+  const std::map<HloInstruction*, const void*>& results_;
   void** temps_array_;
   uint64* profile_counters_array_;
   tensorflow::thread::ThreadPool* thread_pool_;
   BufferAssignment* assignment_;
+  ParallelCpuExecutable::PartitionCostMap* partition_costs_;
 
   // Members used to manage instruction execution.
-  tensorflow::mutex completion_queue_lock_;
-  tensorflow::condition_variable completion_queue_cv_;
-  std::deque<HloInstruction*> completion_queue_;
-  int64 instructions_in_flight_ = 0;
-  std::unordered_map<const HloInstruction*, int64> tasks_in_flight_;
+  std::vector<std::unique_ptr<Node>> nodes_;
+  std::atomic<int64> instructions_in_flight_{0};
+  tensorflow::Notification done_;
 };
 
 Status Executor::Run() {
-  while (!pending_->empty() || instructions_in_flight_ > 0) {
-    auto pending_it = pending_->begin();
-    while (pending_it != pending_->end()) {
-      HloInstruction* instruction = *pending_it;
-      // Skip pending instructions whose operands aren't ready.
-      if (std::any_of(instruction->operands().begin(),
-                      instruction->operands().end(),
-                      [&](HloInstruction* operand) {
-                        return !ContainsKey(*results_, operand);
-                      })) {
-        ++pending_it;
-        continue;
-      }
-
-      // Get 'result_buffer' reference to result buffer for 'instruction'.
-      TF_ASSIGN_OR_RETURN(const BufferAllocation::Slice result_slice,
-                          assignment_->GetUniqueTopLevelSlice(instruction));
-      void* result_buffer =
-          static_cast<char*>(temps_array_[result_slice.index()]) +
-          result_slice.offset();
-
-      if (HasParallelTasks(instruction)) {
-        // 'instruction' has been assigned parallel task partitions.
-        CHECK_EQ(HloOpcode::kCall, instruction->opcode());
-        HloInstruction* root = instruction->to_apply()->root_instruction();
-
-        // Create ShapePartitionIterator to iterate through all outer dimension
-        // partitions of 'instruction'.
-        ShapePartitionIterator partition_iterator(
-            root->shape(), root->outer_dimension_partitions());
-
-        const int64 partition_count =
-            partition_iterator.GetTotalPartitionCount();
-
-        // Record total parallel task count for 'instruction' before dispatch.
-        {
-          tensorflow::mutex_lock l(completion_queue_lock_);
-          tasks_in_flight_.insert(std::make_pair(instruction, partition_count));
-          VLOG(2) << "Schedule PARALLEL"
-                  << " instruction: " << instruction->name()
-                  << " instruction.callee: "
-                  << instruction->to_apply()->root_instruction()->name()
-                  << " partition_count: " << partition_count;
-        }
-
-        for (int64 i = 0; i < partition_count; ++i) {
-          // Get partition [start, limit) for each dimension.
-          auto partition_buffers =
-              GetPartitionBuffers(partition_iterator.GetPartition(i));
-          Schedule(instruction, partition_buffers, result_buffer);
-        }
-
-      } else {
-        // Set tasks in-flight to '1' for sequential instruction execution.
-        {
-          tensorflow::mutex_lock l(completion_queue_lock_);
-          tasks_in_flight_.insert(std::make_pair(instruction, 1));
-          VLOG(2) << "Schedule SEQUENTIAL"
-                  << " instruction: " << instruction->name()
-                  << " instruction.callee: "
-                  << instruction->to_apply()->root_instruction()->name();
-        }
-        Schedule(instruction, nullptr, result_buffer);
-      }
-
-      ++instructions_in_flight_;
-      pending_it = pending_->erase(pending_it);
+  TF_RETURN_IF_ERROR(BuildNodes());
+  if (nodes_.empty()) {
+    return Status::OK();
+  }
+  instructions_in_flight_ = nodes_.size();
+
+  // Collect all the initially ready tasks before scheduling any of them,
+  // since running tasks make more instructions ready.
+  std::vector<Task> ready;
+  for (auto& node : nodes_) {
+    if (node->pending_operands == 0) {
+      AppendTasks(node.get(), &ready);
     }
-    // Wait for a completed HLO instruction to be present in the queue.  We will
-    // pop it out of the queue and make the result available to its users.
-    HloInstruction* instruction;
-    do {
-      tensorflow::mutex_lock l(completion_queue_lock_);
-      if (completion_queue_.empty()) {
-        completion_queue_cv_.wait(l);
-      }
-      if (!completion_queue_.empty()) {
-        instruction = completion_queue_.front();
-        completion_queue_.pop_front();
-        break;
-      }
-    } while (1);
+  }
+  for (const Task& task : ready) {
+    Schedule(task);
+  }
+  done_.WaitForNotification();
+  return Status::OK();
+}
+
+Status Executor::BuildNodes() {
+  std::unordered_map<const HloInstruction*, Node*> instruction_nodes;
+  for (HloInstruction* instruction : pending_) {
+    nodes_.emplace_back(new Node);
+    Node* node = nodes_.back().get();
+    node->instruction = instruction;
+    node->function = FindOrDie(functions_, instruction);
+    // Get 'result_buffer' reference to result buffer for 'instruction'.
     TF_ASSIGN_OR_RETURN(const BufferAllocation::Slice result_slice,
                         assignment_->GetUniqueTopLevelSlice(instruction));
-    void* result_buffer =
+    node->result_buffer =
         static_cast<char*>(temps_array_[result_slice.index()]) +
         result_slice.offset();
-    InsertOrDie(results_, instruction, result_buffer);
-    --instructions_in_flight_;
+    InsertOrDie(&instruction_nodes, instruction, node);
+  }
+
+  for (auto& node : nodes_) {
+    HloInstruction* instruction = node->instruction;
+    std::unordered_set<Node*> pending_operands;
+    for (HloInstruction* operand : instruction->operands()) {
+      auto it = instruction_nodes.find(operand);
+      if (it == instruction_nodes.end()) {
+        // Parameters and constants are available from the start.
+        node->operand_buffers.push_back(FindOrDie(results_, operand));
+        continue;
+      }
+      Node* operand_node = it->second;
+      node->operand_buffers.push_back(operand_node->result_buffer);
+      if (pending_operands.insert(operand_node).second) {
+        operand_node->users.push_back(node.get());
+      }
+    }
+    node->pending_operands = pending_operands.size();
+
+    if (HasParallelTasks(instruction)) {
+      // 'instruction' has been assigned parallel task partitions.
+      CHECK_EQ(HloOpcode::kCall, instruction->opcode());
+      HloInstruction* root = instruction->to_apply()->root_instruction();
+
+      // Create ShapePartitionIterator to iterate through all outer dimension
+      // partitions of 'instruction'.
+      ShapePartitionIterator partition_iterator(
+          root->shape(), root->outer_dimension_partitions());
+      node->partition_count = partition_iterator.GetTotalPartitionCount();
+      node->partition_dimensions = root->outer_dimension_partitions().size();
+      node->partition_buffers.reserve(node->partition_count *
+                                      node->partition_dimensions * 2);
+      for (int64 i = 0; i < node->partition_count; ++i) {
+        // Store partition [start, limit) for each dimension.
+        for (const auto& dimension : partition_iterator.GetPartition(i)) {
+          node->partition_buffers.push_back(dimension.first);
+          node->partition_buffers.push_back(dimension.first +
+                                            dimension.second);
+        }
+      }
+      node->partition_cost_nanos =
+          &FindOrDie(*partition_costs_, instruction);
+    }
   }
   return Status::OK();
 }
 
-void Executor::Schedule(HloInstruction* instruction, int64* partition_buffers,
-                        void* result_buffer) {
-  // The thread pool entry takes ownership of |operand_buffers|.
-  auto operand_buffers = GetOperandBuffers(instruction);
+void Executor::AppendTasks(Node* node, std::vector<Task>* tasks) {
+  if (node->partition_count == 0) {
+    VLOG(2) << "Schedule SEQUENTIAL"
+            << " instruction: " << node->instruction->name()
+            << " instruction.callee: "
+            << node->instruction->to_apply()->root_instruction()->name();
+    node->pending_tasks = 1;
+    tasks->push_back({node, 0, 1});
+    return;
+  }
+
+  // Until the cost has been measured, run one partition per task, as
+  // partitioned by the compiler.
+  int64 partitions_per_task = 1;
+  const uint64 partition_cost_nanos =
+      node->partition_cost_nanos->load(std::memory_order_relaxed);
+  if (partition_cost_nanos > 0) {
+    partitions_per_task = std::min<int64>(
+        node->partition_count,
+        std::max<int64>(1, kMinTaskNanos / partition_cost_nanos));
+  }
+  const int64 task_count =
+      CeilOfRatio(node->partition_count, partitions_per_task);
+  VLOG(2) << "Schedule PARALLEL"
+          << " instruction: " << node->instruction->name()
+          << " instruction.callee: "
+          << node->instruction->to_apply()->root_instruction()->name()
+          << " partition_count: " << node->partition_count
+          << " task_count: " << task_count;
+
+  node->pending_tasks = task_count;
+  node->elapsed_micros = 0;
+  for (int64 begin = 0; begin < node->partition_count;
+       begin += partitions_per_task) {
+    tasks->push_back(
+        {node, begin,
+         std::min(begin + partitions_per_task, node->partition_count)});
+  }
+}
+
+void Executor::Schedule(const Task& task) {
+  thread_pool_->Schedule([this, task]() { Execute(task); });
+}
 
-  auto function = FindOrDie(functions_, instruction);
+void Executor::Execute(Task task) {
   const auto* exec_run_options = &run_options_->run_options();
-  thread_pool_->Schedule([this, instruction, result_buffer, operand_buffers,
-                          partition_buffers, exec_run_options, function]() {
-    function(result_buffer, exec_run_options, operand_buffers, temps_array_,
-             partition_buffers, profile_counters_array_);
-
-    delete[] operand_buffers;
-    delete[] partition_buffers;
-    // Push the completed HLO instruction on the queue, the main
-    // thread will pop it off and potentially launch more work which
-    // uses the result.
-    // TODO(b/27458679) Consider alternative task scheduling and synchronization
-    // schemes. For example, we could avoid the overhead associate with the
-    // condvar here if the thread just dequed the next instruction to execute
-    // on completion.
-    {
-      tensorflow::mutex_lock l(completion_queue_lock_);
-      // Decrement in-flight task count for this completion.
-      if (--FindOrDie(tasks_in_flight_, instruction) == 0) {
-        completion_queue_.push_back(instruction);
-        completion_queue_cv_.notify_all();
-        tasks_in_flight_.erase(instruction);
+  tensorflow::Env* env = tensorflow::Env::Default();
+  while (true) {
+    Node* node = task.node;
+    if (node->partition_count == 0) {
+      node->function(node->result_buffer, exec_run_options,
+                     node->operand_buffers.data(), temps_array_, nullptr,
+                     profile_counters_array_);
+    } else {
+      const uint64 start_micros = env->NowMicros();
+      for (int64 i = task.partition_begin; i < task.partition_end; ++i) {
+        node->function(
+            node->result_buffer, exec_run_options,
+            node->operand_buffers.data(), temps_array_,
+            &node->partition_buffers[i * node->partition_dimensions * 2],
+            profile_counters_array_);
       }
+      node->elapsed_micros += env->NowMicros() - start_micros;
+    }
+
+    if (--node->pending_tasks > 0) {
+      return;
     }
-  });
-}
 
-int64* Executor::GetPartitionBuffers(
-    const std::vector<std::pair<int64, int64>>& partition) {
-  // Return in 'partition_buffers' partition [size, limit) for each dimension.
-  auto partition_buffers = new int64[partition.size() * 2];
-  for (int i = 0; i < partition.size(); ++i) {
-    partition_buffers[2 * i + 0] = partition[i].first;
-    partition_buffers[2 * i + 1] = partition[i].first + partition[i].second;
+    // This was the last task of 'node'.
+    if (node->partition_count > 0) {
+      // Smooth the measured cost, since the first execution is usually the
+      // slowest.
+      const uint64 measured_nanos = std::max<uint64>(
+          1, node->elapsed_micros * 1000 / node->partition_count);
+      const uint64 previous_nanos =
+          node->partition_cost_nanos->load(std::memory_order_relaxed);
+      node->partition_cost_nanos->store(
+          previous_nanos == 0 ? measured_nanos
+                              : (3 * previous_nanos + measured_nanos) / 4,
+          std::memory_order_relaxed);
+    }
+
+    std::vector<Task> ready;
+    for (Node* user : node->users) {
+      if (--user->pending_operands == 0) {
+        AppendTasks(user, &ready);
+      }
+    }
+    if (--instructions_in_flight_ == 0) {
+      // 'this' may be destroyed as soon as 'done_' is notified.
+      done_.Notify();
+      return;
+    }
+    if (ready.empty()) {
+      return;
+    }
+    // Continue with the first ready task on this thread, and leave the rest
+    // to other workers.
+    for (size_t i = 1; i < ready.size(); ++i) {
+      Schedule(ready[i]);
+    }
+    task = ready[0];
   }
-  return partition_buffers;
 }
 
 bool Executor::HasParallelTasks(HloInstruction* instruction) {
@@ -305,21 +421,6 @@ bool Executor::HasParallelTasks(HloInstruction* instruction) {
               .empty();
 }
 
-const void** Executor::GetOperandBuffers(HloInstruction* instruction) {
-  // We cannot use a move-only RAII type like std::unique_ptr because the
-  // list of operands is allocated on the main thread and transferred to the
-  // worker via the lambda passed to enqueue_function.  In order for the
-  // lambda to take ownership, we would need to use generalized lambda
-  // capture which is a feature new to C++14.
-  // TODO(b/27458679) Avoid dynamic allocations in Executor.
-  auto operand_buffers = new const void*[instruction->operand_count()];
-  std::transform(instruction->operands().begin(), instruction->operands().end(),
-                 operand_buffers, [this](HloInstruction* operand) {
-                   return FindOrDie(*results_, operand);
-                 });
-  return operand_buffers;
-}
-
 }  // namespace
 
 Status ParallelCpuExecutable::AllocateBuffers(
@@ -442,9 +543,9 @@ Status ParallelCpuExecutable::ExecuteComputeFunctions(
   // For example, if we expect a library conv/matmul call to run at max
   // concurrency, we should not dispatch runnable instructions until the
   // library call is finished (to avoid expensive cache invalidation).
-  Executor executor(functions, run_options, &pending, &results,
+  Executor executor(functions, run_options, pending, results,
                     buffer_pointers.data(), profile_counters.data(),
-                    assignment_.get());
+                    assignment_.get(), &partition_costs_);
 
   TF_RETURN_IF_ERROR(executor.Run());
 
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_COMPILER_XLA_SERVICE_CPU_PARALLEL_CPU_EXECUTABLE_H_
 
 #include <stddef.h>
+#include <atomic>
 #include <map>
 #include <memory>
 #include <string>
@@ -89,6 +90,11 @@ class ParallelCpuExecutable : public Executable {
     return ShapeUtil::ByteSizeOf(shape, sizeof(void*));
   }
 
+  // Maps each instruction with parallel tasks to the measured cost of one of
+  // its partitions, in nanoseconds, or 0 if it has not been measured yet.
+  using PartitionCostMap =
+      std::unordered_map<const HloInstruction*, std::atomic<uint64>>;
+
   const Status EqualOrFail(const Executable& executable) {
     // TODO(b/62952745) Implement equality test on CPU parallel executable.
     return Unimplemented(
@@ -150,6 +156,11 @@ class ParallelCpuExecutable : public Executable {
   std::unordered_map<const HloInstruction*, std::unique_ptr<unsigned char[]>>
       aligned_constants_;
 
+  // Measured partition costs, updated by every execution and used to group
+  // partitions into tasks of a worthwhile size. Only the values change after
+  // construction, so concurrent executions can share the map.
+  PartitionCostMap partition_costs_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(ParallelCpuExecutable);
 };
 
@@ -35,6 +35,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/runtime_single_threaded_conv2d.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_single_threaded_matmul.h"
 #include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace xla {
@@ -155,13 +156,13 @@ SimpleOrcJIT::SimpleOrcJIT(const llvm::TargetOptions &target_options,
                                 /*MAttrs=*/DetectMachineAttributes()))),
       disassembler_(*target_machine_),
       data_layout_(target_machine_->createDataLayout()),
+      compiler_functor_(target_machine_.get(), &disassembler_, opt_level,
+                        GetAvailableIntrinsics(),
+                        std::move(pre_optimization_hook),
+                        std::move(post_optimization_hook)),
       object_layer_(
           [] { return std::make_shared<llvm::SectionMemoryManager>(); }),
-      compile_layer_(object_layer_,
-                     CompilerFunctor(target_machine_.get(), &disassembler_,
-                                     opt_level, GetAvailableIntrinsics(),
-                                     std::move(pre_optimization_hook),
-                                     std::move(post_optimization_hook))) {
+      compile_layer_(object_layer_, compiler_functor_) {
   VLOG(1) << "CPU target: " << target_machine_->getTargetCPU().str()
           << " features: " << target_machine_->getTargetFeatureString().str();
 }
@@ -174,6 +175,36 @@ SimpleOrcJIT::ModuleHandleT SimpleOrcJIT::AddModule(
   return handle;
 }
 
+SimpleOrcJIT::ModuleHandleT SimpleOrcJIT::AddModule(
+    std::unique_ptr<llvm::Module> module, string *object_code) {
+  ObjectT object = compiler_functor_(*module);
+  llvm::StringRef data = object.getBinary()->getData();
+  object_code->assign(data.data(), data.size());
+  return AddObject(std::move(object));
+}
+
+StatusOr<SimpleOrcJIT::ModuleHandleT> SimpleOrcJIT::AddObjectFile(
+    const string &object_code) {
+  std::unique_ptr<llvm::MemoryBuffer> buffer =
+      llvm::MemoryBuffer::getMemBufferCopy(object_code);
+  llvm::Expected<std::unique_ptr<llvm::object::ObjectFile>> object_file =
+      llvm::object::ObjectFile::createObjectFile(buffer->getMemBufferRef());
+  if (!object_file) {
+    llvm::consumeError(object_file.takeError());
+    return InvalidArgument("Invalid object file of %zu bytes",
+                           object_code.size());
+  }
+  return AddObject(ObjectT(std::move(object_file.get()), std::move(buffer)));
+}
+
+SimpleOrcJIT::ModuleHandleT SimpleOrcJIT::AddObject(ObjectT object) {
+  auto handle = cantFail(object_layer_.addObject(
+      std::make_shared<ObjectT>(std::move(object)),
+      MakeUnique<SimpleResolver>()));
+  module_handles_.push_back(handle);
+  return handle;
+}
+
 void SimpleOrcJIT::RemoveModule(SimpleOrcJIT::ModuleHandleT handle) {
   module_handles_.erase(
       std::remove(module_handles_.begin(), module_handles_.end(), handle),
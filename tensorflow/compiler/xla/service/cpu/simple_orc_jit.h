@@ -24,9 +24,11 @@ limitations under the License.
 #include "external/llvm/include/llvm/ExecutionEngine/Orc/IRCompileLayer.h"
 #include "external/llvm/include/llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h"
 #include "external/llvm/include/llvm/IR/Module.h"
+#include "external/llvm/include/llvm/Support/MemoryBuffer.h"
 #include "external/llvm/include/llvm/Target/TargetMachine.h"
 #include "tensorflow/compiler/xla/service/cpu/compiler_functor.h"
 #include "tensorflow/compiler/xla/service/cpu/disassembler.h"
+#include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/types.h"
 
 namespace xla {
@@ -72,10 +74,25 @@ class SimpleOrcJIT {
     return target_machine_->getTargetTriple();
   }
 
+  // Target machine this JIT was created with.
+  const llvm::TargetMachine& target_machine() const {
+    return *target_machine_;
+  }
+
   // Add a module to the JIT. Returns an opaque handle that can be used to later
   // remove this module.
   ModuleHandleT AddModule(std::unique_ptr<llvm::Module> module);
 
+  // Same as above, and also copies the object code the module was compiled to
+  // into |object_code|, so that it can later be passed to AddObjectFile.
+  ModuleHandleT AddModule(std::unique_ptr<llvm::Module> module,
+                          string* object_code);
+
+  // Add object code previously produced by this JIT for the same target
+  // machine. Returns an opaque handle that can be used to later remove the
+  // object code, or an error if |object_code| is not a valid object file.
+  StatusOr<ModuleHandleT> AddObjectFile(const string& object_code);
+
   // Remove a module from the JIT and free the memory associated with it.
   void RemoveModule(ModuleHandleT handle);
 
@@ -84,10 +101,16 @@ class SimpleOrcJIT {
   llvm::JITSymbol FindSymbol(const std::string& name);
 
  private:
+  using ObjectT = llvm::object::OwningBinary<llvm::object::ObjectFile>;
+
+  // Adds a compiled object to the object layer.
+  ModuleHandleT AddObject(ObjectT object);
+
   std::vector<ModuleHandleT> module_handles_;
   std::unique_ptr<llvm::TargetMachine> target_machine_;
   const Disassembler disassembler_;
   const llvm::DataLayout data_layout_;
+  const CompilerFunctor compiler_functor_;
   ObjLayerT object_layer_;
   CompileLayerT compile_layer_;
 };
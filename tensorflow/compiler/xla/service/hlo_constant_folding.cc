@@ -34,6 +34,27 @@ limitations under the License.
 
 namespace xla {
 
+constexpr int64 HloConstantFolding::kDefaultMaxConstantSizeInBytes;
+
+bool HloConstantFolding::TooLargeToFold(
+    const HloInstruction& instruction) const {
+  if (!ShapeUtil::IsArray(instruction.shape())) {
+    return false;
+  }
+  const int64 result_size = ShapeUtil::ByteSizeOf(instruction.shape());
+  if (result_size <= max_constant_size_in_bytes_) {
+    return false;
+  }
+  int64 operands_size = 0;
+  for (const HloInstruction* operand : instruction.operands()) {
+    if (!ShapeUtil::IsArray(operand->shape())) {
+      return false;
+    }
+    operands_size += ShapeUtil::ByteSizeOf(operand->shape());
+  }
+  return result_size > operands_size;
+}
+
 StatusOr<bool> HloConstantFolding::Run(HloModule* module) {
   auto evaluator = MakeUnique<HloEvaluator>();
 
@@ -64,6 +85,13 @@ StatusOr<bool> HloConstantFolding::Run(HloModule* module) {
       if (instruction->opcode() == HloOpcode::kBroadcast) {
         continue;
       }
+      // Likewise for the other instructions that would produce a large
+      // constant out of smaller ones, such as pads.
+      if (TooLargeToFold(*instruction)) {
+        VLOG(2) << "Skipping constant folding of large result: "
+                << instruction->ToString();
+        continue;
+      }
 
       std::unique_ptr<Literal> result = evaluator->TryEvaluate(instruction);
       // Currently we skip unimplemented operations.
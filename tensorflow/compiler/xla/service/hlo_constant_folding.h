@@ -25,11 +25,29 @@ namespace xla {
 // computation on constants.
 class HloConstantFolding : public HloPassInterface {
  public:
+  // The default for max_constant_size_in_bytes.
+  static constexpr int64 kDefaultMaxConstantSizeInBytes = 1 << 20;
+
+  // Instructions whose result would be larger than
+  // 'max_constant_size_in_bytes' are only folded if their result isn't larger
+  // than their operands together, so that folding doesn't grow the module by
+  // large constants.
+  explicit HloConstantFolding(
+      int64 max_constant_size_in_bytes = kDefaultMaxConstantSizeInBytes)
+      : max_constant_size_in_bytes_(max_constant_size_in_bytes) {}
+
   tensorflow::StringPiece name() const override { return "constant_folding"; }
 
   // Run constant folding operations on the given module. Returns whether the
   // module was changed (constant expressions folded).
   StatusOr<bool> Run(HloModule* module) override;
+
+ private:
+  // Returns true if folding 'instruction' would add a constant that is too
+  // large with respect to the constants it replaces.
+  bool TooLargeToFold(const HloInstruction& instruction) const;
+
+  const int64 max_constant_size_in_bytes_;
 };
 
 }  // namespace xla
@@ -202,6 +202,52 @@ TEST_F(HloConstantFoldingTest, TransposeConstantFold) {
   EXPECT_TRUE(matched);
 }
 
+TEST_F(HloConstantFoldingTest, DoesNotFoldLargePad) {
+  HloComputation::Builder builder(TestName());
+  HloInstruction* input = builder.AddInstruction(
+      HloInstruction::CreateConstant(Literal::CreateR1<float>({1.0f, 2.0f})));
+  HloInstruction* zero = builder.AddInstruction(
+      HloInstruction::CreateConstant(Literal::CreateR0<float>(0.0f)));
+  PaddingConfig padding_config;
+  auto* dimension = padding_config.add_dimensions();
+  dimension->set_edge_padding_low(0);
+  dimension->set_edge_padding_high(30);
+  dimension->set_interior_padding(0);
+  builder.AddInstruction(HloInstruction::CreatePad(
+      ShapeUtil::MakeShape(F32, {32}), input, zero, padding_config));
+
+  auto module = CreateNewModule();
+  auto computation = module->AddEntryComputation(builder.Build());
+
+  // The padded constant would be 128 bytes, out of 12 bytes of operands.
+  HloConstantFolding const_folder(/*max_constant_size_in_bytes=*/64);
+  TF_ASSIGN_OR_ASSERT_OK(bool result, const_folder.Run(module.get()));
+  EXPECT_FALSE(result);
+  EXPECT_THAT(computation->root_instruction(), op::Pad(input, zero));
+}
+
+TEST_F(HloConstantFoldingTest, FoldsLargeElementwise) {
+  HloComputation::Builder builder(TestName());
+  const Shape shape = ShapeUtil::MakeShape(F32, {32});
+  HloInstruction* lhs = builder.AddInstruction(HloInstruction::CreateConstant(
+      Literal::CreateR1<float>(std::vector<float>(32, 1.0f))));
+  HloInstruction* rhs = builder.AddInstruction(HloInstruction::CreateConstant(
+      Literal::CreateR1<float>(std::vector<float>(32, 2.0f))));
+  builder.AddInstruction(
+      HloInstruction::CreateBinary(shape, HloOpcode::kAdd, lhs, rhs));
+
+  auto module = CreateNewModule();
+  auto computation = module->AddEntryComputation(builder.Build());
+
+  // The sum is larger than the limit, but not larger than its operands.
+  HloConstantFolding const_folder(/*max_constant_size_in_bytes=*/64);
+  TF_ASSIGN_OR_ASSERT_OK(bool result, const_folder.Run(module.get()));
+  EXPECT_TRUE(result);
+
+  EXPECT_THAT(computation->root_instruction(), op::Constant());
+  EXPECT_EQ(computation->root_instruction()->literal().Get<float>({31}), 3.0f);
+}
+
 }  // namespace
 }  // namespace xla
 
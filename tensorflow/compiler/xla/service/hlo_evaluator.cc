@@ -50,6 +50,60 @@ namespace xla {
 
 namespace {
 
+// Returns true if literals of the given shapes store the elements with the same
+// multi-dimensional index at the same linear index, so that element-wise
+// operations can walk their buffers directly.
+bool SameLinearOrder(const Shape& lhs, const Shape& rhs) {
+  return ShapeUtil::SameDimensions(lhs, rhs) &&
+         LayoutUtil::LayoutsInShapesEqual(lhs, rhs);
+}
+
+// Returns true if 'computation' applies a single binary operation to its two
+// parameters, and sets 'opcode' to the opcode of that operation.
+bool MatchBinaryComputation(const HloComputation& computation,
+                            HloOpcode* opcode) {
+  const HloInstruction* root = computation.root_instruction();
+  if (computation.num_parameters() != 2 || root->operand_count() != 2 ||
+      root->operand(0)->opcode() != HloOpcode::kParameter ||
+      root->operand(1)->opcode() != HloOpcode::kParameter ||
+      root->operand(0) == root->operand(1)) {
+    return false;
+  }
+  *opcode = root->opcode();
+  return true;
+}
+
+// Returns the larger of 'lhs' and 'rhs'. Integers are compared directly,
+// since std::fmax would convert them to double and round 64-bit values.
+template <typename NativeT,
+          typename std::enable_if<std::is_integral<NativeT>::value>::type* =
+              nullptr>
+NativeT Max(NativeT lhs, NativeT rhs) {
+  return std::max(lhs, rhs);
+}
+
+template <typename NativeT,
+          typename std::enable_if<
+              std::is_floating_point<NativeT>::value>::type* = nullptr>
+NativeT Max(NativeT lhs, NativeT rhs) {
+  return std::fmax(lhs, rhs);
+}
+
+// Returns the smaller of 'lhs' and 'rhs', with the same type handling as Max.
+template <typename NativeT,
+          typename std::enable_if<std::is_integral<NativeT>::value>::type* =
+              nullptr>
+NativeT Min(NativeT lhs, NativeT rhs) {
+  return std::min(lhs, rhs);
+}
+
+template <typename NativeT,
+          typename std::enable_if<
+              std::is_floating_point<NativeT>::value>::type* = nullptr>
+NativeT Min(NativeT lhs, NativeT rhs) {
+  return std::fmin(lhs, rhs);
+}
+
 template <typename OperandT>
 StatusOr<std::unique_ptr<Literal>> Compare(const Shape& shape, HloOpcode opcode,
                                            const Literal& lhs_literal,
@@ -92,6 +146,17 @@ StatusOr<std::unique_ptr<Literal>> Compare(const Shape& shape, HloOpcode opcode,
   }
 
   auto result = Literal::CreateFromShape(shape);
+  if (SameLinearOrder(result->shape(), lhs_literal.shape()) &&
+      SameLinearOrder(lhs_literal.shape(), rhs_literal.shape())) {
+    const auto lhs_data = lhs_literal.GetArraySlice<OperandT>();
+    const auto rhs_data = rhs_literal.GetArraySlice<OperandT>();
+    auto result_data = result->GetMutableArraySlice<bool>();
+    for (int64 i = 0; i < result_data.size(); ++i) {
+      result_data[i] = compare_op(lhs_data[i], rhs_data[i]);
+    }
+    return std::move(result);
+  }
+
   TF_RETURN_IF_ERROR(result->Populate<bool>(
       [&](tensorflow::gtl::ArraySlice<int64> multi_index) {
         return compare_op(lhs_literal.Get<OperandT>(multi_index),
@@ -101,10 +166,9 @@ StatusOr<std::unique_ptr<Literal>> Compare(const Shape& shape, HloOpcode opcode,
   return std::move(result);
 }
 
-template <typename ReturnT, typename NativeT>
+template <typename ReturnT, typename NativeT, typename UnaryOp>
 StatusOr<std::unique_ptr<Literal>> ElementWiseUnaryOpImpl(
-    HloInstruction* instruction,
-    const std::function<ReturnT(NativeT)>& unary_op,
+    HloInstruction* instruction, const UnaryOp& unary_op,
     const Literal& operand_literal) {
   const auto shape = instruction->shape();
   const auto* operand = instruction->operand(0);
@@ -120,10 +184,19 @@ StatusOr<std::unique_ptr<Literal>> ElementWiseUnaryOpImpl(
   }
 
   auto result = Literal::CreateFromShape(shape);
+  if (SameLinearOrder(result->shape(), operand_literal.shape())) {
+    const auto operand_data = operand_literal.GetArraySlice<NativeT>();
+    auto result_data = result->GetMutableArraySlice<ReturnT>();
+    for (int64 i = 0; i < result_data.size(); ++i) {
+      result_data[i] = static_cast<ReturnT>(unary_op(operand_data[i]));
+    }
+    return std::move(result);
+  }
 
   TF_RETURN_IF_ERROR(result->Populate<ReturnT>(
       [&](tensorflow::gtl::ArraySlice<int64> multi_index) {
-        return unary_op(operand_literal.Get<NativeT>(multi_index));
+        return static_cast<ReturnT>(
+            unary_op(operand_literal.Get<NativeT>(multi_index)));
       }));
   return std::move(result);
 }
@@ -321,7 +394,7 @@ class HloEvaluator::TypedVisitor : public DfsHloVisitorWithDefault {
     TF_ASSIGN_OR_RETURN(
         parent_->evaluated_[maximum],
         ElementWiseBinaryOp(maximum, [](ReturnT lhs, ReturnT rhs) {
-          return std::fmax(lhs, rhs);
+          return Max(lhs, rhs);
         }));
     return Status::OK();
   };
@@ -330,7 +403,7 @@ class HloEvaluator::TypedVisitor : public DfsHloVisitorWithDefault {
     TF_ASSIGN_OR_RETURN(
         parent_->evaluated_[minimum],
         ElementWiseBinaryOp(minimum, [](ReturnT lhs_el, ReturnT rhs_el) {
-          return std::fmin(lhs_el, rhs_el);
+          return Min(lhs_el, rhs_el);
         }));
     return Status::OK();
   };
@@ -654,24 +727,94 @@ class HloEvaluator::TypedVisitor : public DfsHloVisitorWithDefault {
     return Status::OK();
   };
 
+  Status HandleReduce(HloInstruction* reduce, HloInstruction* arg,
+                      HloInstruction* init_value,
+                      tensorflow::gtl::ArraySlice<int64> dimensions,
+                      HloComputation* function) override {
+    TF_RET_CHECK(ShapeUtil::IsArray(reduce->shape()));
+    TF_RET_CHECK(ShapeUtil::IsArray(arg->shape()));
+    TF_RET_CHECK(ShapeUtil::SameElementType(arg->shape(), reduce->shape()));
+    TF_RET_CHECK(ShapeUtil::IsScalar(init_value->shape()));
+    TF_RET_CHECK(ShapeUtil::Rank(arg->shape()) ==
+                 ShapeUtil::Rank(reduce->shape()) + dimensions.size());
+
+    const Literal& arg_literal = parent_->GetEvaluatedLiteralFor(arg);
+    const ReturnT init =
+        parent_->GetEvaluatedLiteralFor(init_value).Get<ReturnT>({});
+
+    // Common reductions are applied natively. The others evaluate the
+    // reduction computation for each element.
+    HloOpcode opcode;
+    if (MatchBinaryComputation(*function, &opcode)) {
+      switch (opcode) {
+        case HloOpcode::kAdd:
+          return Reduce(reduce, arg_literal, init, dimensions,
+                        [](ReturnT lhs, ReturnT rhs) { return lhs + rhs; });
+        case HloOpcode::kMultiply:
+          return Reduce(reduce, arg_literal, init, dimensions,
+                        [](ReturnT lhs, ReturnT rhs) { return lhs * rhs; });
+        case HloOpcode::kMaximum:
+          return Reduce(reduce, arg_literal, init, dimensions,
+                        [](ReturnT lhs, ReturnT rhs) { return Max(lhs, rhs); });
+        case HloOpcode::kMinimum:
+          return Reduce(reduce, arg_literal, init, dimensions,
+                        [](ReturnT lhs, ReturnT rhs) { return Min(lhs, rhs); });
+        default:
+          break;
+      }
+    }
+
+    // The reduction computation is evaluated by a separate evaluator, since
+    // this one is in the middle of an evaluation.
+    HloEvaluator function_evaluator;
+    Status status;
+    TF_RETURN_IF_ERROR(Reduce(
+        reduce, arg_literal, init, dimensions,
+        [&](ReturnT accumulator, ReturnT element) {
+          if (!status.ok()) {
+            return accumulator;
+          }
+          const auto accumulator_literal = Literal::CreateR0(accumulator);
+          const auto element_literal = Literal::CreateR0(element);
+          auto result_or = function_evaluator.Evaluate(
+              function, {accumulator_literal.get(), element_literal.get()});
+          if (!result_or.ok()) {
+            status = result_or.status();
+            return accumulator;
+          }
+          return result_or.ValueOrDie()->template GetFirstElement<ReturnT>();
+        }));
+    return status;
+  }
+
   Status Preprocess(HloInstruction* hlo) override {
     VLOG(2) << hlo->ToString();
     return Status::OK();
   };
 
  private:
+  template <typename UnaryOp>
   StatusOr<std::unique_ptr<Literal>> ElementWiseUnaryOp(
-      HloInstruction* instruction,
-      const std::function<ReturnT(ReturnT)>& unary_op) {
+      HloInstruction* instruction, const UnaryOp& unary_op) {
     const Literal& operand_literal =
         parent_->GetEvaluatedLiteralFor(instruction->operand(0));
-    return ElementWiseUnaryOpImpl<ReturnT, ReturnT>(instruction, unary_op,
-                                                    operand_literal);
+    std::unique_ptr<Literal> result =
+        parent_->ReleaseOperandLiteralForReuse(instruction, 0);
+    if (result == nullptr) {
+      return ElementWiseUnaryOpImpl<ReturnT, ReturnT>(instruction, unary_op,
+                                                      operand_literal);
+    }
+    // The operand is overwritten with the result.
+    auto result_data = result->GetMutableArraySlice<ReturnT>();
+    for (int64 i = 0; i < result_data.size(); ++i) {
+      result_data[i] = static_cast<ReturnT>(unary_op(result_data[i]));
+    }
+    return std::move(result);
   }
 
+  template <typename BinaryOp>
   StatusOr<std::unique_ptr<Literal>> ElementWiseBinaryOp(
-      HloInstruction* instruction,
-      const std::function<ReturnT(ReturnT, ReturnT)>& binary_op) {
+      HloInstruction* instruction, const BinaryOp& binary_op) {
     const auto shape = instruction->shape();
     const auto* lhs = instruction->operand(0);
     const auto* rhs = instruction->operand(1);
@@ -691,16 +834,118 @@ class HloEvaluator::TypedVisitor : public DfsHloVisitorWithDefault {
     const Literal& lhs_literal = parent_->GetEvaluatedLiteralFor(lhs);
     const Literal& rhs_literal = parent_->GetEvaluatedLiteralFor(rhs);
 
+    if (SameLinearOrder(shape, lhs_literal.shape()) &&
+        SameLinearOrder(lhs_literal.shape(), rhs_literal.shape())) {
+      // Write the result over one of the operands if possible. The operand
+      // literals stay alive until the end of this function either way.
+      std::unique_ptr<Literal> result =
+          parent_->ReleaseOperandLiteralForReuse(instruction, 0);
+      if (result == nullptr) {
+        result = parent_->ReleaseOperandLiteralForReuse(instruction, 1);
+      }
+      if (result == nullptr) {
+        result = Literal::CreateFromShape(shape);
+      }
+      const auto lhs_data = lhs_literal.GetArraySlice<ReturnT>();
+      const auto rhs_data = rhs_literal.GetArraySlice<ReturnT>();
+      auto result_data = result->GetMutableArraySlice<ReturnT>();
+      for (int64 i = 0; i < result_data.size(); ++i) {
+        result_data[i] =
+            static_cast<ReturnT>(binary_op(lhs_data[i], rhs_data[i]));
+      }
+      return std::move(result);
+    }
+
     auto result = Literal::CreateFromShape(shape);
 
     TF_RETURN_IF_ERROR(result->Populate<ReturnT>(
         [&](tensorflow::gtl::ArraySlice<int64> multi_index) {
-          return binary_op(lhs_literal.Get<ReturnT>(multi_index),
-                           rhs_literal.Get<ReturnT>(multi_index));
+          return static_cast<ReturnT>(
+              binary_op(lhs_literal.Get<ReturnT>(multi_index),
+                        rhs_literal.Get<ReturnT>(multi_index)));
         }));
     return std::move(result);
   }
 
+  // Reduces 'arg_literal' along 'dimensions' with 'reduce_op', and stores
+  // the result as the evaluated literal of 'reduce'. The argument is walked
+  // in its linear order, one run of its most minor dimension at a time.
+  template <typename ReduceOp>
+  Status Reduce(HloInstruction* reduce, const Literal& arg_literal,
+                ReturnT init_value,
+                tensorflow::gtl::ArraySlice<int64> dimensions,
+                const ReduceOp& reduce_op) {
+    const Shape& arg_shape = arg_literal.shape();
+    const int64 rank = ShapeUtil::Rank(arg_shape);
+    auto result = Literal::CreateFromShape(reduce->shape());
+    const Shape& result_shape = result->shape();
+    auto result_data = result->GetMutableArraySlice<ReturnT>();
+    std::fill(result_data.begin(), result_data.end(), init_value);
+    const auto arg_data = arg_literal.GetArraySlice<ReturnT>();
+
+    if (rank == 0) {
+      result_data[0] = static_cast<ReturnT>(reduce_op(init_value, arg_data[0]));
+    }
+    if (rank == 0 || arg_data.empty()) {
+      parent_->evaluated_[reduce] = std::move(result);
+      return Status::OK();
+    }
+
+    // The distance in the result between the elements that are consecutive
+    // along each dimension of the argument. It is 0 for the reduced
+    // dimensions.
+    std::vector<int64> result_dimension_strides(ShapeUtil::Rank(result_shape));
+    int64 stride = 1;
+    for (int64 dimension : result_shape.layout().minor_to_major()) {
+      result_dimension_strides[dimension] = stride;
+      stride *= result_shape.dimensions(dimension);
+    }
+    std::vector<int64> result_strides(rank, 0);
+    int64 result_dimension = 0;
+    for (int64 dimension = 0; dimension < rank; ++dimension) {
+      if (std::find(dimensions.begin(), dimensions.end(), dimension) ==
+          dimensions.end()) {
+        result_strides[dimension] =
+            result_dimension_strides[result_dimension++];
+      }
+    }
+
+    const auto& minor_to_major = arg_shape.layout().minor_to_major();
+    const int64 run_length = arg_shape.dimensions(minor_to_major.Get(0));
+    const int64 run_stride = result_strides[minor_to_major.Get(0)];
+    std::vector<int64> index(rank, 0);
+    int64 result_offset = 0;
+    for (int64 start = 0; start < arg_data.size(); start += run_length) {
+      const ReturnT* run = arg_data.data() + start;
+      ReturnT* result_run = result_data.data() + result_offset;
+      if (run_stride == 0) {
+        ReturnT accumulator = *result_run;
+        for (int64 i = 0; i < run_length; ++i) {
+          accumulator = static_cast<ReturnT>(reduce_op(accumulator, run[i]));
+        }
+        *result_run = accumulator;
+      } else {
+        for (int64 i = 0; i < run_length; ++i) {
+          result_run[i * run_stride] = static_cast<ReturnT>(
+              reduce_op(result_run[i * run_stride], run[i]));
+        }
+      }
+      // Advance to the next run of the most minor dimension.
+      for (int64 k = 1; k < rank; ++k) {
+        const int64 dimension = minor_to_major.Get(k);
+        result_offset += result_strides[dimension];
+        if (++index[dimension] < arg_shape.dimensions(dimension)) {
+          break;
+        }
+        result_offset -= result_strides[dimension] * index[dimension];
+        index[dimension] = 0;
+      }
+    }
+
+    parent_->evaluated_[reduce] = std::move(result);
+    return Status::OK();
+  }
+
   template <typename LhsType, typename RhsType, typename EhsType>
   StatusOr<std::unique_ptr<Literal>> ElementWiseTernaryOp(
       HloInstruction* instruction,
@@ -729,6 +974,18 @@ class HloEvaluator::TypedVisitor : public DfsHloVisitorWithDefault {
     const Literal& ehs_literal = parent_->GetEvaluatedLiteralFor(ehs);
 
     auto result = Literal::CreateFromShape(shape);
+    if (SameLinearOrder(result->shape(), lhs_literal.shape()) &&
+        SameLinearOrder(lhs_literal.shape(), rhs_literal.shape()) &&
+        SameLinearOrder(rhs_literal.shape(), ehs_literal.shape())) {
+      const auto lhs_data = lhs_literal.GetArraySlice<LhsType>();
+      const auto rhs_data = rhs_literal.GetArraySlice<RhsType>();
+      const auto ehs_data = ehs_literal.GetArraySlice<EhsType>();
+      auto result_data = result->GetMutableArraySlice<ReturnT>();
+      for (int64 i = 0; i < result_data.size(); ++i) {
+        result_data[i] = ternary_op(lhs_data[i], rhs_data[i], ehs_data[i]);
+      }
+      return std::move(result);
+    }
 
     TF_RETURN_IF_ERROR(result->Populate<ReturnT>(
         [&](tensorflow::gtl::ArraySlice<int64> multi_index) {
@@ -777,8 +1034,9 @@ StatusOr<std::unique_ptr<Literal>> HloEvaluator::Evaluate(
   evaluated_.clear();
 
   TF_RETURN_IF_ERROR(computation->Accept(this));
-  return MakeUnique<Literal>(
-      GetEvaluatedLiteralFor(computation->root_instruction()));
+  auto result = ReleaseEvaluatedLiteralFor(computation->root_instruction());
+  evaluated_.clear();
+  return std::move(result);
 }
 
 StatusOr<std::unique_ptr<Literal>> HloEvaluator::Evaluate(
@@ -790,21 +1048,22 @@ StatusOr<std::unique_ptr<Literal>> HloEvaluator::Evaluate(
   arg_literals_ = operands;
   evaluated_.clear();
 
-  // Evaluate operands of Parameter type against the input literals which
-  // caches the evaluated literal results.
+  // Operands of Parameter type are evaluated to the input literals, which are
+  // read in place.
   for (const auto operand : instruction->operands()) {
     if (operand->opcode() == HloOpcode::kParameter) {
+      TF_RET_CHECK(operand->parameter_number() < arg_literals_.size());
       const Literal* input_literal = arg_literals_[operand->parameter_number()];
       VLOG(2) << "Parameter operand evaluated to: "
               << input_literal->ToString();
       TF_RET_CHECK(ShapeUtil::Equal(operand->shape(), input_literal->shape()));
-
-      evaluated_[operand] = MakeUnique<Literal>(*input_literal);
     }
   }
 
   TF_RETURN_IF_ERROR(instruction->Visit(this));
-  return MakeUnique<Literal>(GetEvaluatedLiteralFor(instruction));
+  auto result = ReleaseEvaluatedLiteralFor(instruction);
+  evaluated_.clear();
+  return std::move(result);
 }
 
 StatusOr<std::unique_ptr<Literal>> HloEvaluator::Evaluate(
@@ -816,7 +1075,9 @@ StatusOr<std::unique_ptr<Literal>> HloEvaluator::Evaluate(
   arg_literals_.clear();
   evaluated_.clear();
   TF_RETURN_IF_ERROR(instruction->Visit(this));
-  return MakeUnique<Literal>(GetEvaluatedLiteralFor(instruction));
+  auto result = ReleaseEvaluatedLiteralFor(instruction);
+  evaluated_.clear();
+  return std::move(result);
 }
 
 std::unique_ptr<Literal> HloEvaluator::TryEvaluate(
@@ -830,13 +1091,42 @@ std::unique_ptr<Literal> HloEvaluator::TryEvaluate(
   return result_or.ConsumeValueOrDie();
 }
 
+std::unique_ptr<Literal> HloEvaluator::ReleaseEvaluatedLiteralFor(
+    const HloInstruction* hlo) {
+  auto it = evaluated_.find(hlo);
+  if (it == evaluated_.end()) {
+    return MakeUnique<Literal>(GetEvaluatedLiteralFor(hlo));
+  }
+  std::unique_ptr<Literal> literal = std::move(it->second);
+  evaluated_.erase(it);
+  return literal;
+}
+
+std::unique_ptr<Literal> HloEvaluator::ReleaseOperandLiteralForReuse(
+    const HloInstruction* hlo, int64 operand_index) {
+  const HloInstruction* operand = hlo->operand(operand_index);
+  // Only the literals of the root instruction and of instructions with other
+  // users may be read again.
+  if (operand->user_count() != 1 ||
+      (operand->parent() != nullptr &&
+       operand->parent()->root_instruction() == operand)) {
+    return nullptr;
+  }
+  auto it = evaluated_.find(operand);
+  if (it == evaluated_.end() ||
+      !ShapeUtil::Equal(it->second->shape(), hlo->shape())) {
+    return nullptr;
+  }
+  std::unique_ptr<Literal> literal = std::move(it->second);
+  evaluated_.erase(it);
+  return literal;
+}
+
 Status HloEvaluator::HandleParameter(HloInstruction* parameter) {
   VLOG(2) << "HandleParameter: " << parameter->ToString();
-  const Literal* input_literal = arg_literals_[parameter->parameter_number()];
-  VLOG(2) << "Parameter evaluated to: " << input_literal->ToString();
-  DCHECK(ShapeUtil::Equal(parameter->shape(), input_literal->shape()));
-
-  evaluated_[parameter] = MakeUnique<Literal>(*input_literal);
+  const Literal& input_literal = GetEvaluatedLiteralFor(parameter);
+  VLOG(2) << "Parameter evaluated to: " << input_literal.ToString();
+  DCHECK(ShapeUtil::Equal(parameter->shape(), input_literal.shape()));
   return Status::OK();
 }
 
@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/dfs_hlo_visitor_with_default.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/compiler/xla/xla_data.pb.h"
@@ -119,18 +120,36 @@ class HloEvaluator : public DfsHloVisitorWithDefault {
  private:
   // Returns the already-evaluated literal result for the instruction.
   // A Constant instruction is considered evaluated and its literal will be
-  // returned directly without looking up the cache.
+  // returned directly without looking up the cache. The same goes for a
+  // Parameter instruction and its argument literal.
   // Crash with log if the given instruction has not been evaluated previously.
   const Literal& GetEvaluatedLiteralFor(const HloInstruction* hlo) {
     if (hlo->IsConstant()) {
       return hlo->literal();
     }
+    if (hlo->opcode() == HloOpcode::kParameter) {
+      CHECK_LT(hlo->parameter_number(), arg_literals_.size())
+          << "no argument literal for: " << hlo->ToString();
+      return *arg_literals_[hlo->parameter_number()];
+    }
     auto it = evaluated_.find(hlo);
     CHECK(it != evaluated_.end())
         << "could not find evaluated value for: " << hlo->ToString();
     return *(it->second);
   }
 
+  // Returns the evaluated literal result for the instruction, moving it out of
+  // the cache instead of copying it when the cache owns it.
+  std::unique_ptr<Literal> ReleaseEvaluatedLiteralFor(
+      const HloInstruction* hlo);
+
+  // Returns the evaluated literal of the operand 'operand_index' of 'hlo', for
+  // the result of 'hlo' to be written over it, if 'hlo' is the only reader of
+  // that literal and the literal has the shape of the result. Returns nullptr
+  // otherwise. The literal is removed from the cache.
+  std::unique_ptr<Literal> ReleaseOperandLiteralForReuse(
+      const HloInstruction* hlo, int64 operand_index);
+
   // Map from a primitive type to its associated (templated) DfsHloVisitor.
   // Note: the hash function here is only needed because current gcc std::hash
   // does not specialize for enum types. This should however be fixed in the
@@ -140,6 +159,8 @@ class HloEvaluator : public DfsHloVisitorWithDefault {
       typed_visitors_;
 
   // Tracks the HLO instruction and its evaluated literal result.
+  // Element-wise operations reuse the literals of operands that have no other
+  // user, which keeps the cache from growing along chains of such operations.
   // TODO(b/35950897): have better memory management here to free instructions
   // that are no longer a parent for any other subsequent instruction in
   // post-orderring.
@@ -22,10 +22,13 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/compiler/xla/client/computation_builder.h"
+#include "tensorflow/compiler/xla/layout_util.h"
 #include "tensorflow/compiler/xla/literal_util.h"
 #include "tensorflow/compiler/xla/reference_util.h"
 #include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_constant_folding.h"
 #include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
 #include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/status_macros.h"
 #include "tensorflow/compiler/xla/statusor.h"
@@ -35,6 +38,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/compiler/xla/xla_data.pb.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace xla {
@@ -946,5 +950,191 @@ TEST_F(HloEvaluatorTest,
   LiteralTestUtil::ExpectEqual(*expected, *result);
 }
 
+// Builds a computation that applies 'opcode' to its two scalar parameters.
+std::unique_ptr<HloComputation> CreateScalarBinaryComputation(
+    const string& name, PrimitiveType type, HloOpcode opcode) {
+  HloComputation::Builder builder(name);
+  const Shape scalar_shape = ShapeUtil::MakeShape(type, {});
+  HloInstruction* p0 = builder.AddInstruction(
+      HloInstruction::CreateParameter(0, scalar_shape, "p0"));
+  HloInstruction* p1 = builder.AddInstruction(
+      HloInstruction::CreateParameter(1, scalar_shape, "p1"));
+  builder.AddInstruction(
+      HloInstruction::CreateBinary(scalar_shape, opcode, p0, p1));
+  return builder.Build();
+}
+
+TEST_F(HloEvaluatorTest, ReduceAdd) {
+  auto add = CreateScalarBinaryComputation("add", F32, HloOpcode::kAdd);
+  auto arg = HloInstruction::CreateConstant(
+      Literal::CreateR2<float>({{1.f, 2.f, 3.f}, {4.f, 5.f, 6.f}}));
+  auto init = HloInstruction::CreateConstant(Literal::CreateR0<float>(10.f));
+
+  auto reduce_rows =
+      HloInstruction::CreateReduce(ShapeUtil::MakeShape(F32, {2}), arg.get(),
+                                   init.get(), {1}, add.get());
+  auto result = evaluator_->Evaluate(reduce_rows.get()).ConsumeValueOrDie();
+  LiteralTestUtil::ExpectEqual(*Literal::CreateR1<float>({16.f, 25.f}),
+                               *result);
+
+  auto reduce_columns =
+      HloInstruction::CreateReduce(ShapeUtil::MakeShape(F32, {3}), arg.get(),
+                                   init.get(), {0}, add.get());
+  result = evaluator_->Evaluate(reduce_columns.get()).ConsumeValueOrDie();
+  LiteralTestUtil::ExpectEqual(*Literal::CreateR1<float>({15.f, 17.f, 19.f}),
+                               *result);
+
+  auto reduce_all =
+      HloInstruction::CreateReduce(ShapeUtil::MakeShape(F32, {}), arg.get(),
+                                   init.get(), {0, 1}, add.get());
+  result = evaluator_->Evaluate(reduce_all.get()).ConsumeValueOrDie();
+  LiteralTestUtil::ExpectEqual(*Literal::CreateR0<float>(31.f), *result);
+}
+
+TEST_F(HloEvaluatorTest, ReduceColumnMajorMax) {
+  auto max = CreateScalarBinaryComputation("max", S32, HloOpcode::kMaximum);
+  auto arg_literal = Literal::CreateR2WithLayout<int32>(
+      {{1, 7, 3}, {4, 5, 9}}, LayoutUtil::MakeLayout({0, 1}));
+  auto arg = HloInstruction::CreateConstant(std::move(arg_literal));
+  auto init = HloInstruction::CreateConstant(Literal::CreateR0<int32>(2));
+
+  auto reduce =
+      HloInstruction::CreateReduce(ShapeUtil::MakeShape(S32, {3}), arg.get(),
+                                   init.get(), {0}, max.get());
+  auto result = evaluator_->Evaluate(reduce.get()).ConsumeValueOrDie();
+  LiteralTestUtil::ExpectEqual(*Literal::CreateR1<int32>({4, 7, 9}), *result);
+}
+
+// 64-bit integers above 2^53 are not representable as doubles, so they must
+// be compared exactly.
+TEST_F(HloEvaluatorTest, ReduceMaxMinS64) {
+  const int64 kBig = (1LL << 53) + 1;
+  auto arg = HloInstruction::CreateConstant(
+      Literal::CreateR1<int64>({kBig, kBig + 2, kBig + 1}));
+  auto init = HloInstruction::CreateConstant(Literal::CreateR0<int64>(kBig));
+
+  auto max = CreateScalarBinaryComputation("max", S64, HloOpcode::kMaximum);
+  auto reduce_max =
+      HloInstruction::CreateReduce(ShapeUtil::MakeShape(S64, {}), arg.get(),
+                                   init.get(), {0}, max.get());
+  auto result = evaluator_->Evaluate(reduce_max.get()).ConsumeValueOrDie();
+  LiteralTestUtil::ExpectEqual(*Literal::CreateR0<int64>(kBig + 2), *result);
+
+  auto min = CreateScalarBinaryComputation("min", S64, HloOpcode::kMinimum);
+  auto reduce_min =
+      HloInstruction::CreateReduce(ShapeUtil::MakeShape(S64, {}), arg.get(),
+                                   init.get(), {0}, min.get());
+  result = evaluator_->Evaluate(reduce_min.get()).ConsumeValueOrDie();
+  LiteralTestUtil::ExpectEqual(*Literal::CreateR0<int64>(kBig), *result);
+}
+
+// A reduction that isn't recognized is evaluated through its computation.
+TEST_F(HloEvaluatorTest, ReduceWithComputation) {
+  auto subtract =
+      CreateScalarBinaryComputation("subtract", F32, HloOpcode::kSubtract);
+  auto arg = HloInstruction::CreateConstant(
+      Literal::CreateR2<float>({{1.f, 2.f, 3.f}, {4.f, 5.f, 6.f}}));
+  auto init = HloInstruction::CreateConstant(Literal::CreateR0<float>(0.f));
+
+  auto reduce =
+      HloInstruction::CreateReduce(ShapeUtil::MakeShape(F32, {2}), arg.get(),
+                                   init.get(), {1}, subtract.get());
+  auto result = evaluator_->Evaluate(reduce.get()).ConsumeValueOrDie();
+  LiteralTestUtil::ExpectEqual(*Literal::CreateR1<float>({-6.f, -15.f}),
+                               *result);
+}
+
+// The intermediate results of a chain of element-wise operations are
+// overwritten in place. The parameters and the values that are read twice
+// must be left intact.
+TEST_F(HloEvaluatorTest, ElementwiseChainReusesIntermediates) {
+  HloComputation::Builder b(TestName());
+  const Shape shape = ShapeUtil::MakeShape(F32, {4});
+  HloInstruction* x =
+      b.AddInstruction(HloInstruction::CreateParameter(0, shape, "x"));
+  HloInstruction* y =
+      b.AddInstruction(HloInstruction::CreateParameter(1, shape, "y"));
+  HloInstruction* sum = b.AddInstruction(
+      HloInstruction::CreateBinary(shape, HloOpcode::kAdd, x, y));
+  HloInstruction* negated = b.AddInstruction(
+      HloInstruction::CreateUnary(shape, HloOpcode::kNegate, sum));
+  HloInstruction* product = b.AddInstruction(
+      HloInstruction::CreateBinary(shape, HloOpcode::kMultiply, negated, x));
+  b.AddInstruction(
+      HloInstruction::CreateBinary(shape, HloOpcode::kAdd, product, product));
+
+  auto x_literal = Literal::CreateR1<float>({1.f, 2.f, 3.f, 4.f});
+  auto y_literal = Literal::CreateR1<float>({1.f, 1.f, 1.f, 1.f});
+  std::unique_ptr<Literal> result =
+      evaluator_->Evaluate(b.Build().get(), {x_literal.get(), y_literal.get()})
+          .ConsumeValueOrDie();
+
+  LiteralTestUtil::ExpectEqual(
+      *Literal::CreateR1<float>({-4.f, -12.f, -24.f, -40.f}), *result);
+  LiteralTestUtil::ExpectEqual(*Literal::CreateR1<float>({1.f, 2.f, 3.f, 4.f}),
+                               *x_literal);
+}
+
+// Builds a module computing (table * scale + bias) on constants of
+// [num_rows, 128] floats, the way an embedding table may be transformed when
+// it's loaded. If 'reduce' is true, the rows are then summed.
+std::unique_ptr<HloModule> CreateLargeConstantModule(int64 num_rows,
+                                                     bool reduce) {
+  const int64 kNumColumns = 128;
+  auto module = MakeUnique<HloModule>("large_constants");
+  const Shape shape = ShapeUtil::MakeShape(F32, {num_rows, kNumColumns});
+  HloComputation* add = module->AddEmbeddedComputation(
+      CreateScalarBinaryComputation("add", F32, HloOpcode::kAdd));
+
+  HloComputation::Builder b("large_constants");
+  Array2D<float> values(num_rows, kNumColumns);
+  values.FillUnique(1.0f);
+  HloInstruction* table = b.AddInstruction(HloInstruction::CreateConstant(
+      Literal::CreateR2FromArray2D<float>(values)));
+  values.Fill(0.5f);
+  HloInstruction* scale = b.AddInstruction(HloInstruction::CreateConstant(
+      Literal::CreateR2FromArray2D<float>(values)));
+  values.Fill(2.0f);
+  HloInstruction* bias = b.AddInstruction(HloInstruction::CreateConstant(
+      Literal::CreateR2FromArray2D<float>(values)));
+  HloInstruction* scaled = b.AddInstruction(
+      HloInstruction::CreateBinary(shape, HloOpcode::kMultiply, table, scale));
+  HloInstruction* biased = b.AddInstruction(
+      HloInstruction::CreateBinary(shape, HloOpcode::kAdd, scaled, bias));
+  if (reduce) {
+    HloInstruction* zero = b.AddInstruction(
+        HloInstruction::CreateConstant(Literal::CreateR0<float>(0.f)));
+    b.AddInstruction(HloInstruction::CreateReduce(
+        ShapeUtil::MakeShape(F32, {num_rows}), biased, zero, {1}, add));
+  }
+  module->AddEntryComputation(b.Build());
+  return module;
+}
+
+void BM_ConstantFolding(int num_iters, int num_rows, bool reduce) {
+  tensorflow::testing::StopTiming();
+  HloConstantFolding const_folder;
+  for (int i = 0; i < num_iters; ++i) {
+    std::unique_ptr<HloModule> module =
+        CreateLargeConstantModule(num_rows, reduce);
+    tensorflow::testing::StartTiming();
+    CHECK(const_folder.Run(module.get()).ValueOrDie());
+    tensorflow::testing::StopTiming();
+  }
+  tensorflow::testing::BytesProcessed(static_cast<int64>(num_iters) *
+                                      num_rows * 128 * sizeof(float));
+}
+
+void BM_FoldElementwise(int num_iters, int num_rows) {
+  BM_ConstantFolding(num_iters, num_rows, /*reduce=*/false);
+}
+
+void BM_FoldElementwiseAndReduce(int num_iters, int num_rows) {
+  BM_ConstantFolding(num_iters, num_rows, /*reduce=*/true);
+}
+
+BENCHMARK(BM_FoldElementwise)->Arg(1 << 10)->Arg(1 << 14);
+BENCHMARK(BM_FoldElementwiseAndReduce)->Arg(1 << 10)->Arg(1 << 14);
+
 }  // namespace
 }  // namespace xla
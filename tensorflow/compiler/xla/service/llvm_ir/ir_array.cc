@@ -276,6 +276,20 @@ void IrArray::EmitWriteArrayElement(const Index& index, llvm::Value* value,
   }
 }
 
+void IrArray::AnnotateLoadStoreInstructionWithMetadata(
+    llvm::Instruction* instruction) const {
+  CHECK(llvm::isa<llvm::LoadInst>(instruction) ||
+        llvm::isa<llvm::StoreInst>(instruction));
+  llvm_ir::SetTbaaForInstruction(instruction, GetShape(),
+                                 /*is_pointer_to=*/false);
+  for (const auto& kind_md_pair : metadata_) {
+    if (llvm::isa<llvm::StoreInst>(instruction)) {
+      CHECK_NE(kind_md_pair.first, llvm::LLVMContext::MD_invariant_load);
+    }
+    instruction->setMetadata(kind_md_pair.first, kind_md_pair.second);
+  }
+}
+
 IrArray IrArray::CastToShape(const Shape& new_shape,
                              llvm::IRBuilder<>* ir_builder) const {
   llvm::Type* new_ir_type = llvm_ir::ShapeToIrType(new_shape, ir_builder);
@@ -208,6 +208,12 @@ class IrArray {
   void EmitWriteArrayElement(const Index& index, llvm::Value* value,
                              llvm::IRBuilder<>* ir_builder) const;
 
+  // Attaches the metadata that EmitReadArrayElement and EmitWriteArrayElement
+  // would attach to 'instruction', a load from or store to elements of this
+  // array that was emitted by other means (e.g. a vector load).
+  void AnnotateLoadStoreInstructionWithMetadata(
+      llvm::Instruction* instruction) const;
+
   // Returns a new IrArray whose shape is "new_shape" and base pointer is a
   // bitcast of the base pointer of "this" IrArray.
   IrArray CastToShape(const Shape& new_shape,
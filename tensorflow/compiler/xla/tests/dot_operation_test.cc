@@ -18,21 +18,31 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/array2d.h"
 #include "tensorflow/compiler/xla/array3d.h"
+#include "tensorflow/compiler/xla/client/client_library.h"
 #include "tensorflow/compiler/xla/client/computation_builder.h"
 #include "tensorflow/compiler/xla/client/local_client.h"
 #include "tensorflow/compiler/xla/legacy_flags/debug_options_flags.h"
 #include "tensorflow/compiler/xla/legacy_flags/layout_util_flags.h"
 #include "tensorflow/compiler/xla/primitive_util.h"
 #include "tensorflow/compiler/xla/reference_util.h"
+#include "tensorflow/compiler/xla/service/device_memory_allocator.h"
+#include "tensorflow/compiler/xla/service/platform_util.h"
+#include "tensorflow/compiler/xla/service/shaped_buffer.h"
+#include "tensorflow/compiler/xla/service/transfer_manager.h"
 #include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/test_helpers.h"
 #include "tensorflow/compiler/xla/tests/client_library_test_base.h"
 #include "tensorflow/compiler/xla/tests/literal_test_util.h"
 #include "tensorflow/compiler/xla/tests/test_macros.h"
 #include "tensorflow/compiler/xla/tests/test_utils.h"
+#include "tensorflow/core/platform/stream_executor_no_cuda.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/command_line_flags.h"
 
+namespace se = ::perftools::gputools;
+
 namespace xla {
 namespace {
 
@@ -258,6 +268,28 @@ XLA_TEST_F(DotOperationTest, MatrixDotF32_260_3_520_MinorToMajorFF) {
   TestMatrixDot(260, 3, 520, false, false);
 }
 
+// Shapes whose rows and columns do not divide evenly into the tiles of the
+// CPU backend's inline matrix multiply.
+XLA_TEST_F(DotOperationTest, MatrixDotF32_17_9_33_MinorToMajorTT) {
+  TestMatrixDot(17, 9, 33, true, true);
+}
+
+XLA_TEST_F(DotOperationTest, MatrixDotF32_17_9_33_MinorToMajorFT) {
+  TestMatrixDot(17, 9, 33, false, true);
+}
+
+XLA_TEST_F(DotOperationTest, MatrixDotF32_4_31_16_MinorToMajorTT) {
+  TestMatrixDot(4, 31, 16, true, true);
+}
+
+XLA_TEST_F(DotOperationTest, MatrixDotF32_3_200_70_MinorToMajorTT) {
+  TestMatrixDot(3, 200, 70, true, true);
+}
+
+XLA_TEST_F(DotOperationTest, MatrixDotF32_1_64_129_MinorToMajorFT) {
+  TestMatrixDot(1, 64, 129, false, true);
+}
+
 XLA_TEST_F(DotOperationTest, SquareMatrixDotF32MinorToMajorFF) {
   constexpr bool kLhsRowMajor = false;
   constexpr bool kRhsRowMajor = false;
@@ -453,6 +485,90 @@ TEST_F(DotOperationTest, TransposeFolding) {
   }
 }
 
+// Benchmarks a single M x K by K x N matrix multiply with row-major operands.
+// Run with --xla_cpu_tiled_dot=false to compare against the runtime call.
+void BM_DotF32(int num_iters, int shape_index) {
+  tensorflow::testing::StopTiming();
+
+  // {M, K, N} for each benchmark argument.
+  static const int64 kShapes[][3] = {
+      {4, 64, 64},   {16, 16, 16},  {32, 32, 32},    {64, 64, 64},
+      {1, 256, 512}, {8, 512, 256}, {16, 256, 1024}, {256, 256, 256}};
+  const int64 m = kShapes[shape_index][0];
+  const int64 k = kShapes[shape_index][1];
+  const int64 n = kShapes[shape_index][2];
+
+  se::Platform* platform = PlatformUtil::GetDefaultPlatform().ValueOrDie();
+  auto executors = PlatformUtil::GetStreamExecutors(platform).ValueOrDie();
+  StreamExecutorMemoryAllocator allocator(platform, executors);
+  LocalClient* client =
+      ClientLibrary::GetOrCreateLocalClient(platform).ValueOrDie();
+  auto* transfer_manager =
+      TransferManager::GetForPlatform(platform).ValueOrDie();
+  int device_ordinal = client->default_device_ordinal();
+
+  ComputationBuilder builder(client, "DotF32");
+  Shape lhs_shape = ShapeUtil::MakeShapeWithLayout(F32, {m, k}, {1, 0});
+  Shape rhs_shape = ShapeUtil::MakeShapeWithLayout(F32, {k, n}, {1, 0});
+  builder.Dot(builder.Parameter(0, lhs_shape, "lhs"),
+              builder.Parameter(1, rhs_shape, "rhs"));
+  auto computation = builder.Build().ConsumeValueOrDie();
+
+  // Initialize and transfer the parameter buffers.
+  auto lhs_literal =
+      Literal::CreateR2FromArray2D(*MakeLinspaceArray2D(0.0, 1.0, m, k));
+  auto rhs_literal =
+      Literal::CreateR2FromArray2D(*MakeLinspaceArray2D(0.0, 1.0, k, n));
+  auto lhs_buffer =
+      ScopedShapedBuffer::MakeScopedShapedBuffer(lhs_shape, &allocator, 0)
+          .ConsumeValueOrDie();
+  auto rhs_buffer =
+      ScopedShapedBuffer::MakeScopedShapedBuffer(rhs_shape, &allocator, 0)
+          .ConsumeValueOrDie();
+  ASSERT_IS_OK(transfer_manager->TransferLiteralToDevice(
+      executors[device_ordinal], *lhs_literal,
+      lhs_buffer->mutable_buffer({})));
+  ASSERT_IS_OK(transfer_manager->TransferLiteralToDevice(
+      executors[device_ordinal], *rhs_literal,
+      rhs_buffer->mutable_buffer({})));
+
+  std::unique_ptr<LocalExecutable> executable =
+      client
+          ->Compile(computation, {&lhs_buffer->shape(), &rhs_buffer->shape()},
+                    ExecutableBuildOptions())
+          .ConsumeValueOrDie();
+
+  // Run some warm-up executions.
+  ExecutableRunOptions options;
+  options.set_allocator(&allocator);
+  const int kWarmups = 2;
+  for (int i = 0; i < kWarmups; ++i) {
+    auto result =
+        executable->Run({lhs_buffer.get(), rhs_buffer.get()}, options);
+    ASSERT_TRUE(result.ok());
+  }
+
+  // Run benchmark.
+  tensorflow::testing::ItemsProcessed(static_cast<int64>(num_iters) * m * n *
+                                      k * 2);
+  tensorflow::testing::UseRealTime();
+  tensorflow::testing::StartTiming();
+  for (int i = 0; i < num_iters; ++i) {
+    auto result =
+        executable->Run({lhs_buffer.get(), rhs_buffer.get()}, options);
+    ASSERT_TRUE(result.ok());
+  }
+}
+BENCHMARK(BM_DotF32)
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(3)
+    ->Arg(4)
+    ->Arg(5)
+    ->Arg(6)
+    ->Arg(7);
+
 }  // namespace
 }  // namespace xla
 
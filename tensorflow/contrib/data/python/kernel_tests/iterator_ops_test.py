@@ -17,6 +17,8 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import os
+
 import numpy as np
 
 from tensorflow.contrib.data.python.ops import dataset_ops
@@ -26,11 +28,13 @@ from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import errors
 from tensorflow.python.framework import ops
+from tensorflow.python.lib.io import python_io
 from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import gradients_impl
 from tensorflow.python.ops import math_ops
 from tensorflow.python.platform import test
 from tensorflow.python.training import server_lib
+from tensorflow.python.util import compat
 
 
 class IteratorTest(test.TestCase):
@@ -376,6 +380,140 @@ class IteratorTest(test.TestCase):
         sess.run(next_element,
                  feed_dict={handle_placeholder: iterator_4_handle})
 
+  def _testSaveRestore(self, make_dataset, num_outputs, break_point):
+    path = os.path.join(self.get_temp_dir(), "iterator")
+
+    def _build_graph():
+      iterator = make_dataset().make_initializable_iterator()
+      return (iterator.initializer, iterator.get_next(),
+              iterator.save_op(path), iterator.restore_op(path))
+
+    # Produce the expected outputs from an uninterrupted iterator.
+    with ops.Graph().as_default() as g:
+      init_op, get_next, _, _ = _build_graph()
+      with self.test_session(graph=g) as sess:
+        sess.run(init_op)
+        expected = [sess.run(get_next) for _ in range(num_outputs)]
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(get_next)
+
+    with ops.Graph().as_default() as g:
+      init_op, get_next, save_op, _ = _build_graph()
+      with self.test_session(graph=g) as sess:
+        sess.run(init_op)
+        for i in range(break_point):
+          self.assertAllEqual(expected[i], sess.run(get_next))
+        sess.run(save_op)
+
+    # Restore into a fresh iterator in a new session.
+    with ops.Graph().as_default() as g:
+      init_op, get_next, _, restore_op = _build_graph()
+      with self.test_session(graph=g) as sess:
+        sess.run(init_op)
+        sess.run(restore_op)
+        for i in range(break_point, num_outputs):
+          self.assertAllEqual(expected[i], sess.run(get_next))
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(get_next)
+
+  def testSaveRestoreRange(self):
+    self._testSaveRestore(lambda: dataset_ops.Dataset.range(10), 10, 4)
+
+  def testSaveRestoreMapAndBatch(self):
+    self._testSaveRestore(
+        lambda: dataset_ops.Dataset.range(20).map(lambda x: x * x).batch(3),
+        7, 3)
+
+  def testSaveRestoreRepeat(self):
+    self._testSaveRestore(
+        lambda: dataset_ops.Dataset.from_tensor_slices([1, 2, 3]).repeat(4),
+        12, 5)
+
+  def testSaveRestoreShuffle(self):
+    self._testSaveRestore(
+        lambda: dataset_ops.Dataset.range(30).shuffle(10, seed=37).repeat(2),
+        60, 17)
+
+  def _createTextLineFiles(self, num_files, num_lines):
+    filenames = []
+    for i in range(num_files):
+      fn = os.path.join(self.get_temp_dir(), "text_line.%d.txt" % i)
+      filenames.append(fn)
+      with open(fn, "wb") as f:
+        for j in range(num_lines):
+          f.write(compat.as_bytes("%d: %d\n" % (i, j)))
+    return filenames
+
+  def testSaveRestoreTextLineMidFile(self):
+    filenames = self._createTextLineFiles(2, 5)
+    self._testSaveRestore(lambda: dataset_ops.TextLineDataset(filenames),
+                          10, 2)
+
+  def testSaveRestoreTextLineAtFileBoundary(self):
+    # The state is saved after the last line of the first file, before the
+    # iterator has seen the end of that file.
+    filenames = self._createTextLineFiles(2, 5)
+    self._testSaveRestore(lambda: dataset_ops.TextLineDataset(filenames),
+                          10, 5)
+
+  def testSaveRestoreFixedLengthRecordMidFile(self):
+    filenames = []
+    for i in range(2):
+      fn = os.path.join(self.get_temp_dir(), "fixed_length_record.%d.txt" % i)
+      filenames.append(fn)
+      with open(fn, "wb") as f:
+        f.write(b"H" * 5)
+        for j in range(7):
+          f.write(compat.as_bytes(str(i * 2 + j) * 3))
+        f.write(b"F" * 2)
+
+    def _make_dataset():
+      return dataset_ops.FixedLengthRecordDataset(
+          filenames, 3, header_bytes=5, footer_bytes=2)
+
+    self._testSaveRestore(_make_dataset, 14, 3)
+
+  def _createTFRecordFiles(self, num_files, num_records, options=None):
+    filenames = []
+    for i in range(num_files):
+      fn = os.path.join(self.get_temp_dir(), "tf_record.%d.txt" % i)
+      filenames.append(fn)
+      writer = python_io.TFRecordWriter(fn, options=options)
+      for j in range(num_records):
+        writer.write(compat.as_bytes("Record %d of file %d" % (j, i)))
+      writer.close()
+    return filenames
+
+  def testSaveRestoreTFRecordMidFile(self):
+    filenames = self._createTFRecordFiles(2, 5)
+    self._testSaveRestore(lambda: dataset_ops.TFRecordDataset(filenames),
+                          10, 3)
+
+  def testSaveRestoreCompressedTFRecordMidFile(self):
+    filenames = self._createTFRecordFiles(
+        2, 5, options=python_io.TFRecordOptions(
+            python_io.TFRecordCompressionType.GZIP))
+    self._testSaveRestore(
+        lambda: dataset_ops.TFRecordDataset(filenames, "GZIP"), 10, 3)
+
+  def testSaveRestoreCache(self):
+    # The state is saved while the in-memory cache is being filled, and the
+    # second epoch reads the restored cache.
+    self._testSaveRestore(
+        lambda: dataset_ops.Dataset.range(5).cache().repeat(2), 10, 3)
+
+  def testSaveRestoreAtEndOfSequence(self):
+    self._testSaveRestore(lambda: dataset_ops.Dataset.range(5), 5, 5)
+
+  def testSaveUninitializedIteratorFails(self):
+    path = os.path.join(self.get_temp_dir(), "iterator")
+    iterator = dataset_ops.Dataset.range(10).make_initializable_iterator()
+    save_op = iterator.save_op(path)
+    with self.test_session() as sess:
+      with self.assertRaisesRegexp(errors.FailedPreconditionError,
+                                   "not been initialized"):
+        sess.run(save_op)
+
 
 if __name__ == "__main__":
   test.main()
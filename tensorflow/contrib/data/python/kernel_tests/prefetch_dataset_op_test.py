@@ -0,0 +1,108 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the experimental input pipeline ops."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import numpy as np
+
+from tensorflow.contrib.data.python.ops import dataset_ops
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import errors
+from tensorflow.python.ops import array_ops
+from tensorflow.python.platform import test
+
+
+class PrefetchDatasetTest(test.TestCase):
+
+  def testPrefetchDataset(self):
+    components = (np.arange(7),
+                  np.array([[1, 2, 3]]) * np.arange(7)[:, np.newaxis],
+                  np.array(37.0) * np.arange(7))
+    buffer_size_placeholder = array_ops.placeholder(dtypes.int64, shape=[])
+
+    iterator = (dataset_ops.Dataset.from_tensor_slices(components)
+                .repeat(3)
+                .prefetch(buffer_size_placeholder)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    self.assertEqual([c.shape[1:] for c in components],
+                     [t.shape for t in get_next])
+
+    with self.test_session() as sess:
+      # The elements are produced in order for any buffer size.
+      for buffer_size in [1, 3, 100]:
+        sess.run(init_op, feed_dict={buffer_size_placeholder: buffer_size})
+        for _ in range(3):
+          for i in range(7):
+            result = sess.run(get_next)
+            for component, result_component in zip(components, result):
+              self.assertAllEqual(component[i], result_component)
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(get_next)
+
+  def testPrefetchDatasetInvalidBufferSize(self):
+    buffer_size_placeholder = array_ops.placeholder(dtypes.int64, shape=[])
+    iterator = (dataset_ops.Dataset.range(10)
+                .prefetch(buffer_size_placeholder)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+
+    with self.test_session() as sess:
+      with self.assertRaisesRegexp(errors.InvalidArgumentError, "buffer_size"):
+        sess.run(init_op, feed_dict={buffer_size_placeholder: 0})
+
+  def testPrefetchDatasetForwardsErrors(self):
+    components = np.array([1., 2., 3., np.nan, 5.]).astype(np.float32)
+
+    iterator = (dataset_ops.Dataset.from_tensor_slices(components)
+                .map(lambda x: array_ops.check_numerics(x, "message"))
+                .prefetch(2)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      sess.run(init_op)
+      for x in [1., 2., 3.]:
+        self.assertEqual(x, sess.run(get_next))
+      # The failed element is reported, and later elements are still
+      # produced.
+      with self.assertRaises(errors.InvalidArgumentError):
+        sess.run(get_next)
+      self.assertEqual(5., sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+  def testPrefetchDatasetIteratorDisposedEarly(self):
+    iterator = (dataset_ops.Dataset.range(1000)
+                .prefetch(10)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      # Re-initializing destroys the previous iterator while its
+      # prefetch thread is blocked on a full buffer.
+      for _ in range(5):
+        sess.run(init_op)
+        self.assertEqual(0, sess.run(get_next))
+
+
+if __name__ == "__main__":
+  test.main()
@@ -366,6 +366,35 @@ class TFRecordDatasetTest(test.TestCase):
       with self.assertRaises(errors.OutOfRangeError):
         sess.run(self.get_next)
 
+  def _testReadSnappyFiles(self, compression_type):
+    options = python_io.TFRecordOptions(compression_type)
+    compression_type_string = (
+        python_io.TFRecordOptions.get_compression_type_string(options))
+    snappy_files = []
+    for i in range(self._num_files):
+      fn = os.path.join(self.get_temp_dir(), "tfrecord_%s.snappy" % i)
+      snappy_files.append(fn)
+      writer = python_io.TFRecordWriter(fn, options=options)
+      for j in range(self._num_records):
+        writer.write(self._record(i, j))
+      writer.close()
+
+    with self.test_session() as sess:
+      sess.run(self.init_op,
+               feed_dict={self.filenames: snappy_files,
+                          self.compression_type: compression_type_string})
+      for j in range(self._num_files):
+        for i in range(self._num_records):
+          self.assertAllEqual(self._record(j, i), sess.run(self.get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(self.get_next)
+
+  def testReadSnappyFiles(self):
+    self._testReadSnappyFiles(python_io.TFRecordCompressionType.SNAPPY)
+
+  def testReadSnappyBlockFiles(self):
+    self._testReadSnappyFiles(python_io.TFRecordCompressionType.SNAPPY_BLOCK)
+
 
 class ReadBatchFeaturesTest(test.TestCase):
 
@@ -317,6 +317,40 @@ class Iterator(object):
     """
     return gen_dataset_ops.iterator_dispose(self._iterator_resource, name=name)
 
+  def save_op(self, path, name=None):
+    """Returns a `tf.Operation` that saves the state of this iterator.
+
+    The state is written as a tensor bundle with the given path prefix, and
+    can be restored with `restore_op()` into an iterator over an identically
+    defined dataset.
+
+    Args:
+      path: A `tf.string` scalar `tf.Tensor` containing the path prefix.
+      name: (Optional.) A name for the created operation.
+
+    Returns:
+      A `tf.Operation`.
+    """
+    return gen_dataset_ops.save_iterator(self._iterator_resource, path,
+                                         name=name)
+
+  def restore_op(self, path, name=None):
+    """Returns a `tf.Operation` that restores the state of this iterator.
+
+    The iterator must have been initialized before the returned operation is
+    run.
+
+    Args:
+      path: A `tf.string` scalar `tf.Tensor` containing the path prefix that
+        was passed to `save_op()`.
+      name: (Optional.) A name for the created operation.
+
+    Returns:
+      A `tf.Operation`.
+    """
+    return gen_dataset_ops.restore_iterator(self._iterator_resource, path,
+                                            name=name)
+
   def string_handle(self, name=None):
     """Returns a string-valued `tf.Tensor` that represents this iterator.
 
@@ -1071,6 +1105,21 @@ class Dataset(object):
     """
     return FilterDataset(self, predicate)
 
+  def prefetch(self, buffer_size):
+    """Creates a `Dataset` that prefetches elements from this dataset.
+
+    Elements are produced on a background thread, so that the input pipeline
+    runs concurrently with the computation that consumes its elements.
+
+    Args:
+      buffer_size: A `tf.int64` scalar `tf.Tensor`, representing the
+        maximum number of elements that will be buffered when prefetching.
+
+    Returns:
+      A `Dataset`.
+    """
+    return PrefetchDataset(self, buffer_size)
+
 
 class TensorDataset(Dataset):
   """A `Dataset` with a single element, viz. a nested structure of tensors."""
@@ -1376,6 +1425,32 @@ class ShuffleDataset(Dataset):
     return self._input_dataset.output_types
 
 
+class PrefetchDataset(Dataset):
+  """A `Dataset` that asynchronously prefetches its input."""
+
+  def __init__(self, input_dataset, buffer_size):
+    """See `Dataset.prefetch()` for details."""
+    super(PrefetchDataset, self).__init__()
+    self._input_dataset = input_dataset
+    self._buffer_size = ops.convert_to_tensor(
+        buffer_size, dtype=dtypes.int64, name="buffer_size")
+
+  def make_dataset_resource(self):
+    return gen_dataset_ops.prefetch_dataset(
+        self._input_dataset.make_dataset_resource(),
+        buffer_size=self._buffer_size,
+        output_shapes=nest.flatten(self.output_shapes),
+        output_types=nest.flatten(self.output_types))
+
+  @property
+  def output_shapes(self):
+    return self._input_dataset.output_shapes
+
+  @property
+  def output_types(self):
+    return self._input_dataset.output_types
+
+
 class TakeDataset(Dataset):
   """A `Dataset` containing the first `count` elements from its input."""
 
@@ -1974,7 +2049,7 @@ class TFRecordDataset(Dataset):
     Args:
       filenames: A `tf.string` tensor containing one or more filenames.
       compression_type: A `tf.string` scalar evaluating to one of `""` (no
-        compression), `"ZLIB"`, or `"GZIP"`.
+        compression), `"ZLIB"`, `"GZIP"`, `"SNAPPY"`, or `"SNAPPY_BLOCK"`.
     """
     super(TFRecordDataset, self).__init__()
     self._filenames = ops.convert_to_tensor(filenames, name="filenames")
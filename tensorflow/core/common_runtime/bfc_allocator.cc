@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/bfc_allocator.h"
 
+#include <thread>
+
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
@@ -22,13 +24,15 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
 
 BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
-                           bool allow_growth, const string& name)
+                           bool allow_growth, const string& name,
+                           bool use_chunk_cache, bool flat_free_chunk_index)
     : suballocator_(sub_allocator),
       name_(name),
       free_chunks_list_(kInvalidChunkHandle),
@@ -55,7 +59,7 @@ BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
     size_t bin_size = BinNumToSize(b);
     VLOG(1) << "Creating bin of max chunk size "
             << strings::HumanReadableNumBytes(bin_size);
-    new (BinFromIndex(b)) Bin(this, bin_size);
+    new (BinFromIndex(b)) Bin(bin_size, flat_free_chunk_index);
     CHECK_EQ(BinForSize(bin_size), BinFromIndex(b));
     CHECK_EQ(BinForSize(bin_size + 255), BinFromIndex(b));
     CHECK_EQ(BinForSize(bin_size * 2 - 1), BinFromIndex(b));
@@ -63,6 +67,11 @@ BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
       CHECK_NE(BinForSize(bin_size * 2), BinFromIndex(b));
     }
   }
+
+  if (use_chunk_cache) {
+    chunk_cache_.reset(
+        new ChunkCache(std::max(1, port::NumSchedulableCPUs())));
+  }
 }
 
 BFCAllocator::~BFCAllocator() {
@@ -249,27 +258,31 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
   // so all memory addresses are nicely byte aligned.
   size_t rounded_bytes = RoundedBytes(num_bytes);
 
+  if (chunk_cache_ != nullptr && rounded_bytes <= kMaxCachedChunkSize) {
+    void* ptr = AllocateFromChunkCache(rounded_bytes, num_bytes);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+  }
+
   // The BFC allocator tries to find the best fit first.
   BinNum bin_num = BinNumForSize(rounded_bytes);
 
-  mutex_lock l(lock_);
-  void* ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
+  void* ptr = AllocateFromBins(bin_num, rounded_bytes, num_bytes);
+  if (ptr == nullptr && chunk_cache_ != nullptr && FlushChunkCache()) {
+    // The chunks that were parked in the cache may coalesce into a chunk
+    // that is large enough.
+    ptr = AllocateFromBins(bin_num, rounded_bytes, num_bytes);
+  }
   if (ptr != nullptr) {
     return ptr;
   }
 
-  // Try to extend
-  if (Extend(rounded_bytes)) {
-    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
-    if (ptr != nullptr) {
-      return ptr;
-    }
-  }
-
   // We searched all bins for an existing free chunk to use and
   // couldn't find one.  This means we must have run out of memory,
   // Dump the memory log for analysis.
   if (dump_log_on_failure) {
+    mutex_lock l(lock_);
     LOG(WARNING) << "Allocator (" << Name() << ") ran out of memory trying "
                  << "to allocate " << strings::HumanReadableNumBytes(num_bytes)
                  << ".  Current allocation summary follows.";
@@ -279,6 +292,161 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
   return nullptr;
 }
 
+void* BFCAllocator::AllocateFromBins(BinNum bin_num, size_t rounded_bytes,
+                                     size_t num_bytes) {
+  mutex_lock l(lock_);
+  void* ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
+  if (ptr != nullptr) {
+    return ptr;
+  }
+
+  // Try to extend
+  if (Extend(rounded_bytes)) {
+    ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
+  }
+  return ptr;
+}
+
+BFCAllocator::ChunkCache::FreeShard* BFCAllocator::FreeShardForCurrentThread() {
+  const size_t h = std::hash<std::thread::id>()(std::this_thread::get_id());
+  return &chunk_cache_->free_shards[h % chunk_cache_->free_shards.size()];
+}
+
+BFCAllocator::ChunkCache::InfoShard* BFCAllocator::InfoShardFor(
+    const void* ptr) {
+  const size_t h = reinterpret_cast<uintptr_t>(ptr) >> kMinAllocationBits;
+  return &chunk_cache_->info_shards[h % chunk_cache_->info_shards.size()];
+}
+
+int BFCAllocator::ChunkCacheTransferCount(size_t rounded_bytes) const {
+  return std::max<int>(
+      1, std::min<size_t>(kMaxChunkCacheTransferCount,
+                          kChunkCacheTransferBytes / rounded_bytes));
+}
+
+bool BFCAllocator::FindCachedChunkInfo(const void* ptr, CachedChunkInfo* info) {
+  ChunkCache::InfoShard* info_shard = InfoShardFor(ptr);
+  mutex_lock l(info_shard->mu);
+  auto it = info_shard->chunks.find(ptr);
+  if (it == info_shard->chunks.end()) {
+    return false;
+  }
+  *info = it->second;
+  return true;
+}
+
+void* BFCAllocator::AllocateFromChunkCache(size_t rounded_bytes,
+                                           size_t num_bytes) {
+  const int size_class = rounded_bytes / kMinAllocationSize - 1;
+  ChunkCache::FreeShard* shard = FreeShardForCurrentThread();
+  void* ptr = nullptr;
+  {
+    mutex_lock l(shard->mu);
+    std::vector<void*>& free_ptrs = shard->free_ptrs[size_class];
+    if (!free_ptrs.empty()) {
+      ptr = free_ptrs.back();
+      free_ptrs.pop_back();
+    }
+  }
+  if (ptr != nullptr) {
+    ChunkCache::InfoShard* info_shard = InfoShardFor(ptr);
+    mutex_lock l(info_shard->mu);
+    info_shard->chunks[ptr].requested_bytes = num_bytes;
+    return ptr;
+  }
+
+  // Refill: take a batch of chunks out of the bins under one acquisition of
+  // lock_. Do not extend here; a miss falls back to the regular path.
+  std::vector<void*> batch;
+  const int transfer_count = ChunkCacheTransferCount(rounded_bytes);
+  {
+    mutex_lock l(lock_);
+    const BinNum bin_num = BinNumForSize(rounded_bytes);
+    for (int i = 0; i < transfer_count; ++i) {
+      void* p = FindChunkPtr(bin_num, rounded_bytes, rounded_bytes);
+      if (p == nullptr) break;
+      batch.push_back(p);
+    }
+  }
+  if (batch.empty()) {
+    return nullptr;
+  }
+  // Record ownership before any of the chunks can be handed out.
+  for (void* p : batch) {
+    CachedChunkInfo info;
+    info.rounded_bytes = rounded_bytes;
+    info.requested_bytes = (p == batch.front()) ? num_bytes : 0;
+    ChunkCache::InfoShard* info_shard = InfoShardFor(p);
+    mutex_lock l(info_shard->mu);
+    info_shard->chunks[p] = info;
+  }
+  if (batch.size() > 1) {
+    mutex_lock l(shard->mu);
+    std::vector<void*>& free_ptrs = shard->free_ptrs[size_class];
+    free_ptrs.insert(free_ptrs.end(), batch.begin() + 1, batch.end());
+  }
+  return batch.front();
+}
+
+bool BFCAllocator::DeallocateToChunkCache(void* ptr) {
+  CachedChunkInfo info;
+  if (!FindCachedChunkInfo(ptr, &info)) {
+    return false;
+  }
+  const int size_class = info.rounded_bytes / kMinAllocationSize - 1;
+  const int transfer_count = ChunkCacheTransferCount(info.rounded_bytes);
+  std::vector<void*> overflow;
+  {
+    ChunkCache::FreeShard* shard = FreeShardForCurrentThread();
+    mutex_lock l(shard->mu);
+    std::vector<void*>& free_ptrs = shard->free_ptrs[size_class];
+    free_ptrs.push_back(ptr);
+    if (free_ptrs.size() > 2 * transfer_count) {
+      // Return the least recently freed chunks, which are the least likely
+      // to still be in cache.
+      overflow.assign(free_ptrs.begin(), free_ptrs.begin() + transfer_count);
+      free_ptrs.erase(free_ptrs.begin(), free_ptrs.begin() + transfer_count);
+    }
+  }
+  if (!overflow.empty()) {
+    ReturnCachedChunksToBins(overflow);
+  }
+  return true;
+}
+
+void BFCAllocator::ReturnCachedChunksToBins(const std::vector<void*>& ptrs) {
+  // Drop the cache's ownership records first, so that a record created by a
+  // later refill that reuses the same address is never erased.
+  for (void* p : ptrs) {
+    ChunkCache::InfoShard* info_shard = InfoShardFor(p);
+    mutex_lock l(info_shard->mu);
+    info_shard->chunks.erase(p);
+  }
+  mutex_lock l(lock_);
+  for (void* p : ptrs) {
+    BFCAllocator::ChunkHandle h = region_manager_.get_handle(p);
+    CHECK(h != kInvalidChunkHandle);
+    FreeAndMaybeCoalesce(h);
+  }
+}
+
+bool BFCAllocator::FlushChunkCache() {
+  std::vector<void*> ptrs;
+  for (auto& shard : chunk_cache_->free_shards) {
+    mutex_lock l(shard.mu);
+    for (auto& free_ptrs : shard.free_ptrs) {
+      ptrs.insert(ptrs.end(), free_ptrs.begin(), free_ptrs.end());
+      free_ptrs.clear();
+    }
+  }
+  if (ptrs.empty()) {
+    return false;
+  }
+  VLOG(1) << "Returning " << ptrs.size() << " cached chunks to the bins.";
+  ReturnCachedChunksToBins(ptrs);
+  return true;
+}
+
 void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
                                  size_t num_bytes) {
   // First identify the first bin that could satisfy rounded_bytes.
@@ -286,48 +454,48 @@ void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
     // Start searching from the first bin for the smallest chunk that fits
     // rounded_bytes.
     Bin* b = BinFromIndex(bin_num);
-    for (auto citer = b->free_chunks.begin(); citer != b->free_chunks.end();
-         ++citer) {
-      const BFCAllocator::ChunkHandle h = (*citer);
-      BFCAllocator::Chunk* chunk = ChunkFromHandle(h);
-      DCHECK(!chunk->in_use());
-      if (chunk->size >= rounded_bytes) {
-        // We found an existing chunk that fits us that wasn't in use, so remove
-        // it from the free bin structure prior to using.
-        RemoveFreeChunkIterFromBin(&b->free_chunks, citer);
-
-        // If we can break the size of the chunk into two reasonably
-        // large pieces, do so.
-        //
-        // TODO(vrv): What should be the criteria when deciding when
-        // to split?
-        if (chunk->size >= rounded_bytes * 2) {
-          SplitChunk(h, rounded_bytes);
-          chunk = ChunkFromHandle(h);  // Update chunk pointer in case it moved
-        }
+    // The index is sorted by size, so its first chunk of at least
+    // rounded_bytes is the best fit in this bin. It is removed from the
+    // index prior to using.
+    const BFCAllocator::ChunkHandle h =
+        b->free_chunks.RemoveBestFit(rounded_bytes);
+    if (h == kInvalidChunkHandle) {
+      continue;
+    }
+    BFCAllocator::Chunk* chunk = ChunkFromHandle(h);
+    CHECK(!chunk->in_use() && (chunk->bin_num != kInvalidBinNum));
+    chunk->bin_num = kInvalidBinNum;
+
+    // If we can break the size of the chunk into two reasonably
+    // large pieces, do so.
+    //
+    // TODO(vrv): What should be the criteria when deciding when
+    // to split?
+    if (chunk->size >= rounded_bytes * 2) {
+      SplitChunk(h, rounded_bytes);
+      chunk = ChunkFromHandle(h);  // Update chunk pointer in case it moved
+    }
 
-        // The requested size of the returned chunk is what the user
-        // has allocated.
-        chunk->requested_size = num_bytes;
-        // Assign a unique id and increment the id counter, marking the
-        // chunk as being in use.
-        chunk->allocation_id = next_allocation_id_++;
-
-        // Update stats.
-        ++stats_.num_allocs;
-        stats_.bytes_in_use += chunk->size;
-        stats_.max_bytes_in_use =
-            std::max(stats_.max_bytes_in_use, stats_.bytes_in_use);
-        stats_.max_alloc_size =
-            std::max<std::size_t>(stats_.max_alloc_size, chunk->size);
-
-        VLOG(4) << "Returning: " << chunk->ptr;
-        if (VLOG_IS_ON(4)) {
-          LOG(INFO) << "A: " << RenderOccupancy();
-        }
-        return chunk->ptr;
-      }
+    // The requested size of the returned chunk is what the user
+    // has allocated.
+    chunk->requested_size = num_bytes;
+    // Assign a unique id and increment the id counter, marking the
+    // chunk as being in use.
+    chunk->allocation_id = next_allocation_id_++;
+
+    // Update stats.
+    ++stats_.num_allocs;
+    stats_.bytes_in_use += chunk->size;
+    stats_.max_bytes_in_use =
+        std::max(stats_.max_bytes_in_use, stats_.bytes_in_use);
+    stats_.max_alloc_size =
+        std::max<std::size_t>(stats_.max_alloc_size, chunk->size);
+
+    VLOG(4) << "Returning: " << chunk->ptr;
+    if (VLOG_IS_ON(4)) {
+      LOG(INFO) << "A: " << RenderOccupancy();
     }
+    return chunk->ptr;
   }
 
   return nullptr;
@@ -378,6 +546,9 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
     LOG(ERROR) << "tried to deallocate nullptr";
     return;
   }
+  if (chunk_cache_ != nullptr && DeallocateToChunkCache(ptr)) {
+    return;
+  }
   mutex_lock l(lock_);
 
   // Find the chunk from the ptr.
@@ -437,23 +608,13 @@ void BFCAllocator::InsertFreeChunkIntoBin(BFCAllocator::ChunkHandle h) {
   BinNum bin_num = BinNumForSize(c->size);
   Bin* new_bin = BinFromIndex(bin_num);
   c->bin_num = bin_num;
-  new_bin->free_chunks.insert(h);
-}
-
-void BFCAllocator::RemoveFreeChunkIterFromBin(
-    BFCAllocator::Bin::FreeChunkSet* free_chunks,
-    const BFCAllocator::Bin::FreeChunkSet::iterator& citer) {
-  ChunkHandle h = *citer;
-  Chunk* c = ChunkFromHandle(h);
-  CHECK(!c->in_use() && (c->bin_num != kInvalidBinNum));
-  free_chunks->erase(citer);
-  c->bin_num = kInvalidBinNum;
+  new_bin->free_chunks.Insert(c->size, c->ptr, h);
 }
 
 void BFCAllocator::RemoveFreeChunkFromBin(BFCAllocator::ChunkHandle h) {
   Chunk* c = ChunkFromHandle(h);
   CHECK(!c->in_use() && (c->bin_num != kInvalidBinNum));
-  CHECK_GT(BinFromIndex(c->bin_num)->free_chunks.erase(h), 0)
+  CHECK(BinFromIndex(c->bin_num)->free_chunks.Erase(c->size, c->ptr))
       << "Could not find chunk in bin";
   c->bin_num = kInvalidBinNum;
 }
@@ -519,6 +680,13 @@ void BFCAllocator::AddAllocVisitor(Visitor visitor) {
 bool BFCAllocator::TracksAllocationSizes() { return true; }
 
 size_t BFCAllocator::RequestedSize(void* ptr) {
+  if (chunk_cache_ != nullptr) {
+    // The bins only know the size requested when the cache took the chunk.
+    CachedChunkInfo info;
+    if (FindCachedChunkInfo(ptr, &info)) {
+      return info.requested_bytes;
+    }
+  }
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -628,7 +796,7 @@ void BFCAllocator::DumpMemoryLog(size_t num_bytes) {
     size_t total_requested_bytes_in_bin = 0;
     size_t total_chunks_in_use = 0;
     size_t total_chunks_in_bin = 0;
-    for (ChunkHandle h : b->free_chunks) {
+    for (ChunkHandle h : b->free_chunks.Handles()) {
       Chunk* c = ChunkFromHandle(h);
       total_bytes_in_bin += c->size;
       total_requested_bytes_in_bin += c->requested_size;
@@ -661,7 +829,7 @@ void BFCAllocator::DumpMemoryLog(size_t num_bytes) {
             << " was " << strings::HumanReadableNumBytes(b->bin_size)
             << ", Chunk State: ";
 
-  for (ChunkHandle h : b->free_chunks) {
+  for (ChunkHandle h : b->free_chunks.Handles()) {
     Chunk* c = ChunkFromHandle(h);
     LOG(INFO) << c->DebugString(this, true);
   }
@@ -16,13 +16,16 @@ limitations under the License.
 #ifndef TENSORFLOW_COMMON_RUNTIME_BFC_ALLOCATOR_H_
 #define TENSORFLOW_COMMON_RUNTIME_BFC_ALLOCATOR_H_
 
+#include <algorithm>
 #include <memory>
+#include <set>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/common_runtime/visitable_allocator.h"
+#include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/macros.h"
@@ -41,11 +44,23 @@ namespace tensorflow {
 // coalescing.  One assumption we make is that the process using this
 // allocator owns pretty much all of the memory, and that nearly
 // all requests to allocate memory go through this interface.
+//
+// If 'use_chunk_cache' is true, small chunks freed by DeallocateRaw are
+// parked in one of several per-thread caches instead of being returned to
+// the bins immediately, and are handed back out by AllocateRaw without
+// taking the allocator-wide lock. Chunks move between a cache and the bins
+// in batches. Cached chunks are still counted as in use by GetStats().
+//
+// If 'flat_free_chunk_index' is true, each bin keeps its free chunks in a
+// sorted vector rather than a balanced tree, which makes best-fit searches
+// a binary search over contiguous memory.
 class BFCAllocator : public VisitableAllocator {
  public:
   // Takes ownership of sub_allocator.
   BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
-               bool allow_growth, const string& name);
+               bool allow_growth, const string& name,
+               bool use_chunk_cache = false,
+               bool flat_free_chunk_index = false);
   ~BFCAllocator() override;
 
   string Name() override { return name_; }
@@ -140,40 +155,142 @@ class BFCAllocator : public VisitableAllocator {
     }
   };
 
-  // A Bin is a collection of similar-sized free chunks.
-  struct Bin {
-    // All chunks in this bin have >= bin_size memory.
-    size_t bin_size = 0;
+  // The free chunks of a bin, sorted first by size and then by address.
+  // Each entry carries a copy of its chunk's size and address, so searches
+  // never have to look up the chunk itself. Backed by a balanced tree, or
+  // by a sorted vector if 'flat' is set.
+  class FreeChunkIndex {
+   public:
+    struct Entry {
+      size_t size;
+      const void* ptr;
+      ChunkHandle handle;
+
+      bool operator<(const Entry& other) const {
+        if (size != other.size) {
+          return size < other.size;
+        }
+        return ptr < other.ptr;
+      }
+    };
+
+    explicit FreeChunkIndex(bool flat) : flat_(flat) {}
 
-    struct ChunkComparator {
-      explicit ChunkComparator(BFCAllocator* allocator)
-          : allocator_(allocator) {}
-      // Sort first by size and then use pointer address as a tie breaker.
-      bool operator()(const ChunkHandle ha,
-                      const ChunkHandle hb) const NO_THREAD_SAFETY_ANALYSIS {
-        const Chunk* a = allocator_->ChunkFromHandle(ha);
-        const Chunk* b = allocator_->ChunkFromHandle(hb);
-        if (a->size != b->size) {
-          return a->size < b->size;
+    void Insert(size_t size, const void* ptr, ChunkHandle h) {
+      const Entry e = {size, ptr, h};
+      if (flat_) {
+        sorted_.insert(std::upper_bound(sorted_.begin(), sorted_.end(), e),
+                       e);
+      } else {
+        tree_.insert(e);
+      }
+    }
+
+    // Removes the entry for the chunk of 'size' bytes at 'ptr'. Returns
+    // false if there is no such entry.
+    bool Erase(size_t size, const void* ptr) {
+      const Entry key = {size, ptr, 0};
+      if (flat_) {
+        auto it = std::lower_bound(sorted_.begin(), sorted_.end(), key);
+        if (it == sorted_.end() || it->ptr != ptr) {
+          return false;
         }
-        return a->ptr < b->ptr;
+        sorted_.erase(it);
+        return true;
       }
+      return tree_.erase(key) > 0;
+    }
 
-     private:
-      BFCAllocator* allocator_;  // The parent allocator
-    };
+    // Removes and returns the smallest chunk of at least 'size' bytes, or
+    // returns kInvalidChunkHandle if there is none.
+    ChunkHandle RemoveBestFit(size_t size) {
+      const Entry key = {size, nullptr, 0};
+      ChunkHandle h = kInvalidChunkHandle;
+      if (flat_) {
+        auto it = std::lower_bound(sorted_.begin(), sorted_.end(), key);
+        if (it != sorted_.end()) {
+          h = it->handle;
+          sorted_.erase(it);
+        }
+      } else {
+        auto it = tree_.lower_bound(key);
+        if (it != tree_.end()) {
+          h = it->handle;
+          tree_.erase(it);
+        }
+      }
+      return h;
+    }
+
+    // Returns the handles of all chunks in the index, in order.
+    std::vector<ChunkHandle> Handles() const {
+      std::vector<ChunkHandle> handles;
+      if (flat_) {
+        for (const Entry& e : sorted_) handles.push_back(e.handle);
+      } else {
+        for (const Entry& e : tree_) handles.push_back(e.handle);
+      }
+      return handles;
+    }
 
-    typedef std::set<ChunkHandle, ChunkComparator> FreeChunkSet;
-    // List of free chunks within the bin, sorted by chunk size.
-    // Chunk * not owned.
-    FreeChunkSet free_chunks;
-    Bin(BFCAllocator* allocator, size_t bs)
-        : bin_size(bs), free_chunks(ChunkComparator(allocator)) {}
+   private:
+    const bool flat_;
+    std::set<Entry> tree_;       // Used if !flat_.
+    std::vector<Entry> sorted_;  // Used if flat_.
+  };
+
+  // A Bin is a collection of similar-sized free chunks.
+  struct Bin {
+    // All chunks in this bin have >= bin_size memory.
+    size_t bin_size = 0;
+
+    // Free chunks within the bin, sorted by chunk size.
+    FreeChunkIndex free_chunks;
+    Bin(size_t bs, bool flat_free_chunk_index)
+        : bin_size(bs), free_chunks(flat_free_chunk_index) {}
   };
 
   static const size_t kMinAllocationBits = 8;
   static const size_t kMinAllocationSize = 1 << kMinAllocationBits;
 
+  // Chunk cache parameters. Requests of up to kMaxCachedChunkSize rounded
+  // bytes are served from the chunk cache; each multiple of
+  // kMinAllocationSize is its own size class. Chunks move between a cache
+  // shard and the bins in batches of about kChunkCacheTransferBytes.
+  static const size_t kMaxCachedChunkSize = 64 << 10;
+  static const int kNumCacheSizeClasses =
+      kMaxCachedChunkSize / kMinAllocationSize;
+  static const size_t kChunkCacheTransferBytes = 64 << 10;
+  static const int kMaxChunkCacheTransferCount = 32;
+
+  // Describes a chunk that is owned by the chunk cache, i.e. that was taken
+  // out of the bins by a cache refill and has not been returned yet.
+  struct CachedChunkInfo {
+    size_t rounded_bytes = 0;
+    size_t requested_bytes = 0;
+  };
+
+  // The chunk cache. Free chunks are kept in 'free_shards', chosen by the
+  // calling thread, while 'info_shards', chosen by pointer, record the
+  // size of every chunk owned by the cache so that DeallocateRaw can find
+  // its size class without taking the allocator-wide lock.
+  struct ChunkCache {
+    struct FreeShard {
+      mutex mu;
+      std::vector<void*> free_ptrs[kNumCacheSizeClasses] GUARDED_BY(mu);
+    };
+    struct InfoShard {
+      mutex mu;
+      gtl::FlatMap<const void*, CachedChunkInfo> chunks GUARDED_BY(mu);
+    };
+
+    explicit ChunkCache(int num_shards)
+        : free_shards(num_shards), info_shards(num_shards) {}
+
+    std::vector<FreeShard> free_shards;
+    std::vector<InfoShard> info_shards;
+  };
+
   // AllocationRegion maps pointers to ChunkHandles for a single
   // contiguous memory region.
   //
@@ -299,6 +416,36 @@ class BFCAllocator : public VisitableAllocator {
   // Returns 'bytes' rounded up to the next highest kMinAllocationSize.
   size_t RoundedBytes(size_t bytes);
 
+  // Finds a free chunk for 'rounded_bytes', extending the memory regions if
+  // necessary. Returns nullptr if there is not enough memory.
+  void* AllocateFromBins(BinNum bin_num, size_t rounded_bytes,
+                         size_t num_bytes) LOCKS_EXCLUDED(lock_);
+
+  // Chunk cache operations; only valid if chunk_cache_ is not null.
+  //
+  // Returns a chunk of 'rounded_bytes' from the calling thread's cache
+  // shard, refilling the shard from the bins if it is empty. Returns
+  // nullptr if the bins cannot satisfy a refill without extending.
+  void* AllocateFromChunkCache(size_t rounded_bytes, size_t num_bytes)
+      LOCKS_EXCLUDED(lock_);
+  // Parks 'ptr' in the calling thread's cache shard if it is owned by the
+  // cache, returning an overflowing batch to the bins. Returns false if
+  // 'ptr' is not owned by the cache.
+  bool DeallocateToChunkCache(void* ptr) LOCKS_EXCLUDED(lock_);
+  // Returns the cached chunks in 'ptrs' to the bins.
+  void ReturnCachedChunksToBins(const std::vector<void*>& ptrs)
+      LOCKS_EXCLUDED(lock_);
+  // Returns every free chunk held by the cache to the bins. Returns true if
+  // any chunk was returned.
+  bool FlushChunkCache() LOCKS_EXCLUDED(lock_);
+  // Looks up the cache's record for 'ptr'; returns false if 'ptr' is not
+  // owned by the cache.
+  bool FindCachedChunkInfo(const void* ptr, CachedChunkInfo* info);
+
+  ChunkCache::FreeShard* FreeShardForCurrentThread();
+  ChunkCache::InfoShard* InfoShardFor(const void* ptr);
+  int ChunkCacheTransferCount(size_t rounded_bytes) const;
+
   // Try to add a new memory region that can satisfy an allocation of
   // 'rounded_bytes' bytes.  Returns true on success and false on
   // failure.
@@ -325,11 +472,6 @@ class BFCAllocator : public VisitableAllocator {
   // Adds the chunk 'h' to the proper free bin.
   void InsertFreeChunkIntoBin(ChunkHandle h) EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
-  // Removes the free chunk pointed to by 'c' from the set free_chunks.
-  void RemoveFreeChunkIterFromBin(Bin::FreeChunkSet* free_chunks,
-                                  const Bin::FreeChunkSet::iterator& c)
-      EXCLUSIVE_LOCKS_REQUIRED(lock_);
-
   // Removes a free chunk from the bin.
   void RemoveFreeChunkFromBin(ChunkHandle h) EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
@@ -411,6 +553,9 @@ class BFCAllocator : public VisitableAllocator {
   // Stats.
   AllocatorStats stats_ GUARDED_BY(lock_);
 
+  // Null unless the allocator was constructed with use_chunk_cache.
+  std::unique_ptr<ChunkCache> chunk_cache_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(BFCAllocator);
 };
 
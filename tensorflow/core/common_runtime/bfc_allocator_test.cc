@@ -0,0 +1,264 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/bfc_allocator.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace {
+
+class TestCPUSubAllocator : public SubAllocator {
+ public:
+  void* Alloc(size_t alignment, size_t num_bytes) override {
+    return port::AlignedMalloc(num_bytes, static_cast<int>(alignment));
+  }
+  void Free(void* ptr, size_t num_bytes) override { port::AlignedFree(ptr); }
+};
+
+// Allocates many small buffers of distinct sizes, checks that none of them
+// overlap, then frees them in random order.
+void CheckNoOverlap(BFCAllocator* a) {
+  std::vector<std::pair<char*, size_t>> ptrs;
+  for (int s = 1; s < 1024; s++) {
+    char* raw = static_cast<char*>(a->AllocateRaw(1, s * 16));
+    ASSERT_NE(nullptr, raw);
+    ptrs.emplace_back(raw, s * 16);
+    EXPECT_LE(s * 16, a->RequestedSize(raw));
+    EXPECT_LE(a->RequestedSize(raw), a->AllocatedSize(raw));
+  }
+  std::sort(ptrs.begin(), ptrs.end());
+  for (size_t i = 1; i < ptrs.size(); i++) {
+    ASSERT_LE(ptrs[i - 1].first + ptrs[i - 1].second, ptrs[i].first);
+  }
+  random::PhiloxRandom philox(123, 17);
+  random::SimplePhilox rand(&philox);
+  for (size_t i = 0; i < ptrs.size(); i++) {
+    std::swap(ptrs[i], ptrs[i + rand.Uniform(ptrs.size() - i)]);
+  }
+  for (const auto& p : ptrs) {
+    a->DeallocateRaw(p.first);
+  }
+}
+
+TEST(BFCAllocatorTest, NoOverlap) {
+  BFCAllocator a(new TestCPUSubAllocator, 1 << 30, true, "test");
+  CheckNoOverlap(&a);
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  EXPECT_EQ(0, stats.bytes_in_use);
+}
+
+TEST(BFCAllocatorTest, NoOverlapWithChunkCache) {
+  BFCAllocator a(new TestCPUSubAllocator, 1 << 30, true, "test",
+                 true /*use_chunk_cache*/);
+  // Run twice so that the second pass is served from the cache.
+  CheckNoOverlap(&a);
+  CheckNoOverlap(&a);
+}
+
+TEST(BFCAllocatorTest, NoOverlapWithFlatFreeChunkIndex) {
+  BFCAllocator a(new TestCPUSubAllocator, 1 << 30, true, "test",
+                 false /*use_chunk_cache*/, true /*flat_free_chunk_index*/);
+  CheckNoOverlap(&a);
+  CheckNoOverlap(&a);
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  EXPECT_EQ(0, stats.bytes_in_use);
+}
+
+TEST(BFCAllocatorTest, FlatFreeChunkIndexFindsBestFit) {
+  BFCAllocator a(new TestCPUSubAllocator, 1 << 30, true, "test",
+                 false /*use_chunk_cache*/, true /*flat_free_chunk_index*/);
+  // Carve out free holes of 3KiB and 2KiB in the same bin, separated by
+  // live allocations so that they cannot coalesce.
+  void* hole3k = a.AllocateRaw(1, 3072);
+  void* sep0 = a.AllocateRaw(1, 256);
+  void* hole2k = a.AllocateRaw(1, 2048);
+  void* sep1 = a.AllocateRaw(1, 256);
+  a.DeallocateRaw(hole3k);
+  a.DeallocateRaw(hole2k);
+  // The smaller hole is the best fit.
+  void* p = a.AllocateRaw(1, 2048);
+  EXPECT_EQ(hole2k, p);
+  void* q = a.AllocateRaw(1, 3072);
+  EXPECT_EQ(hole3k, q);
+  for (void* ptr : {p, q, sep0, sep1}) {
+    a.DeallocateRaw(ptr);
+  }
+}
+
+TEST(BFCAllocatorTest, ChunkCacheReusesFreedChunk) {
+  BFCAllocator a(new TestCPUSubAllocator, 1 << 30, true, "test",
+                 true /*use_chunk_cache*/);
+  void* p = a.AllocateRaw(1, 1000);
+  a.DeallocateRaw(p);
+  void* q = a.AllocateRaw(1, 1000);
+  EXPECT_EQ(p, q);
+  EXPECT_EQ(1000, a.RequestedSize(q));
+  a.DeallocateRaw(q);
+}
+
+TEST(BFCAllocatorTest, ChunkCacheIsFlushedWhenOutOfMemory) {
+  const size_t kLimit = 1 << 20;
+  BFCAllocator a(new TestCPUSubAllocator, kLimit, false, "test",
+                 true /*use_chunk_cache*/);
+  // Fill the whole region with cacheable chunks, then free them all; some
+  // of them stay parked in the cache rather than coalesced in the bins.
+  std::vector<void*> ptrs;
+  for (size_t i = 0; i < kLimit / 4096; i++) {
+    void* p = a.AllocateRaw(1, 4096);
+    ASSERT_NE(nullptr, p);
+    ptrs.push_back(p);
+  }
+  for (void* p : ptrs) {
+    a.DeallocateRaw(p);
+  }
+  // Asking for the whole region only succeeds once every cached chunk has
+  // been returned to the bins and coalesced.
+  AllocationAttributes attr;
+  attr.no_retry_on_failure = true;
+  void* all = a.AllocateRaw(1, kLimit, attr);
+  EXPECT_NE(nullptr, all);
+  a.DeallocateRaw(all);
+}
+
+// Each of 'num_threads' threads repeatedly allocates and frees a few small
+// buffers, as concurrent Session::Run calls on a CPU device do.
+static void BM_AllocationContention(int iters, int num_threads,
+                                    bool use_chunk_cache) {
+  testing::StopTiming();
+  BFCAllocator a(new TestCPUSubAllocator, 1uLL << 33, true, "bench",
+                 use_chunk_cache);
+  thread::ThreadPool pool(Env::Default(), "bench", num_threads);
+  const int iters_per_thread = std::max(1, iters / num_threads);
+  BlockingCounter counter(num_threads);
+  testing::ItemsProcessed(static_cast<int64>(iters_per_thread) * num_threads);
+  testing::StartTiming();
+  for (int t = 0; t < num_threads; t++) {
+    pool.Schedule([&a, &counter, iters_per_thread]() {
+      static const size_t kSizes[] = {256, 1024, 4096, 512, 16384, 64};
+      void* live[4] = {nullptr, nullptr, nullptr, nullptr};
+      for (int i = 0; i < iters_per_thread; i++) {
+        void*& slot = live[i % 4];
+        if (slot != nullptr) a.DeallocateRaw(slot);
+        slot = a.AllocateRaw(1, kSizes[i % 6]);
+      }
+      for (void* p : live) {
+        if (p != nullptr) a.DeallocateRaw(p);
+      }
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  testing::StopTiming();
+}
+
+static void BM_AllocationContentionBins(int iters, int num_threads) {
+  BM_AllocationContention(iters, num_threads, false);
+}
+BENCHMARK(BM_AllocationContentionBins)->Arg(1)->Arg(4)->Arg(16)->Arg(64);
+
+static void BM_AllocationContentionChunkCache(int iters, int num_threads) {
+  BM_AllocationContention(iters, num_threads, true);
+}
+BENCHMARK(BM_AllocationContentionChunkCache)
+    ->Arg(1)
+    ->Arg(4)
+    ->Arg(16)
+    ->Arg(64);
+
+// One step of an allocation trace: allocates 'bytes' into 'slot' if
+// 'bytes' is non-zero, and frees the allocation in 'slot' otherwise.
+struct TraceEvent {
+  int slot;
+  size_t bytes;
+};
+
+// Generates a trace with the shape of a training step: mostly small
+// activations and temporaries, some medium tensors and a few large
+// buffers, with random lifetimes and up to 'max_live' live allocations.
+static std::vector<TraceEvent> GenerateTrace(int num_events, int max_live) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rand(&philox);
+  std::vector<TraceEvent> trace;
+  std::vector<int> live;
+  std::vector<int> free_slots;
+  for (int i = max_live - 1; i >= 0; --i) free_slots.push_back(i);
+  while (trace.size() < num_events) {
+    if (free_slots.empty() || (!live.empty() && rand.OneIn(2))) {
+      const int i = rand.Uniform(live.size());
+      trace.push_back({live[i], 0});
+      free_slots.push_back(live[i]);
+      live[i] = live.back();
+      live.pop_back();
+    } else {
+      size_t bytes;
+      const uint32 kind = rand.Uniform(100);
+      if (kind < 70) {
+        bytes = 256 + rand.Uniform(64 << 10);
+      } else if (kind < 95) {
+        bytes = (64 << 10) + rand.Uniform(4 << 20);
+      } else {
+        bytes = (4 << 20) + rand.Uniform(16 << 20);
+      }
+      const int slot = free_slots.back();
+      free_slots.pop_back();
+      trace.push_back({slot, bytes});
+      live.push_back(slot);
+    }
+  }
+  for (int slot : live) {
+    trace.push_back({slot, 0});
+  }
+  return trace;
+}
+
+// Replays a generated allocation trace against the allocator. Compares the
+// tree-based and flat free chunk indices.
+static void BM_ReplayTrace(int iters, int flat_free_chunk_index) {
+  testing::StopTiming();
+  const std::vector<TraceEvent> trace = GenerateTrace(100000, 1024);
+  BFCAllocator a(new TestCPUSubAllocator, 1uLL << 36, true, "bench",
+                 false /*use_chunk_cache*/, flat_free_chunk_index != 0);
+  std::vector<void*> slots(1024, nullptr);
+  testing::ItemsProcessed(static_cast<int64>(iters) * trace.size());
+  testing::StartTiming();
+  for (int i = 0; i < iters; i++) {
+    for (const TraceEvent& e : trace) {
+      if (e.bytes > 0) {
+        slots[e.slot] = a.AllocateRaw(1, e.bytes);
+      } else {
+        a.DeallocateRaw(slots[e.slot]);
+      }
+    }
+  }
+  testing::StopTiming();
+}
+BENCHMARK(BM_ReplayTrace)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace tensorflow
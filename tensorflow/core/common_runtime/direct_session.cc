@@ -281,6 +281,11 @@ DirectSession::DirectSession(const SessionOptions& options,
   if (!status.ok()) {
     LOG(ERROR) << status.error_message();
   }
+  status = ReadBoolFromEnvVar("TF_EXECUTOR_WORK_STEALING", false,
+                              &use_work_stealing_);
+  if (!status.ok()) {
+    LOG(ERROR) << status.error_message();
+  }
   // NOTE(mrry): We do not need to use a unique string for the session
   // handle, because DirectSession owns its devices. This may change
   // in future versions.
@@ -314,6 +319,7 @@ DirectSession::~DirectSession() {
   for (auto& it : partial_runs_) {
     it.second.reset(nullptr);
   }
+  callables_.clear();
   for (auto& it : executors_) {
     it.second.reset();
   }
@@ -463,8 +469,7 @@ Status DirectSession::Run(const RunOptions& run_options,
   ExecutorsAndKeys* executors_and_keys;
   RunStateArgs run_state_args(run_options.debug_options());
 
-  Executor::Args args;
-  args.step_id = step_id_counter_.fetch_add(1);
+  const int64 step_id = step_id_counter_.fetch_add(1);
 
   TF_RETURN_IF_ERROR(
       GetOrCreateExecutors(pool, input_tensor_names, output_names, target_nodes,
@@ -474,7 +479,7 @@ Status DirectSession::Run(const RunOptions& run_options,
   std::unique_ptr<DebuggerStateInterface> debugger_state;
   if (!run_options.debug_options().debug_tensor_watch_opts().empty()) {
     TF_RETURN_IF_ERROR(CreateDebuggerState(
-        run_options.debug_options(), args.step_id, executor_step_count,
+        run_options.debug_options(), step_id, executor_step_count,
         input_tensor_names, output_names, target_nodes, &debugger_state));
   }
 
@@ -501,11 +506,69 @@ Status DirectSession::Run(const RunOptions& run_options,
     return s;
   }
 
+  TF_RETURN_IF_ERROR(RunInternal(step_id, run_options, pool, &call_frame,
+                                 executors_and_keys, executor_step_count,
+                                 run_state_args.handle, output_names,
+                                 run_metadata));
+
+  // Receive outputs.
+  if (outputs) {
+    std::vector<Tensor> sorted_outputs;
+    Status s = call_frame.ConsumeRetvals(&sorted_outputs);
+    if (errors::IsInternal(s)) {
+      return errors::InvalidArgument(s.error_message());
+    } else if (!s.ok()) {
+      return s;
+    }
+    const bool unique_outputs =
+        output_names.size() == executors_and_keys->output_name_to_index.size();
+    // first_indices[i] = j implies that j is the smallest value for which
+    // output_names[i] == output_names[j].
+    std::vector<int> first_indices;
+    if (!unique_outputs) {
+      first_indices.resize(output_names.size());
+      for (int i = 0; i < output_names.size(); ++i) {
+        for (int j = 0; j <= i; ++j) {
+          if (output_names[i] == output_names[j]) {
+            first_indices[i] = j;
+            break;
+          }
+        }
+      }
+    }
+    outputs->clear();
+    outputs->reserve(sorted_outputs.size());
+    for (int i = 0; i < output_names.size(); ++i) {
+      const string& output_name = output_names[i];
+      if (first_indices.empty() || first_indices[i] == i) {
+        outputs->emplace_back(
+            std::move(sorted_outputs[executors_and_keys
+                                         ->output_name_to_index[output_name]]));
+      } else {
+        outputs->push_back((*outputs)[first_indices[i]]);
+      }
+    }
+  }
+
+  return Status::OK();
+}
+
+Status DirectSession::RunInternal(int64 step_id, const RunOptions& run_options,
+                                  thread::ThreadPool* pool,
+                                  FunctionCallFrame* call_frame,
+                                  ExecutorsAndKeys* executors_and_keys,
+                                  int64 executor_step_count,
+                                  const string& log_memory_handle,
+                                  const std::vector<string>& output_names,
+                                  RunMetadata* run_metadata) {
+  Executor::Args args;
+  args.step_id = step_id;
+
   // Create a run state and start execution.
-  RunState run_state(args.step_id, &devices_);
+  RunState run_state(step_id, &devices_);
   run_state.rendez = new IntraProcessRendezvous(device_mgr_.get());
   CancellationManager step_cancellation_manager;
-  args.call_frame = &call_frame;
+  args.call_frame = call_frame;
 
   // Start parallel Executors.
   const size_t num_executors = executors_and_keys->items.size();
@@ -527,9 +590,12 @@ Status DirectSession::Run(const RunOptions& run_options,
   args.tensor_store = &run_state.tensor_store;
   args.step_container = &run_state.step_container;
   if (LogMemory::IsEnabled()) {
-    LogMemory::RecordStep(args.step_id, run_state_args.handle);
+    LogMemory::RecordStep(step_id, log_memory_handle);
   }
   args.sync_on_finish = sync_on_finish_;
+  if (use_work_stealing_) {
+    args.num_work_stealing_workers = pool->NumThreads();
+  }
 
   const bool do_trace = (run_options.trace_level() > RunOptions::NO_TRACE);
 
@@ -607,52 +673,13 @@ Status DirectSession::Run(const RunOptions& run_options,
     TF_RETURN_IF_ERROR(run_state.status);
   }
 
-  // Receive outputs.
-  if (outputs) {
-    std::vector<Tensor> sorted_outputs;
-    Status s = call_frame.ConsumeRetvals(&sorted_outputs);
-    if (errors::IsInternal(s)) {
-      return errors::InvalidArgument(s.error_message());
-    } else if (!s.ok()) {
-      return s;
-    }
-    const bool unique_outputs =
-        output_names.size() == executors_and_keys->output_name_to_index.size();
-    // first_indices[i] = j implies that j is the smallest value for which
-    // output_names[i] == output_names[j].
-    std::vector<int> first_indices;
-    if (!unique_outputs) {
-      first_indices.resize(output_names.size());
-      for (int i = 0; i < output_names.size(); ++i) {
-        for (int j = 0; j <= i; ++j) {
-          if (output_names[i] == output_names[j]) {
-            first_indices[i] = j;
-            break;
-          }
-        }
-      }
-    }
-    outputs->clear();
-    outputs->reserve(sorted_outputs.size());
-    for (int i = 0; i < output_names.size(); ++i) {
-      const string& output_name = output_names[i];
-      if (first_indices.empty() || first_indices[i] == i) {
-        outputs->emplace_back(
-            std::move(sorted_outputs[executors_and_keys
-                                         ->output_name_to_index[output_name]]));
-      } else {
-        outputs->push_back((*outputs)[first_indices[i]]);
-      }
-    }
-  }
-
   // Save the output tensors of this run we choose to keep.
   TF_RETURN_IF_ERROR(
       run_state.tensor_store.SaveTensors(output_names, &session_state_));
 
   // Build and return the cost model as instructed.
-  mutex_lock l(executor_lock_);
   if (update_cost_model) {
+    mutex_lock l(executor_lock_);
     // Build the cost model
     std::unordered_map<string, const Graph*> device_to_graph;
     for (const PerPartitionExecutorsAndLib& partition :
@@ -685,6 +712,136 @@ Status DirectSession::Run(const RunOptions& run_options,
   return Status::OK();
 }
 
+Status DirectSession::MakeCallable(const std::vector<string>& feed_names,
+                                   const std::vector<string>& fetch_names,
+                                   const std::vector<string>& target_nodes,
+                                   CallableHandle* handle) {
+  TF_RETURN_IF_ERROR(CheckNotClosed());
+  {
+    mutex_lock l(graph_def_lock_);
+    if (!graph_created_) {
+      return errors::InvalidArgument(
+          "Session was not created with a graph before MakeCallable()!");
+    }
+  }
+
+  // Callables always run on the default inter-op thread pool and without
+  // debug watches, so the executors are resolved with default options.
+  const RunOptions run_options;
+  thread::ThreadPool* pool = thread_pools_[0].first;
+  RunStateArgs run_state_args(run_options.debug_options());
+  ExecutorsAndKeys* executors_and_keys;
+  TF_RETURN_IF_ERROR(GetOrCreateExecutors(pool, feed_names, fetch_names,
+                                          target_nodes, &executors_and_keys,
+                                          &run_state_args));
+
+  std::unique_ptr<Callable> callable(new Callable);
+  callable->executors_and_keys = executors_and_keys;
+  callable->pool = pool;
+  callable->log_memory_handle = run_state_args.handle;
+  callable->fetch_names = fetch_names;
+  callable->feed_arg_indices.reserve(feed_names.size());
+  for (const string& feed : feed_names) {
+    auto it = executors_and_keys->input_name_to_index.find(feed);
+    if (it == executors_and_keys->input_name_to_index.end()) {
+      return errors::InvalidArgument("Feed ", feed, " was not resolved.");
+    }
+    callable->feed_arg_indices.push_back(it->second);
+  }
+  callable->fetch_retval_indices.reserve(fetch_names.size());
+  for (const string& fetch : fetch_names) {
+    auto it = executors_and_keys->output_name_to_index.find(fetch);
+    if (it == executors_and_keys->output_name_to_index.end()) {
+      return errors::InvalidArgument("Fetch ", fetch, " was not resolved.");
+    }
+    callable->fetch_retval_indices.push_back(it->second);
+  }
+
+  mutex_lock l(callables_lock_);
+  *handle = next_callable_handle_++;
+  callables_[*handle] = std::move(callable);
+  return Status::OK();
+}
+
+Status DirectSession::RunCallable(CallableHandle handle,
+                                  const std::vector<Tensor>& feed_tensors,
+                                  std::vector<Tensor>* fetch_tensors,
+                                  RunMetadata* run_metadata) {
+  TF_RETURN_IF_ERROR(CheckNotClosed());
+  direct_session_runs->GetCell()->IncrementBy(1);
+  const Callable* callable;
+  {
+    mutex_lock l(callables_lock_);
+    auto it = callables_.find(handle);
+    if (it == callables_.end()) {
+      return errors::InvalidArgument("No such callable handle: ", handle);
+    }
+    // Callables are only erased by ReleaseCallable(), which must not race
+    // with a RunCallable() on the same handle.
+    callable = it->second.get();
+  }
+  ExecutorsAndKeys* executors_and_keys = callable->executors_and_keys;
+  if (feed_tensors.size() != callable->feed_arg_indices.size()) {
+    return errors::InvalidArgument(
+        "Expected ", callable->feed_arg_indices.size(),
+        " feed tensors, but got ", feed_tensors.size());
+  }
+
+  const int64 step_id = step_id_counter_.fetch_add(1);
+  const int64 executor_step_count = executors_and_keys->step_count.fetch_add(1);
+
+  // The feed and fetch indices were resolved by MakeCallable(), so tensors
+  // go straight into their call frame slots.
+  FunctionCallFrame call_frame(executors_and_keys->input_types,
+                               executors_and_keys->output_types);
+  gtl::InlinedVector<Tensor, 4> feed_args(feed_tensors.size());
+  for (size_t i = 0; i < feed_tensors.size(); ++i) {
+    const size_t arg_index = callable->feed_arg_indices[i];
+    if (feed_tensors[i].dtype() == DT_RESOURCE) {
+      TF_RETURN_IF_ERROR(
+          ResourceHandleToInputTensor(feed_tensors[i], &feed_args[arg_index]));
+    } else {
+      feed_args[arg_index] = feed_tensors[i];
+    }
+  }
+  Status s = call_frame.SetArgs(feed_args);
+  if (errors::IsInternal(s)) {
+    return errors::InvalidArgument(s.error_message());
+  } else if (!s.ok()) {
+    return s;
+  }
+
+  RunMetadata unused_run_metadata;
+  TF_RETURN_IF_ERROR(RunInternal(
+      step_id, RunOptions(), callable->pool, &call_frame, executors_and_keys,
+      executor_step_count, callable->log_memory_handle, callable->fetch_names,
+      run_metadata != nullptr ? run_metadata : &unused_run_metadata));
+
+  if (fetch_tensors) {
+    std::vector<Tensor> sorted_outputs;
+    Status s = call_frame.ConsumeRetvals(&sorted_outputs);
+    if (errors::IsInternal(s)) {
+      return errors::InvalidArgument(s.error_message());
+    } else if (!s.ok()) {
+      return s;
+    }
+    fetch_tensors->clear();
+    fetch_tensors->reserve(callable->fetch_retval_indices.size());
+    for (size_t index : callable->fetch_retval_indices) {
+      fetch_tensors->push_back(sorted_outputs[index]);
+    }
+  }
+  return Status::OK();
+}
+
+Status DirectSession::ReleaseCallable(CallableHandle handle) {
+  mutex_lock l(callables_lock_);
+  if (callables_.erase(handle) == 0) {
+    return errors::InvalidArgument("No such callable handle: ", handle);
+  }
+  return Status::OK();
+}
+
 Status DirectSession::PRunSetup(const std::vector<string>& input_names,
                                 const std::vector<string>& output_names,
                                 const std::vector<string>& target_nodes,
@@ -751,6 +908,9 @@ Status DirectSession::PRunSetup(const std::vector<string>& input_names,
     LogMemory::RecordStep(args.step_id, run_state_args.handle);
   }
   args.sync_on_finish = sync_on_finish_;
+  if (use_work_stealing_) {
+    args.num_work_stealing_workers = pool->NumThreads();
+  }
 
   if (options_.config.graph_options().build_cost_model()) {
     run_state->collector.reset(new StepStatsCollector(nullptr));
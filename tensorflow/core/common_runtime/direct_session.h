@@ -91,6 +91,18 @@ class DirectSession : public Session {
                             const std::vector<string>& output_names,
                             std::vector<Tensor>* outputs) override;
 
+  // Callables pre-resolve a feed/fetch signature to its executors and call
+  // frame slots, so that RunCallable() skips the per-step signature lookup.
+  ::tensorflow::Status MakeCallable(const std::vector<string>& feed_names,
+                                    const std::vector<string>& fetch_names,
+                                    const std::vector<string>& target_nodes,
+                                    CallableHandle* handle) override;
+  ::tensorflow::Status RunCallable(CallableHandle handle,
+                                   const std::vector<Tensor>& feed_tensors,
+                                   std::vector<Tensor>* fetch_tensors,
+                                   RunMetadata* run_metadata) override;
+  ::tensorflow::Status ReleaseCallable(CallableHandle handle) override;
+
   // Reset clears 'containers' from the device_mgr of the DirectSession.
   // If 'containers' is empty, then Reset clears the default container.
   ::tensorflow::Status Reset(const std::vector<string>& containers);
@@ -179,6 +191,18 @@ class DirectSession : public Session {
     const DebugOptions& debug_options;
   };
 
+  // A Callable is a signature that was resolved once by MakeCallable().
+  // 'feed_arg_indices[i]' is the call frame argument index of the i-th feed,
+  // and 'fetch_retval_indices[i]' the return value index of the i-th fetch.
+  struct Callable {
+    ExecutorsAndKeys* executors_and_keys = nullptr;  // Owned by executors_.
+    thread::ThreadPool* pool = nullptr;              // Not owned.
+    std::vector<size_t> feed_arg_indices;
+    std::vector<size_t> fetch_retval_indices;
+    std::vector<string> fetch_names;
+    string log_memory_handle;
+  };
+
   // Initializes the base execution state given the 'graph',
   // if not already initialized.
   Status MaybeInitializeExecutionState(const GraphDef& graph,
@@ -202,6 +226,17 @@ class DirectSession : public Session {
       RunStateArgs* run_state_args, DataTypeVector* input_types,
       DataTypeVector* output_types);
 
+  // Runs the executors in 'executors_and_keys' for one step, feeding and
+  // fetching through 'call_frame'. Shared by Run() and RunCallable().
+  ::tensorflow::Status RunInternal(int64 step_id, const RunOptions& run_options,
+                                   thread::ThreadPool* pool,
+                                   FunctionCallFrame* call_frame,
+                                   ExecutorsAndKeys* executors_and_keys,
+                                   int64 executor_step_count,
+                                   const string& log_memory_handle,
+                                   const std::vector<string>& output_names,
+                                   RunMetadata* run_metadata);
+
   ::tensorflow::Status ExtendLocked(const GraphDef& graph)
       EXCLUSIVE_LOCKS_REQUIRED(graph_def_lock_);
 
@@ -274,6 +309,9 @@ class DirectSession : public Session {
 
   // If true, blocks until device has finished all queued operations in a step.
   bool sync_on_finish_ = true;
+  // If true, executors keep ready nodes in per-worker deques and steal work
+  // from each other instead of scheduling one closure per node.
+  bool use_work_stealing_ = false;
   // Schedules 'c' for execution on pool.
   void SchedClosure(thread::ThreadPool* pool, std::function<void()> c);
 
@@ -290,6 +328,12 @@ class DirectSession : public Session {
   std::unordered_map<string, std::unique_ptr<RunState>> partial_runs_
       GUARDED_BY(executor_lock_);
 
+  mutex callables_lock_;  // protects callables_
+  // Holds the callables created by MakeCallable(), keyed by handle.
+  int64 next_callable_handle_ GUARDED_BY(callables_lock_) = 0;
+  std::unordered_map<int64, std::unique_ptr<Callable>> callables_
+      GUARDED_BY(callables_lock_);
+
   // This holds all the tensors that are currently alive in the session.
   SessionState session_state_;
 
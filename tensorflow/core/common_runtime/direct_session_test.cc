@@ -169,6 +169,79 @@ TEST_F(DirectSessionMinusAXTest, TestConcurrency) {
   delete tp;
 }
 
+TEST_F(DirectSessionMinusAXTest, RunCallable) {
+  Initialize({1, 2, 3, 4});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  // Fetch the same tensor twice, and run to a non-fetched target.
+  Session::CallableHandle handle;
+  TF_ASSERT_OK(session->MakeCallable({x_}, {y_ + ":0", y_ + ":0"},
+                                     {y_neg_}, &handle));
+
+  for (int i = 0; i < 3; ++i) {
+    Tensor t(DT_FLOAT, TensorShape({2, 1}));
+    t.matrix<float>()(0, 0) = 5 + i;
+    t.matrix<float>()(1, 0) = 6;
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->RunCallable(handle, {t}, &outputs, nullptr));
+    ASSERT_EQ(2, outputs.size());
+    for (const Tensor& output : outputs) {
+      auto mat = output.matrix<float>();
+      EXPECT_FLOAT_EQ(17.0 + i, mat(0, 0));
+      EXPECT_FLOAT_EQ(39.0 + 3 * i, mat(1, 0));
+    }
+  }
+
+  // The wrong number of feeds is rejected.
+  std::vector<Tensor> outputs;
+  Status s = session->RunCallable(handle, {}, &outputs, nullptr);
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+  Tensor t(DT_FLOAT, TensorShape({2, 1}));
+  s = session->RunCallable(handle, {t}, &outputs, nullptr);
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+  s = session->ReleaseCallable(handle);
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+}
+
+TEST_F(DirectSessionMinusAXTest, RunCallableConcurrently) {
+  Initialize({1, 2, 3, 4});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+
+  Session::CallableHandle handle;
+  TF_ASSERT_OK(session->MakeCallable({}, {y_ + ":0"}, {}, &handle));
+
+  thread::ThreadPool* tp = new thread::ThreadPool(Env::Default(), "test", 4);
+  auto fn = [&session, handle]() {
+    for (int i = 0; i < 1000; ++i) {
+      std::vector<Tensor> outputs;
+      TF_ASSERT_OK(session->RunCallable(handle, {}, &outputs, nullptr));
+      ASSERT_EQ(1, outputs.size());
+      auto mat = outputs[0].matrix<float>();
+      EXPECT_FLOAT_EQ(3.0, mat(0, 0));
+    }
+  };
+  for (int i = 0; i < 4; ++i) {
+    tp->Schedule(fn);
+  }
+  delete tp;
+  TF_ASSERT_OK(session->ReleaseCallable(handle));
+}
+
+TEST_F(DirectSessionMinusAXTest, MakeCallableForgetToCreate) {
+  Initialize({1, 2, 3, 4});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  Session::CallableHandle handle;
+  Status s = session->MakeCallable({}, {y_ + ":0"}, {}, &handle);
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+}
+
 TEST_F(DirectSessionMinusAXTest, TestPerSessionThreads) {
   Initialize({1, 2, 3, 4});
 
@@ -1249,8 +1322,10 @@ TEST(DirectSessionTest, TestDirectSessionReset) {
 }
 
 // A simple benchmark for the overhead of `DirectSession::Run()` calls
-// with varying numbers of feeds/fetches.
-void FeedFetchBenchmarkHelper(int num_feeds, int iters) {
+// with varying numbers of feeds/fetches. If 'use_callable' is true, the
+// signature is resolved once with `MakeCallable()` and run with
+// `RunCallable()` instead.
+void FeedFetchBenchmarkHelper(int num_feeds, int iters, bool use_callable) {
   testing::StopTiming();
 
   Tensor value(DT_FLOAT, TensorShape());
@@ -1296,6 +1371,25 @@ void FeedFetchBenchmarkHelper(int num_feeds, int iters) {
     std::vector<Tensor> output_values;
     TF_CHECK_OK(session->Run(inputs, outputs, {}, &output_values));
   }
+  if (use_callable) {
+    std::vector<string> feed_names;
+    std::vector<Tensor> feed_values;
+    for (const auto& input : inputs) {
+      feed_names.push_back(input.first);
+      feed_values.push_back(input.second);
+    }
+    Session::CallableHandle handle;
+    TF_CHECK_OK(session->MakeCallable(feed_names, outputs, {}, &handle));
+    testing::StartTiming();
+    for (int i = 0; i < iters; ++i) {
+      std::vector<Tensor> output_values;
+      TF_CHECK_OK(
+          session->RunCallable(handle, feed_values, &output_values, nullptr));
+    }
+    testing::StopTiming();
+    TF_CHECK_OK(session->ReleaseCallable(handle));
+    return;
+  }
   testing::StartTiming();
   for (int i = 0; i < iters; ++i) {
     std::vector<Tensor> output_values;
@@ -1305,10 +1399,14 @@ void FeedFetchBenchmarkHelper(int num_feeds, int iters) {
 }
 
 void BM_FeedFetch(int iters, int num_feeds) {
-  FeedFetchBenchmarkHelper(iters, num_feeds);
+  FeedFetchBenchmarkHelper(num_feeds, iters, false /* use_callable */);
+}
+void BM_FeedFetchCallable(int iters, int num_feeds) {
+  FeedFetchBenchmarkHelper(num_feeds, iters, true /* use_callable */);
 }
 
 BENCHMARK(BM_FeedFetch)->Arg(1)->Arg(2)->Arg(5)->Arg(10);
+BENCHMARK(BM_FeedFetchCallable)->Arg(1)->Arg(2)->Arg(5)->Arg(10);
 
 }  // namespace
 }  // namespace tensorflow
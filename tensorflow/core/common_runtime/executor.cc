@@ -1119,6 +1119,7 @@ class ExecutorState {
     int64 input_iter = -1;
     bool is_dead = false;
 
+    TaggedNode() {}
     TaggedNode(const Node* t_node, FrameState* in_frame, int64 in_iter,
                bool dead) {
       node = t_node;
@@ -1163,6 +1164,127 @@ class ExecutorState {
     int front_index_;
   };
 
+  // Identifies a thread that is not one of the work-stealing workers.
+  static constexpr int kNoWorker = -1;
+
+  // Per-worker ready deques, used when Args::num_work_stealing_workers > 0.
+  // A worker pops from the back of its own deque and steals from the front
+  // of the other deques when its own is empty. The object is shared with
+  // the worker closures, so a worker that runs the last node of the step
+  // (and thereby deletes the ExecutorState in Finish()) can still find the
+  // deques empty and exit without touching the deleted state.
+  class WorkerQueues : public std::enable_shared_from_this<WorkerQueues> {
+   public:
+    struct Item {
+      Item() : scheduled_usec(0) {}
+      Item(const TaggedNode& n, int64 usec) : node(n), scheduled_usec(usec) {}
+
+      TaggedNode node;
+      int64 scheduled_usec;
+    };
+
+    WorkerQueues(ExecutorState* state, const Executor::Args::Runner& runner,
+                 int num_workers)
+        : state_(state), runner_(runner), workers_(num_workers) {
+      for (auto& w : workers_) {
+        w.reset(new Worker);
+      }
+    }
+
+    ExecutorState* state() const { return state_; }
+    int num_workers() const { return workers_.size(); }
+
+    // Returns the deque to use for a node scheduled by a thread that is not
+    // a worker. Spreads such nodes round-robin across the workers.
+    int NextWorker() {
+      return next_worker_.fetch_add(1, std::memory_order_relaxed) %
+             workers_.size();
+    }
+
+    void Push(int worker, const TaggedNode& node, int64 scheduled_usec) {
+      Worker* w = workers_[worker].get();
+      mutex_lock l(w->mu);
+      w->items.emplace_back(node, scheduled_usec);
+    }
+
+    // Dispatches a closure for each of up to "max_new" idle workers.
+    void StartWorkers(int max_new) {
+      const int n = workers_.size();
+      const int start = NextWorker();
+      for (int i = 0; i < n && max_new > 0; ++i) {
+        const int w = (start + i) % n;
+        if (TryActivate(w)) {
+          std::shared_ptr<WorkerQueues> self = shared_from_this();
+          runner_([self, w]() { ExecutorState::RunWorker(self, w); });
+          --max_new;
+        }
+      }
+    }
+
+    // Pops the most recently pushed item from "worker"'s own deque or, if
+    // it is empty, steals the oldest item from another worker's deque.
+    // Returns false if all deques are empty.
+    bool Pop(int worker, Item* item) {
+      const int n = workers_.size();
+      {
+        Worker* w = workers_[worker].get();
+        mutex_lock l(w->mu);
+        if (!w->items.empty()) {
+          *item = w->items.back();
+          w->items.pop_back();
+          return true;
+        }
+      }
+      for (int i = 1; i < n; ++i) {
+        Worker* victim = workers_[(worker + i) % n].get();
+        mutex_lock l(victim->mu);
+        if (!victim->items.empty()) {
+          *item = victim->items.front();
+          victim->items.pop_front();
+          return true;
+        }
+      }
+      return false;
+    }
+
+    // Marks "worker" as running. Returns false if it already is, in which
+    // case the caller must not dispatch another closure for it.
+    bool TryActivate(int worker) {
+      bool expected = false;
+      return workers_[worker]->active.compare_exchange_strong(expected, true);
+    }
+
+    // Called by a worker that found all deques empty. Returns true if the
+    // worker must keep running because work was pushed concurrently and no
+    // other worker claimed it.
+    bool Deactivate(int worker) {
+      workers_[worker]->active.store(false);
+      return HasWork() && TryActivate(worker);
+    }
+
+   private:
+    struct Worker {
+      mutex mu;
+      std::deque<Item> items GUARDED_BY(mu);
+      std::atomic<bool> active{false};
+    };
+
+    bool HasWork() {
+      for (auto& w : workers_) {
+        mutex_lock l(w->mu);
+        if (!w->items.empty()) return true;
+      }
+      return false;
+    }
+
+    ExecutorState* const state_;  // Not owned.
+    const Executor::Args::Runner runner_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<uint32> next_worker_{0};
+
+    TF_DISALLOW_COPY_AND_ASSIGN(WorkerQueues);
+  };
+
   struct AsyncState;
 
   const bool vlog_;  // true if VLOG_IS_ON(1). Used to check vlog cheaply.
@@ -1187,6 +1309,9 @@ class ExecutorState {
   Executor::Args::Runner runner_;
   bool sync_on_finish_;
 
+  // Null unless Args::num_work_stealing_workers > 0.
+  std::shared_ptr<WorkerQueues> worker_queues_;
+
   // Owned.
 
   // A flag that is set on error after the frame state has been
@@ -1230,8 +1355,13 @@ class ExecutorState {
   void CleanupFramesIterations(FrameState* frame, int64 iter,
                                TaggedNodeSeq* ready);
 
-  // Process a ready node in current thread.
-  void Process(TaggedNode node, int64 scheduled_usec);
+  // Process a ready node in current thread. "worker" is the index of the
+  // work-stealing worker running on this thread, or kNoWorker.
+  void Process(TaggedNode node, int64 scheduled_usec, int worker);
+
+  // Body of a work-stealing worker closure: runs nodes from the worker
+  // deques until they are all empty.
+  static void RunWorker(std::shared_ptr<WorkerQueues> queues, int worker);
 
   // Before invoking item->kernel, fills in its "inputs".
   Status PrepareInputs(const NodeItem& item, Entry* first_input,
@@ -1253,12 +1383,19 @@ class ExecutorState {
   // "node" just finishes. Takes ownership of "stats". Returns true if
   // execution has completed.
   bool NodeDone(const Status& s, const Node* node, const TaggedNodeSeq& ready,
-                NodeExecStats* stats, TaggedNodeReadyQueue* inline_ready);
+                NodeExecStats* stats, TaggedNodeReadyQueue* inline_ready,
+                int worker);
 
   // Schedule all the expensive nodes in 'ready', and put all the inexpensive
-  // nodes in 'ready' into 'inline_ready'.
+  // nodes in 'ready' into 'inline_ready'. 'worker' is the work-stealing
+  // worker whose deque receives the scheduled nodes, or kNoWorker.
   void ScheduleReady(const TaggedNodeSeq& ready,
-                     TaggedNodeReadyQueue* inline_ready);
+                     TaggedNodeReadyQueue* inline_ready, int worker);
+
+  // Dispatches a schedulable node: pushes it onto a deque of 'queues' in
+  // work-stealing mode, or hands it to 'runner_' if 'queues' is null.
+  void Dispatch(const TaggedNode& tagged_node, int64 scheduled_usec,
+                WorkerQueues* queues, int worker);
 
   // For debugging/logging only.
   inline void MaybeMarkCompleted(FrameState* frame, int64 iter, int64 id);
@@ -1305,6 +1442,10 @@ ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
       runner_(args.runner),
       sync_on_finish_(args.sync_on_finish),
       num_outstanding_ops_(0) {
+  if (args.num_work_stealing_workers > 0) {
+    worker_queues_ = std::make_shared<WorkerQueues>(
+        this, runner_, args.num_work_stealing_workers);
+  }
   // We start the entire execution in iteration 0 of the root frame
   // so let us create the root frame and the state for iteration 0.
   // We assume root_frame_->frame_name.empty().
@@ -1436,7 +1577,7 @@ void ExecutorState::RunAsync(Executor::DoneCallback done) {
     root_frame_->iterations[0]->outstanding_ops = ready.size();
     done_cb_ = std::move(done);
     // Schedule to run all the ready ops in thread pool.
-    ScheduleReady(ready, nullptr);
+    ScheduleReady(ready, nullptr, kNoWorker);
   }
 }
 
@@ -1485,7 +1626,8 @@ struct ExecutorState::AsyncState {
   }
 };
 
-void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
+void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec,
+                            int worker) {
   const GraphView& gview = impl_->gview_;
   TaggedNodeSeq ready;
   TaggedNodeReadyQueue inline_ready;
@@ -1583,7 +1725,8 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
         }
         MaybeMarkCompleted(input_frame, input_iter, id);
         // Continue to process the nodes in 'inline_ready'.
-        completed = NodeDone(s, item.node, ready, stats, &inline_ready);
+        completed =
+            NodeDone(s, item.node, ready, stats, &inline_ready, worker);
         continue;
       }
 
@@ -1639,7 +1782,7 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
                                                  accessed);
           }
           bool completed =
-              NodeDone(s, state->item->node, ready, stats, nullptr);
+              NodeDone(s, state->item->node, ready, stats, nullptr, kNoWorker);
           delete state;
           if (completed) Finish();
         };
@@ -1683,7 +1826,7 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
         scheduled_usec = nodestats::NowInUsec();
       }
       // Postprocess.
-      completed = NodeDone(s, item.node, ready, stats, &inline_ready);
+      completed = NodeDone(s, item.node, ready, stats, &inline_ready, worker);
     }
   }  // while !inline_ready.empty()
 
@@ -1691,6 +1834,19 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
   if (completed) Finish();
 }
 
+// static
+void ExecutorState::RunWorker(std::shared_ptr<WorkerQueues> queues,
+                              int worker) {
+  WorkerQueues::Item item;
+  do {
+    while (queues->Pop(worker, &item)) {
+      // Every queued node is counted in num_outstanding_ops_, so the state
+      // cannot have been deleted while a node is still in a deque.
+      queues->state()->Process(item.node, item.scheduled_usec, worker);
+    }
+  } while (queues->Deactivate(worker));
+}
+
 Status ExecutorState::PrepareInputs(const NodeItem& item, Entry* first_input,
                                     TensorValueVec* inputs,
                                     DeviceContextVec* input_device_contexts,
@@ -1996,7 +2152,7 @@ void ExecutorState::PropagateOutputs(const TaggedNode& tagged_node,
 
 bool ExecutorState::NodeDone(const Status& s, const Node* node,
                              const TaggedNodeSeq& ready, NodeExecStats* stats,
-                             TaggedNodeReadyQueue* inline_ready) {
+                             TaggedNodeReadyQueue* inline_ready, int worker) {
   if (stats) {
     nodestats::SetAllEnd(stats);
     if (!SetTimelineLabel(node, stats)) {
@@ -2036,54 +2192,78 @@ bool ExecutorState::NodeDone(const Status& s, const Node* node,
 
   // Schedule the ready nodes in 'ready'.
   if (s.ok()) {
-    ScheduleReady(ready, inline_ready);
+    ScheduleReady(ready, inline_ready, worker);
   }
   return completed;
 }
 
 void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
-                                  TaggedNodeReadyQueue* inline_ready) {
+                                  TaggedNodeReadyQueue* inline_ready,
+                                  int worker) {
   if (ready.empty()) return;
 
   int64 scheduled_usec = 0;
   if (stats_collector_) {
     scheduled_usec = nodestats::NowInUsec();
   }
+  // Once the last node is pushed another worker may run the step to
+  // completion and delete this state, so only touch locals after that.
+  std::shared_ptr<WorkerQueues> queues = worker_queues_;
+  int num_dispatched = 0;
   if (inline_ready == nullptr) {
     // Schedule to run all the ready ops in thread pool.
     for (auto& tagged_node : ready) {
-      runner_([=]() { Process(tagged_node, scheduled_usec); });
+      Dispatch(tagged_node, scheduled_usec, queues.get(), worker);
     }
-    return;
-  }
-  const GraphView& gview = impl_->gview_;
-  const TaggedNode* curr_expensive_node = nullptr;
-  for (auto& tagged_node : ready) {
-    const NodeItem& item = *gview.node(tagged_node.node->id());
-    if (tagged_node.is_dead || !item.kernel_is_expensive) {
-      // Inline this inexpensive node.
-      inline_ready->push_back(tagged_node);
-    } else {
-      if (curr_expensive_node) {
-        // Dispatch to another thread since there is plenty of work to
-        // do for this thread.
-        runner_(std::bind(&ExecutorState::Process, this, *curr_expensive_node,
-                          scheduled_usec));
+    num_dispatched = ready.size();
+  } else {
+    const GraphView& gview = impl_->gview_;
+    const TaggedNode* curr_expensive_node = nullptr;
+    for (auto& tagged_node : ready) {
+      const NodeItem& item = *gview.node(tagged_node.node->id());
+      if (tagged_node.is_dead || !item.kernel_is_expensive) {
+        // Inline this inexpensive node.
+        inline_ready->push_back(tagged_node);
+      } else {
+        if (curr_expensive_node) {
+          // Dispatch to another thread since there is plenty of work to
+          // do for this thread.
+          Dispatch(*curr_expensive_node, scheduled_usec, queues.get(), worker);
+          ++num_dispatched;
+        }
+        curr_expensive_node = &tagged_node;
       }
-      curr_expensive_node = &tagged_node;
     }
-  }
-  if (curr_expensive_node) {
-    if (inline_ready->empty()) {
-      // Tail recursion optimization
-      inline_ready->push_back(*curr_expensive_node);
-    } else {
-      // There are inline nodes to run already. We dispatch this expensive
-      // node to other thread.
-      runner_(std::bind(&ExecutorState::Process, this, *curr_expensive_node,
-                        scheduled_usec));
+    if (curr_expensive_node) {
+      if (inline_ready->empty()) {
+        // Tail recursion optimization
+        inline_ready->push_back(*curr_expensive_node);
+      } else {
+        // There are inline nodes to run already. We dispatch this expensive
+        // node to other thread.
+        Dispatch(*curr_expensive_node, scheduled_usec, queues.get(), worker);
+        ++num_dispatched;
+      }
     }
   }
+  if (queues && num_dispatched > 0) {
+    queues->StartWorkers(num_dispatched);
+  }
+}
+
+void ExecutorState::Dispatch(const TaggedNode& tagged_node,
+                             int64 scheduled_usec, WorkerQueues* queues,
+                             int worker) {
+  if (queues == nullptr) {
+    runner_([=]() { Process(tagged_node, scheduled_usec, kNoWorker); });
+    return;
+  }
+  // Nodes made ready by a worker stay on that worker's deque so that they
+  // are likely to run on the same core as their producer.
+  if (worker == kNoWorker) {
+    worker = queues->NextWorker();
+  }
+  queues->Push(worker, tagged_node, scheduled_usec);
 }
 
 inline void ExecutorState::MaybeMarkCompleted(FrameState* frame, int64 iter,
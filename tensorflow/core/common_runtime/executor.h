@@ -97,6 +97,14 @@ class Executor {
     typedef std::function<void(Closure)> Runner;
     Runner runner = nullptr;
 
+    // If greater than zero, ready nodes that are not run inline are kept in
+    // this many per-worker deques instead of being dispatched to "runner"
+    // one closure per node. At most this many worker closures are dispatched
+    // to "runner"; each one drains its own deque and steals from the others
+    // when it runs out of work. Typically set to the number of threads
+    // backing "runner".
+    int num_work_stealing_workers = 0;
+
     // A callback that is invoked each time a node has finished executing.
     typedef std::function<Status(const string& node_name, const int output_slot,
                                  const Tensor* tensor, const bool is_ref,
@@ -29,6 +29,8 @@ GPUBFCAllocator::GPUBFCAllocator(int device_id, size_t total_memory,
           new GPUMemAllocator(
               GPUMachineManager()->ExecutorForDevice(device_id).ValueOrDie()),
           total_memory, gpu_options.allow_growth(),
-          strings::StrCat("GPU_", device_id, "_bfc")) {}
+          strings::StrCat("GPU_", device_id, "_bfc"),
+          false /*use_chunk_cache*/,
+          gpu_options.bfc_use_flat_free_chunk_index()) {}
 
 }  // namespace tensorflow
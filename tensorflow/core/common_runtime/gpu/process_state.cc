@@ -173,9 +173,22 @@ Allocator* ProcessState::GetCPUAllocator(int numa_node) {
         LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
       }
       int64 cpu_mem_limit = cpu_mem_limit_in_mb * (1LL << 20);
+      bool use_chunk_cache = false;
+      status = ReadBoolFromEnvVar("TF_CPU_BFC_USE_CHUNK_CACHE", false,
+                                  &use_chunk_cache);
+      if (!status.ok()) {
+        LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
+      }
+      bool flat_free_chunk_index = false;
+      status = ReadBoolFromEnvVar("TF_CPU_BFC_FLAT_FREE_CHUNK_INDEX", false,
+                                  &flat_free_chunk_index);
+      if (!status.ok()) {
+        LOG(ERROR) << "GetCPUAllocator: " << status.error_message();
+      }
       allocator = new BFCAllocator(new BasicCPUAllocator(), cpu_mem_limit,
                                    true /*allow_growth*/,
-                                   "bfc_cpu_allocator_for_gpu" /*name*/);
+                                   "bfc_cpu_allocator_for_gpu" /*name*/,
+                                   use_chunk_cache, flat_free_chunk_index);
       VLOG(2) << "Using BFCAllocator with memory limit of "
               << cpu_mem_limit_in_mb << " MB for ProcessState CPU allocator";
     } else {
@@ -79,6 +79,7 @@ class ExecutorTest : public ::testing::Test {
     args.rendezvous = rendez;
     args.stats_collector = &step_stats_collector_;
     args.runner = runner_;
+    args.num_work_stealing_workers = num_work_stealing_workers_;
     return exec_->Run(args);
   }
 
@@ -89,6 +90,7 @@ class ExecutorTest : public ::testing::Test {
   StepStats step_stats_;
   Executor::Args::Runner runner_;
   Rendezvous* rendez_ = nullptr;
+  int num_work_stealing_workers_ = 0;
 };
 
 // A float val -> Tensor<float>
@@ -243,6 +245,22 @@ TEST_F(ExecutorTest, RandomTree) {
   EXPECT_EQ(4096.0, V(out));
 }
 
+TEST_F(ExecutorTest, RandomTreeWorkStealing) {
+  num_work_stealing_workers_ = 4;
+  Graph* g = new Graph(OpRegistry::Global());
+  BuildTree(4096, g);
+  Create(g);
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(4096.0, V(out));
+}
+
 void BuildConcurrentAddAssign(Graph* g) {
   auto one = test::graph::Constant(g, V(1.0));
   // A variable holds one float.
@@ -278,6 +296,24 @@ TEST_F(ExecutorTest, ConcurrentAddAssign) {
     rendez->Unref();
   }
 }
+
+TEST_F(ExecutorTest, ConcurrentAddAssignWorkStealing) {
+  num_work_stealing_workers_ = 4;
+  Graph* g = new Graph(OpRegistry::Global());
+  BuildConcurrentAddAssign(g);
+  Create(g);
+  for (int iters = 0; iters < 16; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    TF_ASSERT_OK(Run(rendez));
+    Rendezvous::Args args;
+    Tensor out;
+    bool is_dead;
+    TF_ASSERT_OK(rendez->Recv(Key(ALICE, kIncarnation, BOB, "out"), args, &out,
+                              &is_dead));
+    EXPECT_LE(V(out), 1025.0);
+    rendez->Unref();
+  }
+}
 #endif
 
 TEST_F(ExecutorTest, SimpleSwitchLive) {
@@ -410,4 +446,82 @@ TEST_F(ExecutorTest, RecvInvalidRefDtype) {
   rendez->Unref();
 }
 
+// Builds "width" chains of "depth" scalar Adds, where each Add also reads
+// the previous node of the neighboring chain. Every Add is a separately
+// scheduled (expensive) node that does almost no work, so the running time
+// is dominated by the executor's per-node scheduling overhead.
+static Graph* ScalarAddLattice(int width, int depth) {
+  Graph* g = new Graph(OpRegistry::Global());
+  std::vector<Node*> layer;
+  for (int i = 0; i < width; ++i) {
+    layer.push_back(test::graph::Constant(g, V(1.0)));
+  }
+  for (int d = 0; d < depth; ++d) {
+    std::vector<Node*> next;
+    for (int i = 0; i < width; ++i) {
+      next.push_back(test::graph::Add(g, layer[i], layer[(i + 1) % width]));
+    }
+    layer.swap(next);
+  }
+  return g;
+}
+
+// Reports per-node scheduling throughput as items (nodes) per second.
+static void BM_ExecutorScheduling(int iters, int width, int depth,
+                                  int num_work_stealing_workers) {
+  testing::StopTiming();
+  Graph* g = ScalarAddLattice(width, depth);
+  const int64 num_nodes = g->num_op_nodes();
+  SessionOptions options;
+  Device* device =
+      DeviceFactory::NewDevice("CPU", options, "/job:localhost/replica:0/task:0");
+  thread::ThreadPool* pool = new thread::ThreadPool(
+      options.env, "executor_bench", port::NumSchedulableCPUs());
+  const int version = g->versions().producer();
+  LocalExecutorParams params;
+  params.device = device;
+  params.create_kernel = [device, version](const NodeDef& ndef,
+                                           OpKernel** kernel) {
+    return CreateNonCachedKernel(device, nullptr, ndef, version, kernel);
+  };
+  params.delete_kernel = [](OpKernel* kernel) {
+    DeleteNonCachedKernel(kernel);
+  };
+  Executor* exec = nullptr;
+  TF_CHECK_OK(NewLocalExecutor(params, g, &exec));
+  Executor::Args args;
+  args.runner = [pool](std::function<void()> fn) { pool->Schedule(fn); };
+  args.num_work_stealing_workers =
+      num_work_stealing_workers > 0 ? pool->NumThreads() : 0;
+  // Warm up so that kernel construction is not measured.
+  TF_CHECK_OK(exec->Run(args));
+  testing::ItemsProcessed(num_nodes * iters);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(exec->Run(args));
+  }
+  testing::StopTiming();
+  delete exec;
+  delete pool;
+  delete device;
+}
+
+static void BM_ExecutorSharedPool(int iters, int width, int depth) {
+  BM_ExecutorScheduling(iters, width, depth, 0);
+}
+BENCHMARK(BM_ExecutorSharedPool)
+    ->ArgPair(16, 16)
+    ->ArgPair(64, 64)
+    ->ArgPair(256, 16)
+    ->ArgPair(1024, 4);
+
+static void BM_ExecutorWorkStealing(int iters, int width, int depth) {
+  BM_ExecutorScheduling(iters, width, depth, 1);
+}
+BENCHMARK(BM_ExecutorWorkStealing)
+    ->ArgPair(16, 16)
+    ->ArgPair(64, 64)
+    ->ArgPair(256, 16)
+    ->ArgPair(1024, 4);
+
 }  // namespace tensorflow
@@ -466,6 +466,8 @@ class Tensor {
   friend class OpKernelContext;  // For access to RefCountIsOne().
   friend class NumpyTensorBuffer;  // For access to the private constructor
                                    // taking the buffer.
+  friend class BundleReader;       // For access to the private constructor
+                                   // taking the buffer.
 
   // Creates a tensor with the input datatype, shape and buf.
   //
@@ -48,6 +48,16 @@ Status AnalyticalCostEstimator::Initialize(const GrapplerItem& item) {
   return Status::OK();
 }
 
+Costs AnalyticalCostEstimator::PredictNodeCosts(
+    const NodeInfo& node_info) const {
+  Costs node_costs;
+  if (measured_costs_ != nullptr &&
+      measured_costs_->GetNodeCosts(node_info.name, &node_costs)) {
+    return node_costs;
+  }
+  return node_estimator_->PredictCosts(node_info.op_info);
+}
+
 Status AnalyticalCostEstimator::PredictCosts(const GraphDef& optimized_graph,
                                              CostGraphDef* cost_graph,
                                              Costs* costs) const {
@@ -61,8 +71,22 @@ Status AnalyticalCostEstimator::PredictCosts(const GraphDef& optimized_graph,
     }
   }
   std::vector<string> inaccurate_nodes;
-  VirtualScheduler scheduler(&item, use_static_shapes_, cluster_);
-  auto status = scheduler.Init();
+  std::unique_ptr<VirtualScheduler> scheduler;
+  ReadyNodeManager* ready_nodes;
+  if (use_critical_path_scheduling_) {
+    // The priorities are computed in scheduler->Init(), once the scheduler
+    // knows the inputs and devices of every node.
+    ready_nodes = new CriticalPathManager(
+        [this, &scheduler](const NodeDef& node) {
+          const NodeInfo node_info = scheduler->GetNodeInfo(&node);
+          return PredictNodeCosts(node_info).execution_time;
+        });
+  } else {
+    ready_nodes = new FIFOManager();
+  }
+  scheduler.reset(
+      new VirtualScheduler(&item, use_static_shapes_, cluster_, ready_nodes));
+  auto status = scheduler->Init();
   if (!status.ok()) {
     costs->execution_time = Costs::Duration::max();
     return status;
@@ -70,11 +94,10 @@ Status AnalyticalCostEstimator::PredictCosts(const GraphDef& optimized_graph,
 
   Costs node_costs;
   do {
-    NodeInfo node_info = scheduler.GetCurrNodeInfo();
-    auto& op_info = node_info.op_info;
+    NodeInfo node_info = scheduler->GetCurrNodeInfo();
     const string& op_name = node_info.name;
 
-    node_costs = node_estimator_->PredictCosts(op_info);
+    node_costs = PredictNodeCosts(node_info);
     if (node_costs.inaccurate) {
       inaccurate_nodes.push_back(op_name);
     }
@@ -101,9 +124,9 @@ Status AnalyticalCostEstimator::PredictCosts(const GraphDef& optimized_graph,
         *shape = output.shape();
       }
     }
-  } while (scheduler.MarkCurrNodeExecuted(node_costs));
+  } while (scheduler->MarkCurrNodeExecuted(node_costs));
 
-  *costs = scheduler.Summary();
+  *costs = scheduler->Summary();
   VLOG(1) << inaccurate_nodes.size() << " out of "
           << optimized_graph.node_size()
           << " nodes have inaccurate time estimation";
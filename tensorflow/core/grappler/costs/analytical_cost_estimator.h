@@ -17,7 +17,9 @@ limitations under the License.
 #define TENSORFLOW_CORE_GRAPPLER_COSTS_ANALYTICAL_COST_ESTIMATOR_H_
 
 #include "tensorflow/core/grappler/costs/cost_estimator.h"
+#include "tensorflow/core/grappler/costs/measured_costs.h"
 #include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/virtual_scheduler.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/lib/core/status.h"
 
@@ -45,6 +47,17 @@ class AnalyticalCostEstimator : public CostEstimator {
                           bool use_static_shapes);
   ~AnalyticalCostEstimator() override {}
 
+  // Uses the measured costs of the nodes instead of the analytical estimates
+  // whenever they are available. Does not take ownership of measured_costs.
+  void set_measured_costs(const MeasuredCosts* measured_costs) {
+    measured_costs_ = measured_costs;
+  }
+  // Schedules the ready nodes by critical-path priority instead of in FIFO
+  // order.
+  void set_use_critical_path_scheduling(bool use_critical_path_scheduling) {
+    use_critical_path_scheduling_ = use_critical_path_scheduling;
+  }
+
   // Initializes the estimator for the specified grappler item.
   // This implementation always returns OK.
   Status Initialize(const GrapplerItem& item) override;
@@ -56,10 +69,14 @@ class AnalyticalCostEstimator : public CostEstimator {
                       Costs* overall_latency) const override;
 
  private:
+  Costs PredictNodeCosts(const NodeInfo& node_info) const;
+
   Cluster* cluster_;  // Not owned.
   GrapplerItem item_;
   std::unique_ptr<OpLevelCostEstimator> node_estimator_;
+  const MeasuredCosts* measured_costs_ = nullptr;  // Not owned.
   bool use_static_shapes_;
+  bool use_critical_path_scheduling_ = false;
 };
 
 }  // end namespace grappler
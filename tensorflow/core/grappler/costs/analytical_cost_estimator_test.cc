@@ -106,5 +106,46 @@ TEST_F(AnalyticalCostEstimatorTest, SimpleTest) {
   EXPECT_FALSE(summary.inaccurate);
 }
 
+TEST_F(AnalyticalCostEstimatorTest, CriticalPathScheduling) {
+  GrapplerItem item = CreateMiniGraph();
+
+  AnalyticalCostEstimator estimator(cluster_.get(), true);
+  estimator.set_use_critical_path_scheduling(true);
+  TF_ASSERT_OK(estimator.Initialize(item));
+
+  Costs summary;
+  TF_ASSERT_OK(estimator.PredictCosts(item.graph, nullptr, &summary));
+
+  // All the nodes run on the same device, so the order doesn't change the
+  // total time.
+  EXPECT_EQ(Costs::NanoSeconds(9156), summary.execution_time);
+}
+
+TEST_F(AnalyticalCostEstimatorTest, MeasuredCosts) {
+  GrapplerItem item = CreateMiniGraph();
+
+  CostGraphDef measured_graph;
+  auto* measured_node = measured_graph.add_node();
+  measured_node->set_name("matmul");
+  measured_node->set_compute_cost(1000);
+  MeasuredCosts measured_costs;
+  measured_costs.AddCostGraph(measured_graph);
+
+  AnalyticalCostEstimator estimator(cluster_.get(), true);
+  estimator.set_measured_costs(&measured_costs);
+  TF_ASSERT_OK(estimator.Initialize(item));
+
+  CostGraphDef cost_graph;
+  Costs summary;
+  TF_ASSERT_OK(estimator.PredictCosts(item.graph, &cost_graph, &summary));
+
+  EXPECT_LT(Costs::NanoSeconds(1000000), summary.execution_time);
+  for (const auto& node : cost_graph.node()) {
+    if (node.name() == "matmul") {
+      EXPECT_EQ(1000, node.compute_cost());
+    }
+  }
+}
+
 }  // end namespace grappler
 }  // end namespace tensorflow
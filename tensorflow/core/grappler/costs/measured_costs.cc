@@ -0,0 +1,89 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/measured_costs.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/framework/cost_graph.pb.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/grappler/costs/robust_stats.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+
+namespace tensorflow {
+namespace grappler {
+
+void MeasuredCosts::AddStepStats(const StepStats& step_stats) {
+  // The GPU tracer records every kernel on the stream it ran on, and once more
+  // on the "stream:all" device, under the name "<node name>:<op type>". The
+  // copies are recorded on "memcpy" devices.
+  std::unordered_map<string, double> op_times_us;
+  std::unordered_map<string, double> kernel_times_us;
+  for (const auto& dev_stats : step_stats.dev_stats()) {
+    const StringPiece device(dev_stats.device());
+    const bool is_all_streams = device.ends_with("/stream:all");
+    if (!is_all_streams && (device.contains("/stream:") ||
+                            device.ends_with("/memcpy"))) {
+      continue;
+    }
+    auto& times_us = is_all_streams ? kernel_times_us : op_times_us;
+    for (const auto& node_stats : dev_stats.node_stats()) {
+      const int64 time_us =
+          node_stats.op_end_rel_micros() - node_stats.op_start_rel_micros();
+      string node_name = node_stats.node_name();
+      if (is_all_streams) {
+        const size_t pos = node_name.find(':');
+        if (pos != string::npos) {
+          node_name = node_name.substr(0, pos);
+        }
+      }
+      times_us[node_name] += std::max<int64>(time_us, 0);
+    }
+  }
+  for (const auto& kernel_time : kernel_times_us) {
+    op_times_us[kernel_time.first] = kernel_time.second;
+  }
+  for (const auto& op_time : op_times_us) {
+    AddSample(op_time.first, op_time.second);
+  }
+}
+
+void MeasuredCosts::AddCostGraph(const CostGraphDef& cost_graph) {
+  for (const auto& node : cost_graph.node()) {
+    AddSample(node.name(), std::max<int64>(node.compute_cost(), 0));
+  }
+}
+
+bool MeasuredCosts::GetNodeCosts(const string& node_name, Costs* costs) const {
+  auto it = node_times_.find(node_name);
+  if (it == node_times_.end()) {
+    return false;
+  }
+  *costs = Costs::ZeroCosts();
+  costs->execution_time = it->second;
+  costs->compute_time = it->second;
+  return true;
+}
+
+void MeasuredCosts::AddSample(const string& node_name, double time_us) {
+  auto& samples = samples_us_[node_name];
+  samples.push_back(time_us);
+  RobustStats stats(samples);
+  node_times_[node_name] =
+      Costs::Duration(Costs::MicroSeconds(stats.mean()));
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,65 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_MEASURED_COSTS_H_
+#define TENSORFLOW_CORE_GRAPPLER_COSTS_MEASURED_COSTS_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/grappler/costs/cost_estimator.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+class CostGraphDef;
+class StepStats;
+}  // namespace tensorflow
+
+namespace tensorflow {
+namespace grappler {
+
+// Execution times of the nodes of a graph, measured on real runs and loaded
+// from the StepStats or CostGraphDef collected in their RunMetadata. Each step
+// or cost graph added is one sample per node, and the time of a node is the
+// robust mean of its samples.
+class MeasuredCosts {
+ public:
+  MeasuredCosts() {}
+
+  // Adds the timings of one step. A node that ran several times during the
+  // step, e.g. in a loop, is charged the sum of its runs. On GPUs the kernel
+  // times recorded on the "stream:all" device replace the launch times.
+  void AddStepStats(const StepStats& step_stats);
+
+  // Adds the compute costs of the nodes of a cost graph.
+  void AddCostGraph(const CostGraphDef& cost_graph);
+
+  // Returns true and fills 'costs' if node_name has been measured.
+  bool GetNodeCosts(const string& node_name, Costs* costs) const;
+
+  // Number of nodes measured.
+  int num_nodes() const { return node_times_.size(); }
+
+ private:
+  void AddSample(const string& node_name, double time_us);
+
+  std::unordered_map<string, std::vector<double>> samples_us_;
+  std::unordered_map<string, Costs::Duration> node_times_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_COSTS_MEASURED_COSTS_H_
@@ -0,0 +1,96 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/measured_costs.h"
+#include "tensorflow/core/framework/cost_graph.pb.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+void AddNodeStats(const string& node_name, int64 start_us, int64 end_us,
+                  DeviceStepStats* dev_stats) {
+  NodeExecStats* node_stats = dev_stats->add_node_stats();
+  node_stats->set_node_name(node_name);
+  node_stats->set_op_start_rel_micros(start_us);
+  node_stats->set_op_end_rel_micros(end_us);
+}
+
+TEST(MeasuredCostsTest, StepStats) {
+  StepStats step_stats;
+  DeviceStepStats* cpu = step_stats.add_dev_stats();
+  cpu->set_device("/job:localhost/replica:0/task:0/cpu:0");
+  AddNodeStats("a", 0, 10, cpu);
+  // A node that runs twice is charged for both runs.
+  AddNodeStats("b", 5, 15, cpu);
+  AddNodeStats("b", 20, 25, cpu);
+
+  MeasuredCosts measured_costs;
+  measured_costs.AddStepStats(step_stats);
+  EXPECT_EQ(2, measured_costs.num_nodes());
+
+  Costs costs;
+  EXPECT_TRUE(measured_costs.GetNodeCosts("a", &costs));
+  EXPECT_EQ(10, costs.execution_time.asMicroSeconds().count());
+  EXPECT_TRUE(measured_costs.GetNodeCosts("b", &costs));
+  EXPECT_EQ(15, costs.execution_time.asMicroSeconds().count());
+  EXPECT_FALSE(measured_costs.GetNodeCosts("c", &costs));
+}
+
+TEST(MeasuredCostsTest, GpuKernelTimes) {
+  StepStats step_stats;
+  DeviceStepStats* gpu = step_stats.add_dev_stats();
+  gpu->set_device("/job:localhost/replica:0/task:0/gpu:0");
+  AddNodeStats("conv", 0, 2, gpu);
+  DeviceStepStats* all_streams = step_stats.add_dev_stats();
+  all_streams->set_device("/gpu:0/stream:all");
+  AddNodeStats("conv:Conv2D", 10, 110, all_streams);
+  DeviceStepStats* stream = step_stats.add_dev_stats();
+  stream->set_device("/gpu:0/stream:12");
+  AddNodeStats("conv:Conv2D", 10, 110, stream);
+
+  MeasuredCosts measured_costs;
+  measured_costs.AddStepStats(step_stats);
+
+  EXPECT_EQ(1, measured_costs.num_nodes());
+
+  Costs costs;
+  EXPECT_TRUE(measured_costs.GetNodeCosts("conv", &costs));
+  EXPECT_EQ(100, costs.execution_time.asMicroSeconds().count());
+}
+
+TEST(MeasuredCostsTest, CostGraphs) {
+  MeasuredCosts measured_costs;
+  for (int cost : {10, 12, 11, 1000}) {
+    CostGraphDef cost_graph;
+    auto* node = cost_graph.add_node();
+    node->set_name("a");
+    node->set_compute_cost(cost);
+    measured_costs.AddCostGraph(cost_graph);
+  }
+
+  Costs costs;
+  EXPECT_TRUE(measured_costs.GetNodeCosts("a", &costs));
+  // The outlier is mostly ignored.
+  EXPECT_LT(10, costs.execution_time.asMicroSeconds().count());
+  EXPECT_GT(20, costs.execution_time.asMicroSeconds().count());
+  EXPECT_EQ(costs.execution_time, costs.compute_time);
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -17,6 +17,8 @@ limitations under the License.
 
 #include <math.h>
 
+#include <utility>
+
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/tensor.pb.h"
@@ -58,13 +60,93 @@ Costs CombineCosts(const Costs& left, const Costs& right) {
 }
 }  // namespace
 
+void CriticalPathManager::Init(
+    const std::unordered_map<const NodeDef*, NodeState>* node_state) {
+  // The priority of a node is its execution time plus the largest priority of
+  // its outputs. The outputs are visited depth first; an output that is
+  // still being visited closes a loop and is ignored.
+  priorities_.clear();
+  std::unordered_set<const NodeDef*> visiting;
+  std::vector<std::pair<const NodeDef*, bool>> stack;
+  for (const auto& node_and_state : *node_state) {
+    stack.emplace_back(node_and_state.first, false);
+    while (!stack.empty()) {
+      const NodeDef* node = stack.back().first;
+      if (stack.back().second) {
+        stack.pop_back();
+        Costs::Duration max_output_priority;
+        for (const auto& port_and_outputs : node_state->at(node).outputs) {
+          for (const NodeDef* output : port_and_outputs.second) {
+            auto it = priorities_.find(output);
+            if (it != priorities_.end()) {
+              max_output_priority = std::max(max_output_priority, it->second);
+            }
+          }
+        }
+        priorities_[node] = node_time_(*node) + max_output_priority;
+        visiting.erase(node);
+        continue;
+      }
+      if (priorities_.count(node) > 0 || !visiting.insert(node).second) {
+        stack.pop_back();
+        continue;
+      }
+      stack.back().second = true;
+      for (const auto& port_and_outputs : node_state->at(node).outputs) {
+        for (const NodeDef* output : port_and_outputs.second) {
+          if (priorities_.count(output) == 0 && visiting.count(output) == 0) {
+            stack.emplace_back(output, false);
+          }
+        }
+      }
+    }
+  }
+}
+
+Costs::Duration CriticalPathManager::GetPriority(const NodeDef* node) const {
+  auto it = priorities_.find(node);
+  if (it == priorities_.end()) {
+    return Costs::Duration::zero();
+  }
+  return it->second;
+}
+
+void CriticalPathManager::AddNode(const NodeDef* node) {
+  nodes_.emplace(std::make_pair(-GetPriority(node).count(), num_nodes_added_),
+                 node);
+  ++num_nodes_added_;
+}
+
+const NodeDef* CriticalPathManager::GetCurrNode() {
+  if (!has_curr_) {
+    curr_pos_ = nodes_.begin();
+    has_curr_ = true;
+  }
+  return curr_pos_->second;
+}
+
+void CriticalPathManager::RemoveCurrNode() {
+  if (!has_curr_) {
+    curr_pos_ = nodes_.begin();
+  }
+  nodes_.erase(curr_pos_);
+  has_curr_ = false;
+}
+
 VirtualScheduler::VirtualScheduler(const GrapplerItem* grappler_item,
                                    const bool use_static_shapes,
                                    Cluster* cluster)
     :  // Allow LIFO as well as FIFO. LIFO allows an output node of an node to
        // follow it in execution, saving addition memory time from having to
        // write and read. For default cases, use FIFO for performance.
-      ready_nodes_(new FIFOManager()),
+      VirtualScheduler(grappler_item, use_static_shapes, cluster,
+                       new FIFOManager()) {}
+
+VirtualScheduler::VirtualScheduler(const GrapplerItem* grappler_item,
+                                   const bool use_static_shapes,
+                                   Cluster* cluster,
+                                   ReadyNodeManager* ready_nodes)
+    : ready_nodes_(ready_nodes),
       graph_costs_(Costs::ZeroCosts()),
       graph_properties_(*grappler_item),
       cluster_(cluster),
@@ -111,6 +193,7 @@ Status VirtualScheduler::Init() {
 
   // Build node_map; for each node, create its NodeState and connect its inputs
   // and outputs.
+  std::vector<const NodeDef*> initial_nodes;
   for (const auto* curr_node : nodes) {
     auto& curr_node_state = GetNodeStateOrCreateIt(curr_node);
     const string curr_node_device = DeviceName(curr_node);
@@ -164,7 +247,7 @@ Status VirtualScheduler::Init() {
     if (curr_node->input().empty()) {
       // Node without input: ready at time 0.
       curr_node_state.time_ready = Costs::Duration();
-      ready_nodes_->AddNode(curr_node);
+      initial_nodes.push_back(curr_node);
     }
 
     if (IsPersistentNode(curr_node)) {
@@ -177,6 +260,13 @@ Status VirtualScheduler::Init() {
     }
   }
 
+  // The ready node manager may look at the whole graph before picking the
+  // first nodes.
+  ready_nodes_->Init(&node_map_);
+  for (const auto* node : initial_nodes) {
+    ready_nodes_->AddNode(node);
+  }
+
   if (ready_nodes_->Empty()) {
     return Status(error::UNAVAILABLE, "No ready nodes in the graph.");
   }
@@ -311,8 +401,10 @@ std::pair<const NodeDef*, const NodeDef*> VirtualScheduler::CreateSendRecv(
 }
 
 NodeInfo VirtualScheduler::GetCurrNodeInfo() const {
-  const NodeDef* node = ready_nodes_->GetCurrNode();
+  return GetNodeInfo(ready_nodes_->GetCurrNode());
+}
 
+NodeInfo VirtualScheduler::GetNodeInfo(const NodeDef* node) const {
   // Get the device from the placer.
   DeviceProperties device;
   device = placer_.get_device(*node);
@@ -16,7 +16,9 @@ limitations under the License.
 #ifndef THIRD_PARTY_TENSORFLOW_CORE_GRAPPLER_COSTS_VIRTUAL_SCHEDULER_H_
 #define THIRD_PARTY_TENSORFLOW_CORE_GRAPPLER_COSTS_VIRTUAL_SCHEDULER_H_
 
+#include <functional>
 #include <list>
+#include <map>
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
@@ -126,6 +128,10 @@ class ReadyNodeManager {
  public:
   ReadyNodeManager() {}
   virtual ~ReadyNodeManager() {}
+  // Called once the states of all the nodes are known, before any node is
+  // added.
+  virtual void Init(
+      const std::unordered_map<const NodeDef*, NodeState>* node_state) {}
   virtual void AddNode(const NodeDef* node) = 0;
   virtual const NodeDef* GetCurrNode() = 0;
   virtual void RemoveCurrNode() = 0;
@@ -179,6 +185,42 @@ class LIFOManager : public ReadyNodeManager {
   std::list<const NodeDef*>::iterator curr_pos_ = nodes_.end();
 };
 
+// The CriticalPathManager schedules first the ready node with the longest path
+// to the end of the graph, so that the nodes on the critical path aren't
+// delayed by nodes that have slack. The length of a path is the sum of the
+// execution times of its nodes, as given by node_time. Nodes with the same
+// priority are scheduled in FIFO order.
+class CriticalPathManager : public ReadyNodeManager {
+ public:
+  typedef std::function<Costs::Duration(const NodeDef& node)> NodeTimeFn;
+
+  explicit CriticalPathManager(NodeTimeFn node_time)
+      : ReadyNodeManager(), node_time_(std::move(node_time)) {}
+  ~CriticalPathManager() override {}
+  void Init(const std::unordered_map<const NodeDef*, NodeState>* node_state)
+      override;
+  void AddNode(const NodeDef* node) override;
+  const NodeDef* GetCurrNode() override;
+  void RemoveCurrNode() override;
+  bool Empty() const override { return nodes_.empty(); }
+
+  // Returns the length of the longest path from the start of node to the end
+  // of the graph. Nodes that weren't passed to Init() have a zero priority.
+  Costs::Duration GetPriority(const NodeDef* node) const;
+
+ private:
+  NodeTimeFn node_time_;
+  std::unordered_map<const NodeDef*, Costs::Duration> priorities_;
+  // Ready nodes keyed by negated priority, then by insertion order.
+  std::map<std::pair<int64, int64>, const NodeDef*> nodes_;
+  int64 num_nodes_added_ = 0;
+  // Like in the LIFOManager, nodes may be added while the current node is
+  // executing, so the position of the current node is kept until it is
+  // removed.
+  std::map<std::pair<int64, int64>, const NodeDef*>::iterator curr_pos_;
+  bool has_curr_ = false;
+};
+
 // A wrapper struct to OpInfo proto.
 // TODO(dyoon): once we extend OpInfo or implement a better interface, and  then
 // delete this wrapper struct.
@@ -194,12 +236,20 @@ class VirtualScheduler {
  public:
   VirtualScheduler(const GrapplerItem* grappler_item,
                    const bool use_static_shapes, Cluster* cluster);
+  // Like the above, but picks the nodes to schedule with ready_nodes, which
+  // it takes ownership of.
+  VirtualScheduler(const GrapplerItem* grappler_item,
+                   const bool use_static_shapes, Cluster* cluster,
+                   ReadyNodeManager* ready_nodes);
 
   // Initializes NodeState and DeviceState from grappler_item_ and
   // graph_properties_.
   Status Init();
 
   NodeInfo GetCurrNodeInfo() const;
+  // Returns the NodeInfo of any node known to the scheduler. Only valid after
+  // Init().
+  NodeInfo GetNodeInfo(const NodeDef* node) const;
 
   // Returns true if there is any node to be scheduled.
   bool MarkCurrNodeExecuted(const Costs& node_costs);
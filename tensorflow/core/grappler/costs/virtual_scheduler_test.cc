@@ -543,6 +543,58 @@ TEST_F(VirtualSchedulerTest, AddAndRemoveMultipleLIFOManager) {
   EXPECT_TRUE(manager.Empty());
 }
 
+// Test that CriticalPathManager returns the ready node with the longest path
+// to the end of the graph, and keeps the current node until it is removed.
+TEST_F(VirtualSchedulerTest, CriticalPathManager) {
+  // Node1 -> Node2 -> Node3, and Node4 -> Node5, where Node5 is the slowest.
+  std::unordered_map<const NodeDef*, NodeState> node_states;
+  node_states[&node1_].outputs[0] = {&node2_};
+  node_states[&node2_].outputs[0] = {&node3_};
+  node_states[&node3_];
+  node_states[&node4_].outputs[0] = {&node5_};
+  node_states[&node5_];
+  CriticalPathManager manager([](const NodeDef& node) {
+    return Costs::Duration(node.name() == "Node5" ? 10 : 1);
+  });
+  manager.Init(&node_states);
+  EXPECT_EQ(3, manager.GetPriority(&node1_).count());
+  EXPECT_EQ(1, manager.GetPriority(&node3_).count());
+  EXPECT_EQ(11, manager.GetPriority(&node4_).count());
+
+  manager.AddNode(&node1_);
+  manager.AddNode(&node4_);
+  EXPECT_EQ("Node4", manager.GetCurrNode()->name());
+  // Node5 has a higher priority than Node1, but Node4 is still executing.
+  manager.AddNode(&node5_);
+  EXPECT_EQ("Node4", manager.GetCurrNode()->name());
+  manager.RemoveCurrNode();
+  EXPECT_EQ("Node5", manager.GetCurrNode()->name());
+  manager.RemoveCurrNode();
+  EXPECT_EQ("Node1", manager.GetCurrNode()->name());
+  manager.AddNode(&node2_);
+  manager.RemoveCurrNode();
+  EXPECT_EQ("Node2", manager.GetCurrNode()->name());
+  manager.RemoveCurrNode();
+  EXPECT_TRUE(manager.Empty());
+}
+
+// Test that CriticalPathManager computes priorities in graphs with loops.
+TEST_F(VirtualSchedulerTest, CriticalPathManagerWithLoop) {
+  // Node1 -> Node2 -> Node3 -> Node2.
+  std::unordered_map<const NodeDef*, NodeState> node_states;
+  node_states[&node1_].outputs[0] = {&node2_};
+  node_states[&node2_].outputs[0] = {&node3_};
+  node_states[&node3_].outputs[0] = {&node2_};
+  CriticalPathManager manager(
+      [](const NodeDef& node) { return Costs::Duration(1); });
+  manager.Init(&node_states);
+  // The back edge is ignored, but which edge of the loop is the back edge
+  // depends on where the search starts.
+  EXPECT_LE(2, manager.GetPriority(&node1_).count());
+  EXPECT_LE(1, manager.GetPriority(&node2_).count());
+  EXPECT_LE(1, manager.GetPriority(&node3_).count());
+}
+
 // Create small graph, run predict costs on it, make sure the costs from the
 // summary match the hand-calculated costs.
 TEST_F(VirtualSchedulerTest, SummaryCostTest) {
@@ -18,6 +18,16 @@ limitations under the License.
 namespace tensorflow {
 namespace grappler {
 
+bool IsAddN(const NodeDef& node) {
+  const auto op = node.op();
+  return op == "AddN";
+}
+
+bool IsCast(const NodeDef& node) {
+  const auto op = node.op();
+  return op == "Cast";
+}
+
 bool IsConcat(const NodeDef& node) {
   const auto op = node.op();
   return op == "Concat" || op == "ConcatV2";
@@ -35,16 +45,36 @@ bool IsDequeueOp(const NodeDef& node) {
          op == "QueueDequeueUpToV2" || op == "QueueDequeueUpTo";
 }
 
+bool IsEnter(const NodeDef& node) {
+  const auto& op = node.op();
+  return op == "Enter" || op == "RefEnter";
+}
+
+bool IsExit(const NodeDef& node) {
+  const auto& op = node.op();
+  return op == "Exit" || op == "RefExit";
+}
+
 bool IsIdentity(const NodeDef& node) {
   const auto& op = node.op();
   return op == "Identity";
 }
 
+bool IsLoopCond(const NodeDef& node) {
+  const auto& op = node.op();
+  return op == "LoopCond";
+}
+
 bool IsMerge(const NodeDef& node) {
   const auto op = node.op();
   return op == "Merge";
 }
 
+bool IsMul(const NodeDef& node) {
+  const auto op = node.op();
+  return op == "Mul";
+}
+
 bool IsNoOp(const NodeDef& node) {
   const auto op = node.op();
   return op == "NoOp";
@@ -79,6 +109,11 @@ bool IsSend(const NodeDef& node) {
   return op == "_Send";
 }
 
+bool IsSqueeze(const NodeDef& node) {
+  const auto op = node.op();
+  return op == "Squeeze";
+}
+
 bool IsSwitch(const NodeDef& node) {
   const auto& op = node.op();
   return op == "Switch";
@@ -21,11 +21,17 @@ limitations under the License.
 namespace tensorflow {
 namespace grappler {
 
+bool IsAddN(const NodeDef& node);
+bool IsCast(const NodeDef& node);
 bool IsConcat(const NodeDef& node);
 bool IsConstant(const NodeDef& node);
 bool IsDequeueOp(const NodeDef& node);
+bool IsEnter(const NodeDef& node);
+bool IsExit(const NodeDef& node);
 bool IsIdentity(const NodeDef& node);
+bool IsLoopCond(const NodeDef& node);
 bool IsMerge(const NodeDef& node);
+bool IsMul(const NodeDef& node);
 bool IsNextIteration(const NodeDef& node);
 bool IsNoOp(const NodeDef& node);
 bool IsPlaceholder(const NodeDef& node);
@@ -33,6 +39,7 @@ bool IsRecv(const NodeDef& node);
 bool IsReduction(const NodeDef& node);
 bool IsReshape(const NodeDef& node);
 bool IsSend(const NodeDef& node);
+bool IsSqueeze(const NodeDef& node);
 bool IsSwitch(const NodeDef& node);
 bool IsTranspose(const NodeDef& node);
 bool IsVariable(const NodeDef& node);
@@ -0,0 +1,527 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/arithmetic_optimizer.h"
+#include <algorithm>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+const char kArithmeticOptimizer[] = "ArithmeticOptimizer";
+
+bool HasControlInputs(const NodeDef& node) {
+  for (const string& input : node.input()) {
+    if (IsControlInput(input)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns the node that produces output 0 consumed by 'input', or nullptr if
+// 'input' is a control input or reads another output.
+NodeDef* GetFirstOutputProducer(const string& input, const NodeMap& node_map) {
+  int position;
+  ParseNodeName(input, &position);
+  if (position != 0) {
+    return nullptr;
+  }
+  return node_map.GetNode(input);
+}
+
+// Reads the permutation held by the constant 'node'.
+bool GetPermutation(const NodeDef& node, std::vector<int64>* perm) {
+  if (!IsConstant(node) || node.attr().count("value") == 0) {
+    return false;
+  }
+  Tensor tensor;
+  if (!tensor.FromProto(node.attr().at("value").tensor()) ||
+      tensor.dims() != 1) {
+    return false;
+  }
+  perm->clear();
+  if (tensor.dtype() == DT_INT32) {
+    for (int i = 0; i < tensor.NumElements(); ++i) {
+      perm->push_back(tensor.vec<int32>()(i));
+    }
+  } else if (tensor.dtype() == DT_INT64) {
+    for (int i = 0; i < tensor.NumElements(); ++i) {
+      perm->push_back(tensor.vec<int64>()(i));
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Returns true if every value of type 'from' is exactly representable in type
+// 'to', so that casting to 'to' and back to 'from' is the identity.
+bool IsLosslessCast(DataType from, DataType to) {
+  static const std::set<std::pair<DataType, DataType>>* lossless_casts =
+      new std::set<std::pair<DataType, DataType>>({
+          {DT_HALF, DT_FLOAT},    {DT_HALF, DT_DOUBLE},  {DT_FLOAT, DT_DOUBLE},
+          {DT_INT8, DT_INT16},    {DT_INT8, DT_INT32},   {DT_INT8, DT_INT64},
+          {DT_INT8, DT_FLOAT},    {DT_INT8, DT_DOUBLE},  {DT_INT16, DT_INT32},
+          {DT_INT16, DT_INT64},   {DT_INT16, DT_FLOAT},  {DT_INT16, DT_DOUBLE},
+          {DT_INT32, DT_INT64},   {DT_INT32, DT_DOUBLE}, {DT_UINT8, DT_INT16},
+          {DT_UINT8, DT_UINT16},  {DT_UINT8, DT_INT32},  {DT_UINT8, DT_INT64},
+          {DT_UINT8, DT_FLOAT},   {DT_UINT8, DT_DOUBLE}, {DT_UINT16, DT_INT32},
+          {DT_UINT16, DT_INT64},  {DT_UINT16, DT_FLOAT}, {DT_UINT16, DT_DOUBLE},
+          {DT_BOOL, DT_INT32},    {DT_BOOL, DT_INT64},
+      });
+  return lossless_casts->count({from, to}) > 0;
+}
+
+// Returns true if both shapes are fully defined and identical.
+bool ShapesAreIdentical(const TensorShapeProto& shape1,
+                        const TensorShapeProto& shape2) {
+  const PartialTensorShape partial_shape1(shape1);
+  const PartialTensorShape partial_shape2(shape2);
+  return partial_shape1.IsFullyDefined() &&
+         partial_shape1.IsIdenticalTo(partial_shape2);
+}
+
+// Returns a string that is identical for two nodes iff they compute the same
+// value: same op, device, attributes and inputs. The order of the control
+// inputs does not matter.
+string NodeSignature(const NodeDef& node) {
+  string signature = strings::StrCat(node.op(), ";", node.device(), ";");
+  std::vector<string> control_inputs;
+  for (const string& input : node.input()) {
+    if (IsControlInput(input)) {
+      control_inputs.push_back(input);
+    } else {
+      strings::StrAppend(&signature, input, ",");
+    }
+  }
+  std::sort(control_inputs.begin(), control_inputs.end());
+  for (const string& input : control_inputs) {
+    strings::StrAppend(&signature, input, ",");
+  }
+  std::map<string, const AttrValue*> attrs;
+  for (const auto& attr : node.attr()) {
+    attrs[attr.first] = &attr.second;
+  }
+  for (const auto& attr : attrs) {
+    string value;
+    attr.second->SerializeToString(&value);
+    strings::StrAppend(&signature, ";", attr.first, "=", value);
+  }
+  return signature;
+}
+
+}  // namespace
+
+bool ArithmeticOptimizer::CanDedup(const NodeDef& node) const {
+  if (nodes_to_preserve_.find(node.name()) != nodes_to_preserve_.end()) {
+    return false;
+  }
+  // Nodes without inputs, such as placeholders, are only interchangeable if
+  // they are constants.
+  if (node.input_size() == 0 && !IsConstant(node)) {
+    return false;
+  }
+  if (IsMerge(node) || IsSwitch(node) || IsNextIteration(node) ||
+      IsSend(node) || IsRecv(node)) {
+    return false;
+  }
+  const OpDef* op_def = nullptr;
+  Status status = OpRegistry::Global()->LookUpOpDef(node.op(), &op_def);
+  if (!status.ok()) {
+    return false;
+  }
+  if (op_def->is_stateful()) {
+    return false;
+  }
+  // Nodes that forward references may be used to mutate their input.
+  for (const auto& output_arg : op_def->output_arg()) {
+    if (output_arg.is_ref()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ArithmeticOptimizer::DedupComputations(GraphDef* optimized_graph) const {
+  NodeMap node_map(optimized_graph);
+  std::set<int> duplicates;
+  bool stop = true;
+  do {
+    stop = true;
+    std::unordered_map<string, NodeDef*> representatives;
+    for (int i = 0; i < optimized_graph->node_size(); ++i) {
+      if (duplicates.find(i) != duplicates.end()) {
+        continue;
+      }
+      NodeDef* node = optimized_graph->mutable_node(i);
+      if (!CanDedup(*node)) {
+        continue;
+      }
+      NodeDef*& rep = representatives[NodeSignature(*node)];
+      if (rep == nullptr) {
+        rep = node;
+        continue;
+      }
+      // Make every consumer of 'node' read from 'rep' instead.
+      for (NodeDef* fanout : node_map.GetOutputs(node->name())) {
+        for (string& input : *fanout->mutable_input()) {
+          int position;
+          const string input_node = ParseNodeName(input, &position);
+          if (input_node != node->name()) {
+            continue;
+          }
+          if (position < 0) {
+            input = strings::StrCat("^", rep->name());
+          } else if (position == 0) {
+            input = rep->name();
+          } else {
+            input = strings::StrCat(rep->name(), ":", position);
+          }
+          node_map.AddOutput(rep->name(), fanout->name());
+        }
+      }
+      duplicates.insert(i);
+      stop = false;
+    }
+  } while (!stop);
+
+  if (duplicates.empty()) {
+    return;
+  }
+  VLOG(1) << "Deduped " << duplicates.size() << " nodes";
+  // Move the duplicates to the end of the node list and drop them.
+  int last = optimized_graph->node_size() - 1;
+  for (auto it = duplicates.rbegin(); it != duplicates.rend(); ++it) {
+    optimized_graph->mutable_node()->SwapElements(*it, last);
+    --last;
+  }
+  optimized_graph->mutable_node()->DeleteSubrange(last + 1,
+                                                  duplicates.size());
+}
+
+string ArithmeticOptimizer::TrySimplifyTranspose(
+    const NodeDef& node, const NodeMap& node_map) const {
+  // Transpose(Transpose(x, perm1), perm2) => x if perm2 undoes perm1.
+  if (!IsTranspose(node) || node.input_size() != 2 || HasControlInputs(node)) {
+    return "";
+  }
+  const NodeDef* inner = GetFirstOutputProducer(node.input(0), node_map);
+  if (inner == nullptr || !IsTranspose(*inner) || inner->input_size() != 2 ||
+      HasControlInputs(*inner)) {
+    return "";
+  }
+  const NodeDef* perm1_node = node_map.GetNode(inner->input(1));
+  const NodeDef* perm2_node = node_map.GetNode(node.input(1));
+  std::vector<int64> perm1;
+  std::vector<int64> perm2;
+  if (perm1_node == nullptr || perm2_node == nullptr ||
+      !GetPermutation(*perm1_node, &perm1) ||
+      !GetPermutation(*perm2_node, &perm2) || perm1.size() != perm2.size()) {
+    return "";
+  }
+  // Output dimension i of the outer transpose is input dimension
+  // perm1[perm2[i]].
+  const int64 rank = perm1.size();
+  for (int64 i = 0; i < rank; ++i) {
+    if (perm2[i] < 0 || perm2[i] >= rank || perm1[perm2[i]] != i) {
+      return "";
+    }
+  }
+  return inner->input(0);
+}
+
+string ArithmeticOptimizer::TrySimplifyCast(const NodeDef& node,
+                                            const NodeMap& node_map) const {
+  // Cast has a single data input, so this also skips the casts with control
+  // inputs, which forwarding would drop.
+  if (!IsCast(node) || node.input_size() != 1) {
+    return "";
+  }
+  const DataType src_type = node.attr().at("SrcT").type();
+  const DataType dst_type = node.attr().at("DstT").type();
+  // Cast(x) => x if the cast doesn't change the type.
+  if (src_type == dst_type) {
+    return node.input(0);
+  }
+  // Cast(Cast(x)) => x if the inner cast is lossless and the outer one casts
+  // back to the original type.
+  const NodeDef* inner = GetFirstOutputProducer(node.input(0), node_map);
+  if (inner == nullptr || !IsCast(*inner) || inner->input_size() != 1) {
+    return "";
+  }
+  const DataType inner_src_type = inner->attr().at("SrcT").type();
+  if (inner_src_type == dst_type && IsLosslessCast(inner_src_type, src_type)) {
+    return inner->input(0);
+  }
+  return "";
+}
+
+bool ArithmeticOptimizer::TryFoldReshapes(NodeDef* node,
+                                          NodeMap* node_map) const {
+  // Reshape(Reshape(x, shape1), shape2) => Reshape(x, shape2), and likewise
+  // when the inner node is a Squeeze or an ExpandDims: the outer reshape
+  // fixes the output shape regardless of the shape of its input.
+  if (!IsReshape(*node) || node->input_size() < 2) {
+    return false;
+  }
+  string input = node->input(0);
+  while (true) {
+    const NodeDef* inner = GetFirstOutputProducer(input, *node_map);
+    if (inner == nullptr || HasControlInputs(*inner) ||
+        !(IsReshape(*inner) || IsSqueeze(*inner) ||
+          inner->op() == "ExpandDims")) {
+      break;
+    }
+    input = inner->input(0);
+  }
+  if (input == node->input(0)) {
+    return false;
+  }
+  *node->mutable_input(0) = input;
+  node_map->AddOutput(NodeName(input), node->name());
+  return true;
+}
+
+string ArithmeticOptimizer::TrySimplifySqueeze(
+    const NodeDef& node, const GraphProperties& properties) const {
+  // Squeeze(x) => x if the shape of x has no dimensions of size 1 to remove.
+  if (!IsSqueeze(node) || node.input_size() != 1 ||
+      HasControlInputs(node) ||
+      !properties.HasInputProperties(node.name()) ||
+      !properties.HasOutputProperties(node.name())) {
+    return "";
+  }
+  const auto& input_props = properties.GetInputProperties(node.name());
+  const auto& output_props = properties.GetOutputProperties(node.name());
+  if (input_props.empty() || output_props.empty() ||
+      !ShapesAreIdentical(input_props[0].shape(), output_props[0].shape())) {
+    return "";
+  }
+  return node.input(0);
+}
+
+string ArithmeticOptimizer::TryHoistCommonFactor(
+    const NodeDef& node, const GraphProperties& properties, GraphDef* graph_def,
+    NodeMap* node_map, std::vector<NodeDef*>* new_nodes) const {
+  // AddN(Mul(x, y1), Mul(y2, x), ..., Mul(x, yn)) => Mul(x, AddN(y1, ..., yn))
+  // if all the yi have the same shape, so that the sum doesn't broadcast.
+  if (!IsAddN(node) || node.input_size() < 2 || HasControlInputs(node)) {
+    return "";
+  }
+  std::vector<const NodeDef*> muls;
+  for (const string& input : node.input()) {
+    const NodeDef* mul = GetFirstOutputProducer(input, *node_map);
+    if (mul == nullptr || !IsMul(*mul) || mul->input_size() != 2 ||
+        HasControlInputs(*mul) ||
+        nodes_to_preserve_.find(mul->name()) != nodes_to_preserve_.end() ||
+        node_map->GetOutputs(mul->name()).size() != 1) {
+      return "";
+    }
+    muls.push_back(mul);
+  }
+
+  for (int factor_index = 0; factor_index < 2; ++factor_index) {
+    const string& common_factor = muls[0]->input(factor_index);
+    std::vector<string> unique_factors;
+    bool shapes_match = true;
+    const TensorShapeProto* unique_factor_shape = nullptr;
+    for (const NodeDef* mul : muls) {
+      int unique_index;
+      if (IsSameInput(mul->input(0), common_factor)) {
+        unique_index = 1;
+      } else if (IsSameInput(mul->input(1), common_factor)) {
+        unique_index = 0;
+      } else {
+        break;
+      }
+      unique_factors.push_back(mul->input(unique_index));
+      const auto& props = properties.GetInputProperties(mul->name());
+      if (props.size() != 2) {
+        shapes_match = false;
+        break;
+      }
+      const TensorShapeProto& shape = props[unique_index].shape();
+      if (unique_factor_shape == nullptr) {
+        unique_factor_shape = &shape;
+      }
+      if (!ShapesAreIdentical(*unique_factor_shape, shape)) {
+        shapes_match = false;
+        break;
+      }
+    }
+    if (!shapes_match || unique_factors.size() != muls.size()) {
+      continue;
+    }
+
+    const string add_name = AddPrefixToNodeName(
+        node.name(), strings::StrCat(kArithmeticOptimizer, "/HoistAdd"));
+    const string mul_name = AddPrefixToNodeName(
+        node.name(), strings::StrCat(kArithmeticOptimizer, "/HoistMul"));
+    if (node_map->GetNode(add_name) != nullptr ||
+        node_map->GetNode(mul_name) != nullptr) {
+      return "";
+    }
+    const AttrValue& type_attr = node.attr().at("T");
+
+    NodeDef* new_add = graph_def->add_node();
+    new_add->set_name(add_name);
+    new_add->set_op("AddN");
+    new_add->set_device(node.device());
+    (*new_add->mutable_attr())["T"] = type_attr;
+    (*new_add->mutable_attr())["N"].set_i(unique_factors.size());
+    node_map->AddNode(add_name, new_add);
+    for (const string& unique_factor : unique_factors) {
+      *new_add->add_input() = unique_factor;
+      node_map->AddOutput(NodeName(unique_factor), add_name);
+    }
+
+    NodeDef* new_mul = graph_def->add_node();
+    new_mul->set_name(mul_name);
+    new_mul->set_op("Mul");
+    new_mul->set_device(node.device());
+    (*new_mul->mutable_attr())["T"] = type_attr;
+    *new_mul->add_input() = common_factor;
+    *new_mul->add_input() = add_name;
+    node_map->AddNode(mul_name, new_mul);
+    node_map->AddOutput(NodeName(common_factor), mul_name);
+    node_map->AddOutput(add_name, mul_name);
+
+    new_nodes->push_back(new_add);
+    new_nodes->push_back(new_mul);
+    return mul_name;
+  }
+  return "";
+}
+
+string ArithmeticOptimizer::TrySimplify(
+    const NodeDef& node, const GraphProperties& properties, GraphDef* graph_def,
+    NodeMap* node_map, std::vector<NodeDef*>* new_nodes) const {
+  string simplified = TrySimplifyTranspose(node, *node_map);
+  if (simplified.empty()) {
+    simplified = TrySimplifyCast(node, *node_map);
+  }
+  if (simplified.empty()) {
+    simplified = TrySimplifySqueeze(node, properties);
+  }
+  if (simplified.empty()) {
+    simplified = TryHoistCommonFactor(node, properties, graph_def, node_map,
+                                      new_nodes);
+  }
+  return simplified;
+}
+
+void ArithmeticOptimizer::SimplifyArithmeticOps(
+    GraphDef* optimized_graph, const GraphProperties& properties) const {
+  NodeMap node_map(optimized_graph);
+  std::vector<NodeDef*> nodes_to_simplify;
+  for (int i = 0; i < optimized_graph->node_size(); ++i) {
+    nodes_to_simplify.push_back(optimized_graph->mutable_node(i));
+  }
+  int num_simplified = 0;
+  while (!nodes_to_simplify.empty()) {
+    NodeDef* node = nodes_to_simplify.back();
+    nodes_to_simplify.pop_back();
+    if (TryFoldReshapes(node, &node_map)) {
+      ++num_simplified;
+    }
+    if (nodes_to_preserve_.find(node->name()) != nodes_to_preserve_.end()) {
+      continue;
+    }
+    std::vector<NodeDef*> new_nodes;
+    const string simplified =
+        TrySimplify(*node, properties, optimized_graph, &node_map, &new_nodes);
+    if (simplified.empty()) {
+      continue;
+    }
+    ++num_simplified;
+
+    // Forward the data consumers of 'node' to 'simplified'. Control
+    // dependencies on 'node' are left alone: 'node' stays in the graph, and
+    // is only run if something still depends on it.
+    const std::set<NodeDef*> consumers = node_map.GetOutputs(node->name());
+    for (NodeDef* consumer : consumers) {
+      bool updated = false;
+      for (string& input : *consumer->mutable_input()) {
+        int position;
+        if (ParseNodeName(input, &position) == node->name() &&
+            position == 0) {
+          input = simplified;
+          updated = true;
+        }
+      }
+      if (updated) {
+        node_map.AddOutput(NodeName(simplified), consumer->name());
+        nodes_to_simplify.push_back(consumer);
+      }
+    }
+    for (NodeDef* new_node : new_nodes) {
+      nodes_to_simplify.push_back(new_node);
+    }
+  }
+  VLOG(1) << "Applied " << num_simplified << " arithmetic simplifications";
+}
+
+Status ArithmeticOptimizer::Optimize(Cluster* /*cluster*/,
+                                     const GrapplerItem& item,
+                                     GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  nodes_to_preserve_.clear();
+  for (const auto& fetch : item.fetch) {
+    nodes_to_preserve_.insert(NodeName(fetch));
+  }
+  for (const auto& feed : item.feed) {
+    nodes_to_preserve_.insert(NodeName(feed.first));
+  }
+  for (const auto& init_op : item.init_ops) {
+    nodes_to_preserve_.insert(NodeName(init_op));
+  }
+
+  // The shape-dependent simplifications are skipped for the nodes whose
+  // shapes can't be inferred.
+  GraphProperties properties(item);
+  Status s = properties.InferStatically();
+  if (!s.ok()) {
+    VLOG(1) << "Failed to infer graph shapes: " << s;
+  }
+
+  DedupComputations(optimized_graph);
+  SimplifyArithmeticOps(optimized_graph, properties);
+  return Status::OK();
+}
+
+void ArithmeticOptimizer::Feedback(Cluster* /*cluster*/,
+                                   const GrapplerItem& /*item*/,
+                                   const GraphDef& /*optimized_graph*/,
+                                   double /*result*/) {
+  // Nothing to do for ArithmeticOptimizer.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,80 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_GRAPPLER_OPTIMIZERS_ARITHMETIC_OPTIMIZER_H_
+#define TENSORFLOW_GRAPPLER_OPTIMIZERS_ARITHMETIC_OPTIMIZER_H_
+
+#include <unordered_set>
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/grappler/utils.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Optimize TF computations by deduping equivalent subgraphs and by applying
+// arithmetic simplifications, such as removing pairs of transposes that cancel
+// out, redundant casts, chained reshapes, and hoisting common factors out of
+// sums.
+class ArithmeticOptimizer : public GraphOptimizer {
+ public:
+  ArithmeticOptimizer() {}
+  ~ArithmeticOptimizer() override {}
+
+  string name() const override { return "arithmetic_optimizer"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override;
+
+ private:
+  // Returns true if 'node' may be replaced by an equivalent node.
+  bool CanDedup(const NodeDef& node) const;
+  // Replaces every node with a previously seen equivalent node (same op,
+  // device, attributes and inputs) and deletes the duplicates.
+  void DedupComputations(GraphDef* optimized_graph) const;
+
+  // Runs the peephole simplifications below until none of them applies.
+  void SimplifyArithmeticOps(GraphDef* optimized_graph,
+                             const GraphProperties& properties) const;
+  // Makes the Reshape 'node' read directly from the start of the chain of
+  // reshapes that feeds it. Returns true if 'node' was rewritten.
+  bool TryFoldReshapes(NodeDef* node, NodeMap* node_map) const;
+  // Tries to simplify 'node'. Returns the name of the tensor that replaces the
+  // output of 'node', or the empty string if 'node' cannot be simplified.
+  // Nodes created along the way are appended to 'new_nodes'.
+  string TrySimplify(const NodeDef& node, const GraphProperties& properties,
+                     GraphDef* graph_def, NodeMap* node_map,
+                     std::vector<NodeDef*>* new_nodes) const;
+
+  string TrySimplifyTranspose(const NodeDef& node,
+                              const NodeMap& node_map) const;
+  string TrySimplifyCast(const NodeDef& node, const NodeMap& node_map) const;
+  string TrySimplifySqueeze(const NodeDef& node,
+                            const GraphProperties& properties) const;
+  string TryHoistCommonFactor(const NodeDef& node,
+                              const GraphProperties& properties,
+                              GraphDef* graph_def, NodeMap* node_map,
+                              std::vector<NodeDef*>* new_nodes) const;
+
+  std::unordered_set<string> nodes_to_preserve_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_OPTIMIZERS_ARITHMETIC_OPTIMIZER_H_
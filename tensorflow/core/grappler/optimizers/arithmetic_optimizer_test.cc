@@ -0,0 +1,301 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/arithmetic_optimizer.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class ArithmeticOptimizerTest : public ::testing::Test {
+ protected:
+  std::vector<Tensor> EvaluateNodes(const GraphDef& graph,
+                                    const std::vector<string>& fetch) {
+    SessionOptions options;
+    std::unique_ptr<tensorflow::Session> session(NewSession(options));
+    TF_CHECK_OK(session->Create(graph));
+    RunOptions run_options;
+    std::vector<Tensor> output_tensors;
+    TF_CHECK_OK(
+        session->Run(run_options, {}, fetch, fetch, &output_tensors, nullptr));
+    TF_CHECK_OK(session->Close());
+    return output_tensors;
+  }
+
+  // Checks that 'output' computes the same values as 'item' for its fetches.
+  void ExpectSameResults(const GrapplerItem& item, const GraphDef& output) {
+    auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+    auto tensors = EvaluateNodes(output, item.fetch);
+    ASSERT_EQ(tensors_expected.size(), tensors.size());
+    for (int i = 0; i < tensors.size(); ++i) {
+      test::ExpectTensorNear<float>(tensors_expected[i], tensors[i], 1e-6);
+    }
+  }
+};
+
+TEST_F(ArithmeticOptimizerTest, NoOp) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Const(s.WithOpName("a"), 1.0f, {2});
+  Output b = ops::Const(s.WithOpName("b"), 2.0f, {2});
+  Output c = ops::Add(s.WithOpName("c"), a, b);
+
+  GrapplerItem item;
+  item.fetch = {"c"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ArithmeticOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+}
+
+TEST_F(ArithmeticOptimizerTest, DedupComputations) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Const(s.WithOpName("a"), 1.0f, {2});
+  Output b = ops::Const(s.WithOpName("b"), 2.0f, {2});
+  Output c1 = ops::Add(s.WithOpName("c1"), a, b);
+  Output c2 = ops::Add(s.WithOpName("c2"), a, b);
+  Output d1 = ops::Sqrt(s.WithOpName("d1"), c1);
+  Output d2 = ops::Sqrt(s.WithOpName("d2"), c2);
+  Output e = ops::Mul(s.WithOpName("e"), d1, d2);
+
+  GrapplerItem item;
+  item.fetch = {"e"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ArithmeticOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // c2 and d2 are duplicates of c1 and d1.
+  EXPECT_EQ(item.graph.node_size() - 2, output.node_size());
+  NodeMap node_map(&output);
+  EXPECT_EQ(nullptr, node_map.GetNode("c2"));
+  EXPECT_EQ(nullptr, node_map.GetNode("d2"));
+  const NodeDef* new_e = node_map.GetNode("e");
+  ASSERT_NE(nullptr, new_e);
+  EXPECT_EQ("d1", new_e->input(0));
+  EXPECT_EQ("d1", new_e->input(1));
+  ExpectSameResults(item, output);
+}
+
+TEST_F(ArithmeticOptimizerTest, NoDedupAcrossDevices) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Const(s.WithOpName("a"), 1.0f, {2});
+  Output c1 = ops::Sqrt(s.WithOpName("c1").WithDevice("/CPU:0"), a);
+  Output c2 = ops::Sqrt(s.WithOpName("c2").WithDevice("/CPU:1"), a);
+  Output d = ops::Add(s.WithOpName("d"), c1, c2);
+
+  GrapplerItem item;
+  item.fetch = {"d"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ArithmeticOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+}
+
+TEST_F(ArithmeticOptimizerTest, RemoveInverseTransposes) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Const(s.WithOpName("x"), {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f},
+                        {1, 2, 3});
+  Output perm1 = ops::Const(s.WithOpName("perm1"), {2, 0, 1}, {3});
+  Output perm2 = ops::Const(s.WithOpName("perm2"), {1, 2, 0}, {3});
+  Output t1 = ops::Transpose(s.WithOpName("t1"), x, perm1);
+  Output t2 = ops::Transpose(s.WithOpName("t2"), t1, perm2);
+  Output y = ops::Sqrt(s.WithOpName("y"), t2);
+
+  GrapplerItem item;
+  item.fetch = {"y"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ArithmeticOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* new_y = node_map.GetNode("y");
+  ASSERT_NE(nullptr, new_y);
+  EXPECT_EQ("x", new_y->input(0));
+  ExpectSameResults(item, output);
+}
+
+TEST_F(ArithmeticOptimizerTest, KeepNonInverseTransposes) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Const(s.WithOpName("x"), {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f},
+                        {1, 2, 3});
+  Output perm = ops::Const(s.WithOpName("perm"), {2, 0, 1}, {3});
+  Output t1 = ops::Transpose(s.WithOpName("t1"), x, perm);
+  Output t2 = ops::Transpose(s.WithOpName("t2"), t1, perm);
+  Output y = ops::Sqrt(s.WithOpName("y"), t2);
+
+  GrapplerItem item;
+  item.fetch = {"y"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ArithmeticOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ("t2", node_map.GetNode("y")->input(0));
+}
+
+TEST_F(ArithmeticOptimizerTest, RemoveRedundantCasts) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Const(s.WithOpName("x"), {1.0f, 2.0f}, {2});
+  Output same = ops::Cast(s.WithOpName("same"), x, DT_FLOAT);
+  Output up = ops::Cast(s.WithOpName("up"), same, DT_DOUBLE);
+  Output down = ops::Cast(s.WithOpName("down"), up, DT_FLOAT);
+  Output y = ops::Sqrt(s.WithOpName("y"), down);
+
+  GrapplerItem item;
+  item.fetch = {"y"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ArithmeticOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ("x", node_map.GetNode("y")->input(0));
+  ExpectSameResults(item, output);
+}
+
+TEST_F(ArithmeticOptimizerTest, KeepLossyCasts) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Const(s.WithOpName("x"), {1.5f, 2.5f}, {2});
+  Output down = ops::Cast(s.WithOpName("down"), x, DT_INT32);
+  Output up = ops::Cast(s.WithOpName("up"), down, DT_FLOAT);
+  Output y = ops::Sqrt(s.WithOpName("y"), up);
+
+  GrapplerItem item;
+  item.fetch = {"y"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ArithmeticOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ("up", node_map.GetNode("y")->input(0));
+}
+
+TEST_F(ArithmeticOptimizerTest, FoldReshapeChain) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Const(s.WithOpName("x"), {1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f},
+                        {1, 2, 3});
+  Output squeeze = ops::Squeeze(s.WithOpName("squeeze"), x);
+  Output r1 = ops::Reshape(s.WithOpName("r1"), squeeze, {6});
+  Output r2 = ops::Reshape(s.WithOpName("r2"), r1, {3, 2});
+  Output y = ops::Sqrt(s.WithOpName("y"), r2);
+
+  GrapplerItem item;
+  item.fetch = {"y"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ArithmeticOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* new_r2 = node_map.GetNode("r2");
+  ASSERT_NE(nullptr, new_r2);
+  EXPECT_EQ("x", new_r2->input(0));
+  EXPECT_EQ("r2", node_map.GetNode("y")->input(0));
+  ExpectSameResults(item, output);
+}
+
+TEST_F(ArithmeticOptimizerTest, RemoveNoOpSqueeze) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Const(s.WithOpName("x"), {1.0f, 2.0f, 3.0f, 4.0f}, {2, 2});
+  Output squeeze = ops::Squeeze(s.WithOpName("squeeze"), x);
+  Output y = ops::Sqrt(s.WithOpName("y"), squeeze);
+
+  GrapplerItem item;
+  item.fetch = {"y"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ArithmeticOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  EXPECT_EQ("x", node_map.GetNode("y")->input(0));
+  ExpectSameResults(item, output);
+}
+
+TEST_F(ArithmeticOptimizerTest, HoistCommonFactor) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Const(s.WithOpName("x"), {1.0f, 2.0f}, {2});
+  Output y1 = ops::Const(s.WithOpName("y1"), {3.0f, 4.0f}, {2});
+  Output y2 = ops::Const(s.WithOpName("y2"), {5.0f, 6.0f}, {2});
+  Output m1 = ops::Mul(s.WithOpName("m1"), x, y1);
+  Output m2 = ops::Mul(s.WithOpName("m2"), y2, x);
+  Output sum = ops::AddN(s.WithOpName("sum"), {m1, m2});
+  Output z = ops::Sqrt(s.WithOpName("z"), sum);
+
+  GrapplerItem item;
+  item.fetch = {"z"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ArithmeticOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  NodeMap node_map(&output);
+  const NodeDef* new_mul = node_map.GetNode("ArithmeticOptimizer/HoistMul/sum");
+  const NodeDef* new_add = node_map.GetNode("ArithmeticOptimizer/HoistAdd/sum");
+  ASSERT_NE(nullptr, new_mul);
+  ASSERT_NE(nullptr, new_add);
+  EXPECT_EQ("x", new_mul->input(0));
+  EXPECT_EQ(new_add->name(), new_mul->input(1));
+  EXPECT_EQ("y1", new_add->input(0));
+  EXPECT_EQ("y2", new_add->input(1));
+  EXPECT_EQ(new_mul->name(), node_map.GetNode("z")->input(0));
+  ExpectSameResults(item, output);
+}
+
+TEST_F(ArithmeticOptimizerTest, NoHoistWhenFactorsBroadcast) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Const(s.WithOpName("x"), {1.0f, 2.0f}, {2});
+  Output y1 = ops::Const(s.WithOpName("y1"), 3.0f, {1});
+  Output y2 = ops::Const(s.WithOpName("y2"), {5.0f, 6.0f}, {2});
+  Output m1 = ops::Mul(s.WithOpName("m1"), x, y1);
+  Output m2 = ops::Mul(s.WithOpName("m2"), x, y2);
+  Output sum = ops::AddN(s.WithOpName("sum"), {m1, m2});
+
+  GrapplerItem item;
+  item.fetch = {"sum"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  ArithmeticOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
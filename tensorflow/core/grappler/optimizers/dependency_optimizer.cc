@@ -0,0 +1,318 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/dependency_optimizer.h"
+#include <deque>
+#include <set>
+#include <unordered_set>
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// The maximum number of nodes visited when looking for an alternative path
+// to a control input. Control edges that would need a longer search are
+// kept.
+const int kMaxReachabilityVisits = 1024;
+
+string AsControlDependency(const string& node_name) {
+  return strings::StrCat("^", node_name);
+}
+
+bool IsControlFlow(const NodeDef& node) {
+  return IsSwitch(node) || IsMerge(node) || IsEnter(node) || IsExit(node) ||
+         IsNextIteration(node);
+}
+
+// Returns true if 'node' produces a reference. Nodes that can't be found in
+// the op registry are assumed to.
+bool HasRefOutput(const NodeDef& node) {
+  const OpDef* op_def = nullptr;
+  if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok()) {
+    return true;
+  }
+  for (const auto& output_arg : op_def->output_arg()) {
+    if (output_arg.is_ref()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int CountEdges(const GraphDef& graph) {
+  int num_edges = 0;
+  for (const NodeDef& node : graph.node()) {
+    num_edges += node.input_size();
+  }
+  return num_edges;
+}
+
+// Returns true if the node named 'target' is an ancestor of one of the inputs
+// of 'node', ignoring input 'skip'. Merge nodes don't wait for all their
+// inputs, so the search doesn't go through them. Returns false if the search
+// gives up.
+bool IsAncestorOfOtherInput(const NodeDef& node, int skip,
+                            const string& target, const NodeMap& node_map) {
+  std::deque<const NodeDef*> queue;
+  std::unordered_set<const NodeDef*> visited;
+  for (int i = 0; i < node.input_size(); ++i) {
+    if (i == skip) {
+      continue;
+    }
+    const NodeDef* input = node_map.GetNode(node.input(i));
+    if (input != nullptr && visited.insert(input).second) {
+      queue.push_back(input);
+    }
+  }
+  while (!queue.empty()) {
+    const NodeDef* current = queue.front();
+    queue.pop_front();
+    if (current->name() == target) {
+      return true;
+    }
+    if (visited.size() > kMaxReachabilityVisits) {
+      return false;
+    }
+    if (IsMerge(*current)) {
+      continue;
+    }
+    for (const string& input_name : current->input()) {
+      const NodeDef* input = node_map.GetNode(input_name);
+      if (input != nullptr && visited.insert(input).second) {
+        queue.push_back(input);
+      }
+    }
+  }
+  return false;
+}
+
+// Deletes the nodes at the given indices.
+void DeleteNodes(const std::set<int>& nodes_to_delete, GraphDef* graph) {
+  int last = graph->node_size() - 1;
+  for (auto it = nodes_to_delete.rbegin(); it != nodes_to_delete.rend();
+       ++it) {
+    graph->mutable_node()->SwapElements(*it, last);
+    --last;
+  }
+  graph->mutable_node()->DeleteSubrange(last + 1, nodes_to_delete.size());
+}
+
+}  // namespace
+
+bool DependencyOptimizer::SafeToBypass(const NodeDef& node,
+                                       const NodeMap& node_map) const {
+  if (nodes_to_preserve_.find(node.name()) != nodes_to_preserve_.end()) {
+    return false;
+  }
+  const std::set<NodeDef*>& fanouts = node_map.GetOutputs(node.name());
+  for (const NodeDef* fanout : fanouts) {
+    if (IsControlFlow(*fanout)) {
+      return false;
+    }
+  }
+  int num_control_inputs = 0;
+  for (const string& input_name : node.input()) {
+    const NodeDef* input = node_map.GetNode(input_name);
+    if (input == nullptr || IsControlFlow(*input)) {
+      return false;
+    }
+    if (IsControlInput(input_name)) {
+      ++num_control_inputs;
+    }
+  }
+
+  if (IsNoOp(node)) {
+    // Connecting every input to every fanout must not add edges, except in
+    // the 2x2 case where the count stays the same.
+    const int num_inputs = node.input_size();
+    const int num_outputs = fanouts.size();
+    return num_inputs * num_outputs <= num_inputs + num_outputs;
+  }
+
+  if (IsIdentity(node)) {
+    if (node.input_size() == 0 || IsControlInput(node.input(0))) {
+      return false;
+    }
+    const NodeDef* input = node_map.GetNode(node.input(0));
+    // An Identity of a reference takes a snapshot of its value, and an
+    // Identity placed on another device than its input is a copy that may be
+    // shared by several consumers.
+    if (HasRefOutput(*input) || input->device() != node.device()) {
+      return false;
+    }
+    // The control inputs of the Identity get copied to each fanout.
+    return num_control_inputs == 0 || fanouts.size() <= 1;
+  }
+  return false;
+}
+
+void DependencyOptimizer::BypassNode(const NodeDef& node,
+                                     NodeMap* node_map) const {
+  string data_input;
+  std::vector<string> control_inputs;
+  for (const string& input : node.input()) {
+    if (IsControlInput(input)) {
+      control_inputs.push_back(input);
+    } else {
+      data_input = input;
+    }
+  }
+
+  const std::set<NodeDef*> fanouts = node_map->GetOutputs(node.name());
+  for (NodeDef* fanout : fanouts) {
+    std::vector<string> new_data_inputs;
+    std::vector<string> new_control_inputs;
+    bool depends_on_node = false;
+    for (const string& input : fanout->input()) {
+      int position;
+      const bool is_node = ParseNodeName(input, &position) == node.name();
+      depends_on_node |= is_node;
+      if (!is_node) {
+        if (IsControlInput(input)) {
+          new_control_inputs.push_back(input);
+        } else {
+          new_data_inputs.push_back(input);
+        }
+      } else if (position >= 0) {
+        new_data_inputs.push_back(data_input);
+      } else if (!data_input.empty()) {
+        new_control_inputs.push_back(
+            AsControlDependency(NodeName(data_input)));
+      }
+    }
+    if (!depends_on_node) {
+      continue;
+    }
+    new_control_inputs.insert(new_control_inputs.end(), control_inputs.begin(),
+                              control_inputs.end());
+
+    fanout->clear_input();
+    for (const string& input : new_data_inputs) {
+      *fanout->add_input() = input;
+      node_map->AddOutput(NodeName(input), fanout->name());
+    }
+    std::unordered_set<string> seen_control_inputs;
+    for (const string& input : new_control_inputs) {
+      if (seen_control_inputs.insert(input).second) {
+        *fanout->add_input() = input;
+        node_map->AddOutput(NodeName(input), fanout->name());
+      }
+    }
+  }
+}
+
+void DependencyOptimizer::BypassNodes(GraphDef* optimized_graph) {
+  NodeMap node_map(optimized_graph);
+  std::set<int> nodes_to_delete;
+  for (int i = 0; i < optimized_graph->node_size(); ++i) {
+    const NodeDef& node = optimized_graph->node(i);
+    if (!IsNoOp(node) && !IsIdentity(node)) {
+      continue;
+    }
+    if (!SafeToBypass(node, node_map)) {
+      continue;
+    }
+    BypassNode(node, &node_map);
+    nodes_to_delete.insert(i);
+  }
+  DeleteNodes(nodes_to_delete, optimized_graph);
+}
+
+void DependencyOptimizer::TransitiveReduction(GraphDef* optimized_graph) {
+  NodeMap node_map(optimized_graph);
+  for (int i = 0; i < optimized_graph->node_size(); ++i) {
+    NodeDef* node = optimized_graph->mutable_node(i);
+    // A Merge node only waits for one of its data inputs, so its control
+    // inputs are never implied by them.
+    if (node->input_size() == 0 || IsMerge(*node) ||
+        !IsControlInput(node->input(node->input_size() - 1))) {
+      continue;
+    }
+
+    // Drop the control inputs that are duplicated, or that depend on a node
+    // that is also a data input.
+    std::unordered_set<string> input_nodes;
+    std::vector<string> inputs;
+    for (const string& input : node->input()) {
+      if (!IsControlInput(input)) {
+        input_nodes.insert(NodeName(input));
+        inputs.push_back(input);
+      } else if (input_nodes.insert(NodeName(input)).second) {
+        inputs.push_back(input);
+      }
+    }
+    node->clear_input();
+    for (const string& input : inputs) {
+      *node->add_input() = input;
+    }
+
+    // Drop the control inputs that are ancestors of another input. The
+    // removed inputs are not used to justify removing the others.
+    for (int j = node->input_size() - 1; j >= 0; --j) {
+      if (!IsControlInput(node->input(j))) {
+        break;
+      }
+      if (IsAncestorOfOtherInput(*node, j, NodeName(node->input(j)),
+                                 node_map)) {
+        node->mutable_input()->DeleteSubrange(j, 1);
+      }
+    }
+  }
+}
+
+Status DependencyOptimizer::Optimize(Cluster* /*cluster*/,
+                                     const GrapplerItem& item,
+                                     GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  nodes_to_preserve_.clear();
+  for (const auto& fetch : item.fetch) {
+    nodes_to_preserve_.insert(NodeName(fetch));
+  }
+  for (const auto& feed : item.feed) {
+    nodes_to_preserve_.insert(NodeName(feed.first));
+  }
+  for (const auto& init_op : item.init_ops) {
+    nodes_to_preserve_.insert(NodeName(init_op));
+  }
+
+  const int num_nodes = optimized_graph->node_size();
+  const int num_edges = CountEdges(*optimized_graph);
+  BypassNodes(optimized_graph);
+  TransitiveReduction(optimized_graph);
+  num_nodes_removed_ = num_nodes - optimized_graph->node_size();
+  num_edges_removed_ = num_edges - CountEdges(*optimized_graph);
+
+  VLOG(1) << "Removed " << num_nodes_removed_ << " nodes and "
+          << num_edges_removed_ << " edges from the graph. The graph now "
+          << "contains " << optimized_graph->node_size() << " nodes.";
+  return Status::OK();
+}
+
+void DependencyOptimizer::Feedback(Cluster* /*cluster*/,
+                                   const GrapplerItem& /*item*/,
+                                   const GraphDef& /*optimized_graph*/,
+                                   double /*result*/) {
+  // Nothing to do for DependencyOptimizer.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,62 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_GRAPPLER_OPTIMIZERS_DEPENDENCY_OPTIMIZER_H_
+#define TENSORFLOW_GRAPPLER_OPTIMIZERS_DEPENDENCY_OPTIMIZER_H_
+
+#include <unordered_set>
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/grappler/utils.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Reduce the number of nodes and edges the executor has to process:
+// * Bypass the NoOp and Identity nodes that aren't fetched, and remove them.
+// * Remove the control dependencies that are implied by other inputs.
+class DependencyOptimizer : public GraphOptimizer {
+ public:
+  DependencyOptimizer() {}
+  ~DependencyOptimizer() override {}
+
+  string name() const override { return "dependency_optimizer"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override;
+
+ private:
+  // Returns true if the NoOp or Identity 'node' can be bypassed without
+  // changing what runs, or increasing the number of edges too much.
+  bool SafeToBypass(const NodeDef& node, const NodeMap& node_map) const;
+  // Connects the inputs of 'node' to its fanouts directly.
+  void BypassNode(const NodeDef& node, NodeMap* node_map) const;
+  // Bypasses and removes the nodes accepted by SafeToBypass.
+  void BypassNodes(GraphDef* optimized_graph);
+  // Removes the control inputs of each node that are duplicates of another
+  // input, or ancestors of another input.
+  void TransitiveReduction(GraphDef* optimized_graph);
+
+  std::unordered_set<string> nodes_to_preserve_;
+  int num_nodes_removed_ = 0;
+  int num_edges_removed_ = 0;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_OPTIMIZERS_DEPENDENCY_OPTIMIZER_H_
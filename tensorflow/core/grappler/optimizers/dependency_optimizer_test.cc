@@ -0,0 +1,194 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/dependency_optimizer.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class DependencyOptimizerTest : public ::testing::Test {
+ protected:
+  std::vector<Tensor> EvaluateNodes(const GraphDef& graph,
+                                    const std::vector<string>& fetch) {
+    SessionOptions options;
+    std::unique_ptr<tensorflow::Session> session(NewSession(options));
+    TF_CHECK_OK(session->Create(graph));
+    RunOptions run_options;
+    std::vector<Tensor> output_tensors;
+    TF_CHECK_OK(
+        session->Run(run_options, {}, fetch, fetch, &output_tensors, nullptr));
+    TF_CHECK_OK(session->Close());
+    return output_tensors;
+  }
+
+  const NodeDef* FindNode(const GraphDef& graph, const string& name) {
+    for (const NodeDef& node : graph.node()) {
+      if (node.name() == name) {
+        return &node;
+      }
+    }
+    return nullptr;
+  }
+};
+
+TEST_F(DependencyOptimizerTest, NoOp) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Const(s.WithOpName("a"), 1.0f, {2});
+  Output b = ops::Sqrt(s.WithOpName("b"), a);
+
+  GrapplerItem item;
+  item.fetch = {"b"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  DependencyOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+}
+
+TEST_F(DependencyOptimizerTest, BypassNoOp) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Const(s.WithOpName("x"), 1.0f, {2});
+  Operation n = ops::NoOp(s.WithOpName("n").WithControlDependencies(x));
+  Output y =
+      ops::Const(s.WithOpName("y").WithControlDependencies(n), 2.0f, {2});
+
+  GrapplerItem item;
+  item.fetch = {"y"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  DependencyOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(2, output.node_size());
+  EXPECT_EQ(nullptr, FindNode(output, "n"));
+  const NodeDef* new_y = FindNode(output, "y");
+  ASSERT_NE(nullptr, new_y);
+  ASSERT_EQ(1, new_y->input_size());
+  EXPECT_EQ("^x", new_y->input(0));
+}
+
+TEST_F(DependencyOptimizerTest, BypassIdentity) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Const(s.WithOpName("a"), 1.0f, {2});
+  Output id1 = ops::Identity(s.WithOpName("id1"), a);
+  Output id2 = ops::Identity(s.WithOpName("id2"), id1);
+  Output b = ops::Sqrt(s.WithOpName("b"), id2);
+
+  GrapplerItem item;
+  item.fetch = {"b"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  DependencyOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(2, output.node_size());
+  const NodeDef* new_b = FindNode(output, "b");
+  ASSERT_NE(nullptr, new_b);
+  ASSERT_EQ(1, new_b->input_size());
+  EXPECT_EQ("a", new_b->input(0));
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+  auto tensors = EvaluateNodes(output, item.fetch);
+  EXPECT_EQ(1, tensors_expected.size());
+  EXPECT_EQ(1, tensors.size());
+  test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
+}
+
+TEST_F(DependencyOptimizerTest, KeepFetchedIdentity) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Const(s.WithOpName("a"), 1.0f, {2});
+  Output id = ops::Identity(s.WithOpName("id"), a);
+  Output b = ops::Sqrt(s.WithOpName("b"), id);
+
+  GrapplerItem item;
+  item.fetch = {"id", "b"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  DependencyOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(3, output.node_size());
+  const NodeDef* new_b = FindNode(output, "b");
+  ASSERT_NE(nullptr, new_b);
+  EXPECT_EQ("id", new_b->input(0));
+}
+
+TEST_F(DependencyOptimizerTest, KeepIdentityOfVariable) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output v = ops::Variable(s.WithOpName("v"), {2}, DT_FLOAT);
+  Output id = ops::Identity(s.WithOpName("id"), v);
+  Output b = ops::Sqrt(s.WithOpName("b"), id);
+
+  GrapplerItem item;
+  item.fetch = {"b"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+
+  DependencyOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(3, output.node_size());
+  EXPECT_NE(nullptr, FindNode(output, "id"));
+}
+
+TEST_F(DependencyOptimizerTest, TransitiveReduction) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output a = ops::Const(s.WithOpName("a"), 1.0f, {2});
+  Output b = ops::Sqrt(s.WithOpName("b"), a);
+  Output c = ops::Sqrt(s.WithOpName("c").WithControlDependencies(a), b);
+  Output d = ops::Sqrt(s.WithOpName("d"), a);
+
+  GrapplerItem item;
+  item.fetch = {"c", "d"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  // The control dependencies of 'd' are implied by its data input.
+  for (NodeDef& node : *item.graph.mutable_node()) {
+    if (node.name() == "d") {
+      *node.add_input() = "^a";
+      *node.add_input() = "^a";
+    }
+  }
+
+  DependencyOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(4, output.node_size());
+  const NodeDef* new_c = FindNode(output, "c");
+  ASSERT_NE(nullptr, new_c);
+  ASSERT_EQ(1, new_c->input_size());
+  EXPECT_EQ("b", new_c->input(0));
+  const NodeDef* new_d = FindNode(output, "d");
+  ASSERT_NE(nullptr, new_d);
+  ASSERT_EQ(1, new_d->input_size());
+  EXPECT_EQ("a", new_d->input(0));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
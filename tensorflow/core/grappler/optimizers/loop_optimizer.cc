@@ -0,0 +1,252 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
+#include <deque>
+#include <map>
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+const char kEnterPrefix[] = "LoopOptimizer/Enter";
+
+string AsControlDependency(const string& node_name) {
+  return strings::StrCat("^", node_name);
+}
+
+// Returns true if 'node' forwards a tensor that doesn't change from one
+// iteration of its frame to the next.
+bool IsLoopInvariantEnter(const NodeDef& node) {
+  if (node.op() != "Enter") {
+    return false;
+  }
+  auto it = node.attr().find("is_constant");
+  return it != node.attr().end() && it->second.b();
+}
+
+const string& FrameName(const NodeDef& enter) {
+  return enter.attr().at("frame_name").s();
+}
+
+// Returns the data types of the outputs of 'node', or false if they can't be
+// inferred.
+bool GetOutputTypes(const NodeDef& node, DataTypeVector* output_types) {
+  const OpDef* op_def = nullptr;
+  if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok()) {
+    return false;
+  }
+  DataTypeVector input_types;
+  return InOutTypesForNode(node, *op_def, &input_types, output_types).ok();
+}
+
+}  // namespace
+
+bool LoopOptimizer::CanHoist(const NodeDef& node) const {
+  if (nodes_to_preserve_.find(node.name()) != nodes_to_preserve_.end()) {
+    return false;
+  }
+  if (IsEnter(node) || IsExit(node) || IsMerge(node) || IsSwitch(node) ||
+      IsNextIteration(node) || IsLoopCond(node) || IsSend(node) ||
+      IsRecv(node)) {
+    return false;
+  }
+  const OpDef* op_def = nullptr;
+  if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok()) {
+    return false;
+  }
+  // Running a stateful op once instead of once per iteration changes the
+  // results.
+  if (op_def->is_stateful()) {
+    return false;
+  }
+  DataTypeVector input_types;
+  DataTypeVector output_types;
+  if (!InOutTypesForNode(node, *op_def, &input_types, &output_types).ok() ||
+      output_types.empty()) {
+    return false;
+  }
+  for (DataType type : input_types) {
+    if (IsRefType(type)) {
+      return false;
+    }
+  }
+  for (DataType type : output_types) {
+    if (IsRefType(type)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::unordered_map<const NodeDef*, const NodeDef*>
+LoopOptimizer::FindLoopInvariantNodes(const GraphDef& graph,
+                                      const NodeMap& node_map) const {
+  // Maps the loop-invariant Enter nodes to themselves, and the other
+  // loop-invariant nodes to one of the Enter nodes they depend on.
+  std::unordered_map<const NodeDef*, const NodeDef*> invariant_nodes;
+  std::deque<const NodeDef*> queue;
+  for (const NodeDef& node : graph.node()) {
+    if (IsLoopInvariantEnter(node)) {
+      invariant_nodes[&node] = &node;
+      for (const NodeDef* fanout : node_map.GetOutputs(node.name())) {
+        queue.push_back(fanout);
+      }
+    }
+  }
+
+  // A node is loop-invariant once all its inputs are. It gets queued again
+  // each time one of its inputs turns out to be invariant.
+  while (!queue.empty()) {
+    const NodeDef* node = queue.front();
+    queue.pop_front();
+    if (invariant_nodes.count(node) > 0 || !CanHoist(*node)) {
+      continue;
+    }
+    const NodeDef* frame_enter = nullptr;
+    bool is_invariant = true;
+    for (const string& input : node->input()) {
+      auto it = invariant_nodes.find(node_map.GetNode(input));
+      if (it == invariant_nodes.end() ||
+          (frame_enter != nullptr &&
+           FrameName(*frame_enter) != FrameName(*it->second))) {
+        is_invariant = false;
+        break;
+      }
+      frame_enter = it->second;
+    }
+    if (!is_invariant || frame_enter == nullptr) {
+      continue;
+    }
+    invariant_nodes[node] = frame_enter;
+    for (const NodeDef* fanout : node_map.GetOutputs(node->name())) {
+      queue.push_back(fanout);
+    }
+  }
+
+  std::unordered_map<const NodeDef*, const NodeDef*> nodes_to_hoist;
+  for (const auto& invariant_node : invariant_nodes) {
+    if (invariant_node.first != invariant_node.second) {
+      nodes_to_hoist.insert(invariant_node);
+    }
+  }
+  return nodes_to_hoist;
+}
+
+Status LoopOptimizer::Optimize(Cluster* /*cluster*/, const GrapplerItem& item,
+                               GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  nodes_to_preserve_.clear();
+  for (const auto& fetch : item.fetch) {
+    nodes_to_preserve_.insert(NodeName(fetch));
+  }
+  for (const auto& feed : item.feed) {
+    nodes_to_preserve_.insert(NodeName(feed.first));
+  }
+  for (const auto& init_op : item.init_ops) {
+    nodes_to_preserve_.insert(NodeName(init_op));
+  }
+
+  NodeMap node_map(optimized_graph);
+  const std::unordered_map<const NodeDef*, const NodeDef*> nodes_to_hoist =
+      FindLoopInvariantNodes(*optimized_graph, node_map);
+  if (nodes_to_hoist.empty()) {
+    return Status::OK();
+  }
+
+  // The consumers of the hoisted nodes that stay in the loop read them through
+  // new loop-invariant Enter nodes, one per output.
+  std::map<std::pair<const NodeDef*, int>, string> new_enters;
+  for (const auto& node_and_enter : nodes_to_hoist) {
+    const NodeDef* node = node_and_enter.first;
+    const NodeDef* frame_enter = node_and_enter.second;
+    DataTypeVector output_types;
+    CHECK(GetOutputTypes(*node, &output_types));
+    for (NodeDef* fanout : node_map.GetOutputs(node->name())) {
+      if (nodes_to_hoist.count(fanout) > 0) {
+        continue;
+      }
+      for (string& input : *fanout->mutable_input()) {
+        int position;
+        if (ParseNodeName(input, &position) != node->name()) {
+          continue;
+        }
+        const int port = std::max(position, 0);
+        string& enter_name = new_enters[std::make_pair(node, port)];
+        if (enter_name.empty()) {
+          NodeDef* enter = optimized_graph->add_node();
+          if (port == 0) {
+            enter_name = AddPrefixToNodeName(node->name(), kEnterPrefix);
+            *enter->add_input() = node->name();
+          } else {
+            enter_name = AddPrefixToNodeName(
+                strings::StrCat(node->name(), "_", port), kEnterPrefix);
+            *enter->add_input() = strings::StrCat(node->name(), ":", port);
+          }
+          enter->set_name(enter_name);
+          enter->set_op("Enter");
+          enter->set_device(node->device());
+          auto& attr = *enter->mutable_attr();
+          attr["T"].set_type(output_types[port]);
+          attr["frame_name"] = frame_enter->attr().at("frame_name");
+          attr["is_constant"].set_b(true);
+          if (frame_enter->attr().count("parallel_iterations") > 0) {
+            attr["parallel_iterations"] =
+                frame_enter->attr().at("parallel_iterations");
+          }
+        }
+        input = position < 0 ? AsControlDependency(enter_name) : enter_name;
+      }
+    }
+  }
+
+  // Move the hoisted nodes out of the loop: the loop-invariant Enter nodes
+  // they read from are replaced by their inputs.
+  for (const auto& node_and_enter : nodes_to_hoist) {
+    NodeDef* node = node_map.GetNode(node_and_enter.first->name());
+    for (string& input : *node->mutable_input()) {
+      const NodeDef* input_node = node_map.GetNode(input);
+      if (nodes_to_hoist.count(input_node) > 0) {
+        continue;
+      }
+      const string& outer_input = input_node->input(0);
+      input = IsControlInput(input) ? AsControlDependency(NodeName(outer_input))
+                                    : outer_input;
+    }
+  }
+
+  VLOG(1) << "Hoisted " << nodes_to_hoist.size()
+          << " loop-invariant nodes out of their loop, and added "
+          << new_enters.size() << " Enter nodes.";
+  return Status::OK();
+}
+
+void LoopOptimizer::Feedback(Cluster* /*cluster*/, const GrapplerItem& /*item*/,
+                             const GraphDef& /*optimized_graph*/,
+                             double /*result*/) {
+  // Nothing to do for LoopOptimizer.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,59 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_GRAPPLER_OPTIMIZERS_LOOP_OPTIMIZER_H_
+#define TENSORFLOW_GRAPPLER_OPTIMIZERS_LOOP_OPTIMIZER_H_
+
+#include <unordered_map>
+#include <unordered_set>
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/grappler/utils.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Hoist loop-invariant computations out of while loops: the nodes of a frame
+// that only depend on loop-invariant (is_constant) Enter nodes, directly or
+// through other such nodes, are moved to the parent frame so that they run
+// once instead of once per iteration. Their consumers in the loop read them
+// through new loop-invariant Enter nodes.
+class LoopOptimizer : public GraphOptimizer {
+ public:
+  LoopOptimizer() {}
+  ~LoopOptimizer() override {}
+
+  string name() const override { return "loop_optimizer"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override;
+
+ private:
+  // Returns true if 'node' may run in the parent frame of its inputs.
+  bool CanHoist(const NodeDef& node) const;
+  // Finds the nodes to hoist. Returns, for each of them, the loop-invariant
+  // Enter node that gives their frame.
+  std::unordered_map<const NodeDef*, const NodeDef*> FindLoopInvariantNodes(
+      const GraphDef& graph, const NodeMap& node_map) const;
+
+  std::unordered_set<string> nodes_to_preserve_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_OPTIMIZERS_LOOP_OPTIMIZER_H_
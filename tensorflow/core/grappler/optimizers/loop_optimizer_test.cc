@@ -0,0 +1,181 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+using test::function::NDef;
+
+class LoopOptimizerTest : public ::testing::Test {
+ protected:
+  std::vector<Tensor> EvaluateNodes(const GraphDef& graph,
+                                    const std::vector<string>& fetch) {
+    SessionOptions options;
+    std::unique_ptr<tensorflow::Session> session(NewSession(options));
+    TF_CHECK_OK(session->Create(graph));
+    RunOptions run_options;
+    std::vector<Tensor> output_tensors;
+    TF_CHECK_OK(
+        session->Run(run_options, {}, fetch, fetch, &output_tensors, nullptr));
+    TF_CHECK_OK(session->Close());
+    return output_tensors;
+  }
+
+  const NodeDef* FindNode(const GraphDef& graph, const string& name) {
+    for (const NodeDef& node : graph.node()) {
+      if (node.name() == name) {
+        return &node;
+      }
+    }
+    return nullptr;
+  }
+
+  NodeDef Enter(const string& name, const string& input, bool is_constant) {
+    return NDef(name, "Enter", {input}, {{"T", DT_FLOAT},
+                                         {"frame_name", "while"},
+                                         {"is_constant", is_constant},
+                                         {"parallel_iterations", 10}});
+  }
+
+  // Builds the graph of:
+  //   i = 0
+  //   while i < limit:
+  //     i = i + a * b
+  // The product a * b doesn't change from one iteration to the next.
+  GraphDef WhileLoop() {
+    GraphDef graph;
+    *graph.add_node() =
+        NDef("i0", "Const", {},
+             {{"dtype", DT_FLOAT}, {"value", test::AsScalar<float>(0.0f)}});
+    *graph.add_node() =
+        NDef("a", "Const", {},
+             {{"dtype", DT_FLOAT}, {"value", test::AsScalar<float>(2.0f)}});
+    *graph.add_node() =
+        NDef("b", "Const", {},
+             {{"dtype", DT_FLOAT}, {"value", test::AsScalar<float>(3.0f)}});
+    *graph.add_node() =
+        NDef("limit", "Const", {},
+             {{"dtype", DT_FLOAT}, {"value", test::AsScalar<float>(10.0f)}});
+    *graph.add_node() = Enter("enter_i", "i0", false);
+    *graph.add_node() = Enter("enter_a", "a", true);
+    *graph.add_node() = Enter("enter_b", "b", true);
+    *graph.add_node() = Enter("enter_limit", "limit", true);
+    *graph.add_node() = NDef("merge", "Merge", {"enter_i", "next_iteration"},
+                             {{"T", DT_FLOAT}, {"N", 2}});
+    *graph.add_node() =
+        NDef("less", "Less", {"merge", "enter_limit"}, {{"T", DT_FLOAT}});
+    *graph.add_node() = NDef("loop_cond", "LoopCond", {"less"});
+    *graph.add_node() =
+        NDef("switch", "Switch", {"merge", "loop_cond"}, {{"T", DT_FLOAT}});
+    *graph.add_node() =
+        NDef("identity", "Identity", {"switch:1"}, {{"T", DT_FLOAT}});
+    *graph.add_node() =
+        NDef("mul", "Mul", {"enter_a", "enter_b"}, {{"T", DT_FLOAT}});
+    *graph.add_node() =
+        NDef("add", "Add", {"identity", "mul"}, {{"T", DT_FLOAT}});
+    *graph.add_node() =
+        NDef("next_iteration", "NextIteration", {"add"}, {{"T", DT_FLOAT}});
+    *graph.add_node() = NDef("exit", "Exit", {"switch"}, {{"T", DT_FLOAT}});
+    return graph;
+  }
+};
+
+TEST_F(LoopOptimizerTest, NoLoop) {
+  GrapplerItem item;
+  *item.graph.add_node() =
+      NDef("a", "Const", {},
+           {{"dtype", DT_FLOAT}, {"value", test::AsScalar<float>(2.0f)}});
+  *item.graph.add_node() = NDef("b", "Sqrt", {"a"}, {{"T", DT_FLOAT}});
+  item.fetch = {"b"};
+
+  LoopOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+}
+
+TEST_F(LoopOptimizerTest, HoistLoopInvariant) {
+  GrapplerItem item;
+  item.graph = WhileLoop();
+  item.fetch = {"exit"};
+
+  LoopOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // The product is computed before entering the loop, and read through a new
+  // loop-invariant Enter node.
+  EXPECT_EQ(item.graph.node_size() + 1, output.node_size());
+  const NodeDef* mul = FindNode(output, "mul");
+  ASSERT_NE(nullptr, mul);
+  ASSERT_EQ(2, mul->input_size());
+  EXPECT_EQ("a", mul->input(0));
+  EXPECT_EQ("b", mul->input(1));
+  const NodeDef* enter = FindNode(output, "LoopOptimizer/Enter/mul");
+  ASSERT_NE(nullptr, enter);
+  EXPECT_EQ("Enter", enter->op());
+  ASSERT_EQ(1, enter->input_size());
+  EXPECT_EQ("mul", enter->input(0));
+  EXPECT_EQ("while", enter->attr().at("frame_name").s());
+  EXPECT_TRUE(enter->attr().at("is_constant").b());
+  const NodeDef* add = FindNode(output, "add");
+  ASSERT_NE(nullptr, add);
+  EXPECT_EQ("identity", add->input(0));
+  EXPECT_EQ("LoopOptimizer/Enter/mul", add->input(1));
+
+  // The loop condition depends on the loop variable, and stays in the loop.
+  const NodeDef* less = FindNode(output, "less");
+  ASSERT_NE(nullptr, less);
+  EXPECT_EQ("merge", less->input(0));
+  EXPECT_EQ("enter_limit", less->input(1));
+
+  std::vector<Tensor> expected = EvaluateNodes(item.graph, item.fetch);
+  std::vector<Tensor> optimized = EvaluateNodes(output, item.fetch);
+  ASSERT_EQ(1, expected.size());
+  ASSERT_EQ(1, optimized.size());
+  test::ExpectTensorEqual<float>(expected[0], optimized[0]);
+  EXPECT_EQ(12.0f, optimized[0].scalar<float>()());
+}
+
+TEST_F(LoopOptimizerTest, KeepFetchedNode) {
+  GrapplerItem item;
+  item.graph = WhileLoop();
+  item.fetch = {"exit", "mul"};
+
+  LoopOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+  const NodeDef* mul = FindNode(output, "mul");
+  ASSERT_NE(nullptr, mul);
+  EXPECT_EQ("enter_a", mul->input(0));
+  EXPECT_EQ("enter_b", mul->input(1));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
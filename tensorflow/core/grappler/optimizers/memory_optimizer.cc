@@ -24,6 +24,8 @@ limitations under the License.
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/costs/graph_memory.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/op_types.h"
@@ -43,6 +45,10 @@ const char* kRecomputeTriggerNodePrefix = "RecomputeTrigger";
 // recomputed.
 const char* kRecomputeHint = "_recompute_hint";
 const char* kRecomputationTargetNamePrefix = "gradients/";
+// Attribute listing the inputs of a node to swap to host memory.
+const char* kSwapToHostAttr = "_swap_to_host";
+// Tensors smaller than this aren't worth swapping.
+const int64 kMinSwapSizeBytes = 4096;
 
 // Ops which we wouldn't mind recomputing to save memory.
 // TODO(allenl): Replace this list with a cost model.
@@ -513,6 +519,133 @@ static int64 EstimateSize(const OpInfo::TensorProperties& t) {
   return num_elems * size;
 }
 
+// Let's assume we're going to swap over PCIe running at 16 GBps.
+static Costs::NanoSeconds EstimateSwapTime(int64 bytes_to_swap) {
+  return bytes_to_swap / 16;
+}
+
+// Returns the memory of the smallest device of the cluster, or 0 if the memory
+// of the devices is unknown.
+static int64 GetDeviceMemoryLimit(const Cluster& cluster) {
+  int64 memory_limit = 0;
+  for (const auto& device : cluster.GetDevices()) {
+    const int64 memory_size = device.second.memory_size();
+    if (memory_size > 0 && (memory_limit == 0 || memory_size < memory_limit)) {
+      memory_limit = memory_size;
+    }
+  }
+  return memory_limit;
+}
+
+// Marks the inputs of gradient nodes to swap to host memory when the worst
+// case memory usage of the graph exceeds the memory of the devices. An input
+// qualifies if it is an activation that stays idle long enough, between the
+// time it's produced and the time its gradient node can run, to be swapped out
+// and back in. The largest inputs are picked first, until the excess memory is
+// covered.
+static void IdentifySwappingCandidates(Cluster* cluster,
+                                       const GrapplerItem& item,
+                                       GraphDef* optimized_graph) {
+  if (cluster == nullptr) {
+    return;
+  }
+  const int64 memory_limit = GetDeviceMemoryLimit(*cluster);
+  if (memory_limit == 0) {
+    return;
+  }
+  GrapplerItem swap_item = item;
+  swap_item.graph = *optimized_graph;
+  GraphProperties properties(swap_item);
+  if (!properties.InferStatically().ok()) {
+    return;
+  }
+  GraphMemory memory(swap_item);
+  if (!memory.InferFromGraphProperties(&properties).ok()) {
+    return;
+  }
+  int64 excess_memory = memory.GetWorstCaseMemoryUsage() - memory_limit;
+  if (excess_memory <= 0) {
+    return;
+  }
+  VLOG(1) << "Worst case memory usage exceeds the device memory by "
+          << excess_memory << " bytes";
+
+  std::unordered_map<const NodeDef*, Costs::NanoSeconds> execution_times;
+  if (!EstimateEarliestExecutionTimes(swap_item, cluster, &execution_times)
+           .ok()) {
+    return;
+  }
+  std::unordered_map<string, const NodeDef*> name_map;
+  for (const auto& node : swap_item.graph.node()) {
+    name_map[node.name()] = &node;
+  }
+
+  struct SwapCandidate {
+    int node_index;
+    int input_id;
+    int64 size;
+  };
+  std::vector<SwapCandidate> candidates;
+  for (int i = 0; i < swap_item.graph.node_size(); ++i) {
+    const NodeDef& node = swap_item.graph.node(i);
+    if (!IsTargetOp(node) || node.attr().count(kSwapToHostAttr) != 0) {
+      continue;
+    }
+    // The node can't start before all its inputs are available.
+    Costs::NanoSeconds ready_time(0);
+    for (const string& input : node.input()) {
+      auto it = name_map.find(NodeName(input));
+      if (it == name_map.end() || execution_times.count(it->second) == 0) {
+        ready_time = Costs::NanoSeconds(-1);
+        break;
+      }
+      ready_time = std::max(ready_time, execution_times[it->second]);
+    }
+    if (ready_time < Costs::NanoSeconds(0)) {
+      continue;
+    }
+    const std::vector<OpInfo::TensorProperties> props =
+        properties.GetInputProperties(node.name());
+    for (int input_id = 0; input_id < node.input_size(); ++input_id) {
+      const string& input = node.input(input_id);
+      if (IsControlInput(input) || input_id >= props.size()) {
+        break;
+      }
+      const NodeDef* producer = name_map[NodeName(input)];
+      if (IsTargetOp(*producer) || IsVariable(*producer) ||
+          IsConstant(*producer)) {
+        continue;
+      }
+      const int64 size = EstimateSize(props[input_id]);
+      if (size < kMinSwapSizeBytes) {
+        continue;
+      }
+      const Costs::NanoSeconds idle_time =
+          ready_time - execution_times[producer];
+      if (idle_time <= EstimateSwapTime(size) * 2) {
+        continue;
+      }
+      candidates.push_back({i, input_id, size});
+    }
+  }
+
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const SwapCandidate& a, const SwapCandidate& b) {
+                     return a.size > b.size;
+                   });
+  for (const SwapCandidate& candidate : candidates) {
+    if (excess_memory <= 0) {
+      break;
+    }
+    NodeDef* node = optimized_graph->mutable_node(candidate.node_index);
+    VLOG(2) << "Swapping input " << candidate.input_id << " of "
+            << node->name() << " (" << candidate.size << " bytes)";
+    (*node->mutable_attr())[kSwapToHostAttr].mutable_list()->add_i(
+        candidate.input_id);
+    excess_memory -= candidate.size;
+  }
+}
+
 struct SwapInfo {
   std::vector<int> inputs_to_swap;
   Costs::NanoSeconds time_to_swap = 0;
@@ -598,12 +731,16 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
 
   RecomputationRewritingPass(optimization_level_, optimized_graph, item);
 
+  if (optimization_level_ == RewriterConfig::SWAPPING_HEURISTICS) {
+    IdentifySwappingCandidates(cluster, item, optimized_graph);
+  }
+
   // Figure out what needs to be swapped;
   std::unordered_map<NodeDef*, SwapInfo> nodes_to_swap;
   for (auto& node : *optimized_graph->mutable_node()) {
-    if (node.attr().count("_swap_to_host") != 0) {
+    if (node.attr().count(kSwapToHostAttr) != 0) {
       SwapInfo& swap_info = nodes_to_swap[&node];
-      const AttrValue& val = node.attr().at("_swap_to_host");
+      const AttrValue& val = node.attr().at(kSwapToHostAttr);
       if (val.has_list()) {
         for (int64 input_id : val.list().i()) {
           swap_info.inputs_to_swap.push_back(input_id);
@@ -633,8 +770,7 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
         const OpInfo::TensorProperties& t = props[input_id];
         bytes_to_swap += EstimateSize(t);
       }
-      // Let's assume we're going to swap over PCIe running at 16 GBps.
-      swap_info.time_to_swap = bytes_to_swap / 16;
+      swap_info.time_to_swap = EstimateSwapTime(bytes_to_swap);
     }
   }
 
@@ -250,6 +250,75 @@ TEST_F(MemoryOptimizerTest, SimpleSwapping) {
   EXPECT_EQ("^c", swap_in.input(1));
 }
 
+TEST_F(MemoryOptimizerTest, SwappingHeuristics) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  Output a = ops::Variable(s.WithOpName("a"), {128, 128}, DT_FLOAT);
+  Output b = ops::AddN(s.WithOpName("b"), {a});
+  Output c = ops::AddN(s.WithOpName("c"), {b});
+  Output d = ops::AddN(s.WithOpName("d"), {c});
+  Output e = ops::AddN(s.WithOpName("gradients/e"), {b, d});
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"gradients/e"};
+
+  // The 4 AddN nodes produce 64KB each, which doesn't fit in 200KB.
+  DeviceProperties cpu_device;
+  cpu_device.set_type("CPU");
+  cpu_device.set_frequency(1000);
+  cpu_device.set_num_cores(4);
+  cpu_device.set_bandwidth(32);
+  cpu_device.set_memory_size(200 * 1024);
+  std::unordered_map<string, DeviceProperties> devices;
+  devices["/job:localhost/replica:0/task:0/cpu:0"] = cpu_device;
+  VirtualCluster cluster(devices);
+
+  MemoryOptimizer optimizer(RewriterConfig::SWAPPING_HEURISTICS);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(&cluster, item, &output));
+
+  // Only b stays idle until gradients/e runs, so it is the one swapped.
+  EXPECT_EQ(7, output.node_size());
+  NodeMap node_map(&output);
+  const NodeDef* new_e = node_map.GetNode("gradients/e");
+  ASSERT_NE(nullptr, new_e);
+  EXPECT_EQ(2, new_e->input_size());
+  EXPECT_EQ("swap_in_gradients/e_0", new_e->input(0));
+  EXPECT_EQ("d", new_e->input(1));
+
+  const NodeDef* swap_out = node_map.GetNode("swap_out_gradients/e_0");
+  ASSERT_NE(nullptr, swap_out);
+  EXPECT_EQ("b", swap_out->input(0));
+  const NodeDef* swap_in = node_map.GetNode("swap_in_gradients/e_0");
+  ASSERT_NE(nullptr, swap_in);
+  EXPECT_EQ(2, swap_in->input_size());
+  EXPECT_EQ("swap_out_gradients/e_0", swap_in->input(0));
+  EXPECT_EQ("^c", swap_in->input(1));
+}
+
+TEST_F(MemoryOptimizerTest, NoSwappingWhenGraphFits) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  Output a = ops::Variable(s.WithOpName("a"), {128, 128}, DT_FLOAT);
+  Output b = ops::AddN(s.WithOpName("b"), {a});
+  Output c = ops::AddN(s.WithOpName("c"), {b});
+  Output d = ops::AddN(s.WithOpName("d"), {c});
+  Output e = ops::AddN(s.WithOpName("gradients/e"), {b, d});
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"gradients/e"};
+
+  // The cluster created by CreateVirtualCluster() has no memory limit.
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+
+  MemoryOptimizer optimizer(RewriterConfig::SWAPPING_HEURISTICS);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+  EXPECT_EQ(5, output.node_size());
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
@@ -16,10 +16,13 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/versions.pb.h"
+#include "tensorflow/core/grappler/optimizers/arithmetic_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/auto_parallel.h"
 #include "tensorflow/core/grappler/optimizers/constant_folding.h"
+#include "tensorflow/core/grappler/optimizers/dependency_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/layout_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/model_pruner.h"
 #include "tensorflow/core/grappler/utils/topological_sort.h"
@@ -38,6 +41,15 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::NewOptimizer(
   if (optimizer == "constfold") {
     graph_optimizer.reset(new ConstantFolding());
   }
+  if (optimizer == "arithmetic") {
+    graph_optimizer.reset(new ArithmeticOptimizer());
+  }
+  if (optimizer == "dependency") {
+    graph_optimizer.reset(new DependencyOptimizer());
+  }
+  if (optimizer == "loop") {
+    graph_optimizer.reset(new LoopOptimizer());
+  }
   if (optimizer == "layout") {
     graph_optimizer.reset(new LayoutOptimizer());
   }
@@ -62,6 +74,17 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
       optimizers.push_back(
           std::unique_ptr<GraphOptimizer>(new ConstantFolding()));
     }
+    if (cfg_.arithmetic_optimization()) {
+      optimizers.push_back(
+          std::unique_ptr<GraphOptimizer>(new ArithmeticOptimizer()));
+    }
+    if (cfg_.dependency_optimization()) {
+      optimizers.push_back(
+          std::unique_ptr<GraphOptimizer>(new DependencyOptimizer()));
+    }
+    if (cfg_.loop_optimization()) {
+      optimizers.push_back(std::unique_ptr<GraphOptimizer>(new LoopOptimizer()));
+    }
     if (cfg_.optimize_tensor_layout()) {
       optimizers.push_back(
           std::unique_ptr<GraphOptimizer>(new LayoutOptimizer()));
@@ -75,8 +98,9 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
           new AutoParallel(cfg_.auto_parallel().num_replicas())));
     }
   } else {
-    std::set<string> available_optimizers = {"pruning", "constfold", "layout",
-                                             "memory", "autoparallel"};
+    std::set<string> available_optimizers = {
+        "pruning", "constfold", "arithmetic", "dependency", "loop",
+        "layout",  "memory",    "autoparallel"};
     for (const auto& optimizer : cfg_.optimizers()) {
       if (available_optimizers.find(optimizer) != available_optimizers.end()) {
         optimizers.push_back(NewOptimizer(optimizer));
@@ -119,7 +143,13 @@ void MetaOptimizer::Feedback(Cluster* cluster, const GrapplerItem& item,
   // Nothing to do for MetaOptimizer.
 }
 
-bool MetaOptimizerEnabled(const RewriterConfig& cfg) { return false; }
+bool MetaOptimizerEnabled(const RewriterConfig& cfg) {
+  return cfg.optimize_tensor_layout() || cfg.constant_folding() ||
+         cfg.arithmetic_optimization() || cfg.dependency_optimization() ||
+         cfg.loop_optimization() ||
+         cfg.memory_optimization() != RewriterConfig::NO_MEM_OPT ||
+         cfg.auto_parallel().enable() || !cfg.optimizers().empty();
+}
 
 Status RunMetaOptimizer(const GrapplerItem& item, const RewriterConfig& cfg,
                         Cluster* cluster, GraphDef* optimized_graph) {
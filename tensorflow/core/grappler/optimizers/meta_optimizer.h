@@ -43,6 +43,8 @@ class MetaOptimizer : public GraphOptimizer {
   RewriterConfig cfg_;
 };
 
+// Returns true if 'cfg' turns on at least one optimizer, in which case the
+// sessions run the meta-optimizer on their graphs.
 bool MetaOptimizerEnabled(const RewriterConfig& cfg);
 
 Status RunMetaOptimizer(const GrapplerItem& item, const RewriterConfig& cfg,
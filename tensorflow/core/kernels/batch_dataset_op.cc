@@ -191,6 +191,19 @@ class BatchDatasetOp : public UnaryDatasetOpKernel {
         return Status::OK();
       }
 
+      // A batch is assembled within a single call to `GetNext()`, so the
+      // position of this iterator is the position of its input.
+      Status Save(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        return SaveInput(writer, "input", input_impl_.get());
+      }
+
+      Status Restore(IteratorContext* ctx,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        return RestoreInput(ctx, reader, "input", input_impl_.get());
+      }
+
      private:
       mutex mu_;
       int64 i_ GUARDED_BY(mu_);
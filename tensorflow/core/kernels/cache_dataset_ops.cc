@@ -240,6 +240,33 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
         return Status::OK();
       }
 
+      Status Save(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        return writer->WriteScalar("cur_index", cur_index_);
+      }
+
+      Status Restore(IteratorContext* ctx,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        int64 cur_index;
+        TF_RETURN_IF_ERROR(reader->ReadScalar("cur_index", &cur_index));
+        TF_RETURN_IF_ERROR(reader_.status());
+        cur_index_ = cur_index;
+        // Position the reader on the last tensor of the previous item, so
+        // that the next call to `GetNext()` reads item `cur_index_`.
+        if (cur_index_ > 0) {
+          const string key = dataset()->FormatName(
+              cur_index_ - 1, dataset()->num_tensors_ - 1);
+          reader_.Seek(key);
+          if (!reader_.Valid() || reader_.key() != key) {
+            return errors::InvalidArgument(
+                "Cache does not contain item ", cur_index_ - 1,
+                "; was it written by a different dataset?");
+          }
+        }
+        return Status::OK();
+      }
+
      private:
       mutex mu_;
       size_t cur_index_ GUARDED_BY(mu_);
@@ -321,6 +348,57 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
         return Status::OK();
       }
 
+      // The saved state comprises the elements cached so far and the
+      // position of the input.
+      Status Save(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        if (!cache_) {
+          return errors::FailedPrecondition(
+              "Cannot save a cache iterator after the end of its input.");
+        }
+        TF_RETURN_IF_ERROR(writer->WriteScalar("cache_size", cache_->size()));
+        for (size_t i = 0; i < cache_->size(); ++i) {
+          const std::vector<Tensor>& element = (*cache_)[i];
+          TF_RETURN_IF_ERROR(writer->WriteScalar(
+              strings::StrCat("cache[", i, "].size"), element.size()));
+          for (size_t j = 0; j < element.size(); ++j) {
+            TF_RETURN_IF_ERROR(writer->WriteTensor(
+                strings::StrCat("cache[", i, "][", j, "]"), element[j]));
+          }
+        }
+        return SaveInput(writer, "input", input_impl_.get());
+      }
+
+      Status Restore(IteratorContext* ctx,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        if (!cache_) {
+          return errors::FailedPrecondition(
+              "Cannot restore a cache iterator after the end of its input.");
+        }
+        if (!reader->Contains("cache_size")) {
+          return errors::FailedPrecondition(
+              "The iterator state was saved after the in-memory cache was "
+              "filled, and the cached elements are not part of it.");
+        }
+        int64 cache_size;
+        TF_RETURN_IF_ERROR(reader->ReadScalar("cache_size", &cache_size));
+        cache_->clear();
+        cache_->resize(cache_size);
+        for (int64 i = 0; i < cache_size; ++i) {
+          std::vector<Tensor>& element = (*cache_)[i];
+          int64 element_size;
+          TF_RETURN_IF_ERROR(reader->ReadScalar(
+              strings::StrCat("cache[", i, "].size"), &element_size));
+          element.resize(element_size);
+          for (int64 j = 0; j < element_size; ++j) {
+            TF_RETURN_IF_ERROR(reader->ReadTensor(
+                strings::StrCat("cache[", i, "][", j, "]"), &element[j]));
+          }
+        }
+        return RestoreInput(ctx, reader, "input", input_impl_.get());
+      }
+
      private:
       mutex mu_;
       std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
@@ -352,6 +430,25 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
         }
       }
 
+      Status Save(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        return writer->WriteScalar("index", index_);
+      }
+
+      Status Restore(IteratorContext* ctx,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        int64 index;
+        TF_RETURN_IF_ERROR(reader->ReadScalar("index", &index));
+        if (index < 0 || index > cache_->size()) {
+          return errors::InvalidArgument("Restored index ", index,
+                                         " is out of range [0, ",
+                                         cache_->size(), "].");
+        }
+        index_ = index;
+        return Status::OK();
+      }
+
      private:
       mutex mu_;
       const std::vector<std::vector<Tensor>>* const cache_;
@@ -15,8 +15,80 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/dataset.h"
 
+#include "tensorflow/core/lib/strings/strcat.h"
+
 namespace tensorflow {
 
+namespace {
+
+// Forwards to another IteratorStateWriter, prefixing every key.
+class PrefixedIteratorStateWriter : public IteratorStateWriter {
+ public:
+  PrefixedIteratorStateWriter(IteratorStateWriter* writer, StringPiece prefix)
+      : writer_(writer), prefix_(prefix.ToString()) {}
+
+  Status WriteScalar(StringPiece key, int64 val) override {
+    return writer_->WriteScalar(Key(key), val);
+  }
+  Status WriteScalar(StringPiece key, const string& val) override {
+    return writer_->WriteScalar(Key(key), val);
+  }
+  Status WriteTensor(StringPiece key, const Tensor& val) override {
+    return writer_->WriteTensor(Key(key), val);
+  }
+
+ private:
+  string Key(StringPiece key) const {
+    return strings::StrCat(prefix_, "/", key);
+  }
+
+  IteratorStateWriter* const writer_;  // Not owned.
+  const string prefix_;
+};
+
+// Forwards to another IteratorStateReader, prefixing every key.
+class PrefixedIteratorStateReader : public IteratorStateReader {
+ public:
+  PrefixedIteratorStateReader(IteratorStateReader* reader, StringPiece prefix)
+      : reader_(reader), prefix_(prefix.ToString()) {}
+
+  Status ReadScalar(StringPiece key, int64* val) override {
+    return reader_->ReadScalar(Key(key), val);
+  }
+  Status ReadScalar(StringPiece key, string* val) override {
+    return reader_->ReadScalar(Key(key), val);
+  }
+  Status ReadTensor(StringPiece key, Tensor* val) override {
+    return reader_->ReadTensor(Key(key), val);
+  }
+  bool Contains(StringPiece key) override {
+    return reader_->Contains(Key(key));
+  }
+
+ private:
+  string Key(StringPiece key) const {
+    return strings::StrCat(prefix_, "/", key);
+  }
+
+  IteratorStateReader* const reader_;  // Not owned.
+  const string prefix_;
+};
+
+}  // namespace
+
+Status IteratorBase::SaveInput(IteratorStateWriter* writer,
+                               StringPiece prefix, IteratorBase* input) {
+  PrefixedIteratorStateWriter prefixed_writer(writer, prefix);
+  return input->Save(&prefixed_writer);
+}
+
+Status IteratorBase::RestoreInput(IteratorContext* ctx,
+                                  IteratorStateReader* reader,
+                                  StringPiece prefix, IteratorBase* input) {
+  PrefixedIteratorStateReader prefixed_reader(reader, prefix);
+  return input->Restore(ctx, &prefixed_reader);
+}
+
 void DatasetOpKernel::Compute(OpKernelContext* ctx) {
   DatasetBase* dataset = nullptr;
   MakeDataset(ctx, &dataset);
@@ -75,6 +75,29 @@ class IteratorContext {
   Params params_;
 };
 
+// Interface for writing the state of an iterator as a set of named
+// values. See `IteratorBase::Save()`.
+class IteratorStateWriter {
+ public:
+  virtual Status WriteScalar(StringPiece key, int64 val) = 0;
+  virtual Status WriteScalar(StringPiece key, const string& val) = 0;
+  virtual Status WriteTensor(StringPiece key, const Tensor& val) = 0;
+
+  virtual ~IteratorStateWriter() {}
+};
+
+// Interface for reading the state of an iterator that was written by an
+// `IteratorStateWriter`. See `IteratorBase::Restore()`.
+class IteratorStateReader {
+ public:
+  virtual Status ReadScalar(StringPiece key, int64* val) = 0;
+  virtual Status ReadScalar(StringPiece key, string* val) = 0;
+  virtual Status ReadTensor(StringPiece key, Tensor* val) = 0;
+  virtual bool Contains(StringPiece key) = 0;
+
+  virtual ~IteratorStateReader() {}
+};
+
 // Represents the current position in a range of outputs, where the
 // range of outputs is typically represented by an `DatasetBase`,
 // defined below.
@@ -108,6 +131,33 @@ class IteratorBase {
   // (and possibly partially defined) shapes of each tuple component
   // in the outputs of this iterator.
   virtual const std::vector<PartialTensorShape>& output_shapes() const = 0;
+
+  // Saves the current position of this iterator to `writer`.
+  //
+  // A fresh iterator over an identically-defined dataset can resume
+  // from the saved position by calling `Restore()`, without producing
+  // the elements that were consumed before the call to `Save()`.
+  //
+  // This method is thread-safe with respect to `GetNext()`.
+  virtual Status Save(IteratorStateWriter* writer) {
+    return errors::Unimplemented("Save() is not supported for this iterator.");
+  }
+
+  // Restores the position of this iterator from `reader`, which must
+  // hold the state saved by an iterator over an identically-defined
+  // dataset.
+  virtual Status Restore(IteratorContext* ctx, IteratorStateReader* reader) {
+    return errors::Unimplemented(
+        "Restore() is not supported for this iterator.");
+  }
+
+ protected:
+  // Saves (or restores) the state of `input`, an iterator from which
+  // this iterator reads, under keys prefixed with `prefix`.
+  static Status SaveInput(IteratorStateWriter* writer, StringPiece prefix,
+                          IteratorBase* input);
+  static Status RestoreInput(IteratorContext* ctx, IteratorStateReader* reader,
+                             StringPiece prefix, IteratorBase* input);
 };
 
 // Represents a (potentially infinite) range of outputs, where each
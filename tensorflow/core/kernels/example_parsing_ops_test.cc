@@ -230,4 +230,92 @@ BM_AllParseExample(SparseFloat);
 BM_AllParseExample(DenseFloat);
 BM_AllParseExample(VarLenDenseFloat);
 
+// Builds a ParseExample graph over 'batch_size' examples that each have
+// 'num_keys' dense float features of 4 values, 'num_keys' variable length int64
+// features of 1 to 8 ids, and 'num_keys' sparse string features of 1 to 4
+// values, like the inputs of a ranking model.
+static Graph* ParseMixedExample(int batch_size, int num_keys) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor serialized(DT_STRING, TensorShape({batch_size}));
+  auto serialized_t = serialized.vec<string>();
+  for (int b = 0; b < batch_size; ++b) {
+    Example example;
+    auto& fmap = *example.mutable_features()->mutable_feature();
+    for (int k = 0; k < num_keys; ++k) {
+      auto* floats = fmap[strings::Printf("dense_%d", k)].mutable_float_list();
+      for (int i = 0; i < 4; ++i) {
+        floats->add_value(1.729f * i);
+      }
+      auto* ids = fmap[strings::Printf("varlen_%d", k)].mutable_int64_list();
+      for (int i = 0; i < 1 + (b + k) % 8; ++i) {
+        ids->add_value((b * 7919 + k * 104729 + i * 31) % 1000000);
+      }
+      auto* bytes = fmap[strings::Printf("sparse_%d", k)].mutable_bytes_list();
+      for (int i = 0; i < 1 + (b + k) % 4; ++i) {
+        bytes->add_value("abcd1234abcd1234");
+      }
+    }
+    CHECK(example.SerializeToString(&serialized_t(b)));
+  }
+  Tensor names(DT_STRING, TensorShape({batch_size}));
+
+  std::vector<NodeBuilder::NodeOut> sparse_keys;
+  std::vector<NodeBuilder::NodeOut> dense_keys;
+  std::vector<NodeBuilder::NodeOut> dense_defaults;
+  std::vector<DataType> sparse_types;
+  std::vector<PartialTensorShape> dense_shapes;
+  for (int k = 0; k < num_keys; ++k) {
+    Tensor dense_key(DT_STRING, TensorShape());
+    dense_key.scalar<string>()() = strings::Printf("dense_%d", k);
+    dense_keys.emplace_back(test::graph::Constant(g, dense_key));
+    dense_defaults.emplace_back(
+        test::graph::Constant(g, Tensor(DT_FLOAT, TensorShape({4}))));
+    dense_shapes.push_back(PartialTensorShape({4}));
+
+    Tensor varlen_key(DT_STRING, TensorShape());
+    varlen_key.scalar<string>()() = strings::Printf("varlen_%d", k);
+    dense_keys.emplace_back(test::graph::Constant(g, varlen_key));
+    dense_defaults.emplace_back(
+        test::graph::Constant(g, Tensor(DT_INT64, TensorShape({1}))));
+    dense_shapes.push_back(PartialTensorShape({-1}));
+
+    Tensor sparse_key(DT_STRING, TensorShape());
+    sparse_key.scalar<string>()() = strings::Printf("sparse_%d", k);
+    sparse_keys.emplace_back(test::graph::Constant(g, sparse_key));
+    sparse_types.push_back(DT_STRING);
+  }
+
+  Node* ret;
+  TF_EXPECT_OK(NodeBuilder(g->NewName("n"), "ParseExample")
+                   .Input(test::graph::Constant(g, serialized))
+                   .Input(test::graph::Constant(g, names))
+                   .Input(sparse_keys)
+                   .Input(dense_keys)
+                   .Input(dense_defaults)
+                   .Attr("sparse_types", sparse_types)
+                   .Attr("dense_shapes", dense_shapes)
+                   .Finalize(g, &ret));
+
+  return g;
+}
+
+// Reports the throughput in examples per second.
+// B == batch_size, K == num_keys of each kind.
+#define BM_ParseMixedExample(B, K)                          \
+  static void BM_ParseMixedExample##_##B##_##K(int iters) { \
+    testing::StopTiming();                                  \
+    Graph* g = ParseMixedExample(B, K);                     \
+    testing::UseRealTime();                                 \
+    testing::ItemsProcessed(static_cast<int64>(iters) * B); \
+    testing::StartTiming();                                 \
+    test::Benchmark("cpu", g).Run(iters);                   \
+  }                                                         \
+  BENCHMARK(BM_ParseMixedExample##_##B##_##K);
+
+BM_ParseMixedExample(128, 10);
+BM_ParseMixedExample(512, 10);
+BM_ParseMixedExample(128, 100);
+BM_ParseMixedExample(512, 100);
+BM_ParseMixedExample(4096, 10);
+
 }  // end namespace tensorflow
@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_KERNELS_GATHER_FUNCTOR_H_
 #define TENSORFLOW_KERNELS_GATHER_FUNCTOR_H_
 
+#include <algorithm>
+#include <atomic>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 
 #include "tensorflow/core/framework/tensor_types.h"
@@ -29,10 +32,13 @@ typedef Eigen::ThreadPoolDevice CPUDevice;
 
 namespace functor {
 
-// Helper method to copy using memcpy.
+// Helper method to copy using memcpy. The copies are sharded over the threads
+// of 'd', or run on the calling thread if 'd' is null. Returns the position
+// of an out of range index, or -1 if all of them are in range.
 template <typename T, typename Index, typename SliceIndex,
-          SliceIndex static_slice_elems>
-SliceIndex HandleCopies(typename TTypes<T, 3>::ConstTensor params,
+          SliceIndex static_slice_elems, typename Device>
+SliceIndex HandleCopies(const Device* d,
+                        typename TTypes<T, 3>::ConstTensor params,
                         typename TTypes<Index>::ConstFlat indices,
                         SliceIndex slice_elems,
                         typename TTypes<T, 3>::Tensor out) {
@@ -47,46 +53,95 @@ SliceIndex HandleCopies(typename TTypes<T, 3>::ConstTensor params,
   }
   // Compute slice_bytes here so that static knowledge is available
   const size_t slice_bytes = slice_elems * sizeof(T);
-  for (SliceIndex b = 0; b < batch_size; b++) {
-    for (SliceIndex i = 0; i < indices_size; i++) {
-      const SliceIndex i_next = i + 1;
-      const SliceIndex b_next = b + 1;
-      if (i_next < indices_size) {
-        port::prefetch<port::PREFETCH_HINT_T0>(&params(b, indices(i_next), 0));
-        port::prefetch<port::PREFETCH_HINT_T0>(&out(b, i_next, 0));
-      } else if (b_next < batch_size) {
-        port::prefetch<port::PREFETCH_HINT_T0>(&params(b_next, indices(0), 0));
-        port::prefetch<port::PREFETCH_HINT_T0>(&out(b_next, 0, 0));
+
+  // The smallest position of an out of range index found so far, or
+  // indices_size if there is none. A shard stops at the first one it finds.
+  std::atomic<SliceIndex> bad_i(indices_size);
+  // Copies the slices [start, end) of the output, in (batch, index) order.
+  auto work = [&](int64 start, int64 end) {
+    SliceIndex b = static_cast<SliceIndex>(start / indices_size);
+    SliceIndex i = static_cast<SliceIndex>(start % indices_size);
+    for (int64 pos = start; pos < end; ++pos) {
+      SliceIndex i_next = i + 1;
+      SliceIndex b_next = b;
+      if (i_next == indices_size) {
+        i_next = 0;
+        ++b_next;
+      }
+      if (pos + 1 < end) {
+        port::prefetch<port::PREFETCH_HINT_T0>(
+            &params(b_next, indices(i_next), 0));
+        port::prefetch<port::PREFETCH_HINT_T0>(&out(b_next, i_next, 0));
       }
       // Grab the index and check its validity.  An earlier version of the
       // code checked it and then grabbed it from memory a second time, which
       // was a security risk since it could have changed in between.
       const Index index = internal::SubtleMustCopy(indices(i));
-      if (!FastBoundsCheck(index, limit)) return i;
-      // Copy using memcpy if possible, otherwise an Eigen loop
+      if (!FastBoundsCheck(index, limit)) {
+        SliceIndex current = bad_i.load();
+        while (i < current && !bad_i.compare_exchange_weak(current, i)) {
+        }
+        return;
+      }
+      // Avoid auto-promotion to Index from SliceIndex by casting.
+      T* out_slice = out_base + (b * indices_size + i) * slice_elems;
+      const SliceIndex params_row =
+          b * static_cast<SliceIndex>(limit) + static_cast<SliceIndex>(index);
+      const T* params_slice = params_base + params_row * slice_elems;
+      // Copy using memcpy if possible, otherwise an element by element loop
       // TODO(cwhipkey): avoid linking to framework to get Allocator (to improve
       // ahead-of-time compilation binary size).
       if (is_simple_type<T>::value) {
-        // Avoid auto-promotion to Index from SliceIndex by casting.
-        memcpy(out_base + (b * indices_size + i) * slice_elems,
-               params_base + (b * static_cast<SliceIndex>(limit) +
-                              static_cast<SliceIndex>(index)) *
-                                 slice_elems,
-               slice_bytes);
+        memcpy(out_slice, params_slice, slice_bytes);
       } else {
         // For non-"simple" types (e.g. strings).
-        out.template chip<1>(i) = params.template chip<1>(index);
+        std::copy_n(params_slice, slice_elems, out_slice);
       }
+      b = b_next;
+      i = i_next;
     }
+  };
+
+  const int64 num_slices = static_cast<int64>(batch_size) * indices_size;
+  if (num_slices == 0) {
+    return -1;
+  }
+  if (d == nullptr) {
+    work(0, num_slices);
+  } else {
+    // Each slice loads an index and a slice of params, and stores a slice.
+    d->parallelFor(num_slices,
+                   Eigen::TensorOpCost(sizeof(Index) + slice_bytes,
+                                       slice_bytes, 0),
+                   work);
   }
-  return -1;
+  const SliceIndex result = bad_i.load();
+  return result == indices_size ? -1 : result;
 }
 
 template <typename T, typename Index>
 struct GatherFunctorCPU {
+  // Runs the copies on the calling thread.
   int64 operator()(typename TTypes<T, 3>::ConstTensor params,
                    typename TTypes<Index>::ConstFlat indices,
                    typename TTypes<T, 3>::Tensor out) {
+    return Gather(static_cast<const CPUDevice*>(nullptr), params, indices,
+                  out);
+  }
+
+  // Shards the copies over the threads of 'd'.
+  int64 operator()(const CPUDevice& d,
+                   typename TTypes<T, 3>::ConstTensor params,
+                   typename TTypes<Index>::ConstFlat indices,
+                   typename TTypes<T, 3>::Tensor out) {
+    return Gather(&d, params, indices, out);
+  }
+
+ private:
+  template <typename Device>
+  int64 Gather(const Device* d, typename TTypes<T, 3>::ConstTensor params,
+               typename TTypes<Index>::ConstFlat indices,
+               typename TTypes<T, 3>::Tensor out) {
     const int64 N = indices.size();
     const int64 slice_size = out.dimension(2);
     int64 bad_i;
@@ -94,16 +149,16 @@ struct GatherFunctorCPU {
     bool use_large = (slice_size > std::numeric_limits<int32>::max() ||
                       params.size() > std::numeric_limits<int32>::max() ||
                       N > std::numeric_limits<int32>::max());
-#define CALL(elems)                                                   \
-  do {                                                                \
-    if (use_large) {                                                  \
-      bad_i = HandleCopies<T, Index, int64, elems>(params, indices,   \
-                                                   slice_size, out);  \
-    } else {                                                          \
-      const int32 small_slice = static_cast<int32>(slice_size);       \
-      bad_i = HandleCopies<T, Index, int32, elems>(params, indices,   \
-                                                   small_slice, out); \
-    }                                                                 \
+#define CALL(elems)                                                      \
+  do {                                                                   \
+    if (use_large) {                                                     \
+      bad_i = HandleCopies<T, Index, int64, elems>(d, params, indices,   \
+                                                   slice_size, out);     \
+    } else {                                                             \
+      const int32 small_slice = static_cast<int32>(slice_size);          \
+      bad_i = HandleCopies<T, Index, int32, elems>(d, params, indices,   \
+                                                   small_slice, out);    \
+    }                                                                    \
   } while (0)
 
     if (slice_size == 10)
@@ -131,7 +186,7 @@ struct GatherFunctor<CPUDevice, T, Index> {
                    typename TTypes<T, 3>::ConstTensor params,
                    typename TTypes<Index>::ConstFlat indices,
                    typename TTypes<T, 3>::Tensor out) {
-    return GatherFunctorCPU<T, Index>()(params, indices, out);
+    return GatherFunctorCPU<T, Index>()(d, params, indices, out);
   }
 };
 
@@ -103,20 +103,24 @@ struct GatherNdSlice<CPUDevice, T, Index, IXDIM> {
     std::atomic<Index> error_loc(-1);
 
     const Eigen::DenseIndex batch_size = Tindices.dimension(0);
-#if !defined(EIGEN_HAS_INDEX_LIST)
-    Eigen::Tensor<Eigen::DenseIndex, 1>::Dimensions reshape_dims{{ 1 }};
-    Eigen::array<Eigen::DenseIndex, 1> broadcast_dims{{ batch_size }};
-#else
-    Eigen::IndexList<Eigen::type2index<1> > reshape_dims;
-    Eigen::IndexList<Eigen::DenseIndex> broadcast_dims;
-    broadcast_dims.set(0, batch_size);
-#endif
     generator::GatherNdSliceGenerator<T, Index, IXDIM> gather_nd_generator(
         slice_size, Tindices, Tparams, Tout, &error_loc);
-    Tscratch.device(d) = Tscratch.reshape(reshape_dims)
-                             .broadcast(broadcast_dims)
-                             .generate(gather_nd_generator)
-                             .sum();
+    auto work = [&gather_nd_generator](int64 start, int64 end) {
+      Eigen::array<Eigen::DenseIndex, 1> loc;
+      for (int64 i = start; i < end; ++i) {
+        loc[0] = i;
+        gather_nd_generator(loc);
+      }
+    };
+    // The slices are copied directly rather than through an Eigen reduction
+    // of the generator, whose cost Eigen can't tell: each one loads IXDIM
+    // indices and a slice of params, and stores a slice. Tscratch is only
+    // needed on GPU.
+    const double slice_bytes = static_cast<double>(slice_size) * sizeof(T);
+    d.parallelFor(batch_size,
+                  Eigen::TensorOpCost(IXDIM * sizeof(Index) + slice_bytes,
+                                      slice_bytes, 0),
+                  work);
 
     // error_loc() returns -1 if there's no out-of-bounds index,
     // otherwise it returns the location of an OOB index in Tindices.
@@ -125,5 +125,47 @@ BM_GATHER_ND(gpu, int32);
 BM_GATHER_ND(cpu, int64);
 BM_GATHER_ND(gpu, int64);
 
+// Gathers num_lookups rows of dim floats out of a 512MB matrix.
+template <typename Index>
+static Graph* GatherNdRows(int dim, int num_lookups) {
+  Graph* g = new Graph(OpRegistry::Global());
+  const int kRows = ((512 << 20) / sizeof(float)) / dim;
+  Tensor params(DT_FLOAT, TensorShape({kRows, dim}));
+  params.flat<float>().setRandom();
+
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  Tensor indices(DataTypeToEnum<Index>::value, TensorShape({num_lookups, 1}));
+  auto indices_mat = indices.matrix<Index>();
+  for (int i = 0; i < num_lookups; i++) {
+    indices_mat(i, 0) = rnd.Uniform(kRows);
+  }
+
+  test::graph::GatherNd(g, test::graph::Constant(g, params),
+                        test::graph::Constant(g, indices));
+  return g;
+}
+
+#define BM_GATHER_ND_ROWS(DEVICE, INDEX)                                      \
+  static void BM_##DEVICE##_gather_nd_rows_##INDEX(int iters, int dim,       \
+                                                   int num_lookups) {        \
+    const int64 tot = static_cast<int64>(iters) * num_lookups * dim;         \
+    testing::ItemsProcessed(tot);                                            \
+    testing::BytesProcessed(tot * sizeof(float));                            \
+    testing::UseRealTime();                                                  \
+    test::Benchmark(#DEVICE, GatherNdRows<INDEX>(dim, num_lookups))          \
+        .Run(iters);                                                         \
+  }                                                                          \
+  BENCHMARK(BM_##DEVICE##_gather_nd_rows_##INDEX)                            \
+      ->ArgPair(1, 100000)                                                   \
+      ->ArgPair(16, 100000)                                                  \
+      ->ArgPair(64, 1000)                                                    \
+      ->ArgPair(64, 10000)                                                   \
+      ->ArgPair(64, 100000)                                                  \
+      ->ArgPair(256, 100000)
+
+BM_GATHER_ND_ROWS(cpu, int32);
+BM_GATHER_ND_ROWS(cpu, int64);
+
 }  // namespace
 }  // namespace tensorflow
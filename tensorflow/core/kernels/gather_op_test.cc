@@ -178,7 +178,7 @@ TEST_F(GatherOpTest, Error_IndexOutOfRange) {
 constexpr int kLookups = 2000;
 
 template <typename Index>
-static Graph* Gather(int dim) {
+static Graph* Gather(int dim, int num_lookups = kLookups) {
   Graph* g = new Graph(OpRegistry::Global());
   // Always use a 512MB buffer.
   const int kRows = ((512 << 20) / sizeof(float)) / dim;
@@ -188,11 +188,11 @@ static Graph* Gather(int dim) {
   random::PhiloxRandom philox(301, 17);
   random::SimplePhilox rnd(&philox);
   std::vector<Index> indices_vec;
-  indices_vec.reserve(kLookups);
-  for (int i = 0; i < kLookups; i++) {
+  indices_vec.reserve(num_lookups);
+  for (int i = 0; i < num_lookups; i++) {
     indices_vec.push_back(rnd.Uniform(kRows));
   }
-  Tensor indices(DataTypeToEnum<Index>::value, TensorShape({kLookups}));
+  Tensor indices(DataTypeToEnum<Index>::value, TensorShape({num_lookups}));
   for (int i = 0; i < indices_vec.size(); i++) {
     indices.flat<Index>()(i) = indices_vec[i];
   }
@@ -228,5 +228,26 @@ BM_GATHER(gpu, int32);
 BM_GATHER(cpu, int64);
 BM_GATHER(gpu, int64);
 
+// Large lookups, as done on embedding tables, which are split between threads.
+#define BM_GATHER_LOOKUPS(DEVICE, INDEX)                                      \
+  static void BM_##DEVICE##_gather_lookups_##INDEX(int iters, int dim,       \
+                                                   int num_lookups) {        \
+    const int64 tot = static_cast<int64>(iters) * num_lookups * dim;         \
+    testing::ItemsProcessed(tot);                                            \
+    testing::BytesProcessed(tot * sizeof(float));                            \
+    testing::UseRealTime();                                                  \
+    test::Benchmark(#DEVICE, Gather<INDEX>(dim, num_lookups)).Run(iters);    \
+  }                                                                          \
+  BENCHMARK(BM_##DEVICE##_gather_lookups_##INDEX)                            \
+      ->ArgPair(1, 100000)                                                   \
+      ->ArgPair(16, 100000)                                                  \
+      ->ArgPair(64, 1000)                                                    \
+      ->ArgPair(64, 10000)                                                   \
+      ->ArgPair(64, 100000)                                                  \
+      ->ArgPair(256, 100000)
+
+BM_GATHER_LOOKUPS(cpu, int32);
+BM_GATHER_LOOKUPS(cpu, int64);
+
 }  // namespace
 }  // namespace tensorflow
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
 
@@ -68,6 +69,71 @@ Status VerifyShapesCompatible(const std::vector<PartialTensorShape>& expected,
   return Status::OK();
 }
 
+// Writes iterator state into a tensor bundle, storing each scalar as a
+// rank-0 tensor.
+class BundleIteratorStateWriter : public IteratorStateWriter {
+ public:
+  explicit BundleIteratorStateWriter(BundleWriter* writer) : writer_(writer) {}
+
+  Status WriteScalar(StringPiece key, int64 val) override {
+    Tensor val_t(DT_INT64, TensorShape({}));
+    val_t.scalar<int64>()() = val;
+    return writer_->Add(key, val_t);
+  }
+
+  Status WriteScalar(StringPiece key, const string& val) override {
+    Tensor val_t(DT_STRING, TensorShape({}));
+    val_t.scalar<string>()() = val;
+    return writer_->Add(key, val_t);
+  }
+
+  Status WriteTensor(StringPiece key, const Tensor& val) override {
+    return writer_->Add(key, val);
+  }
+
+ private:
+  BundleWriter* const writer_;  // Not owned.
+};
+
+// Reads iterator state that was written by a BundleIteratorStateWriter.
+class BundleIteratorStateReader : public IteratorStateReader {
+ public:
+  explicit BundleIteratorStateReader(BundleReader* reader) : reader_(reader) {}
+
+  Status ReadScalar(StringPiece key, int64* val) override {
+    Tensor val_t;
+    TF_RETURN_IF_ERROR(ReadScalarTensor(key, DT_INT64, &val_t));
+    *val = val_t.scalar<int64>()();
+    return Status::OK();
+  }
+
+  Status ReadScalar(StringPiece key, string* val) override {
+    Tensor val_t;
+    TF_RETURN_IF_ERROR(ReadScalarTensor(key, DT_STRING, &val_t));
+    *val = val_t.scalar<string>()();
+    return Status::OK();
+  }
+
+  Status ReadTensor(StringPiece key, Tensor* val) override {
+    return reader_->Lookup(key, val);
+  }
+
+  bool Contains(StringPiece key) override { return reader_->Contains(key); }
+
+ private:
+  Status ReadScalarTensor(StringPiece key, DataType dtype, Tensor* val) {
+    TF_RETURN_IF_ERROR(reader_->Lookup(key, val));
+    if (val->dtype() != dtype || !TensorShapeUtils::IsScalar(val->shape())) {
+      return errors::InvalidArgument("Iterator state entry ", key,
+                                     " is not a scalar of type ",
+                                     DataTypeString(dtype), ".");
+    }
+    return Status::OK();
+  }
+
+  BundleReader* const reader_;  // Not owned.
+};
+
 class IteratorResource : public ResourceBase {
  public:
   IteratorResource(const DataTypeVector& output_dtypes,
@@ -89,6 +155,30 @@ class IteratorResource : public ResourceBase {
     }
   }
 
+  Status Save(IteratorStateWriter* writer) {
+    std::shared_ptr<IteratorBase> captured_iterator(iterator_);
+    if (captured_iterator) {
+      return captured_iterator->Save(writer);
+    } else {
+      return errors::FailedPrecondition(
+          "Save() failed because the iterator has not been initialized.");
+    }
+  }
+
+  // Restores the state of the current iterator, which must have been
+  // initialized with an identically-defined dataset.
+  Status Restore(IteratorContext* ctx, IteratorStateReader* reader) {
+    std::shared_ptr<IteratorBase> captured_iterator(iterator_);
+    if (captured_iterator) {
+      return captured_iterator->Restore(ctx, reader);
+    } else {
+      return errors::FailedPrecondition(
+          "Restore() failed because the iterator has not been initialized. "
+          "Ensure that you have run the initializer operation for this "
+          "iterator before restoring its state.");
+    }
+  }
+
   // Transfers ownership of iterator to this. This method is thread-safe.
   Status set_iterator(std::unique_ptr<IteratorBase> iterator) {
     if (iterator) {
@@ -415,6 +505,55 @@ class IteratorDisposeOp : public OpKernel {
   }
 };
 
+class SaveIteratorOp : public OpKernel {
+ public:
+  explicit SaveIteratorOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    IteratorResource* iterator;
+    OP_REQUIRES_OK(ctx,
+                   LookupResource(ctx, HandleFromInput(ctx, 0), &iterator));
+    core::ScopedUnref unref_iterator(iterator);
+    const Tensor& prefix_t = ctx->input(1);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(prefix_t.shape()),
+                errors::InvalidArgument("prefix must be a scalar"));
+
+    BundleWriter writer(ctx->env(), prefix_t.scalar<string>()());
+    OP_REQUIRES_OK(ctx, writer.status());
+    BundleIteratorStateWriter state_writer(&writer);
+    OP_REQUIRES_OK(ctx, iterator->Save(&state_writer));
+    OP_REQUIRES_OK(ctx, writer.Finish());
+  }
+};
+
+class RestoreIteratorOp : public OpKernel {
+ public:
+  explicit RestoreIteratorOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    IteratorResource* iterator;
+    OP_REQUIRES_OK(ctx,
+                   LookupResource(ctx, HandleFromInput(ctx, 0), &iterator));
+    core::ScopedUnref unref_iterator(iterator);
+    const Tensor& prefix_t = ctx->input(1);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(prefix_t.shape()),
+                errors::InvalidArgument("prefix must be a scalar"));
+
+    BundleReader reader(ctx->env(), prefix_t.scalar<string>()());
+    OP_REQUIRES_OK(ctx, reader.status());
+    BundleIteratorStateReader state_reader(&reader);
+
+    IteratorContext::Params params;
+    params.env = ctx->env();
+    params.step_id = ctx->step_id();
+    params.resource_manager = ctx->resource_manager();
+    params.runner = *(ctx->runner());
+    IteratorContext iter_ctx(std::move(params));
+
+    OP_REQUIRES_OK(ctx, iterator->Restore(&iter_ctx, &state_reader));
+  }
+};
+
 class IteratorToStringHandleOp : public OpKernel {
  public:
   explicit IteratorToStringHandleOp(OpKernelConstruction* ctx)
@@ -487,6 +626,10 @@ REGISTER_KERNEL_BUILDER(Name("IteratorGetNext").Device(DEVICE_CPU),
                         IteratorGetNextOp);
 REGISTER_KERNEL_BUILDER(Name("IteratorDispose").Device(DEVICE_CPU),
                         IteratorDisposeOp);
+REGISTER_KERNEL_BUILDER(Name("SaveIterator").Device(DEVICE_CPU),
+                        SaveIteratorOp);
+REGISTER_KERNEL_BUILDER(Name("RestoreIterator").Device(DEVICE_CPU),
+                        RestoreIteratorOp);
 REGISTER_KERNEL_BUILDER(Name("IteratorToStringHandle").Device(DEVICE_CPU),
                         IteratorToStringHandleOp);
 REGISTER_KERNEL_BUILDER(Name("IteratorFromStringHandle").Device(DEVICE_CPU),
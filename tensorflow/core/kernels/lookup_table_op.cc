@@ -796,6 +796,39 @@ REGISTER_KERNEL(string, bool);
 
 #undef REGISTER_KERNEL
 
+// Register the open-addressing implementation of the HashTable op. It is
+// selected with the "flat" kernel label, e.g. in Python with
+// `graph._kernel_label_map({"HashTableV2": "flat"})`.
+#define REGISTER_KERNEL(key_dtype, value_dtype)                               \
+  REGISTER_KERNEL_BUILDER(                                                    \
+      Name("HashTable")                                                       \
+          .Device(DEVICE_CPU)                                                 \
+          .Label("flat")                                                      \
+          .TypeConstraint<key_dtype>("key_dtype")                             \
+          .TypeConstraint<value_dtype>("value_dtype"),                        \
+      LookupTableOp<lookup::FlatHashTable<key_dtype, value_dtype>, key_dtype, \
+                    value_dtype>)                                             \
+  REGISTER_KERNEL_BUILDER(                                                    \
+      Name("HashTableV2")                                                     \
+          .Device(DEVICE_CPU)                                                 \
+          .Label("flat")                                                      \
+          .TypeConstraint<key_dtype>("key_dtype")                             \
+          .TypeConstraint<value_dtype>("value_dtype"),                        \
+      LookupTableOp<lookup::FlatHashTable<key_dtype, value_dtype>, key_dtype, \
+                    value_dtype>)
+
+REGISTER_KERNEL(string, double);
+REGISTER_KERNEL(string, float);
+REGISTER_KERNEL(string, int32);
+REGISTER_KERNEL(string, int64);
+REGISTER_KERNEL(int64, string);
+REGISTER_KERNEL(int64, int64);
+REGISTER_KERNEL(int64, float);
+REGISTER_KERNEL(string, string);
+REGISTER_KERNEL(string, bool);
+
+#undef REGISTER_KERNEL
+
 // Register the MutableHashTable op.
 #define REGISTER_KERNEL(key_dtype, value_dtype)                                \
   REGISTER_KERNEL_BUILDER(                                                     \
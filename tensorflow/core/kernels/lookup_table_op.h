@@ -16,6 +16,9 @@ limitations under the License.
 #ifndef TENSORFLOW_KERNELS_LOOKUP_TABLE_OP_H_
 #define TENSORFLOW_KERNELS_LOOKUP_TABLE_OP_H_
 
+#include <algorithm>
+#include <vector>
+
 #include "tensorflow/core/framework/lookup_interface.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/resource_mgr.h"
@@ -26,9 +29,15 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/prefetch.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace tensorflow {
 
 // Lookup table op that supports different table implementations specified by
@@ -227,8 +236,10 @@ class HashTable : public InitializableLookupTable {
 
   int64 MemoryUsed() const override {
     if (table_) {
+      // Each element lives in its own node, linked from a bucket array.
       const int64 num_elements = table_->size();
-      return num_elements * (sizeof(K) + sizeof(V));
+      return num_elements * (sizeof(K) + sizeof(V) + sizeof(void*)) +
+             table_->bucket_count() * sizeof(void*);
     } else {
       return 0;
     }
@@ -238,6 +249,287 @@ class HashTable : public InitializableLookupTable {
   std::unique_ptr<std::unordered_map<K, V>> table_;
 };
 
+namespace flat_hash_internal {
+
+// Helpers for the control bytes of FlatHashTable. Slots are grouped into
+// groups of kFlatGroupSize, and each slot has a control byte that is either
+// kFlatEmpty or the low 7 bits of the hash of the key stored in the slot.
+constexpr int kFlatGroupSize = 16;
+constexpr uint8 kFlatEmpty = 0x80;
+
+// Returns a bitmask with bit i set iff ctrl[i] == b, for the kFlatGroupSize
+// control bytes starting at ctrl, which must be kFlatGroupSize-aligned.
+inline uint32 FlatGroupMatch(const uint8* ctrl, uint8 b) {
+#if defined(__SSE2__)
+  const __m128i group = _mm_load_si128(reinterpret_cast<const __m128i*>(ctrl));
+  return static_cast<uint32>(_mm_movemask_epi8(
+      _mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(b)))));
+#else
+  uint32 mask = 0;
+  for (int i = 0; i < kFlatGroupSize; ++i) {
+    mask |= static_cast<uint32>(ctrl[i] == b) << i;
+  }
+  return mask;
+#endif
+}
+
+// Returns the index of the lowest set bit of mask, which must be non-zero.
+inline int FlatLowestBit(uint32 mask) {
+#if defined(__GNUC__)
+  return __builtin_ctz(mask);
+#else
+  int i = 0;
+  while ((mask & 1) == 0) {
+    mask >>= 1;
+    ++i;
+  }
+  return i;
+#endif
+}
+
+// Hashes for FlatHashTable. Integer keys are mixed so that sequential ids
+// spread over all groups; the table only uses the low bits for addressing.
+template <typename T>
+inline uint64 FlatHashKey(const T& key) {
+  uint64 x = static_cast<uint64>(key);
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+inline uint64 FlatHashKey(const string& key) { return Hash64(key); }
+
+// An aligned, fixed-size array of control bytes.
+class FlatControlBytes {
+ public:
+  FlatControlBytes() {}
+  FlatControlBytes(FlatControlBytes&&) = default;
+  FlatControlBytes& operator=(FlatControlBytes&&) = default;
+  explicit FlatControlBytes(size_t size)
+      : storage_(size + kFlatGroupSize, kFlatEmpty) {
+    const uintptr_t addr = reinterpret_cast<uintptr_t>(storage_.data());
+    offset_ = (kFlatGroupSize - addr % kFlatGroupSize) % kFlatGroupSize;
+  }
+
+  uint8* data() { return storage_.data() + offset_; }
+  const uint8* data() const { return storage_.data() + offset_; }
+
+ private:
+  std::vector<uint8> storage_;
+  size_t offset_ = 0;
+};
+
+}  // namespace flat_hash_internal
+
+// Lookup table with the same semantics as HashTable, stored in flat
+// open-addressing arrays instead of an unordered_map.
+//
+// Keys and values are kept in two parallel arrays of slots, with one control
+// byte per slot holding 7 bits of the key's hash. A lookup scans a group of
+// 16 control bytes at a time (with SSE2 when available), so only slots whose
+// hash bits match have their key compared. There are no per-entry heap
+// allocations, and DoFind() hashes and prefetches a batch of keys before
+// probing any of them.
+//
+// This table is registered as the "flat" kernel label of the HashTable ops.
+template <class K, class V>
+class FlatHashTable : public InitializableLookupTable {
+ public:
+  FlatHashTable(OpKernelContext* ctx, OpKernel* kernel) {}
+
+  size_t size() const override {
+    // return the size of the table only if it's initialized, otherwise 0.
+    if (!is_initialized_) {
+      return 0;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return num_entries_;
+  }
+
+  DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
+
+  DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
+
+ protected:
+  Status DoPrepare(size_t expected_num_elements) override {
+    if (is_initialized_) {
+      return errors::Aborted("HashTable already initialized.");
+    }
+    // Initializers that do not know their size ahead of time pass -1.
+    if (static_cast<int64>(expected_num_elements) <= 0) {
+      expected_num_elements = 0;
+    }
+    if (num_slots_ == 0) {
+      Resize(MinSlotsFor(expected_num_elements));
+    }
+    return Status::OK();
+  }
+
+  Status DoInsert(const Tensor& keys, const Tensor& values) override {
+    if (num_slots_ == 0) {
+      return errors::FailedPrecondition("HashTable is not prepared.");
+    }
+
+    const auto key_values = keys.flat<K>();
+    const auto value_values = values.flat<V>();
+    for (int64 i = 0; i < key_values.size(); ++i) {
+      const K key = SubtleMustCopyUnlessStringOrFloat(key_values(i));
+      const V value = SubtleMustCopyUnlessStringOrFloat(value_values(i));
+      const uint64 hash = HashKey(key);
+      const int64 slot = FindSlot(key, hash);
+      if (slot >= 0) {
+        const V previous_value = values_[slot];
+        if (previous_value != value) {
+          return errors::FailedPrecondition(
+              "HashTable has different value for same key. Key ", key,
+              " has ", previous_value, " and trying to add value ", value);
+        }
+        continue;
+      }
+      if (num_entries_ + 1 > MaxEntries(num_slots_)) {
+        Resize(num_slots_ * 2);
+      }
+      InsertNew(key, value, hash);
+    }
+    return Status::OK();
+  }
+
+  Status DoFind(const Tensor& key, Tensor* value,
+                const Tensor& default_value) override {
+    const V default_val = default_value.flat<V>()(0);
+    const auto key_values = key.flat<K>();
+    auto value_values = value->flat<V>();
+    const int64 num_keys = key_values.size();
+
+    // Hash a batch of keys and prefetch their first probe group, so that the
+    // cache misses of the batch overlap instead of being taken one by one.
+    uint64 hashes[kFindBatchSize];
+    for (int64 start = 0; start < num_keys; start += kFindBatchSize) {
+      const int64 end = std::min(num_keys, start + kFindBatchSize);
+      for (int64 i = start; i < end; ++i) {
+        const uint64 hash =
+            HashKey(SubtleMustCopyUnlessStringOrFloat(key_values(i)));
+        hashes[i - start] = hash;
+        port::prefetch<port::PREFETCH_HINT_T0>(
+            ctrl_.data() + GroupIndex(hash) * kGroupSize);
+      }
+      for (int64 i = start; i < end; ++i) {
+        const int64 slot =
+            FindSlot(SubtleMustCopyUnlessStringOrFloat(key_values(i)),
+                     hashes[i - start]);
+        value_values(i) = slot >= 0 ? values_[slot] : default_val;
+      }
+    }
+    return Status::OK();
+  }
+
+  int64 MemoryUsed() const override {
+    return num_slots_ * (sizeof(uint8) + sizeof(K) + sizeof(V));
+  }
+
+ private:
+  typedef flat_hash_internal::FlatControlBytes ControlBytes;
+  static constexpr int64 kFindBatchSize = 16;
+  static constexpr int64 kGroupSize = flat_hash_internal::kFlatGroupSize;
+  static constexpr uint8 kEmpty = flat_hash_internal::kFlatEmpty;
+
+  static uint32 GroupMatch(const uint8* ctrl, uint8 b) {
+    return flat_hash_internal::FlatGroupMatch(ctrl, b);
+  }
+  static int LowestBit(uint32 mask) {
+    return flat_hash_internal::FlatLowestBit(mask);
+  }
+  static uint64 HashKey(const K& key) {
+    return flat_hash_internal::FlatHashKey(key);
+  }
+
+  // The table is kept at most 7/8 full, so every probe sequence reaches a
+  // group with an empty slot.
+  static int64 MaxEntries(int64 num_slots) { return num_slots / 8 * 7; }
+
+  static int64 MinSlotsFor(int64 num_entries) {
+    int64 num_slots = kGroupSize;
+    while (MaxEntries(num_slots) < num_entries) {
+      num_slots *= 2;
+    }
+    return num_slots;
+  }
+
+  int64 GroupIndex(uint64 hash) const { return (hash >> 7) & group_mask_; }
+
+  static uint8 HashTag(uint64 hash) { return hash & 0x7f; }
+
+  // Returns the slot that holds key, or -1 if the key is not in the table.
+  // Groups are probed in a triangular sequence, which visits every group
+  // since the number of groups is a power of two.
+  int64 FindSlot(const K& key, uint64 hash) const {
+    const uint8 tag = HashTag(hash);
+    int64 group = GroupIndex(hash);
+    for (int64 probe = 1;; ++probe) {
+      const int64 base = group * kGroupSize;
+      const uint8* ctrl = ctrl_.data() + base;
+      for (uint32 mask = GroupMatch(ctrl, tag); mask != 0; mask &= mask - 1) {
+        const int64 slot = base + LowestBit(mask);
+        if (keys_[slot] == key) {
+          return slot;
+        }
+      }
+      if (GroupMatch(ctrl, kEmpty) != 0) {
+        return -1;
+      }
+      group = (group + probe) & group_mask_;
+    }
+  }
+
+  // Inserts a key that is known not to be in the table.
+  void InsertNew(const K& key, const V& value, uint64 hash) {
+    int64 group = GroupIndex(hash);
+    for (int64 probe = 1;; ++probe) {
+      const int64 base = group * kGroupSize;
+      uint8* ctrl = ctrl_.data() + base;
+      const uint32 empty = GroupMatch(ctrl, kEmpty);
+      if (empty != 0) {
+        const int64 slot = base + LowestBit(empty);
+        ctrl[slot - base] = HashTag(hash);
+        keys_[slot] = key;
+        values_[slot] = value;
+        ++num_entries_;
+        return;
+      }
+      group = (group + probe) & group_mask_;
+    }
+  }
+
+  void Resize(int64 num_slots) {
+    ControlBytes old_ctrl = std::move(ctrl_);
+    std::vector<K> old_keys = std::move(keys_);
+    std::vector<V> old_values = std::move(values_);
+    const int64 old_num_slots = num_slots_;
+
+    ctrl_ = ControlBytes(num_slots);
+    keys_ = std::vector<K>(num_slots);
+    values_ = std::vector<V>(num_slots);
+    num_slots_ = num_slots;
+    group_mask_ = num_slots / kGroupSize - 1;
+    num_entries_ = 0;
+    for (int64 i = 0; i < old_num_slots; ++i) {
+      if (old_ctrl.data()[i] != kEmpty) {
+        InsertNew(old_keys[i], old_values[i], HashKey(old_keys[i]));
+      }
+    }
+  }
+
+  ControlBytes ctrl_;
+  std::vector<K> keys_;
+  std::vector<V> values_;
+  int64 num_slots_ = 0;
+  int64 group_mask_ = 0;
+  int64 num_entries_ = 0;
+};
+
 }  // namespace lookup
 
 }  // namespace tensorflow
@@ -0,0 +1,232 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/lookup_table_op.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/initializable_lookup_table.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace lookup {
+namespace {
+
+// Yields the given keys and values as a single batch.
+class TensorIterator : public InitializableLookupTable::InitTableIterator {
+ public:
+  TensorIterator(const Tensor& keys, const Tensor& values, int64 total_size)
+      : keys_(keys), values_(values), total_size_(total_size) {}
+
+  bool Valid() const override { return valid_; }
+  void Next() override { valid_ = false; }
+  const Tensor& keys() const override { return keys_; }
+  const Tensor& values() const override { return values_; }
+  Status status() const override {
+    return valid_ ? Status::OK() : errors::OutOfRange("No more data.");
+  }
+  int64 total_size() const override { return total_size_; }
+
+ private:
+  const Tensor keys_;
+  const Tensor values_;
+  const int64 total_size_;
+  bool valid_ = true;
+};
+
+template <class Table>
+Status InitTable(Table* table, const Tensor& keys, const Tensor& values,
+                 int64 total_size) {
+  TensorIterator iter(keys, values, total_size);
+  return table->Initialize(iter);
+}
+
+TEST(FlatHashTableTest, Int64Keys) {
+  auto* table = new FlatHashTable<int64, int64>(nullptr, nullptr);
+  core::ScopedUnref unref(table);
+  const int kNumKeys = 1000;
+  Tensor keys(DT_INT64, TensorShape({kNumKeys}));
+  Tensor values(DT_INT64, TensorShape({kNumKeys}));
+  for (int i = 0; i < kNumKeys; ++i) {
+    keys.vec<int64>()(i) = i * 7919;
+    values.vec<int64>()(i) = i;
+  }
+  // Pass -1 as the size, as initializers that read files do, so that the
+  // table has to grow while it is populated.
+  TF_ASSERT_OK(InitTable(table, keys, values, -1));
+  EXPECT_EQ(kNumKeys, table->size());
+
+  Tensor lookup(DT_INT64, TensorShape({kNumKeys + 1}));
+  for (int i = 0; i < kNumKeys; ++i) {
+    lookup.vec<int64>()(i) = keys.vec<int64>()(kNumKeys - 1 - i);
+  }
+  lookup.vec<int64>()(kNumKeys) = 1;
+  Tensor out(DT_INT64, TensorShape({kNumKeys + 1}));
+  TF_ASSERT_OK(table->Find(nullptr, lookup, &out, test::AsScalar<int64>(-1)));
+  for (int i = 0; i < kNumKeys; ++i) {
+    EXPECT_EQ(kNumKeys - 1 - i, out.vec<int64>()(i));
+  }
+  EXPECT_EQ(-1, out.vec<int64>()(kNumKeys));
+}
+
+TEST(FlatHashTableTest, StringKeys) {
+  auto* table = new FlatHashTable<string, float>(nullptr, nullptr);
+  core::ScopedUnref unref(table);
+  TF_ASSERT_OK(InitTable(table, test::AsTensor<string>({"a", "b", "c"}),
+                         test::AsTensor<float>({1.0, 2.0, 3.0}), 3));
+  EXPECT_EQ(3, table->size());
+
+  Tensor out(DT_FLOAT, TensorShape({4}));
+  TF_ASSERT_OK(table->Find(nullptr,
+                           test::AsTensor<string>({"c", "d", "a", "b"}), &out,
+                           test::AsScalar<float>(-1.0)));
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({3.0, -1.0, 1.0, 2.0}),
+                                 out);
+}
+
+TEST(FlatHashTableTest, DuplicateKeys) {
+  auto* table = new FlatHashTable<int64, int64>(nullptr, nullptr);
+  core::ScopedUnref unref(table);
+  // Repeating a key with the same value is allowed.
+  TF_EXPECT_OK(InitTable(table, test::AsTensor<int64>({1, 2, 1}),
+                         test::AsTensor<int64>({10, 20, 10}), 3));
+  EXPECT_EQ(2, table->size());
+
+  auto* other = new FlatHashTable<int64, int64>(nullptr, nullptr);
+  core::ScopedUnref unref_other(other);
+  Status s = InitTable(other, test::AsTensor<int64>({1, 2, 1}),
+                       test::AsTensor<int64>({10, 20, 30}), 3);
+  EXPECT_TRUE(errors::IsFailedPrecondition(s)) << s;
+}
+
+TEST(FlatHashTableTest, NotInitialized) {
+  auto* table = new FlatHashTable<int64, int64>(nullptr, nullptr);
+  core::ScopedUnref unref(table);
+  EXPECT_EQ(0, table->size());
+  Tensor out(DT_INT64, TensorShape({1}));
+  Status s = table->Find(nullptr, test::AsTensor<int64>({1}), &out,
+                         test::AsScalar<int64>(-1));
+  EXPECT_TRUE(errors::IsFailedPrecondition(s)) << s;
+}
+
+// Builds a table with 'num_keys' random int64 keys, then looks up batches of
+// 'kBatchSize' keys of which half are present. Reports the bytes used per
+// entry as the label.
+template <class Table>
+static void BM_Int64Lookup(int iters, int num_keys) {
+  testing::StopTiming();
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rand(&philox);
+  Tensor keys(DT_INT64, TensorShape({num_keys}));
+  Tensor values(DT_INT64, TensorShape({num_keys}));
+  for (int i = 0; i < num_keys; ++i) {
+    keys.vec<int64>()(i) = rand.Rand64();
+    values.vec<int64>()(i) = i;
+  }
+  auto* table = new Table(nullptr, nullptr);
+  core::ScopedUnref unref(table);
+  TF_CHECK_OK(InitTable(table, keys, values, num_keys));
+
+  const int kBatchSize = 4096;
+  Tensor lookup(DT_INT64, TensorShape({kBatchSize}));
+  for (int i = 0; i < kBatchSize; ++i) {
+    lookup.vec<int64>()(i) = rand.OneIn(2)
+                                 ? keys.vec<int64>()(rand.Uniform(num_keys))
+                                 : static_cast<int64>(rand.Rand64());
+  }
+  Tensor out(DT_INT64, TensorShape({kBatchSize}));
+  const Tensor default_value = test::AsScalar<int64>(-1);
+  testing::SetLabel(strings::StrCat(
+      "bytes/entry=",
+      static_cast<LookupInterface*>(table)->MemoryUsed() /
+          static_cast<double>(num_keys)));
+  testing::ItemsProcessed(static_cast<int64>(iters) * kBatchSize);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(table->Find(nullptr, lookup, &out, default_value));
+  }
+  testing::StopTiming();
+}
+
+static void BM_HashTableInt64Lookup(int iters, int num_keys) {
+  BM_Int64Lookup<HashTable<int64, int64>>(iters, num_keys);
+}
+BENCHMARK(BM_HashTableInt64Lookup)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 22);
+
+static void BM_FlatHashTableInt64Lookup(int iters, int num_keys) {
+  BM_Int64Lookup<FlatHashTable<int64, int64>>(iters, num_keys);
+}
+BENCHMARK(BM_FlatHashTableInt64Lookup)
+    ->Arg(1 << 10)
+    ->Arg(1 << 16)
+    ->Arg(1 << 22);
+
+// Same as BM_Int64Lookup, with vocabulary-like string keys.
+template <class Table>
+static void BM_StringLookup(int iters, int num_keys) {
+  testing::StopTiming();
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rand(&philox);
+  Tensor keys(DT_STRING, TensorShape({num_keys}));
+  Tensor values(DT_INT64, TensorShape({num_keys}));
+  for (int i = 0; i < num_keys; ++i) {
+    keys.vec<string>()(i) = strings::StrCat("token_", rand.Rand64());
+    values.vec<int64>()(i) = i;
+  }
+  auto* table = new Table(nullptr, nullptr);
+  core::ScopedUnref unref(table);
+  TF_CHECK_OK(InitTable(table, keys, values, num_keys));
+
+  const int kBatchSize = 4096;
+  Tensor lookup(DT_STRING, TensorShape({kBatchSize}));
+  for (int i = 0; i < kBatchSize; ++i) {
+    lookup.vec<string>()(i) =
+        rand.OneIn(2) ? keys.vec<string>()(rand.Uniform(num_keys))
+                      : strings::StrCat("token_", rand.Rand64());
+  }
+  Tensor out(DT_INT64, TensorShape({kBatchSize}));
+  const Tensor default_value = test::AsScalar<int64>(-1);
+  testing::SetLabel(strings::StrCat(
+      "bytes/entry=",
+      static_cast<LookupInterface*>(table)->MemoryUsed() /
+          static_cast<double>(num_keys)));
+  testing::ItemsProcessed(static_cast<int64>(iters) * kBatchSize);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(table->Find(nullptr, lookup, &out, default_value));
+  }
+  testing::StopTiming();
+}
+
+static void BM_HashTableStringLookup(int iters, int num_keys) {
+  BM_StringLookup<HashTable<string, int64>>(iters, num_keys);
+}
+BENCHMARK(BM_HashTableStringLookup)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+
+static void BM_FlatHashTableStringLookup(int iters, int num_keys) {
+  BM_StringLookup<FlatHashTable<string, int64>>(iters, num_keys);
+}
+BENCHMARK(BM_FlatHashTableStringLookup)
+    ->Arg(1 << 10)
+    ->Arg(1 << 16)
+    ->Arg(1 << 20);
+
+}  // namespace
+}  // namespace lookup
+}  // namespace tensorflow
@@ -127,6 +127,17 @@ class MapDatasetOp : public UnaryDatasetOpKernel {
         return dataset()->captured_func_->Run(opts, args, out_tensors);
       }
 
+      // `f` is stateless with respect to the iteration, so the position
+      // of this iterator is the position of its input.
+      Status Save(IteratorStateWriter* writer) override {
+        return SaveInput(writer, "input", input_impl_.get());
+      }
+
+      Status Restore(IteratorContext* ctx,
+                     IteratorStateReader* reader) override {
+        return RestoreInput(ctx, reader, "input", input_impl_.get());
+      }
+
      private:
       const std::unique_ptr<IteratorBase> input_impl_;
     };
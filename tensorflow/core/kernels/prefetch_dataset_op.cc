@@ -0,0 +1,226 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <deque>
+
+#include "tensorflow/core/kernels/dataset.h"
+
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The fraction of the prefetch buffer that is occupied each time an element
+// is consumed. A buffer that is mostly empty means that the input pipeline
+// cannot keep up with its consumer.
+auto* prefetch_buffer_utilization = monitoring::Sampler<0>::New(
+    {"/tensorflow/data/prefetch_buffer_utilization",
+     "The fraction of the PrefetchDataset buffer that is occupied when an "
+     "element is consumed."},
+    {0.0, 0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0});
+
+// See documentation in ../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+class PrefetchDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  explicit PrefetchDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx) {}
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override {
+    int64 buffer_size;
+    OP_REQUIRES_OK(
+        ctx, ParseScalarArgument<int64>(ctx, "buffer_size", &buffer_size));
+    OP_REQUIRES(ctx, buffer_size > 0,
+                errors::InvalidArgument("buffer_size must be > 0"));
+
+    // The background thread calls the input iterator outside of any step,
+    // so it uses a context captured from this kernel, as
+    // ParallelMapDatasetOp does.
+    IteratorContext::Params params;
+    params.env = ctx->env();
+    params.resource_manager = ctx->resource_manager();
+    params.runner = *(ctx->runner());
+
+    *output = new Dataset(input, buffer_size, std::move(params));
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(const DatasetBase* input, int64 buffer_size,
+            IteratorContext::Params ctx_params)
+        : input_(input),
+          buffer_size_(buffer_size),
+          ctx_params_(std::move(ctx_params)) {
+      input_->Ref();
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIterator() const override {
+      return std::unique_ptr<IteratorBase>(new Iterator(this));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return input_->output_dtypes();
+    }
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return input_->output_shapes();
+    }
+
+    string DebugString() override { return "PrefetchDatasetOp::Dataset"; }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Dataset* dataset)
+          : DatasetIterator<Dataset>(dataset),
+            iter_ctx_(dataset->ctx_params_),
+            input_impl_(dataset->input_->MakeIterator()) {}
+
+      ~Iterator() override {
+        // Signal the prefetch thread to terminate it. We will then
+        // join that thread when we delete `this->prefetch_thread_`.
+        {
+          mutex_lock l(mu_);
+          cancelled_ = true;
+          cond_var_.notify_all();
+        }
+      }
+
+      Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                     bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(EnsurePrefetchThreadStarted(ctx));
+
+        // Wait until the next element in the buffer has been
+        // produced, or we are shutting down.
+        while (!cancelled_ && buffer_.empty() && !prefetch_thread_finished_) {
+          cond_var_.wait(l);
+        }
+
+        if (cancelled_) {
+          return errors::Cancelled(
+              "PrefetchDatasetOp::Dataset::Iterator::GetNext");
+        }
+
+        if (!buffer_.empty()) {
+          prefetch_buffer_utilization->GetCell()->Add(
+              static_cast<double>(buffer_.size()) / dataset()->buffer_size_);
+
+          // Forward the status from producing the element, and (if we
+          // successfully got an element) the output values.
+          Status s = buffer_.front().status;
+          if (s.ok()) {
+            *out_tensors = std::move(buffer_.front().value);
+          }
+          buffer_.pop_front();
+          *end_of_sequence = false;
+
+          // Wake the prefetch thread, in case it has been waiting for
+          // space in the buffer.
+          cond_var_.notify_one();
+          return s;
+        }
+
+        DCHECK(prefetch_thread_finished_);
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+
+     private:
+      // A buffer element comprises a status and (if that status is
+      // OK) a vector of tensors, representing an element of the input
+      // dataset.
+      struct BufferElement {
+        // The producer sets `status` if getting the input element fails.
+        Status status;
+        // The buffered data element.
+        std::vector<Tensor> value;
+      };
+
+      Status EnsurePrefetchThreadStarted(IteratorContext* ctx)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (!prefetch_thread_) {
+          prefetch_thread_.reset(ctx->env()->StartThread(
+              {}, "prefetch_thread", [this]() { PrefetchThread(); }));
+        }
+        return Status::OK();
+      }
+
+      // Prefetches elements of the input, storing results in an internal
+      // buffer.
+      void PrefetchThread() {
+        while (true) {
+          // 1. Wait for a slot in the buffer.
+          {
+            mutex_lock l(mu_);
+            while (!cancelled_ && buffer_.size() == dataset()->buffer_size_) {
+              cond_var_.wait(l);
+            }
+
+            if (cancelled_) {
+              return;
+            }
+          }
+
+          // 2. Read the next element. Only this thread touches
+          // `input_impl_`, so `mu_` is not held while it runs.
+          BufferElement buffer_element;
+          bool end_of_sequence;
+          buffer_element.status = input_impl_->GetNext(
+              &iter_ctx_, &buffer_element.value, &end_of_sequence);
+          if (buffer_element.status.ok() && end_of_sequence) {
+            mutex_lock l(mu_);
+            prefetch_thread_finished_ = true;
+            cond_var_.notify_all();
+            return;
+          }
+
+          // 3. Signal that the element has been produced.
+          {
+            mutex_lock l(mu_);
+            buffer_.push_back(std::move(buffer_element));
+            cond_var_.notify_all();
+          }
+        }
+      }
+
+      IteratorContext iter_ctx_;
+      const std::unique_ptr<IteratorBase> input_impl_;
+      mutex mu_;
+      condition_variable cond_var_;
+      std::deque<BufferElement> buffer_ GUARDED_BY(mu_);
+      std::unique_ptr<Thread> prefetch_thread_ GUARDED_BY(mu_);
+      bool cancelled_ GUARDED_BY(mu_) = false;
+      bool prefetch_thread_finished_ GUARDED_BY(mu_) = false;
+    };
+
+    const DatasetBase* const input_;
+    const int64 buffer_size_;
+    const IteratorContext::Params ctx_params_;
+  };
+};
+
+REGISTER_KERNEL_BUILDER(Name("PrefetchDataset").Device(DEVICE_CPU),
+                        PrefetchDatasetOp);
+
+}  // namespace
+
+}  // namespace tensorflow
@@ -94,9 +94,20 @@ class RangeDatasetOp : public DatasetOpKernel {
         return Status::OK();
       }
 
+      Status Save(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        return writer->WriteScalar("next", next_);
+      }
+
+      Status Restore(IteratorContext* ctx,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        return reader->ReadScalar("next", &next_);
+      }
+
      private:
       mutex mu_;
-      int64 next_;
+      int64 next_ GUARDED_BY(mu_);
     };
 
     const int64 start_;
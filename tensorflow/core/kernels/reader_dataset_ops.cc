@@ -137,11 +137,7 @@ class TextLineDatasetOp : public OpKernel {
 
             // We have reached the end of the current file, so maybe
             // move on to next file.
-            processing_file_ = false;
-            input_stream_.reset();
-            zlib_input_stream_.reset();
-            buffered_input_stream_.reset();
-            file_.reset();
+            ResetStreamsLocked();
             ++current_file_index_;
           }
 
@@ -152,25 +148,84 @@ class TextLineDatasetOp : public OpKernel {
           }
 
           // Actually move on to next file.
-          TF_RETURN_IF_ERROR(ctx->env()->NewRandomAccessFile(
-              dataset()->filenames_[current_file_index_], &file_));
-          processing_file_ = true;
-          input_stream_.reset(
-              new io::RandomAccessInputStream(file_.get(), false));
-          if (dataset()->use_compression_) {
-            zlib_input_stream_.reset(
-                new io::ZlibInputStream(input_stream_.get(), kBufferSize,
-                                        kBufferSize, dataset()->options_));
-            buffered_input_stream_.reset(new io::BufferedInputStream(
-                zlib_input_stream_.get(), kBufferSize, false));
-          } else {
-            buffered_input_stream_.reset(new io::BufferedInputStream(
-                input_stream_.get(), kBufferSize, false));
-          }
+          TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env(), 0));
         } while (true);
       }
 
+      Status Save(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar("current_file_index", current_file_index_));
+        if (processing_file_) {
+          TF_RETURN_IF_ERROR(writer->WriteScalar(
+              "current_pos", buffered_input_stream_->Tell()));
+        }
+        return Status::OK();
+      }
+
+      Status Restore(IteratorContext* ctx,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        ResetStreamsLocked();
+        int64 current_file_index;
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar("current_file_index", &current_file_index));
+        if (current_file_index < 0 ||
+            current_file_index > dataset()->filenames_.size()) {
+          return errors::InvalidArgument("Restored file index ",
+                                         current_file_index,
+                                         " is out of range.");
+        }
+        current_file_index_ = current_file_index;
+        if (reader->Contains("current_pos")) {
+          int64 current_pos;
+          TF_RETURN_IF_ERROR(reader->ReadScalar("current_pos", &current_pos));
+          TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env(), current_pos));
+        }
+        return Status::OK();
+      }
+
      private:
+      // Opens the current file and positions the streams at byte `pos`
+      // of its (uncompressed) contents.
+      Status SetupStreamsLocked(Env* env, int64 pos)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (current_file_index_ >= dataset()->filenames_.size()) {
+          return errors::InvalidArgument(
+              "current_file_index_:", current_file_index_,
+              " >= filenames_.size():", dataset()->filenames_.size());
+        }
+        TF_RETURN_IF_ERROR(env->NewRandomAccessFile(
+            dataset()->filenames_[current_file_index_], &file_));
+        processing_file_ = true;
+        input_stream_.reset(
+            new io::RandomAccessInputStream(file_.get(), false));
+        if (dataset()->use_compression_) {
+          zlib_input_stream_.reset(
+              new io::ZlibInputStream(input_stream_.get(), kBufferSize,
+                                      kBufferSize, dataset()->options_));
+          buffered_input_stream_.reset(new io::BufferedInputStream(
+              zlib_input_stream_.get(), kBufferSize, false));
+          // The compressed stream cannot seek, so decompress up to `pos`.
+          if (pos > 0) {
+            TF_RETURN_IF_ERROR(buffered_input_stream_->SkipNBytes(pos));
+          }
+        } else {
+          TF_RETURN_IF_ERROR(input_stream_->Seek(pos));
+          buffered_input_stream_.reset(new io::BufferedInputStream(
+              input_stream_.get(), kBufferSize, false));
+        }
+        return Status::OK();
+      }
+
+      void ResetStreamsLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        processing_file_ = false;
+        buffered_input_stream_.reset();
+        zlib_input_stream_.reset();
+        input_stream_.reset();
+        file_.reset();
+      }
+
       // TODO(mrry): Make this configurable via an attr on the dataset op?
       // Or maybe via a data input?
       enum { kBufferSize = 256 << 10 /* 256 kB */ };
@@ -310,19 +365,63 @@ class FixedLengthRecordDatasetOp : public OpKernel {
           }
 
           // Actually move on to next file.
-          uint64 file_size;
-          TF_RETURN_IF_ERROR(ctx->env()->GetFileSize(
-              dataset()->filenames_[current_file_index_], &file_size));
-          file_pos_limit_ = file_size - dataset()->footer_bytes_;
-          TF_RETURN_IF_ERROR(ctx->env()->NewRandomAccessFile(
-              dataset()->filenames_[current_file_index_], &file_));
-          input_buffer_.reset(new io::InputBuffer(file_.get(), kBufferSize));
           TF_RETURN_IF_ERROR(
-              input_buffer_->SkipNBytes(dataset()->header_bytes_));
+              OpenFileLocked(ctx->env(), dataset()->header_bytes_));
         } while (true);
       }
 
+      Status Save(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar("current_file_index", current_file_index_));
+        if (input_buffer_) {
+          TF_RETURN_IF_ERROR(
+              writer->WriteScalar("current_pos", input_buffer_->Tell()));
+        }
+        return Status::OK();
+      }
+
+      Status Restore(IteratorContext* ctx,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        input_buffer_.reset();
+        file_.reset();
+        int64 current_file_index;
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar("current_file_index", &current_file_index));
+        if (current_file_index < 0 ||
+            current_file_index > dataset()->filenames_.size()) {
+          return errors::InvalidArgument("Restored file index ",
+                                         current_file_index,
+                                         " is out of range.");
+        }
+        current_file_index_ = current_file_index;
+        if (reader->Contains("current_pos")) {
+          int64 current_pos;
+          TF_RETURN_IF_ERROR(reader->ReadScalar("current_pos", &current_pos));
+          TF_RETURN_IF_ERROR(OpenFileLocked(ctx->env(), current_pos));
+        }
+        return Status::OK();
+      }
+
      private:
+      // Opens the current file and positions `input_buffer_` at byte `pos`.
+      Status OpenFileLocked(Env* env, int64 pos) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (current_file_index_ >= dataset()->filenames_.size()) {
+          return errors::InvalidArgument(
+              "current_file_index_:", current_file_index_,
+              " >= filenames_.size():", dataset()->filenames_.size());
+        }
+        uint64 file_size;
+        TF_RETURN_IF_ERROR(env->GetFileSize(
+            dataset()->filenames_[current_file_index_], &file_size));
+        file_pos_limit_ = file_size - dataset()->footer_bytes_;
+        TF_RETURN_IF_ERROR(env->NewRandomAccessFile(
+            dataset()->filenames_[current_file_index_], &file_));
+        input_buffer_.reset(new io::InputBuffer(file_.get(), kBufferSize));
+        return input_buffer_->Seek(pos);
+      }
+
       // TODO(mrry): Make this configurable via an attr on the dataset op?
       // Or maybe via a data input?
       enum { kBufferSize = 256 << 10 /* 256 kB */ };
@@ -443,16 +542,69 @@ class TFRecordDatasetOp : public OpKernel {
           }
 
           // Actually move on to next file.
-          const string& next_filename =
-              dataset()->filenames_[current_file_index_];
-          TF_RETURN_IF_ERROR(
-              ctx->env()->NewRandomAccessFile(next_filename, &file_));
-          reader_.reset(new io::RecordReader(file_.get(), dataset()->options_));
-          offset_ = 0;
+          TF_RETURN_IF_ERROR(OpenFileLocked(ctx->env()));
         } while (true);
       }
 
+      Status Save(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar("current_file_index", current_file_index_));
+        if (reader_) {
+          TF_RETURN_IF_ERROR(writer->WriteScalar("offset", offset_));
+        }
+        return Status::OK();
+      }
+
+      Status Restore(IteratorContext* ctx,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        reader_.reset();
+        file_.reset();
+        int64 current_file_index;
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar("current_file_index", &current_file_index));
+        if (current_file_index < 0 ||
+            current_file_index > dataset()->filenames_.size()) {
+          return errors::InvalidArgument("Restored file index ",
+                                         current_file_index,
+                                         " is out of range.");
+        }
+        current_file_index_ = current_file_index;
+        if (reader->Contains("offset")) {
+          int64 offset;
+          TF_RETURN_IF_ERROR(reader->ReadScalar("offset", &offset));
+          TF_RETURN_IF_ERROR(OpenFileLocked(ctx->env()));
+          if (dataset()->options_.compression_type ==
+              io::RecordReaderOptions::NONE) {
+            // Uncompressed records can be read from any offset.
+            offset_ = offset;
+          } else {
+            // A compressed file must be read sequentially, so skip the
+            // records before `offset`.
+            string record;
+            while (offset_ < offset) {
+              TF_RETURN_IF_ERROR(reader_->ReadRecord(&offset_, &record));
+            }
+          }
+        }
+        return Status::OK();
+      }
+
      private:
+      Status OpenFileLocked(Env* env) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (current_file_index_ >= dataset()->filenames_.size()) {
+          return errors::InvalidArgument(
+              "current_file_index_:", current_file_index_,
+              " >= filenames_.size():", dataset()->filenames_.size());
+        }
+        TF_RETURN_IF_ERROR(env->NewRandomAccessFile(
+            dataset()->filenames_[current_file_index_], &file_));
+        reader_.reset(new io::RecordReader(file_.get(), dataset()->options_));
+        offset_ = 0;
+        return Status::OK();
+      }
+
       mutex mu_;
       size_t current_file_index_ GUARDED_BY(mu_) = 0;
       uint64 offset_ GUARDED_BY(mu_) = 0;
@@ -79,6 +79,15 @@ class RepeatDatasetOp : public UnaryDatasetOpKernel {
         *end_of_sequence = true;
         return Status::OK();
       }
+
+      Status Save(IteratorStateWriter* writer) override {
+        return Status::OK();
+      }
+
+      Status Restore(IteratorContext* ctx,
+                     IteratorStateReader* reader) override {
+        return Status::OK();
+      }
     };
 
     class FiniteIterator : public DatasetIterator<Dataset> {
@@ -105,6 +114,27 @@ class RepeatDatasetOp : public UnaryDatasetOpKernel {
         return Status::OK();
       }
 
+      Status Save(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(writer->WriteScalar("i", i_));
+        if (!input_impl_) {
+          return writer->WriteScalar("input_impl_empty", "");
+        }
+        return SaveInput(writer, "input", input_impl_.get());
+      }
+
+      Status Restore(IteratorContext* ctx,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(reader->ReadScalar("i", &i_));
+        if (reader->Contains("input_impl_empty")) {
+          input_impl_.reset();
+          return Status::OK();
+        }
+        input_impl_ = dataset()->input_->MakeIterator();
+        return RestoreInput(ctx, reader, "input", input_impl_.get());
+      }
+
      private:
       mutex mu_;
       int64 i_ GUARDED_BY(mu_);
@@ -148,6 +178,25 @@ class RepeatDatasetOp : public UnaryDatasetOpKernel {
         } while (true);
       }
 
+      Status Save(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        if (!input_impl_) {
+          return writer->WriteScalar("input_impl_empty", "");
+        }
+        return SaveInput(writer, "input", input_impl_.get());
+      }
+
+      Status Restore(IteratorContext* ctx,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        if (reader->Contains("input_impl_empty")) {
+          input_impl_.reset();
+          return Status::OK();
+        }
+        input_impl_ = dataset()->input_->MakeIterator();
+        return RestoreInput(ctx, reader, "input", input_impl_.get());
+      }
+
      private:
       mutex mu_;
       std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <stdlib.h>
 #include <complex>
 #include <functional>
 #include <memory>
@@ -26,11 +27,13 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_description.pb.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
 namespace {
@@ -347,6 +350,111 @@ class RestoreV2OpTest : public OpsTestBase {
   }
 };
 
+// Restores many tensors in one op, including one that is large enough to be
+// read in several concurrent pieces.
+TEST_F(RestoreV2OpTest, RestoreManyTensorsInParallel) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "tensor_many");
+  const int kNumSmall = 20;
+  const int64 kLargeSize = 20 << 20;  // 80MB of floats.
+  {
+    BundleWriter writer(Env::Default(), prefix);
+    for (int i = 0; i < kNumSmall; ++i) {
+      TF_ASSERT_OK(writer.Add(strings::StrCat("small", i),
+                              MakeInput<int64>(TensorShape({100}), [i](int x) {
+                                return static_cast<int64>(i) * 1000 + x;
+                              })));
+    }
+    TF_ASSERT_OK(writer.Add(
+        "large", MakeInput<float>(TensorShape({kLargeSize}),
+                                  [](int x) -> float { return x; })));
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  std::vector<string> names;
+  std::vector<DataType> dtypes;
+  for (int i = 0; i < kNumSmall; ++i) {
+    names.push_back(strings::StrCat("small", i));
+    dtypes.push_back(DT_INT64);
+  }
+  names.push_back("large");
+  dtypes.push_back(DT_FLOAT);
+  TF_ASSERT_OK(NodeDefBuilder("myop", "RestoreV2")
+                   .Input(FakeInput())
+                   .Input(FakeInput())
+                   .Input(FakeInput())
+                   .Attr("dtypes", dtypes)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInput<string>(TensorShape({}), [&prefix](int x) { return prefix; });
+  AddInput<string>(TensorShape({static_cast<int64>(names.size())}),
+                   [&names](int x) { return names[x]; });
+  AddInput<string>(TensorShape({static_cast<int64>(names.size())}),
+                   [](int x) -> string { return ""; });
+  TF_ASSERT_OK(RunOpKernel());
+
+  for (int i = 0; i < kNumSmall; ++i) {
+    const Tensor* output = GetOutput(i);
+    ASSERT_EQ(100, output->NumElements());
+    for (int x = 0; x < 100; ++x) {
+      EXPECT_EQ(static_cast<int64>(i) * 1000 + x, output->flat<int64>()(x));
+    }
+  }
+  const Tensor* large = GetOutput(kNumSmall);
+  ASSERT_EQ(kLargeSize, large->NumElements());
+  for (int64 x = 0; x < kLargeSize; x += 4099) {
+    EXPECT_EQ(static_cast<float>(x), large->flat<float>()(x));
+  }
+}
+
+// In mmap mode, the aligned numeric outputs alias the mapped data file rather
+// than being copied into allocated outputs.
+TEST_F(RestoreV2OpTest, RestoreWithMmap) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "tensor_mmap");
+  {
+    BundleWriter::Options writer_options;
+    writer_options.data_alignment = Allocator::kAllocatorAlignment;
+    BundleWriter writer(Env::Default(), prefix, writer_options);
+    TF_ASSERT_OK(writer.Add(
+        "floats", MakeInput<float>(TensorShape({3}),
+                                   [](int x) -> float { return x; })));
+    TF_ASSERT_OK(writer.Add(
+        "ints", MakeInput<int64>(TensorShape({2, 2}),
+                                 [](int x) -> int64 { return 10 * x; })));
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  setenv("TF_CHECKPOINT_RESTORE_USE_MMAP", "true", 1);
+  TF_ASSERT_OK(NodeDefBuilder("myop", "RestoreV2")
+                   .Input(FakeInput())
+                   .Input(FakeInput())
+                   .Input(FakeInput())
+                   .Attr("dtypes", {DT_FLOAT, DT_INT64})
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInput<string>(TensorShape({}), [&prefix](int x) { return prefix; });
+  AddInput<string>(TensorShape({2}), [](int x) -> string {
+    return x == 0 ? "floats" : "ints";
+  });
+  AddInput<string>(TensorShape({2}), [](int x) -> string { return ""; });
+  const Status s = RunOpKernel();
+  unsetenv("TF_CHECKPOINT_RESTORE_USE_MMAP");
+  TF_ASSERT_OK(s);
+
+  for (int i = 0; i < 2; ++i) {
+    TensorDescription description;
+    GetOutput(i)->FillDescription(&description);
+    EXPECT_EQ("BundleReaderMmap",
+              description.allocation_description().allocator_name());
+  }
+  test::ExpectTensorEqual<float>(
+      MakeInput<float>(TensorShape({3}), [](int x) -> float { return x; }),
+      *GetOutput(0));
+  test::ExpectTensorEqual<int64>(
+      MakeInput<int64>(TensorShape({2, 2}),
+                       [](int x) -> int64 { return 10 * x; }),
+      *GetOutput(1));
+}
+
 // The intended use case (write in V2, read in V2).
 TEST_F(RestoreV2OpTest, RestoreAfterSaveV2) { RunTest("SaveV2"); }
 // For backward compatibility.
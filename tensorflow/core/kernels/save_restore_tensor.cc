@@ -13,21 +13,28 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
+#include <memory>
 #include <unordered_map>
 
 #include <utility>
 #include <vector>
 #include "tensorflow/core/kernels/save_restore_tensor.h"
 
+#include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
@@ -231,6 +238,58 @@ void RestoreTensor(OpKernelContext* context,
 #undef READER_COPY
 }
 
+namespace {
+
+// Large unpartitioned tensors are restored in pieces of at most this many
+// bytes, which are read concurrently.
+const int64 kRestorePieceBytes = 32 << 20;
+
+// One unit of work of RestoreTensorsV2(): a whole tensor, a slice of a
+// partitioned tensor, or a byte range of a large tensor.
+struct RestoreTask {
+  int64 index;  // Index of the output.
+  // Set for a slice of a partitioned tensor.
+  bool is_slice = false;
+  TensorSlice slice;
+  // Set for a byte range of a large tensor.
+  bool is_piece = false;
+  int64 offset = 0;
+  int64 size = 0;
+  // Temporary memory used while the task runs.
+  int64 scratch_bytes = 0;
+};
+
+// Bounds the temporary memory held by the restore tasks that are in flight.
+// A task that needs more than the whole budget runs once nothing else does.
+class InflightBudget {
+ public:
+  explicit InflightBudget(int64 limit) : limit_(limit), available_(limit) {}
+
+  void Acquire(int64 bytes) {
+    bytes = std::min(bytes, limit_);
+    mutex_lock l(mu_);
+    while (available_ < bytes) {
+      cv_.wait(l);
+    }
+    available_ -= bytes;
+  }
+
+  void Release(int64 bytes) {
+    bytes = std::min(bytes, limit_);
+    mutex_lock l(mu_);
+    available_ += bytes;
+    cv_.notify_all();
+  }
+
+ private:
+  const int64 limit_;
+  mutex mu_;
+  condition_variable cv_;
+  int64 available_ GUARDED_BY(mu_);
+};
+
+}  // namespace
+
 Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
                         const Tensor& tensor_names,
                         const Tensor& shape_and_slices,
@@ -239,34 +298,79 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
   const auto& tensor_names_flat = tensor_names.flat<string>();
   const auto& shape_and_slices_flat = shape_and_slices.flat<string>();
 
-  BundleReader reader(Env::Default(), prefix_string);
+  // Memory-mapping the data files avoids copying the restored tensors out of
+  // the page cache, which dominates the startup time of large models.
+  BundleReader::Options options;
+  TF_RETURN_IF_ERROR(ReadBoolFromEnvVar("TF_CHECKPOINT_RESTORE_USE_MMAP",
+                                        false, &options.use_mmap));
+  int64 max_inflight_bytes;
+  TF_RETURN_IF_ERROR(ReadInt64FromEnvVar(
+      "TF_CHECKPOINT_RESTORE_MAX_INFLIGHT_BYTES", 1LL << 30,
+      &max_inflight_bytes));
+  BundleReader reader(Env::Default(), prefix_string, options);
   TF_RETURN_IF_ERROR(reader.status());
 
-  // TODO(zongheng): potential optimization: one Seek() in first lookup.
-  // TODO(zongheng): consider measuring speed and issuing concurrent lookups
-  // within a fixed memory budget.
+  // Looks up the metadata and allocates the outputs on this thread, and
+  // splits the reads into tasks.
+  std::vector<Tensor*> restored_tensors(tensor_names_flat.size());
+  // In mmap mode, unpartitioned numeric tensors are looked up into these
+  // instead of into allocated outputs, so that they alias the mapping.
+  std::vector<Tensor> mapped_tensors(tensor_names_flat.size());
+  std::vector<bool> is_mapped(tensor_names_flat.size(), false);
+  std::vector<RestoreTask> tasks;
+  DataType restored_dtype;
   TensorShape restored_full_shape;
-  Tensor* restored_tensor = nullptr;
+  std::vector<TensorSlice> stored_slices;
   for (size_t i = 0; i < tensor_names_flat.size(); ++i) {
     const string& tensor_name = tensor_names_flat(i);
     const string& shape_and_slice = shape_and_slices_flat(i);
-    TF_RETURN_IF_ERROR(
-        reader.LookupTensorShape(tensor_name, &restored_full_shape));
+    TF_RETURN_IF_ERROR(reader.LookupDtypeAndShape(
+        tensor_name, &restored_dtype, &restored_full_shape));
+    if (dtypes[i] != restored_dtype) {
+      return errors::InvalidArgument(
+          "tensor_name = ", tensor_name, "; expected dtype ",
+          DataTypeString(dtypes[i]), " does not equal restored dtype ",
+          DataTypeString(restored_dtype));
+    }
 
+    RestoreTask task;
+    task.index = i;
     if (shape_and_slice.empty()) {
       // Lookup the full tensor.
       TF_RETURN_IF_ERROR(
-          context->allocate_output(i, restored_full_shape, &restored_tensor));
-      TF_RETURN_IF_ERROR(reader.Lookup(tensor_name, restored_tensor));
+          reader.LookupTensorSlices(tensor_name, &stored_slices));
+      if (options.use_mmap && DataTypeCanUseMemcpy(restored_dtype) &&
+          stored_slices.empty()) {
+        is_mapped[i] = true;
+        restored_tensors[i] = &mapped_tensors[i];
+        tasks.push_back(task);
+        continue;
+      }
+      TF_RETURN_IF_ERROR(context->allocate_output(i, restored_full_shape,
+                                                  &restored_tensors[i]));
+      const int64 num_bytes = restored_tensors[i]->TotalBytes();
+      if (!options.use_mmap && DataTypeCanUseMemcpy(restored_dtype) &&
+          stored_slices.empty() && num_bytes > kRestorePieceBytes) {
+        task.is_piece = true;
+        for (int64 offset = 0; offset < num_bytes;
+             offset += kRestorePieceBytes) {
+          task.offset = offset;
+          task.size = std::min(kRestorePieceBytes, num_bytes - offset);
+          tasks.push_back(task);
+        }
+        continue;
+      }
+      // Partitioned tensors are assembled from temporaries.
+      if (!stored_slices.empty()) task.scratch_bytes = num_bytes;
     } else {
       // Lookup the slice.
       TensorShape parsed_full_shape;
-      TensorSlice parsed_slice;
       TensorShape parsed_slice_shape;
 
+      task.is_slice = true;
       TF_RETURN_IF_ERROR(
           checkpoint::ParseShapeAndSlice(shape_and_slice, &parsed_full_shape,
-                                         &parsed_slice, &parsed_slice_shape));
+                                         &task.slice, &parsed_slice_shape));
       if (!restored_full_shape.IsSameSize(parsed_full_shape)) {
         return errors::InvalidArgument(
             "tensor_name = ", tensor_name, "; shape in shape_and_slice spec ",
@@ -275,17 +379,98 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
             restored_full_shape.DebugString());
       }
 
-      TF_RETURN_IF_ERROR(
-          context->allocate_output(i, parsed_slice_shape, &restored_tensor));
-      TF_RETURN_IF_ERROR(
-          reader.LookupSlice(tensor_name, parsed_slice, restored_tensor));
+      TF_RETURN_IF_ERROR(context->allocate_output(i, parsed_slice_shape,
+                                                  &restored_tensors[i]));
+      task.scratch_bytes = restored_tensors[i]->TotalBytes();
     }
-    if (dtypes[i] != restored_tensor->dtype()) {
-      return errors::InvalidArgument(
-          "tensor_name = ", tensor_name, "; expected dtype ",
-          DataTypeString(dtypes[i]), " does not equal restored dtype ",
-          DataTypeString(restored_tensor->dtype()));
+    tasks.push_back(task);
+  }
+
+  // The number of pieces of each large tensor that are not yet read.  The
+  // worker that reads the last piece verifies the tensor's checksum.
+  std::vector<int64> pieces_left(restored_tensors.size(), 0);
+  for (const RestoreTask& task : tasks) {
+    if (task.is_piece) ++pieces_left[task.index];
+  }
+
+  // Runs the tasks on up to one worker per intra-op thread, each with its own
+  // reader, since a BundleReader must not be shared between threads.
+  InflightBudget budget(max_inflight_bytes);
+  mutex mu;
+  Status status;
+  int64 next_task = 0;
+  auto run_worker = [&](BundleReader* worker_reader) {
+    std::unique_ptr<BundleReader> owned_reader;
+    while (true) {
+      int64 t;
+      {
+        mutex_lock l(mu);
+        if (!status.ok() || next_task == tasks.size()) return;
+        t = next_task++;
+      }
+      const RestoreTask& task = tasks[t];
+      const string& tensor_name = tensor_names_flat(task.index);
+      Tensor* restored_tensor = restored_tensors[task.index];
+      Status s;
+      if (worker_reader == nullptr) {
+        owned_reader.reset(
+            new BundleReader(Env::Default(), prefix_string, options));
+        worker_reader = owned_reader.get();
+        s = worker_reader->status();
+      }
+      if (s.ok()) {
+        budget.Acquire(task.scratch_bytes);
+        if (task.is_piece) {
+          char* base = const_cast<char*>(restored_tensor->tensor_data().data());
+          s = worker_reader->ReadTensorBytes(tensor_name, task.offset,
+                                             task.size, base + task.offset);
+        } else if (task.is_slice) {
+          s = worker_reader->LookupSlice(tensor_name, task.slice,
+                                         restored_tensor);
+        } else {
+          s = worker_reader->Lookup(tensor_name, restored_tensor);
+        }
+        budget.Release(task.scratch_bytes);
+      }
+      if (s.ok() && task.is_piece) {
+        bool last_piece;
+        {
+          mutex_lock l(mu);
+          last_piece = --pieces_left[task.index] == 0;
+        }
+        if (last_piece) {
+          s = worker_reader->VerifyChecksum(tensor_name, *restored_tensor);
+        }
+      }
+      if (!s.ok()) {
+        mutex_lock l(mu);
+        status.Update(s);
+        return;
+      }
     }
+  };
+
+  thread::ThreadPool* pool =
+      context->device()->tensorflow_cpu_worker_threads()->workers;
+  const int64 num_workers = std::min<int64>(
+      context->device()->tensorflow_cpu_worker_threads()->num_threads,
+      tasks.size());
+  BlockingCounter counter(std::max<int64>(num_workers - 1, 0));
+  for (int64 i = 1; i < num_workers; ++i) {
+    pool->Schedule([&run_worker, &counter]() {
+      run_worker(nullptr);
+      counter.DecrementCount();
+    });
+  }
+  // This thread is a worker too, and reuses the reader opened above.
+  run_worker(&reader);
+  counter.Wait();
+  TF_RETURN_IF_ERROR(status);
+
+  // The mapped tensors do not own their read-only buffers, so they are never
+  // forwarded to a consumer that writes in place; such consumers copy them.
+  for (size_t i = 0; i < mapped_tensors.size(); ++i) {
+    if (is_mapped[i]) context->set_output(i, mapped_tensors[i]);
   }
   return Status::OK();
 }
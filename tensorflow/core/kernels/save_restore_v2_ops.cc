@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 #include "tensorflow/core/util/tensor_slice_reader.h"
@@ -105,7 +106,13 @@ class SaveV2 : public OpKernel {
     const auto& tensor_names_flat = tensor_names.flat<string>();
     const auto& shape_and_slices_flat = shape_and_slices.flat<string>();
 
-    BundleWriter writer(Env::Default(), prefix_string);
+    // Aligning the tensors lets RestoreV2 serve them straight from a
+    // memory-mapped data file (see TF_CHECKPOINT_RESTORE_USE_MMAP).
+    BundleWriter::Options options;
+    OP_REQUIRES_OK(context,
+                   ReadInt64FromEnvVar("TF_CHECKPOINT_DATA_ALIGNMENT", 1,
+                                       &options.data_alignment));
+    BundleWriter writer(Env::Default(), prefix_string, options);
     OP_REQUIRES_OK(context, writer.status());
     VLOG(1) << "BundleWriter, prefix_string: " << prefix_string;
 
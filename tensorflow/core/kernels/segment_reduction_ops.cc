@@ -18,6 +18,8 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 
 #include "tensorflow/core/kernels/segment_reduction_ops.h"
+#include <algorithm>
+#include <functional>
 #include <vector>
 #include "third_party/eigen3/Eigen/Core"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -30,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/util/util.h"
 
 namespace tensorflow {
@@ -57,6 +60,64 @@ static bool SegmentReductionDoValidation(OpKernelContext* c,
   return c->status().ok();
 }
 
+// Sets 'segments' to the first row and the id of each run of equal ids in
+// 'segment_vec', checking that the ids are increasing and smaller than
+// 'output_rows'.
+template <typename Index>
+static void FindSortedSegments(OpKernelContext* context,
+                               typename TTypes<Index>::ConstVec segment_vec,
+                               Index output_rows,
+                               std::vector<std::pair<int64, Index>>* segments) {
+  const int64 num_indices = segment_vec.size();
+  int64 start = 0;
+  Index out_index = internal::SubtleMustCopy(segment_vec(start));
+  for (int64 end = 1; end <= num_indices; ++end) {
+    // We initialize next_index to 0 to avoid "warning: 'next_index' may be
+    // used uninitialized in this function" in the Mac build (since the
+    // compiler isn't smart enough to realize the code is safe).
+    Index next_index = 0;
+    if (end < num_indices) {
+      next_index = internal::SubtleMustCopy(segment_vec(end));
+      if (out_index == next_index) {
+        continue;
+      }
+      // We have a new segment here.  Verify that the segment ids are growing.
+      OP_REQUIRES(context, out_index < next_index,
+                  errors::InvalidArgument("segment ids are not increasing"));
+    }
+    OP_REQUIRES(
+        context, FastBoundsCheck(out_index, output_rows),
+        errors::InvalidArgument(
+            "Segment id ", out_index, " out of range [0, ", output_rows,
+            "), possibly because 'segment_ids' input is not sorted."));
+    segments->emplace_back(start, out_index);
+    start = end;
+    out_index = next_index;
+  }
+}
+
+// Calls 'work' from the threads of 'd' on ranges of the columns of a matrix
+// of T with 'num_rows' rows, split in blocks of a cache line. Used by the
+// reductions into rows picked by an index, where splitting the rows between
+// threads would make them write to the same output rows.
+template <typename T>
+static void ParallelForColumnBlocks(
+    const CPUDevice& d, int64 num_rows, int64 num_cols,
+    const std::function<void(int64 col_start, int64 col_end)>& work) {
+  if (num_cols == 0) return;
+  const int64 kBlockSize = std::max<int64>(1, 64 / sizeof(T));
+  const int64 num_blocks = (num_cols + kBlockSize - 1) / kBlockSize;
+  const double block_bytes = kBlockSize * sizeof(T);
+  d.parallelFor(num_blocks,
+                Eigen::TensorOpCost(num_rows * (block_bytes + sizeof(int64)),
+                                    num_rows * block_bytes,
+                                    num_rows * kBlockSize),
+                [&work, kBlockSize, num_cols](int64 start, int64 end) {
+                  work(start * kBlockSize,
+                       std::min(end * kBlockSize, num_cols));
+                });
+}
+
 // This operator handles reducing segments along the first dimension.
 // See core/ops/math_ops.cc for more details.
 template <typename Device, class T, class Index, typename Reducer,
@@ -100,86 +161,81 @@ class SegmentReductionOp : public OpKernel {
                 errors::InvalidArgument("segment ids must be >= 0"));
     auto output_flat = output->flat_outer_dims<T>();
 
+    // Finds the segments first, so that they can then be reduced in
+    // parallel.
+    std::vector<std::pair<int64, Index>> segments;
+    FindSortedSegments<Index>(context, segment_vec, output_rows, &segments);
+    if (!context->status().ok()) return;
+    const int64 num_segments = segments.size();
+
+    auto reduce_segments = [&](int64 first_segment, int64 last_segment) {
 #if !defined(EIGEN_HAS_INDEX_LIST)
-    Eigen::DSizes<Eigen::DenseIndex, 1> dims_to_reduce;
-    dims_to_reduce[0] = 0;
+      Eigen::DSizes<Eigen::DenseIndex, 1> dims_to_reduce;
+      dims_to_reduce[0] = 0;
 #else
-    Eigen::IndexList<Eigen::type2index<0>> dims_to_reduce;
+      Eigen::IndexList<Eigen::type2index<0>> dims_to_reduce;
 #endif
-    Index start = 0, end = 1;
-
-    Index uninitialized_index = 0;  // Index from which the output is not set.
-    Index out_index = internal::SubtleMustCopy(segment_vec(start));
-
-    // TODO(agarwal): if this loop becomes a bottleneck, consider sharding it
-    // across threads.
-    Eigen::DSizes<Eigen::DenseIndex, 1> out_slice_shape(num_col);
-    while (end <= num_indices) {
-      // We initialize next_index to 0 to avoid "warning: 'next_index' may be
-      // used uninitialized in this function" in the Mac build (since the
-      // compiler isn't smart enough to realize the code is safe).
-      Index next_index = 0;
-      if (end < num_indices) {
-        next_index = internal::SubtleMustCopy(segment_vec(end));
-        if (out_index == next_index) {
-          ++end;
-          continue;
-        }
-        // We have a new segment here.  Verify that the segment ids are growing.
-        OP_REQUIRES(context, out_index < next_index,
-                    errors::InvalidArgument("segment ids are not increasing"));
-      }
-
-      // Process segment [start, end)
-      const T* in_slice_ptr = &input_flat(start, 0);
-      typedef Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor>,
-                               Eigen::Unaligned>
-          OutT;
-
-      OP_REQUIRES(
-          context, FastBoundsCheck(out_index, output_rows),
-          errors::InvalidArgument(
-              "Segment id ", out_index, " out of range [0, ", output_rows,
-              "), possibly because 'segment_ids' input is not sorted."));
-
-      // If there is a gap between two indices, we need to set that gap to the
-      // default value.
-      if (out_index > uninitialized_index) {
-        Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
-            out_index - uninitialized_index, num_col);
-        Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>, Eigen::Unaligned>
-            gap_slice(&output_flat(uninitialized_index, 0), gap_slice_shape);
-        gap_slice.setConstant(T(default_value));
-      }
-
-      T* out_slice_ptr = &output_flat(out_index, 0);
-      OutT out_slice(out_slice_ptr, out_slice_shape);
-      // We don't use out_slice.device(context->eigen_device<Device>)
-      // because these pieces of work are likely to be very small and
-      // the context switching overhead dwarfs any benefit we get from
-      // using another thread to do this work.
-      if (start == end - 1) {
-        typedef Eigen::TensorMap<Eigen::Tensor<const T, 1, Eigen::RowMajor>,
+      Eigen::DSizes<Eigen::DenseIndex, 1> out_slice_shape(num_col);
+      for (int64 s = first_segment; s < last_segment; ++s) {
+        // Process segment [start, end)
+        const int64 start = segments[s].first;
+        const int64 end =
+            s + 1 < num_segments ? segments[s + 1].first : num_indices;
+        const Index out_index = segments[s].second;
+        // Index from which the output is not set.
+        const Index uninitialized_index =
+            s > 0 ? segments[s - 1].second + 1 : 0;
+
+        const T* in_slice_ptr = &input_flat(start, 0);
+        typedef Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor>,
                                  Eigen::Unaligned>
-            InT;
-        InT in_slice(in_slice_ptr, out_slice_shape);
-        out_slice = in_slice;
-      } else {
-        Eigen::DSizes<Eigen::DenseIndex, 2> in_slice_shape(end - start,
-                                                           num_col);
-        typedef Eigen::TensorMap<Eigen::Tensor<const T, 2, Eigen::RowMajor>,
-                                 Eigen::Unaligned>
-            InT;
-        InT in_slice(in_slice_ptr, in_slice_shape);
+            OutT;
+
+        // If there is a gap between two indices, we need to set that gap to
+        // the default value.
+        if (out_index > uninitialized_index) {
+          Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
+              out_index - uninitialized_index, num_col);
+          Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>,
+                           Eigen::Unaligned>
+              gap_slice(&output_flat(uninitialized_index, 0),
+                        gap_slice_shape);
+          gap_slice.setConstant(T(default_value));
+        }
 
-        out_slice = in_slice.reduce(dims_to_reduce, Reducer());
+        T* out_slice_ptr = &output_flat(out_index, 0);
+        OutT out_slice(out_slice_ptr, out_slice_shape);
+        // We don't use out_slice.device(context->eigen_device<Device>)
+        // because these pieces of work are likely to be very small and
+        // the context switching overhead dwarfs any benefit we get from
+        // using another thread to do this work. The segments are split
+        // between threads instead.
+        if (start == end - 1) {
+          typedef Eigen::TensorMap<Eigen::Tensor<const T, 1, Eigen::RowMajor>,
+                                   Eigen::Unaligned>
+              InT;
+          InT in_slice(in_slice_ptr, out_slice_shape);
+          out_slice = in_slice;
+        } else {
+          Eigen::DSizes<Eigen::DenseIndex, 2> in_slice_shape(end - start,
+                                                             num_col);
+          typedef Eigen::TensorMap<Eigen::Tensor<const T, 2, Eigen::RowMajor>,
+                                   Eigen::Unaligned>
+              InT;
+          InT in_slice(in_slice_ptr, in_slice_shape);
+
+          out_slice = in_slice.reduce(dims_to_reduce, Reducer());
+        }
       }
-      if (end >= num_indices) break;
-      start = end;
-      ++end;
-      uninitialized_index = out_index + 1;
-      out_index = next_index;
-    }
+    };
+    const double rows_per_segment =
+        static_cast<double>(num_indices) / num_segments;
+    const double row_bytes = num_col * sizeof(T);
+    context->eigen_device<Device>().parallelFor(
+        num_segments,
+        Eigen::TensorOpCost(rows_per_segment * row_bytes, row_bytes,
+                            rows_per_segment * num_col),
+        reduce_segments);
   }
 };
 
@@ -239,20 +295,34 @@ struct UnsortedSegmentSumFunctor<CPUDevice, T, Index>
                   typename TTypes<Index>::ConstFlat segment_ids,
                   const Index data_size, const T* data,
                   typename TTypes<T, 2>::Tensor output) override {
-    output.setZero();
+    output.device(d) = output.constant(T(0));
     if (data_size == 0) {
       return;
     }
     const int64 N = segment_ids.dimension(0);
-    auto data_flat = typename TTypes<T, 2>::ConstTensor(data, N, data_size / N);
     for (int64 i = 0; i < N; ++i) {
       Index j = internal::SubtleMustCopy(segment_ids(i));
       OP_REQUIRES(ctx, FastBoundsCheck(j, output_rows),
                   errors::InvalidArgument(
                       "segment_ids", SliceDebugString(segment_ids_shape, i),
                       " = ", j, " is out of range [0, ", output_rows, ")"));
-      output.template chip<0>(j) += data_flat.template chip<0>(i);
     }
+    const int64 num_col = data_size / N;
+    ParallelForColumnBlocks<T>(d, N, num_col, [&](int64 start, int64 end) {
+      typedef Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor>,
+                               Eigen::Unaligned>
+          OutT;
+      typedef Eigen::TensorMap<Eigen::Tensor<const T, 1, Eigen::RowMajor>,
+                               Eigen::Unaligned>
+          InT;
+      for (int64 i = 0; i < N; ++i) {
+        // The ids were checked above, but may have been changed since.
+        Index j = internal::SubtleMustCopy(segment_ids(i));
+        if (!FastBoundsCheck(j, output_rows)) continue;
+        OutT out(&output(j, start), end - start);
+        out += InT(data + i * num_col + start, end - start);
+      }
+    });
   }
 };
 // UnsortedSegmentMaxFunctor implementation for CPUDevice.
@@ -264,21 +334,34 @@ struct UnsortedSegmentMaxFunctor<CPUDevice, T, Index>
                   typename TTypes<Index>::ConstFlat segment_ids,
                   const Index data_size, const T* data,
                   typename TTypes<T, 2>::Tensor output) override {
-    output.setConstant(std::numeric_limits<T>::lowest());
+    output.device(d) = output.constant(std::numeric_limits<T>::lowest());
     if (data_size == 0) {
       return;
     }
     const int64 N = segment_ids.dimension(0);
-    auto data_flat = typename TTypes<T, 2>::ConstTensor(data, N, data_size / N);
     for (int64 i = 0; i < N; ++i) {
       Index j = internal::SubtleMustCopy(segment_ids(i));
       OP_REQUIRES(ctx, FastBoundsCheck(j, output_rows),
                   errors::InvalidArgument(
                       "segment_ids", SliceDebugString(segment_ids_shape, i),
                       " = ", j, " is out of range [0, ", output_rows, ")"));
-      output.template chip<0>(j) =
-          data_flat.template chip<0>(i).cwiseMax(output.template chip<0>(j));
     }
+    const int64 num_col = data_size / N;
+    ParallelForColumnBlocks<T>(d, N, num_col, [&](int64 start, int64 end) {
+      typedef Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor>,
+                               Eigen::Unaligned>
+          OutT;
+      typedef Eigen::TensorMap<Eigen::Tensor<const T, 1, Eigen::RowMajor>,
+                               Eigen::Unaligned>
+          InT;
+      for (int64 i = 0; i < N; ++i) {
+        // The ids were checked above, but may have been changed since.
+        Index j = internal::SubtleMustCopy(segment_ids(i));
+        if (!FastBoundsCheck(j, output_rows)) continue;
+        OutT out(&output(j, start), end - start);
+        out = InT(data + i * num_col + start, end - start).cwiseMax(out);
+      }
+    });
   }
 };
 }  // namespace functor
@@ -468,58 +551,62 @@ class SparseSegmentReductionOpBase : public OpKernel {
                 errors::InvalidArgument("segment ids must be >= 0"));
     auto output_flat = output->flat_outer_dims<T>();
 
-    int64 start = 0, end = 1;
-    // Index from which the output is not initialized.
-    OutputRow uninitialized_index = 0;
-    OutputRow out_index = internal::SubtleMustCopy(segment_vec(start));
-
-    while (true) {
-      // We initialize next_index to 0 to avoid "warning: 'next_index' may be
-      // used uninitialized in this function" in the Mac build (since the
-      // compiler isn't smart enough to realize the code is safe).
-      OutputRow next_index = 0;
-      if (end < num_indices) {
-        next_index = internal::SubtleMustCopy(segment_vec(end));
-        if (out_index == next_index) {
-          ++end;
-          continue;
+    // Finds the segments first, so that they can then be reduced in
+    // parallel.
+    std::vector<std::pair<int64, OutputRow>> segments;
+    FindSortedSegments<OutputRow>(context, segment_vec, output_rows,
+                                  &segments);
+    if (!context->status().ok()) return;
+    const int64 num_segments = segments.size();
+
+    mutex mu;
+    int64 bad_index = -1;  // The first out of range index, guarded by mu.
+    auto reduce_segments = [&](int64 first_segment, int64 last_segment) {
+      for (int64 s = first_segment; s < last_segment; ++s) {
+        const int64 start = segments[s].first;
+        const int64 end =
+            s + 1 < num_segments ? segments[s + 1].first : num_indices;
+        const OutputRow out_index = segments[s].second;
+        // Index from which the output is not initialized.
+        const OutputRow uninitialized_index =
+            s > 0 ? segments[s - 1].second + 1 : 0;
+
+        // If there is a gap between two indices, we need to set that gap to
+        // the default value.
+        if (out_index > uninitialized_index) {
+          Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
+              out_index - uninitialized_index, num_col);
+          Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>,
+                           Eigen::Unaligned>
+              gap_slice(&output_flat(uninitialized_index, 0),
+                        gap_slice_shape);
+          gap_slice.setConstant(default_value_);
         }
-        // We have a new segment here.  Verify that the segment ids are growing.
-        OP_REQUIRES(context, out_index < next_index,
-                    errors::InvalidArgument("segment ids are not increasing"));
-      }
 
-      OP_REQUIRES(
-          context, FastBoundsCheck(out_index, output_rows),
-          errors::InvalidArgument(
-              "Segment id ", out_index, " out of range [0, ", output_rows,
-              "), possibly because 'segment_ids' input is not sorted."));
-
-      // If there is a gap between two indices, we need to set that gap to the
-      // default value.
-      if (out_index > uninitialized_index) {
-        Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
-            out_index - uninitialized_index, num_col);
-        Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>, Eigen::Unaligned>
-            gap_slice(&output_flat(uninitialized_index, 0), gap_slice_shape);
-        gap_slice.setConstant(default_value_);
+        auto out = output_flat.template chip<0>(out_index);
+        const int64 bad_offset =
+            Reduce(input_flat, indices_vec, start, end - start, out);
+        if (bad_offset >= 0) {
+          mutex_lock l(mu);
+          if (bad_index < 0 || start + bad_offset < bad_index) {
+            bad_index = start + bad_offset;
+          }
+        }
       }
-
-      auto out = output_flat.template chip<0>(out_index);
-      const int bad_offset =
-          Reduce(input_flat, indices_vec, start, end - start, out);
-      OP_REQUIRES(context, bad_offset < 0,
-                  errors::InvalidArgument(
-                      "Bad: indices[", start + bad_offset, "] == ",
-                      indices_vec(start + bad_offset), " out of range [0, ",
-                      input_flat.dimension(0), ")"));
-
-      if (end >= num_indices) break;
-      start = end;
-      ++end;
-      uninitialized_index = out_index + 1;
-      out_index = next_index;
-    }
+    };
+    const double rows_per_segment =
+        static_cast<double>(num_indices) / num_segments;
+    const double row_bytes = num_col * sizeof(T);
+    context->eigen_device<Device>().parallelFor(
+        num_segments,
+        Eigen::TensorOpCost(rows_per_segment * (row_bytes + sizeof(Index)),
+                            row_bytes, rows_per_segment * num_col),
+        reduce_segments);
+    OP_REQUIRES(context, bad_index < 0,
+                errors::InvalidArgument(
+                    "Bad: indices[", bad_index, "] == ",
+                    indices_vec(bad_index), " out of range [0, ",
+                    input_flat.dimension(0), ")"));
   }
 
  private:
@@ -780,42 +867,45 @@ class SparseSegmentGradOpBase : public OpKernel {
       }
     }
 
-    auto output_flat = output->flat_outer_dims<T>();
-    output_flat.setZero();
-    std::vector<bool> is_modified(M, false);
-
     for (int64 i = 0; i < N; ++i) {
       const Index output_idx = internal::SubtleMustCopy(indices_vec(i));
       OP_REQUIRES(context, FastBoundsCheck(output_idx, M),
                   errors::InvalidArgument("Index ", output_idx,
                                           " out of range [0, ", M, ")."));
+    }
 
-      const SegmentId idx = internal::SubtleMustCopy(segment_vec(i));
-      OP_REQUIRES(
-          context, FastBoundsCheck(idx, num_segments),
-          errors::InvalidArgument("Segment id ", idx, " out of range [0, ",
-                                  num_segments, ")."));
+    const CPUDevice& d = context->eigen_device<CPUDevice>();
+    auto output_flat = output->flat_outer_dims<T>();
+    output_flat.device(d) = output_flat.constant(T(0));
 
-      const T scale = static_cast<T>(scaling[idx]);
-      if (is_modified[output_idx]) {
-        if (scale == 1.0) {
-          output_flat.template chip<0>(output_idx) +=
-              input_flat.template chip<0>(idx);
-        } else {
-          output_flat.template chip<0>(output_idx) +=
-              input_flat.template chip<0>(idx) * scale;
+    // The indices may repeat, so the threads split the columns rather than
+    // the indices.
+    const int64 num_col = output_flat.dimension(1);
+    ParallelForColumnBlocks<T>(d, N, num_col, [&](int64 start, int64 end) {
+      typedef Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor>,
+                               Eigen::Unaligned>
+          OutT;
+      typedef Eigen::TensorMap<Eigen::Tensor<const T, 1, Eigen::RowMajor>,
+                               Eigen::Unaligned>
+          InT;
+      for (int64 i = 0; i < N; ++i) {
+        // The indices were checked above, but may have been changed since.
+        const Index output_idx = internal::SubtleMustCopy(indices_vec(i));
+        const SegmentId idx = internal::SubtleMustCopy(segment_vec(i));
+        if (!FastBoundsCheck(output_idx, M) ||
+            !FastBoundsCheck(idx, num_segments)) {
+          continue;
         }
-      } else {
+        OutT out(&output_flat(output_idx, start), end - start);
+        InT in(&input_flat(idx, start), end - start);
+        const T scale = static_cast<T>(scaling[idx]);
         if (scale == 1.0) {
-          output_flat.template chip<0>(output_idx) =
-              input_flat.template chip<0>(idx);
+          out += in;
         } else {
-          output_flat.template chip<0>(output_idx) =
-              input_flat.template chip<0>(idx) * scale;
+          out += in * scale;
         }
       }
-      is_modified[output_idx] = true;
-    }
+    });
   }
 
  private:
@@ -855,4 +945,294 @@ REGISTER_CPU_SPARSE_KERNELS(double);
 REGISTER_CPU_SPARSE_KERNELS(float);
 REGISTER_CPU_SPARSE_KERNELS(double);
 #undef REGISTER_CPU_SPARSE_KERNELS
+
+// Static routine not in the templated classes to reduce code size.
+static void FusedEmbeddingLookupSparseValidationHelper(
+    OpKernelContext* context, const Tensor& ids, const Tensor& segment_ids,
+    const Tensor& weights) {
+  OP_REQUIRES(context, TensorShapeUtils::IsVector(ids.shape()),
+              errors::InvalidArgument("ids should be a vector."));
+  OP_REQUIRES(context, TensorShapeUtils::IsVector(segment_ids.shape()),
+              errors::InvalidArgument("segment_ids should be a vector."));
+  OP_REQUIRES(context, TensorShapeUtils::IsVector(weights.shape()),
+              errors::InvalidArgument("weights should be a vector."));
+  OP_REQUIRES(
+      context, ids.NumElements() == segment_ids.NumElements(),
+      errors::InvalidArgument("segment_ids and ids should have same size."));
+  OP_REQUIRES(context,
+              weights.NumElements() == 0 ||
+                  weights.NumElements() == ids.NumElements(),
+              errors::InvalidArgument(
+                  "weights should be empty or have the same size as ids."));
+}
+
+// Combines the rows of params picked by the ids along sorted segments, as
+// done by a Gather followed by a SparseSegmentSum, SparseSegmentMean or
+// SparseSegmentSqrtN, without materializing the gathered rows.
+template <class T, class Index>
+class FusedEmbeddingLookupSparseOp : public OpKernel {
+ public:
+  explicit FusedEmbeddingLookupSparseOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    string combiner;
+    OP_REQUIRES_OK(context, context->GetAttr("combiner", &combiner));
+    is_mean_ = combiner == "mean";
+    is_sqrtn_ = combiner == "sqrtn";
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& params = context->input(0);
+    const Tensor& ids = context->input(1);
+    const Tensor& segment_ids = context->input(2);
+    const Tensor& weights = context->input(3);
+
+    OP_REQUIRES(
+        context, TensorShapeUtils::IsVectorOrHigher(params.shape()),
+        errors::InvalidArgument("params must be at least 1 dimensional"));
+    FusedEmbeddingLookupSparseValidationHelper(context, ids, segment_ids,
+                                               weights);
+    if (!context->status().ok()) return;
+
+    const int64 num_ids = ids.NumElements();
+    const bool has_weights = weights.NumElements() > 0;
+    auto params_flat = params.flat_outer_dims<T>();
+    const int64 num_params = params_flat.dimension(0);
+    const int64 num_col = params_flat.dimension(1);
+    const auto ids_vec = ids.vec<Index>();
+    typedef int32 OutputRow;
+    const auto segment_vec = segment_ids.vec<OutputRow>();
+    const auto weights_vec = weights.vec<T>();
+    // Note that the current implementation assumes that segment_vec values are
+    // sorted.
+    const OutputRow output_rows =
+        num_ids > 0 ? internal::SubtleMustCopy(segment_vec(num_ids - 1)) + 1
+                    : 0;
+    OP_REQUIRES(context, output_rows >= 0,
+                errors::InvalidArgument("segment ids must be >= 0"));
+
+    TensorShape output_shape = params.shape();
+    output_shape.set_dim(0, output_rows);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(0, output_shape, &output));
+    if (num_ids == 0) return;
+    OP_REQUIRES(context, output_rows > 0,
+                errors::InvalidArgument("segment ids must be >= 0"));
+    auto output_flat = output->flat_outer_dims<T>();
+
+    std::vector<std::pair<int64, OutputRow>> segments;
+    FindSortedSegments<OutputRow>(context, segment_vec, output_rows,
+                                  &segments);
+    if (!context->status().ok()) return;
+    const int64 num_segments = segments.size();
+
+    mutex mu;
+    int64 bad_i = -1;  // The first out of range id, guarded by mu.
+    auto combine_segments = [&](int64 first_segment, int64 last_segment) {
+      typedef Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor>,
+                               Eigen::Unaligned>
+          OutT;
+      typedef Eigen::TensorMap<Eigen::Tensor<const T, 1, Eigen::RowMajor>,
+                               Eigen::Unaligned>
+          InT;
+      for (int64 s = first_segment; s < last_segment; ++s) {
+        const int64 start = segments[s].first;
+        const int64 end =
+            s + 1 < num_segments ? segments[s + 1].first : num_ids;
+        const OutputRow out_index = segments[s].second;
+        const OutputRow uninitialized_index =
+            s > 0 ? segments[s - 1].second + 1 : 0;
+        if (out_index > uninitialized_index) {
+          OutT gap(&output_flat(uninitialized_index, 0),
+                   (out_index - uninitialized_index) * num_col);
+          gap.setZero();
+        }
+
+        OutT out(&output_flat(out_index, 0), num_col);
+        out.setZero();
+        T weight_sum(0);
+        for (int64 i = start; i < end; ++i) {
+          const Index id = internal::SubtleMustCopy(ids_vec(i));
+          if (!FastBoundsCheck(id, num_params)) {
+            mutex_lock l(mu);
+            if (bad_i < 0 || i < bad_i) bad_i = i;
+            break;
+          }
+          InT row(&params_flat(id, 0), num_col);
+          if (has_weights) {
+            const T weight = weights_vec(i);
+            out += row * weight;
+            weight_sum += is_sqrtn_ ? weight * weight : weight;
+          } else {
+            out += row;
+            weight_sum += T(1);
+          }
+        }
+        if (is_mean_) {
+          out = out / weight_sum;
+        } else if (is_sqrtn_) {
+          out = out / static_cast<T>(sqrt(weight_sum));
+        }
+      }
+    };
+    const double ids_per_segment = static_cast<double>(num_ids) / num_segments;
+    const double row_bytes = num_col * sizeof(T);
+    context->eigen_device<CPUDevice>().parallelFor(
+        num_segments,
+        Eigen::TensorOpCost(ids_per_segment * (row_bytes + sizeof(Index)),
+                            row_bytes, ids_per_segment * num_col * 2),
+        combine_segments);
+    OP_REQUIRES(context, bad_i < 0,
+                errors::InvalidArgument("ids[", bad_i, "] = ", ids_vec(bad_i),
+                                        " is not in [0, ", num_params, ")"));
+  }
+
+ private:
+  bool is_mean_;
+  bool is_sqrtn_;
+};
+
+// Computes the gradient of FusedEmbeddingLookupSparse with respect to the
+// rows of params that were looked up. The ids are sorted, and the gradient
+// of each distinct id is accumulated by one thread.
+template <class T, class Index>
+class FusedEmbeddingLookupSparseGradOp : public OpKernel {
+ public:
+  explicit FusedEmbeddingLookupSparseGradOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    string combiner;
+    OP_REQUIRES_OK(context, context->GetAttr("combiner", &combiner));
+    is_mean_ = combiner == "mean";
+    is_sqrtn_ = combiner == "sqrtn";
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& grad = context->input(0);
+    const Tensor& ids = context->input(1);
+    const Tensor& segment_ids = context->input(2);
+    const Tensor& weights = context->input(3);
+
+    OP_REQUIRES(context, TensorShapeUtils::IsVectorOrHigher(grad.shape()),
+                errors::InvalidArgument("grad must be at least 1 dimensional"));
+    FusedEmbeddingLookupSparseValidationHelper(context, ids, segment_ids,
+                                               weights);
+    if (!context->status().ok()) return;
+
+    const int64 num_ids = ids.NumElements();
+    const bool has_weights = weights.NumElements() > 0;
+    auto grad_flat = grad.flat_outer_dims<T>();
+    typedef int32 SegmentId;
+    const SegmentId num_segments = grad_flat.dimension(0);
+    const int64 num_col = grad_flat.dimension(1);
+    const auto ids_vec = ids.vec<Index>();
+    const auto segment_vec = segment_ids.vec<SegmentId>();
+    const auto weights_vec = weights.vec<T>();
+
+    // Compute the scaling factor of each segment.
+    std::vector<T> scaling(num_segments, T(0));
+    for (int64 i = 0; i < num_ids; ++i) {
+      const SegmentId idx = internal::SubtleMustCopy(segment_vec(i));
+      OP_REQUIRES(
+          context, FastBoundsCheck(idx, num_segments),
+          errors::InvalidArgument("Segment id ", idx, " out of range [0, ",
+                                  num_segments, ")."));
+      const T weight = has_weights ? weights_vec(i) : T(1);
+      scaling[idx] += is_sqrtn_ ? weight * weight : weight;
+    }
+    for (SegmentId idx = 0; idx < num_segments; ++idx) {
+      if (is_mean_) {
+        scaling[idx] = T(1) / scaling[idx];
+      } else if (is_sqrtn_) {
+        scaling[idx] = T(1) / static_cast<T>(sqrt(scaling[idx]));
+      } else {
+        scaling[idx] = T(1);
+      }
+    }
+
+    // Groups the positions of each id, in order.
+    std::vector<std::pair<Index, int64>> sorted_ids(num_ids);
+    for (int64 i = 0; i < num_ids; ++i) {
+      sorted_ids[i] = {internal::SubtleMustCopy(ids_vec(i)), i};
+    }
+    std::sort(sorted_ids.begin(), sorted_ids.end());
+    std::vector<int64> id_starts;
+    for (int64 k = 0; k < num_ids; ++k) {
+      if (k == 0 || sorted_ids[k].first != sorted_ids[k - 1].first) {
+        id_starts.push_back(k);
+      }
+    }
+    const int64 num_unique = id_starts.size();
+
+    Tensor* unique_ids = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, TensorShape({num_unique}), &unique_ids));
+    auto unique_ids_vec = unique_ids->vec<Index>();
+    for (int64 u = 0; u < num_unique; ++u) {
+      unique_ids_vec(u) = sorted_ids[id_starts[u]].first;
+    }
+    TensorShape values_shape = grad.shape();
+    values_shape.set_dim(0, num_unique);
+    Tensor* values = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(1, values_shape, &values));
+    if (num_unique == 0) return;
+    auto values_flat = values->flat_outer_dims<T>();
+
+    auto accumulate_ids = [&](int64 first_id, int64 last_id) {
+      typedef Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor>,
+                               Eigen::Unaligned>
+          OutT;
+      typedef Eigen::TensorMap<Eigen::Tensor<const T, 1, Eigen::RowMajor>,
+                               Eigen::Unaligned>
+          InT;
+      for (int64 u = first_id; u < last_id; ++u) {
+        const int64 end = u + 1 < num_unique ? id_starts[u + 1] : num_ids;
+        OutT out(&values_flat(u, 0), num_col);
+        out.setZero();
+        for (int64 k = id_starts[u]; k < end; ++k) {
+          const int64 i = sorted_ids[k].second;
+          // The segment ids were checked above, but may have been changed
+          // since.
+          const SegmentId idx = internal::SubtleMustCopy(segment_vec(i));
+          if (!FastBoundsCheck(idx, num_segments)) continue;
+          const T weight = has_weights ? weights_vec(i) : T(1);
+          out += InT(&grad_flat(idx, 0), num_col) * (weight * scaling[idx]);
+        }
+      }
+    };
+    const double ids_per_row = static_cast<double>(num_ids) / num_unique;
+    const double row_bytes = num_col * sizeof(T);
+    context->eigen_device<CPUDevice>().parallelFor(
+        num_unique,
+        Eigen::TensorOpCost(ids_per_row * (row_bytes + sizeof(int64)),
+                            row_bytes, ids_per_row * num_col * 2),
+        accumulate_ids);
+  }
+
+ private:
+  bool is_mean_;
+  bool is_sqrtn_;
+};
+
+#define REGISTER_CPU_FUSED_EMBEDDING_KERNELS(type, index_type) \
+  REGISTER_KERNEL_BUILDER(                                     \
+      Name("FusedEmbeddingLookupSparse")                       \
+          .Device(DEVICE_CPU)                                  \
+          .TypeConstraint<type>("T")                           \
+          .TypeConstraint<index_type>("Tidx"),                 \
+      FusedEmbeddingLookupSparseOp<type, index_type>);         \
+  REGISTER_KERNEL_BUILDER(                                     \
+      Name("FusedEmbeddingLookupSparseGrad")                   \
+          .Device(DEVICE_CPU)                                  \
+          .TypeConstraint<type>("T")                           \
+          .TypeConstraint<index_type>("Tidx"),                 \
+      FusedEmbeddingLookupSparseGradOp<type, index_type>);
+
+#define REGISTER_CPU_FUSED_EMBEDDING_KERNELS_ALL(type) \
+  REGISTER_CPU_FUSED_EMBEDDING_KERNELS(type, int32);   \
+  REGISTER_CPU_FUSED_EMBEDDING_KERNELS(type, int64)
+
+REGISTER_CPU_FUSED_EMBEDDING_KERNELS_ALL(float);
+REGISTER_CPU_FUSED_EMBEDDING_KERNELS_ALL(double);
+#undef REGISTER_CPU_FUSED_EMBEDDING_KERNELS
+#undef REGISTER_CPU_FUSED_EMBEDDING_KERNELS_ALL
 }  // namespace tensorflow
@@ -113,7 +113,104 @@ BM_Reduce_Arg(64, 32, 2);
 BM_Reduce_Arg(4096, 32, 2);
 BM_Reduce_Arg(4096, 128, 2);
 
-static void SparseSegmentMeanGradHelper(int iters, float uniqueness, int size) {
+BM_Reduce_Arg(65536, 128, 16);
+BM_Reduce_Arg(16384, 1024, 4);
+
+static void UnsortedSegmentSumHelper(int iters, int num_rows, int num_cols) {
+  testing::StopTiming();
+  Graph* g = new Graph(OpRegistry::Global());
+
+  const int kNumSegments = num_rows / 16;
+  Tensor data(DT_FLOAT, TensorShape({num_rows, num_cols}));
+  data.flat<float>().setRandom();
+  Tensor segment_ids(DT_INT32, TensorShape({num_rows}));
+  auto segment_ids_flat = segment_ids.flat<int32>();
+  for (int i = 0; i < num_rows; ++i) {
+    segment_ids_flat(i) = (i * 31) % kNumSegments;
+  }
+  Tensor num_segments(DT_INT32, TensorShape({}));
+  num_segments.scalar<int32>()() = kNumSegments;
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "UnsortedSegmentSum")
+                  .Input(test::graph::Constant(g, data))
+                  .Input(test::graph::Constant(g, segment_ids))
+                  .Input(test::graph::Constant(g, num_segments))
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(g, &node));
+
+  testing::UseRealTime();
+  testing::BytesProcessed(static_cast<int64>(iters) * num_rows * num_cols *
+                          sizeof(float));
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+
+static void BM_UnsortedSegmentSum(int iters, int num_rows, int num_cols) {
+  UnsortedSegmentSumHelper(iters, num_rows, num_cols);
+}
+
+BENCHMARK(BM_UnsortedSegmentSum)
+    ->ArgPair(4096, 32)
+    ->ArgPair(4096, 1024)
+    ->ArgPair(65536, 128)
+    ->ArgPair(65536, 512);
+
+// Reduces 'num_indices' random rows of a table of 'num_cols' columns, in
+// segments of 16 rows.
+static void SparseSegmentReductionHelper(int iters, const string& op,
+                                         int num_indices, int num_cols) {
+  testing::StopTiming();
+  Graph* g = new Graph(OpRegistry::Global());
+
+  const int kNumRows = 65536;
+  Tensor input(DT_FLOAT, TensorShape({kNumRows, num_cols}));
+  input.flat<float>().setRandom();
+  Tensor indices(DT_INT32, TensorShape({num_indices}));
+  auto indices_flat = indices.flat<int32>();
+  Tensor segments(DT_INT32, TensorShape({num_indices}));
+  auto segments_flat = segments.flat<int32>();
+  for (int i = 0; i < num_indices; ++i) {
+    indices_flat(i) = (i * 7919) % kNumRows;
+    segments_flat(i) = i / 16;
+  }
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), op)
+                  .Input(test::graph::Constant(g, input))
+                  .Input(test::graph::Constant(g, indices))
+                  .Input(test::graph::Constant(g, segments))
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(g, &node));
+
+  testing::UseRealTime();
+  testing::BytesProcessed(static_cast<int64>(iters) * num_indices * num_cols *
+                          sizeof(float));
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+
+static void BM_SparseSegmentMean(int iters, int num_indices, int num_cols) {
+  SparseSegmentReductionHelper(iters, "SparseSegmentMean", num_indices,
+                               num_cols);
+}
+
+static void BM_SparseSegmentSqrtN(int iters, int num_indices, int num_cols) {
+  SparseSegmentReductionHelper(iters, "SparseSegmentSqrtN", num_indices,
+                               num_cols);
+}
+
+BENCHMARK(BM_SparseSegmentMean)
+    ->ArgPair(1024, 64)
+    ->ArgPair(65536, 64)
+    ->ArgPair(65536, 256);
+BENCHMARK(BM_SparseSegmentSqrtN)
+    ->ArgPair(1024, 64)
+    ->ArgPair(65536, 64)
+    ->ArgPair(65536, 256);
+
+static void SparseSegmentGradHelper(int iters, const string& op,
+                                    float uniqueness, int size) {
   testing::StopTiming();
   Graph* g = new Graph(OpRegistry::Global());
   CHECK_LE(uniqueness, 1.0);
@@ -140,7 +237,7 @@ static void SparseSegmentMeanGradHelper(int iters, float uniqueness, int size) {
   input.flat<float>().setRandom();
 
   Node* node;
-  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "SparseSegmentMeanGrad")
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), op)
                   .Input(test::graph::Constant(g, input))
                   .Input(test::graph::Constant(g, indices))
                   .Input(test::graph::Constant(g, segments))
@@ -156,14 +253,85 @@ static void SparseSegmentMeanGradHelper(int iters, float uniqueness, int size) {
 }
 
 static void BM_SparseSegmentMeanGrad_Low(int iters, int size) {
-  return SparseSegmentMeanGradHelper(iters, 1.0, size);
+  return SparseSegmentGradHelper(iters, "SparseSegmentMeanGrad", 1.0, size);
 }
 
 static void BM_SparseSegmentMeanGrad_High(int iters, int size) {
-  return SparseSegmentMeanGradHelper(iters, 0.01, size);
+  return SparseSegmentGradHelper(iters, "SparseSegmentMeanGrad", 0.01, size);
+}
+
+static void BM_SparseSegmentSqrtNGrad_Low(int iters, int size) {
+  return SparseSegmentGradHelper(iters, "SparseSegmentSqrtNGrad", 1.0, size);
+}
+
+static void BM_SparseSegmentSqrtNGrad_High(int iters, int size) {
+  return SparseSegmentGradHelper(iters, "SparseSegmentSqrtNGrad", 0.01, size);
 }
 
 BENCHMARK(BM_SparseSegmentMeanGrad_Low)->Arg(1000)->Arg(100000);
 BENCHMARK(BM_SparseSegmentMeanGrad_High)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_SparseSegmentSqrtNGrad_Low)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_SparseSegmentSqrtNGrad_High)->Arg(1000)->Arg(100000);
+
+// Looks up and combines 'num_ids' random rows of a table of 'num_cols'
+// columns, in segments of 16 ids, or computes the gradient of that lookup.
+static void FusedEmbeddingLookupSparseHelper(int iters, bool grad,
+                                             int num_ids, int num_cols) {
+  testing::StopTiming();
+  Graph* g = new Graph(OpRegistry::Global());
+
+  const int kNumRows = 65536;
+  const int num_segments = (num_ids + 15) / 16;
+  Tensor input(DT_FLOAT, TensorShape({grad ? num_segments : kNumRows,
+                                      num_cols}));
+  input.flat<float>().setRandom();
+  Tensor ids(DT_INT64, TensorShape({num_ids}));
+  auto ids_flat = ids.flat<int64>();
+  Tensor segments(DT_INT32, TensorShape({num_ids}));
+  auto segments_flat = segments.flat<int32>();
+  Tensor weights(DT_FLOAT, TensorShape({num_ids}));
+  weights.flat<float>().setRandom();
+  for (int i = 0; i < num_ids; ++i) {
+    ids_flat(i) = (i * 7919) % kNumRows;
+    segments_flat(i) = i / 16;
+  }
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"),
+                          grad ? "FusedEmbeddingLookupSparseGrad"
+                               : "FusedEmbeddingLookupSparse")
+                  .Input(test::graph::Constant(g, input))
+                  .Input(test::graph::Constant(g, ids))
+                  .Input(test::graph::Constant(g, segments))
+                  .Input(test::graph::Constant(g, weights))
+                  .Attr("T", DT_FLOAT)
+                  .Attr("combiner", "mean")
+                  .Finalize(g, &node));
+
+  testing::UseRealTime();
+  testing::BytesProcessed(static_cast<int64>(iters) * num_ids * num_cols *
+                          sizeof(float));
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+
+static void BM_FusedEmbeddingLookupSparse(int iters, int num_ids,
+                                          int num_cols) {
+  FusedEmbeddingLookupSparseHelper(iters, false, num_ids, num_cols);
+}
+
+static void BM_FusedEmbeddingLookupSparseGrad(int iters, int num_ids,
+                                              int num_cols) {
+  FusedEmbeddingLookupSparseHelper(iters, true, num_ids, num_cols);
+}
+
+BENCHMARK(BM_FusedEmbeddingLookupSparse)
+    ->ArgPair(1024, 64)
+    ->ArgPair(65536, 64)
+    ->ArgPair(65536, 256);
+BENCHMARK(BM_FusedEmbeddingLookupSparseGrad)
+    ->ArgPair(1024, 64)
+    ->ArgPair(65536, 64)
+    ->ArgPair(65536, 256);
 
 }  // namespace tensorflow
@@ -87,14 +87,14 @@ class ShuffleDatasetOp : public UnaryDatasetOpKernel {
             input_impl_(dataset->input_->MakeIterator()),
             generator_(&parent_generator_) {
         buffer_.reserve(dataset->buffer_size_);
-        int64 seed = dataset->seed_;
-        int64 seed2 = dataset->seed2_;
-        if (seed == 0 && seed2 == 0) {
+        seed_ = dataset->seed_;
+        seed2_ = dataset->seed2_;
+        if (seed_ == 0 && seed2_ == 0) {
           // If both seeds are unspecified, use completely random seeds.
-          seed = random::New64();
-          seed2 = random::New64();
+          seed_ = random::New64();
+          seed2_ = random::New64();
         }
-        parent_generator_ = random::PhiloxRandom(seed, seed2);
+        parent_generator_ = random::PhiloxRandom(seed_, seed2_);
       }
 
       Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
@@ -115,6 +115,7 @@ class ShuffleDatasetOp : public UnaryDatasetOpKernel {
           // Choose an element to produce uniformly at random, and
           // swap the last element into its place in the buffer.
           int64 index = generator_() % buffer_.size();
+          ++num_random_samples_;
           *out_tensors = std::move(buffer_[index]);
           std::swap(buffer_[index], buffer_.back());
           buffer_.pop_back();
@@ -125,6 +126,69 @@ class ShuffleDatasetOp : public UnaryDatasetOpKernel {
         return Status::OK();
       }
 
+      // The saved state comprises the seeds and the number of samples
+      // drawn from the generator, the buffered elements, and (if the
+      // input has not been exhausted) the position of the input.
+      Status Save(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(writer->WriteScalar("seed", seed_));
+        TF_RETURN_IF_ERROR(writer->WriteScalar("seed2", seed2_));
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar("num_random_samples", num_random_samples_));
+        TF_RETURN_IF_ERROR(writer->WriteScalar("buffer_size", buffer_.size()));
+        for (size_t i = 0; i < buffer_.size(); ++i) {
+          TF_RETURN_IF_ERROR(writer->WriteScalar(
+              strings::StrCat("buffer[", i, "].size"), buffer_[i].size()));
+          for (size_t j = 0; j < buffer_[i].size(); ++j) {
+            TF_RETURN_IF_ERROR(writer->WriteTensor(
+                strings::StrCat("buffer[", i, "][", j, "]"), buffer_[i][j]));
+          }
+        }
+        if (end_of_input_sequence_) {
+          return writer->WriteScalar("end_of_input_sequence", "");
+        }
+        return SaveInput(writer, "input", input_impl_.get());
+      }
+
+      Status Restore(IteratorContext* ctx,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(reader->ReadScalar("seed", &seed_));
+        TF_RETURN_IF_ERROR(reader->ReadScalar("seed2", &seed2_));
+        TF_RETURN_IF_ERROR(
+            reader->ReadScalar("num_random_samples", &num_random_samples_));
+        // Fast-forward the generator to the saved position.
+        const int64 kSamplesPerBlock =
+            random::PhiloxRandom::kResultElementCount;
+        parent_generator_ = random::PhiloxRandom(seed_, seed2_);
+        parent_generator_.Skip(num_random_samples_ / kSamplesPerBlock);
+        generator_ = random::SingleSampleAdapter<random::PhiloxRandom>(
+            &parent_generator_);
+        for (int64 i = 0; i < num_random_samples_ % kSamplesPerBlock; ++i) {
+          generator_();
+        }
+
+        int64 buffer_size;
+        TF_RETURN_IF_ERROR(reader->ReadScalar("buffer_size", &buffer_size));
+        buffer_.clear();
+        buffer_.resize(buffer_size);
+        for (int64 i = 0; i < buffer_size; ++i) {
+          int64 num_components;
+          TF_RETURN_IF_ERROR(reader->ReadScalar(
+              strings::StrCat("buffer[", i, "].size"), &num_components));
+          buffer_[i].resize(num_components);
+          for (int64 j = 0; j < num_components; ++j) {
+            TF_RETURN_IF_ERROR(reader->ReadTensor(
+                strings::StrCat("buffer[", i, "][", j, "]"), &buffer_[i][j]));
+          }
+        }
+        end_of_input_sequence_ = reader->Contains("end_of_input_sequence");
+        if (end_of_input_sequence_) {
+          return Status::OK();
+        }
+        return RestoreInput(ctx, reader, "input", input_impl_.get());
+      }
+
      private:
       mutex mu_;
       std::vector<std::vector<Tensor>> buffer_ GUARDED_BY(mu_);
@@ -133,6 +197,9 @@ class ShuffleDatasetOp : public UnaryDatasetOpKernel {
       random::PhiloxRandom parent_generator_ GUARDED_BY(mu_);
       random::SingleSampleAdapter<random::PhiloxRandom> generator_
           GUARDED_BY(mu_);
+      int64 seed_ GUARDED_BY(mu_);
+      int64 seed2_ GUARDED_BY(mu_);
+      int64 num_random_samples_ GUARDED_BY(mu_) = 0;
     };
 
     const DatasetBase* const input_;
@@ -160,6 +160,24 @@ class TensorSliceDatasetOp : public DatasetOpKernel {
         return Status::OK();
       }
 
+      Status Save(IteratorStateWriter* writer) override {
+        mutex_lock l(mu_);
+        return writer->WriteScalar("i", i_);
+      }
+
+      Status Restore(IteratorContext* ctx,
+                     IteratorStateReader* reader) override {
+        mutex_lock l(mu_);
+        int64 i;
+        TF_RETURN_IF_ERROR(reader->ReadScalar("i", &i));
+        if (i < 0 || i > n_) {
+          return errors::InvalidArgument("Restored position ", i,
+                                         " is out of range [0, ", n_, "].");
+        }
+        i_ = i;
+        return Status::OK();
+      }
+
      private:
       mutex mu_;
       int i_ GUARDED_BY(mu_);
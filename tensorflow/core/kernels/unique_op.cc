@@ -13,19 +13,74 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
-#include <unordered_map>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/gtl/flatmap.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
+namespace {
+
+// Inputs with at least this many elements are deduplicated by sorting when
+// their type allows it. Below that, the hash table usually fits in the cache.
+const int64 kMinRadixSortSize = 1 << 20;
+
+// Number of elements below which a block of the radix sort isn't worth
+// handing to another thread.
+const int64 kMinRadixSortBlockSize = 1 << 16;
+
+// Strings are looked up by reference into the input tensor.
+template <typename T>
+struct UniqueKey {
+  typedef T type;
+  static T ToValue(const T& key) { return key; }
+};
+
+template <>
+struct UniqueKey<string> {
+  typedef StringPiece type;
+  static string ToValue(StringPiece key) { return key.ToString(); }
+};
+
+// The hashes of std::hash are the values themselves for integers, which
+// FlatMap doesn't mix: consecutive ids would all probe the same buckets.
+template <typename Key>
+struct UniqueHash {
+  size_t operator()(const Key& key) const {
+    uint64 h = hash<Key>()(key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+};
+
+template <>
+struct UniqueHash<StringPiece> : hash<StringPiece> {};
+
+// Types whose values are equal exactly when their bits are, and that can be
+// deduplicated with a radix sort on those bits.
+template <typename T>
+struct UseRadixSort
+    : std::integral_constant<bool, std::is_integral<T>::value &&
+                                       sizeof(T) >= sizeof(int32)> {};
+
+}  // namespace
+
 template <typename T>
 class UniqueOp : public OpKernel {
  public:
@@ -45,39 +100,216 @@ class UniqueOp : public OpKernel {
     auto Tin = input.vec<T>();
     const int64 N = static_cast<int64>(Tin.size());
 
+    // The input and idx may share the same buffer, so each element of the
+    // input must be read before the same element of idx is written.
     Tensor* idx = nullptr;
     OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
                                 {0}, 1, input.shape(), &idx));
     auto idx_vec = idx->template vec<int32>();
 
-    std::unordered_map<T, int32> uniq;
-    uniq.reserve(2 * N);
-    for (int64 i = 0, j = 0; i < N; ++i) {
-      auto it = uniq.insert(std::make_pair(Tin(i), j));
-      idx_vec(i) = it.first->second;
-      if (it.second) {
-        ++j;
+    if (UseRadixSort<T>::value && N >= kMinRadixSortSize) {
+      ComputeWithRadixSort(context, Tin, idx_vec, UseRadixSort<T>());
+    } else {
+      ComputeWithHashTable(context, Tin, idx_vec);
+    }
+  }
+
+ private:
+  // Allocates the unique values, and their counts for UniqueWithCounts.
+  Status AllocateOutputs(OpKernelContext* context, int64 uniq_size,
+                         Tensor** output, Tensor** count_output) {
+    TF_RETURN_IF_ERROR(
+        context->allocate_output(0, TensorShape({uniq_size}), output));
+    if (num_outputs() > 2) {
+      TF_RETURN_IF_ERROR(
+          context->allocate_output(2, TensorShape({uniq_size}), count_output));
+    }
+    return Status::OK();
+  }
+
+  // Assigns ids in order of first occurrence with an open-addressing table.
+  void ComputeWithHashTable(OpKernelContext* context,
+                            typename TTypes<T>::ConstVec Tin,
+                            typename TTypes<int32>::Vec idx_vec) {
+    typedef typename UniqueKey<T>::type Key;
+    const int64 N = static_cast<int64>(Tin.size());
+    const bool with_counts = num_outputs() > 2;
+
+    // The table grows with the number of unique values rather than being
+    // sized for N, so that it stays small when there are many repeats.
+    gtl::FlatMap<Key, int32, UniqueHash<Key>> uniq;
+    std::vector<int32> counts;
+    for (int64 i = 0; i < N; ++i) {
+      auto it = uniq.insert(
+          std::make_pair(Key(Tin(i)), static_cast<int32>(uniq.size())));
+      const int32 id = it.first->second;
+      idx_vec(i) = id;
+      if (with_counts) {
+        if (it.second) {
+          counts.push_back(0);
+        }
+        ++counts[id];
       }
     }
-    int64 uniq_size = static_cast<int64>(uniq.size());
+
+    const int64 uniq_size = static_cast<int64>(uniq.size());
     Tensor* output = nullptr;
-    OP_REQUIRES_OK(context, context->allocate_output(
-                                0, TensorShape({uniq_size}), &output));
+    Tensor* count_output = nullptr;
+    OP_REQUIRES_OK(context, AllocateOutputs(context, uniq_size, &output,
+                                            &count_output));
     auto output_vec = output->template vec<T>();
+    for (const auto& it : uniq) {
+      output_vec(it.second) = UniqueKey<T>::ToValue(it.first);
+    }
+    if (with_counts) {
+      std::copy(counts.begin(), counts.end(),
+                count_output->template vec<int32>().data());
+    }
+  }
+
+  void ComputeWithRadixSort(OpKernelContext* context,
+                            typename TTypes<T>::ConstVec Tin,
+                            typename TTypes<int32>::Vec idx_vec,
+                            std::false_type) {
+    LOG(FATAL) << "Unique can't radix sort "
+               << DataTypeString(DataTypeToEnum<T>::v());
+  }
+
+  // Groups equal values with a parallel LSD radix sort of (value, position)
+  // pairs. The sort is stable, so the first pair of each group holds the
+  // first occurrence of its value, and the ids are given in the order of
+  // these first occurrences. The values are sorted by their unsigned bits:
+  // only equality matters, not the order of the groups.
+  void ComputeWithRadixSort(OpKernelContext* context,
+                            typename TTypes<T>::ConstVec Tin,
+                            typename TTypes<int32>::Vec idx_vec,
+                            std::true_type) {
+    typedef typename std::make_unsigned<T>::type Key;
+    struct Entry {
+      Key key;
+      int32 pos;
+    };
+    const int64 N = static_cast<int64>(Tin.size());
+    const bool with_counts = num_outputs() > 2;
+
+    // Splits the input in blocks of consecutive elements, which are
+    // processed in parallel.
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    const int64 num_blocks = std::max<int64>(
+        1, std::min<int64>(worker_threads->num_threads,
+                           N / kMinRadixSortBlockSize));
+    auto block_start = [N, num_blocks](int64 block) {
+      return N * block / num_blocks;
+    };
+    auto for_each_block = [worker_threads, num_blocks,
+                           N](std::function<void(int64 block)> fn) {
+      Shard(worker_threads->num_threads, worker_threads->workers, num_blocks,
+            N / num_blocks * 10, [&fn](int64 start, int64 limit) {
+              for (int64 block = start; block < limit; ++block) {
+                fn(block);
+              }
+            });
+    };
+
+    std::vector<Entry> entries(N);
+    std::vector<Entry> scratch(N);
+    Entry* src = entries.data();
+    Entry* dst = scratch.data();
+    for_each_block([&](int64 block) {
+      for (int64 i = block_start(block); i < block_start(block + 1); ++i) {
+        src[i].key = static_cast<Key>(Tin(i));
+        src[i].pos = static_cast<int32>(i);
+      }
+    });
 
-    for (auto it : uniq) {
-      output_vec(it.second) = it.first;
+    const int kRadixBits = 8;
+    const int kRadix = 1 << kRadixBits;
+    std::vector<int64> offsets(num_blocks * kRadix);
+    for (int shift = 0; shift < 8 * sizeof(Key); shift += kRadixBits) {
+      auto digit = [shift](const Entry& e) {
+        return static_cast<int>((e.key >> shift) & (kRadix - 1));
+      };
+      for_each_block([&](int64 block) {
+        int64* hist = &offsets[block * kRadix];
+        std::fill(hist, hist + kRadix, 0);
+        for (int64 i = block_start(block); i < block_start(block + 1); ++i) {
+          ++hist[digit(src[i])];
+        }
+      });
+      // Turns the histograms into the first destination of each digit in
+      // each block, unless all the elements share the same digit.
+      bool single_digit = false;
+      int64 total = 0;
+      for (int d = 0; d < kRadix && !single_digit; ++d) {
+        const int64 start = total;
+        for (int64 block = 0; block < num_blocks; ++block) {
+          const int64 count = offsets[block * kRadix + d];
+          offsets[block * kRadix + d] = total;
+          total += count;
+        }
+        single_digit = total - start == N;
+      }
+      if (single_digit) {
+        continue;
+      }
+      for_each_block([&](int64 block) {
+        int64* next = &offsets[block * kRadix];
+        for (int64 i = block_start(block); i < block_start(block + 1); ++i) {
+          dst[next[digit(src[i])]++] = src[i];
+        }
+      });
+      std::swap(src, dst);
     }
 
-    if (num_outputs() > 2) {
-      OP_REQUIRES_OK(context, context->allocate_output(
-                                  2, TensorShape({uniq_size}), &output));
-      auto count_output_vec = output->template vec<int32>();
-      count_output_vec.setZero();
-      for (int64 i = 0; i < N; ++i) {
-        count_output_vec(idx_vec(i))++;
+    // Finds the position of the first occurrence of each value, and numbers
+    // them in order.
+    auto is_group_start = [src](int64 i) {
+      return i == 0 || src[i].key != src[i - 1].key;
+    };
+    std::vector<int32> ids(N, -1);
+    for_each_block([&](int64 block) {
+      for (int64 i = block_start(block); i < block_start(block + 1); ++i) {
+        if (is_group_start(i)) {
+          ids[src[i].pos] = 0;
+        }
+      }
+    });
+    int64 uniq_size = 0;
+    for (int64 i = 0; i < N; ++i) {
+      if (ids[i] >= 0) {
+        ids[i] = uniq_size++;
       }
     }
+
+    Tensor* output = nullptr;
+    Tensor* count_output = nullptr;
+    OP_REQUIRES_OK(context, AllocateOutputs(context, uniq_size, &output,
+                                            &count_output));
+    auto output_vec = output->template vec<T>();
+    int32* counts = with_counts ? count_output->template vec<int32>().data()
+                            : nullptr;
+
+    // Each block handles the groups that start in it.
+    for_each_block([&](int64 block) {
+      int64 i = block_start(block);
+      const int64 limit = block_start(block + 1);
+      while (i < limit && !is_group_start(i)) {
+        ++i;
+      }
+      while (i < limit) {
+        const int32 id = ids[src[i].pos];
+        output_vec(id) = static_cast<T>(src[i].key);
+        int64 end = i;
+        do {
+          idx_vec(src[end].pos) = id;
+          ++end;
+        } while (end < N && !is_group_start(end));
+        if (counts != nullptr) {
+          counts[id] = static_cast<int32>(end - i);
+        }
+        i = end;
+      }
+    });
   }
 };
 
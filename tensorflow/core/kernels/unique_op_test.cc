@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
@@ -102,6 +103,42 @@ static void BM_Unique_INT32_Repeat(int iters, int dim, int max_int) {
   test::Benchmark("cpu", g).Run(iters);
 }
 
+// Sizes from both sides of the switch to a radix sort, with few and with many
+// unique ids.
+static void UniqueInt64(int iters, int dim, int max_int, bool with_counts) {
+  testing::StopTiming();
+  Graph* g = new Graph(OpRegistry::Global());
+
+  Tensor input(DT_INT64, TensorShape({dim}));
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  auto input_vec = input.vec<int64>();
+  for (int i = 0; i < dim; ++i) {
+    input_vec(i) = rnd.Uniform64(max_int);
+  }
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"),
+                          with_counts ? "UniqueWithCounts" : "Unique")
+                  .Input(test::graph::Constant(g, input))
+                  .Attr("T", DT_INT64)
+                  .Finalize(g, &node));
+
+  testing::ItemsProcessed(static_cast<int64>(iters) * dim);
+  testing::BytesProcessed(static_cast<int64>(iters) * dim * sizeof(int64));
+  testing::UseRealTime();
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+
+static void BM_Unique_INT64(int iters, int dim, int max_int) {
+  UniqueInt64(iters, dim, max_int, false);
+}
+
+static void BM_UniqueWithCounts_INT64(int iters, int dim, int max_int) {
+  UniqueInt64(iters, dim, max_int, true);
+}
+
 TensorProto GetRandomStringsTensorProto(int dim, int max_str_len) {
   TensorProto tensor_proto;
   tensor_proto.set_dtype(DT_STRING);
@@ -180,6 +217,22 @@ BENCHMARK(BM_Unique_INT32_Repeat)
     ->ArgPair(64 * 1024, 64 * 1024 * 1024)
     ->ArgPair(1024 * 1024, 64 * 1024 * 1024);
 
+BENCHMARK(BM_Unique_INT64)
+    ->ArgPair(256 * 1024, 1024)
+    ->ArgPair(256 * 1024, 1024 * 1024 * 1024)
+    ->ArgPair(1024 * 1024, 1024)
+    ->ArgPair(1024 * 1024, 1024 * 1024 * 1024)
+    ->ArgPair(8 * 1024 * 1024, 1024)
+    ->ArgPair(8 * 1024 * 1024, 1024 * 1024 * 1024);
+
+BENCHMARK(BM_UniqueWithCounts_INT64)
+    ->ArgPair(256 * 1024, 1024)
+    ->ArgPair(256 * 1024, 1024 * 1024 * 1024)
+    ->ArgPair(1024 * 1024, 1024)
+    ->ArgPair(1024 * 1024, 1024 * 1024 * 1024)
+    ->ArgPair(8 * 1024 * 1024, 1024)
+    ->ArgPair(8 * 1024 * 1024, 1024 * 1024 * 1024);
+
 BENCHMARK(BM_Unique_STRING)
     ->Arg(32)
     ->Arg(256)
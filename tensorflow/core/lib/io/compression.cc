@@ -21,6 +21,8 @@ namespace compression {
 
 const char kNone[] = "";
 const char kGzip[] = "GZIP";
+const char kSnappy[] = "SNAPPY";
+const char kSnappyBlock[] = "SNAPPY_BLOCK";
 
 }
 }
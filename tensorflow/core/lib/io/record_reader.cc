@@ -22,10 +22,20 @@ limitations under the License.
 #include "tensorflow/core/lib/hash/crc32c.h"
 #include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
+#if !defined(IS_SLIM_BUILD)
+#include "tensorflow/core/lib/io/snappy/snappy_inputbuffer.h"
+#endif  // IS_SLIM_BUILD
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/snappy.h"
 
 namespace tensorflow {
 namespace io {
+namespace {
+
+const size_t kHeaderSize = sizeof(uint64) + sizeof(uint32);
+const size_t kFooterSize = sizeof(uint32);
+
+}  // namespace
 
 RecordReaderOptions RecordReaderOptions::CreateRecordReaderOptions(
     const string& compression_type) {
@@ -46,6 +56,15 @@ RecordReaderOptions RecordReaderOptions::CreateRecordReaderOptions(
 #else
     options.zlib_options = io::ZlibCompressionOptions::GZIP();
 #endif  // IS_SLIM_BUILD
+  } else if (compression_type == compression::kSnappy) {
+    options.compression_type = io::RecordReaderOptions::SNAPPY_COMPRESSION;
+#if defined(IS_SLIM_BUILD)
+    LOG(ERROR) << "Compression is not supported but compression_type is set."
+               << " No compression will be used.";
+#endif  // IS_SLIM_BUILD
+  } else if (compression_type == compression::kSnappyBlock) {
+    options.compression_type =
+        io::RecordReaderOptions::SNAPPY_BLOCK_COMPRESSION;
   } else if (compression_type != compression::kNone) {
     LOG(ERROR) << "Unsupported compression_type:" << compression_type
                << ". No comprression will be used.";
@@ -62,11 +81,25 @@ RecordReader::RecordReader(RandomAccessFile* file,
     LOG(FATAL) << "Zlib compression is unsupported on mobile platforms.";
 #else   // IS_SLIM_BUILD
     random_input_stream_.reset(new RandomAccessInputStream(file));
-    zlib_input_stream_.reset(new ZlibInputStream(
+    input_stream_.reset(new ZlibInputStream(
         random_input_stream_.get(), options.zlib_options.input_buffer_size,
         options.zlib_options.output_buffer_size, options.zlib_options));
 #endif  // IS_SLIM_BUILD
-  } else if (options.compression_type == RecordReaderOptions::NONE) {
+  } else if (options.compression_type ==
+             RecordReaderOptions::SNAPPY_COMPRESSION) {
+#if defined(IS_SLIM_BUILD)
+    LOG(FATAL) << "Snappy stream compression is unsupported on mobile "
+               << "platforms.";
+#else   // IS_SLIM_BUILD
+    // The input buffer must hold a whole compressed block and its 4 byte
+    // length, which snappy bounds by 32 + n + n / 6 for n input bytes.
+    const size_t block_size = options.snappy_block_size;
+    input_stream_.reset(new SnappyInputBuffer(
+        file, 32 + block_size + block_size / 6 + sizeof(uint32), block_size));
+#endif  // IS_SLIM_BUILD
+  } else if (options.compression_type == RecordReaderOptions::NONE ||
+             options.compression_type ==
+                 RecordReaderOptions::SNAPPY_BLOCK_COMPRESSION) {
     // Nothing to do.
   } else {
     LOG(FATAL) << "Unspecified compression type :" << options.compression_type;
@@ -74,8 +107,10 @@ RecordReader::RecordReader(RandomAccessFile* file,
 }
 
 RecordReader::~RecordReader() {
-  zlib_input_stream_.reset(nullptr);
+#if !defined(IS_SLIM_BUILD)
+  input_stream_.reset(nullptr);
   random_input_stream_.reset(nullptr);
+#endif  // IS_SLIM_BUILD
 }
 
 // Read n+4 bytes from file, verify that checksum of first n bytes is
@@ -91,15 +126,15 @@ Status RecordReader::ReadChecksummed(uint64 offset, size_t n,
   storage->resize(expected);
 
 #if !defined(IS_SLIM_BUILD)
-  if (zlib_input_stream_) {
-    // If we have a zlib compressed buffer, we assume that the
+  if (input_stream_) {
+    // If we have a compressed stream, we assume that the
     // file is being read sequentially, and we use the underlying
     // implementation to read the data.
     //
     // No checks are done to validate that the file is being read
-    // sequentially.  At some point the zlib input buffer may support
+    // sequentially.  At some point the compressed input streams may support
     // seeking, possibly inefficiently.
-    TF_RETURN_IF_ERROR(zlib_input_stream_->ReadNBytes(expected, storage));
+    TF_RETURN_IF_ERROR(input_stream_->ReadNBytes(expected, storage));
 
     if (storage->size() != expected) {
       if (storage->empty()) {
@@ -140,8 +175,10 @@ Status RecordReader::ReadChecksummed(uint64 offset, size_t n,
 }
 
 Status RecordReader::ReadRecord(uint64* offset, string* record) {
-  static const size_t kHeaderSize = sizeof(uint64) + sizeof(uint32);
-  static const size_t kFooterSize = sizeof(uint32);
+  if (options_.compression_type ==
+      RecordReaderOptions::SNAPPY_BLOCK_COMPRESSION) {
+    return ReadBlockRecord(offset, record);
+  }
 
   // Read header data.
   StringPiece lbuf;
@@ -172,5 +209,61 @@ Status RecordReader::ReadRecord(uint64* offset, string* record) {
   return Status::OK();
 }
 
+Status RecordReader::ReadBlock() {
+  // A block is stored as a record whose data is the snappy-compressed
+  // block.
+  StringPiece lbuf;
+  TF_RETURN_IF_ERROR(ReadChecksummed(block_offset_, sizeof(uint64), &lbuf,
+                                     &compressed_block_));
+  const uint64 length = core::DecodeFixed64(lbuf.data());
+
+  StringPiece data;
+  Status s = ReadChecksummed(block_offset_ + kHeaderSize, length, &data,
+                             &compressed_block_);
+  if (!s.ok()) {
+    if (errors::IsOutOfRange(s)) {
+      s = errors::DataLoss("truncated block at ", block_offset_);
+    }
+    return s;
+  }
+
+  size_t uncompressed_length;
+  if (!port::Snappy_GetUncompressedLength(data.data(), data.size(),
+                                          &uncompressed_length)) {
+    return errors::DataLoss("corrupted block at ", block_offset_);
+  }
+  block_.resize(uncompressed_length);
+  if (uncompressed_length > 0 &&
+      !port::Snappy_Uncompress(data.data(), data.size(), &block_[0])) {
+    return errors::DataLoss("failed to uncompress block at ", block_offset_);
+  }
+  block_pos_ = 0;
+  block_offset_ += kHeaderSize + length + kFooterSize;
+  return Status::OK();
+}
+
+Status RecordReader::ReadBlockRecord(uint64* offset, string* record) {
+  while (block_pos_ == block_.size()) {
+    TF_RETURN_IF_ERROR(ReadBlock());
+  }
+
+  // The uncompressed block is a sequence of records in the uncompressed
+  // format. The checksum of the compressed block already covers them, so
+  // their own checksums are not computed again.
+  const size_t remaining = block_.size() - block_pos_;
+  if (remaining < kHeaderSize + kFooterSize) {
+    return errors::DataLoss("truncated record at ", *offset);
+  }
+  const char* header = block_.data() + block_pos_;
+  const uint64 length = core::DecodeFixed64(header);
+  if (length > remaining - kHeaderSize - kFooterSize) {
+    return errors::DataLoss("truncated record at ", *offset);
+  }
+  record->assign(header + kHeaderSize, length);
+  block_pos_ += kHeaderSize + length + kFooterSize;
+  *offset += kHeaderSize + length + kFooterSize;
+  return Status::OK();
+}
+
 }  // namespace io
 }  // namespace tensorflow
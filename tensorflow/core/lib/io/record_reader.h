@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #if !defined(IS_SLIM_BUILD)
+#include "tensorflow/core/lib/io/inputstream_interface.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
@@ -34,7 +35,13 @@ namespace io {
 
 class RecordReaderOptions {
  public:
-  enum CompressionType { NONE = 0, ZLIB_COMPRESSION = 1 };
+  // See RecordWriterOptions for a description of the compressed formats.
+  enum CompressionType {
+    NONE = 0,
+    ZLIB_COMPRESSION = 1,
+    SNAPPY_COMPRESSION = 2,
+    SNAPPY_BLOCK_COMPRESSION = 3
+  };
   CompressionType compression_type = NONE;
 
   static RecordReaderOptions CreateRecordReaderOptions(
@@ -44,6 +51,10 @@ class RecordReaderOptions {
   // Options specific to zlib compression.
   ZlibCompressionOptions zlib_options;
 #endif  // IS_SLIM_BUILD
+
+  // The uncompressed size of a SNAPPY_COMPRESSION block. This must be at
+  // least the block size that the file was written with.
+  int64 snappy_block_size = 256 << 10;
 };
 
 class RecordReader {
@@ -58,19 +69,40 @@ class RecordReader {
   // Read the record at "*offset" into *record and update *offset to
   // point to the offset of the next record.  Returns OK on success,
   // OUT_OF_RANGE for end of file, or something else for an error.
+  //
+  // For compressed files, "*offset" is the offset in the uncompressed
+  // stream of records, and records must be read sequentially.
   Status ReadRecord(uint64* offset, string* record);
 
  private:
   Status ReadChecksummed(uint64 offset, size_t n, StringPiece* result,
                          string* storage);
 
+  // Reads the next record from the current block of a
+  // SNAPPY_BLOCK_COMPRESSION file, reading and uncompressing the next block
+  // first if the current one is exhausted.
+  Status ReadBlockRecord(uint64* offset, string* record);
+
+  // Reads and uncompresses the block at `block_offset_` into `block_`.
+  Status ReadBlock();
+
   RandomAccessFile* src_;
   RecordReaderOptions options_;
 #if !defined(IS_SLIM_BUILD)
   std::unique_ptr<RandomAccessInputStream> random_input_stream_;
-  std::unique_ptr<ZlibInputStream> zlib_input_stream_;
+  // Uncompresses zlib or snappy streams from `random_input_stream_` or
+  // `src_`.
+  std::unique_ptr<InputStreamInterface> input_stream_;
 #endif  // IS_SLIM_BUILD
 
+  // State for SNAPPY_BLOCK_COMPRESSION: the file offset of the next block,
+  // the uncompressed current block and the position of the next record in
+  // it, and a buffer for the compressed block.
+  uint64 block_offset_ = 0;
+  string block_;
+  size_t block_pos_ = 0;
+  string compressed_block_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(RecordReader);
 };
 
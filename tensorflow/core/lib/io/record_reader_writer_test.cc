@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 
@@ -105,4 +106,191 @@ TEST(RecordReaderWriterTest, TestZlib) {
   }
 }
 
+// Writes `records` to `fname` with the given compression type and block size.
+static void WriteRecords(const string& fname,
+                         io::RecordWriterOptions::CompressionType type,
+                         int64 block_size,
+                         const std::vector<string>& records) {
+  std::unique_ptr<WritableFile> file;
+  TF_CHECK_OK(Env::Default()->NewWritableFile(fname, &file));
+  io::RecordWriterOptions options;
+  options.compression_type = type;
+  options.snappy_block_size = block_size;
+  io::RecordWriter writer(file.get(), options);
+  for (const string& record : records) {
+    TF_CHECK_OK(writer.WriteRecord(record));
+  }
+  TF_CHECK_OK(writer.Close());
+  TF_CHECK_OK(file->Close());
+}
+
+// Reads `fname` back and checks that it holds exactly `records`, and that
+// the offsets are those of the uncompressed records.
+static void CheckRecords(const string& fname,
+                         io::RecordReaderOptions::CompressionType type,
+                         int64 block_size,
+                         const std::vector<string>& records) {
+  std::unique_ptr<RandomAccessFile> file;
+  TF_CHECK_OK(Env::Default()->NewRandomAccessFile(fname, &file));
+  io::RecordReaderOptions options;
+  options.compression_type = type;
+  options.snappy_block_size = block_size;
+  io::RecordReader reader(file.get(), options);
+  uint64 offset = 0;
+  uint64 expected_offset = 0;
+  string record;
+  for (const string& expected : records) {
+    TF_ASSERT_OK(reader.ReadRecord(&offset, &record));
+    EXPECT_EQ(expected, record);
+    expected_offset += expected.size() + 16;
+    EXPECT_EQ(expected_offset, offset);
+  }
+  EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&offset, &record)));
+}
+
+static std::vector<string> TestRecords() {
+  std::vector<string> records;
+  for (int i = 0; i < 1000; ++i) {
+    records.push_back(strings::StrCat("record ", i, " ", string(i % 50, 'x')));
+  }
+  // Larger than a block.
+  records.push_back(string(100000, 'y'));
+  records.push_back("");
+  records.push_back("last");
+  return records;
+}
+
+TEST(RecordReaderWriterTest, TestSnappy) {
+  string fname = testing::TmpDir() + "/record_reader_writer_snappy_test";
+  const std::vector<string> records = TestRecords();
+  for (int64 block_size : {64, 4096, 256 << 10}) {
+    WriteRecords(fname, io::RecordWriterOptions::SNAPPY_COMPRESSION,
+                 block_size, records);
+    CheckRecords(fname, io::RecordReaderOptions::SNAPPY_COMPRESSION,
+                 block_size, records);
+  }
+}
+
+TEST(RecordReaderWriterTest, TestSnappyBlock) {
+  string fname = testing::TmpDir() + "/record_reader_writer_snappy_block_test";
+  const std::vector<string> records = TestRecords();
+  for (int64 block_size : {1, 64, 4096, 256 << 10}) {
+    WriteRecords(fname, io::RecordWriterOptions::SNAPPY_BLOCK_COMPRESSION,
+                 block_size, records);
+    // The reader does not depend on the block size.
+    CheckRecords(fname, io::RecordReaderOptions::SNAPPY_BLOCK_COMPRESSION, 0,
+                 records);
+  }
+}
+
+TEST(RecordReaderWriterTest, TestSnappyBlockFlush) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_snappy_flush_test";
+  std::unique_ptr<WritableFile> file;
+  TF_CHECK_OK(env->NewWritableFile(fname, &file));
+  io::RecordWriterOptions options =
+      io::RecordWriterOptions::CreateRecordWriterOptions("SNAPPY_BLOCK");
+  io::RecordWriter writer(file.get(), options);
+  TF_EXPECT_OK(writer.WriteRecord("abc"));
+  TF_EXPECT_OK(writer.WriteRecord("defg"));
+  // Records are buffered until the block is full or flushed.
+  TF_CHECK_OK(file->Flush());
+  uint64 size;
+  TF_CHECK_OK(env->GetFileSize(fname, &size));
+  EXPECT_EQ(0, size);
+  TF_CHECK_OK(writer.Flush());
+  TF_CHECK_OK(file->Flush());
+
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+  io::RecordReader reader(
+      read_file.get(),
+      io::RecordReaderOptions::CreateRecordReaderOptions("SNAPPY_BLOCK"));
+  uint64 offset = 0;
+  string record;
+  TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+  EXPECT_EQ("abc", record);
+  TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+  EXPECT_EQ("defg", record);
+  EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&offset, &record)));
+}
+
+TEST(RecordReaderWriterTest, TestSnappyBlockCorruption) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_snappy_corrupt";
+  WriteRecords(fname, io::RecordWriterOptions::SNAPPY_BLOCK_COMPRESSION, 1024,
+               TestRecords());
+  string contents;
+  TF_CHECK_OK(ReadFileToString(env, fname, &contents));
+  contents[contents.size() / 2] ^= 0x55;
+  TF_CHECK_OK(WriteStringToFile(env, fname, contents));
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &file));
+  io::RecordReaderOptions options;
+  options.compression_type = io::RecordReaderOptions::SNAPPY_BLOCK_COMPRESSION;
+  io::RecordReader reader(file.get(), options);
+  uint64 offset = 0;
+  string record;
+  Status s;
+  while (s.ok()) {
+    s = reader.ReadRecord(&offset, &record);
+  }
+  EXPECT_TRUE(errors::IsDataLoss(s)) << s;
+}
+
+// Reads back 64MB of text-like records written with the given compression
+// type.
+static void BM_ReadRecords(int iters, int compression_type) {
+  testing::StopTiming();
+  const auto type =
+      static_cast<io::RecordWriterOptions::CompressionType>(compression_type);
+  string fname = strings::StrCat(testing::TmpDir(), "/bm_read_records_",
+                                 compression_type);
+  std::vector<string> records;
+  int64 bytes = 0;
+  for (int i = 0; bytes < (64 << 20); ++i) {
+    records.push_back(strings::StrCat("feature { key: \"id\" value: ", i, " } ",
+                                      string(200 + i % 300, 'a' + i % 26)));
+    bytes += records.back().size();
+  }
+  io::RecordWriterOptions write_options;
+  write_options.compression_type = type;
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(Env::Default()->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get(), write_options);
+    for (const string& record : records) {
+      TF_CHECK_OK(writer.WriteRecord(record));
+    }
+    TF_CHECK_OK(writer.Close());
+    TF_CHECK_OK(file->Close());
+  }
+  uint64 file_size;
+  TF_CHECK_OK(Env::Default()->GetFileSize(fname, &file_size));
+  testing::SetLabel(strings::StrCat("ratio=", static_cast<double>(file_size) /
+                                                  bytes));
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_CHECK_OK(Env::Default()->NewRandomAccessFile(fname, &file));
+  io::RecordReaderOptions read_options;
+  read_options.compression_type =
+      static_cast<io::RecordReaderOptions::CompressionType>(compression_type);
+  testing::BytesProcessed(static_cast<int64>(iters) * bytes);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    io::RecordReader reader(file.get(), read_options);
+    uint64 offset = 0;
+    string record;
+    while (reader.ReadRecord(&offset, &record).ok()) {
+    }
+  }
+  testing::StopTiming();
+}
+BENCHMARK(BM_ReadRecords)
+    ->Arg(io::RecordWriterOptions::NONE)
+    ->Arg(io::RecordWriterOptions::ZLIB_COMPRESSION)
+    ->Arg(io::RecordWriterOptions::SNAPPY_COMPRESSION)
+    ->Arg(io::RecordWriterOptions::SNAPPY_BLOCK_COMPRESSION);
+
 }  // namespace tensorflow
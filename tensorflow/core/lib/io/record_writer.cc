@@ -16,9 +16,14 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_writer.h"
 
 #include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
 #include "tensorflow/core/lib/io/compression.h"
+#if !defined(IS_SLIM_BUILD)
+#include "tensorflow/core/lib/io/snappy/snappy_outputbuffer.h"
+#endif  // IS_SLIM_BUILD
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/snappy.h"
 
 namespace tensorflow {
 namespace io {
@@ -26,6 +31,20 @@ namespace {
 bool IsZlibCompressed(RecordWriterOptions options) {
   return options.compression_type == RecordWriterOptions::ZLIB_COMPRESSION;
 }
+
+bool IsSnappyCompressed(RecordWriterOptions options) {
+  return options.compression_type == RecordWriterOptions::SNAPPY_COMPRESSION;
+}
+
+bool IsSnappyBlockCompressed(RecordWriterOptions options) {
+  return options.compression_type ==
+         RecordWriterOptions::SNAPPY_BLOCK_COMPRESSION;
+}
+
+// Returns true if `dest_` is a compressing buffer owned by the writer.
+bool OwnsOutputBuffer(RecordWriterOptions options) {
+  return IsZlibCompressed(options) || IsSnappyCompressed(options);
+}
 }  // namespace
 
 RecordWriterOptions RecordWriterOptions::CreateRecordWriterOptions(
@@ -47,6 +66,15 @@ RecordWriterOptions RecordWriterOptions::CreateRecordWriterOptions(
 #else
     options.zlib_options = io::ZlibCompressionOptions::GZIP();
 #endif  // IS_SLIM_BUILD
+  } else if (compression_type == compression::kSnappy) {
+    options.compression_type = io::RecordWriterOptions::SNAPPY_COMPRESSION;
+#if defined(IS_SLIM_BUILD)
+    LOG(ERROR) << "Compression is not supported but compression_type is set."
+               << " No compression will be used.";
+#endif  // IS_SLIM_BUILD
+  } else if (compression_type == compression::kSnappyBlock) {
+    options.compression_type =
+        io::RecordWriterOptions::SNAPPY_BLOCK_COMPRESSION;
   } else if (compression_type != compression::kNone) {
     LOG(ERROR) << "Unsupported compression_type:" << compression_type
                << ". No comprression will be used.";
@@ -72,6 +100,16 @@ RecordWriter::RecordWriter(WritableFile* dest,
     }
     dest_ = zlib_output_buffer;
 #endif  // IS_SLIM_BUILD
+  } else if (IsSnappyCompressed(options)) {
+#if defined(IS_SLIM_BUILD)
+    LOG(FATAL) << "Snappy stream compression is unsupported on mobile "
+               << "platforms.";
+#else   // IS_SLIM_BUILD
+    dest_ = new SnappyOutputBuffer(dest, options.snappy_block_size,
+                                   options.snappy_block_size);
+#endif  // IS_SLIM_BUILD
+  } else if (IsSnappyBlockCompressed(options)) {
+    block_.reserve(options.snappy_block_size);
   } else if (options.compression_type == RecordWriterOptions::NONE) {
     // Nothing to do
   } else {
@@ -105,14 +143,50 @@ Status RecordWriter::WriteRecord(StringPiece data) {
   char footer[sizeof(uint32)];
   core::EncodeFixed32(footer, MaskedCrc(data.data(), data.size()));
 
+  if (IsSnappyBlockCompressed(options_)) {
+    block_.append(header, sizeof(header));
+    block_.append(data.data(), data.size());
+    block_.append(footer, sizeof(footer));
+    if (block_.size() >= static_cast<size_t>(options_.snappy_block_size)) {
+      return WriteBlock();
+    }
+    return Status::OK();
+  }
+
   TF_RETURN_IF_ERROR(dest_->Append(StringPiece(header, sizeof(header))));
   TF_RETURN_IF_ERROR(dest_->Append(data));
   return dest_->Append(StringPiece(footer, sizeof(footer)));
 }
 
+Status RecordWriter::WriteBlock() {
+  if (block_.empty()) {
+    return Status::OK();
+  }
+  string compressed;
+  if (!port::Snappy_Compress(block_.data(), block_.size(), &compressed)) {
+    return errors::Unimplemented(
+        "Snappy compression is not available in this build");
+  }
+  block_.clear();
+
+  char header[sizeof(uint64) + sizeof(uint32)];
+  core::EncodeFixed64(header + 0, compressed.size());
+  core::EncodeFixed32(header + sizeof(uint64),
+                      MaskedCrc(header, sizeof(uint64)));
+  char footer[sizeof(uint32)];
+  core::EncodeFixed32(footer, MaskedCrc(compressed.data(), compressed.size()));
+
+  TF_RETURN_IF_ERROR(dest_->Append(StringPiece(header, sizeof(header))));
+  TF_RETURN_IF_ERROR(dest_->Append(compressed));
+  return dest_->Append(StringPiece(footer, sizeof(footer)));
+}
+
 Status RecordWriter::Close() {
+  if (IsSnappyBlockCompressed(options_)) {
+    return WriteBlock();
+  }
 #if !defined(IS_SLIM_BUILD)
-  if (IsZlibCompressed(options_)) {
+  if (OwnsOutputBuffer(options_)) {
     Status s = dest_->Close();
     delete dest_;
     dest_ = nullptr;
@@ -123,7 +197,10 @@ Status RecordWriter::Close() {
 }
 
 Status RecordWriter::Flush() {
-  if (IsZlibCompressed(options_)) {
+  if (IsSnappyBlockCompressed(options_)) {
+    return WriteBlock();
+  }
+  if (OwnsOutputBuffer(options_)) {
     return dest_->Flush();
   }
   return Status::OK();
@@ -33,7 +33,21 @@ namespace io {
 
 class RecordWriterOptions {
  public:
-  enum CompressionType { NONE = 0, ZLIB_COMPRESSION = 1 };
+  // ZLIB_COMPRESSION and SNAPPY_COMPRESSION compress the whole stream of
+  // records, which must then be read sequentially. SNAPPY_COMPRESSION
+  // compresses the stream in blocks of `snappy_block_size` bytes, using the
+  // format of SnappyOutputBuffer.
+  //
+  // SNAPPY_BLOCK_COMPRESSION groups whole records into blocks of about
+  // `snappy_block_size` uncompressed bytes, and writes each block in the
+  // record format with its snappy-compressed records as the data. Each block
+  // is checksummed once and can be uncompressed on its own.
+  enum CompressionType {
+    NONE = 0,
+    ZLIB_COMPRESSION = 1,
+    SNAPPY_COMPRESSION = 2,
+    SNAPPY_BLOCK_COMPRESSION = 3
+  };
   CompressionType compression_type = NONE;
 
   static RecordWriterOptions CreateRecordWriterOptions(
@@ -43,6 +57,9 @@ class RecordWriterOptions {
 #if !defined(IS_SLIM_BUILD)
   ZlibCompressionOptions zlib_options;
 #endif  // IS_SLIM_BUILD
+
+  // The uncompressed size of a block for both snappy compression types.
+  int64 snappy_block_size = 256 << 10;
 };
 
 class RecordWriter {
@@ -73,9 +90,15 @@ class RecordWriter {
   Status Close();
 
  private:
+  // Compresses the records in `block_` and writes them as one block.
+  Status WriteBlock();
+
   WritableFile* dest_;
   RecordWriterOptions options_;
 
+  // The uncompressed records of the current SNAPPY_BLOCK_COMPRESSION block.
+  string block_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(RecordWriter);
 };
 
@@ -55,27 +55,45 @@ Status SnappyOutputBuffer::Write(StringPiece data) {
     return Status::OK();
   }
 
-  // `data` is too large to fit in input buffer so we deflate it directly.
+  // `data` is too large to fit in input buffer so we deflate it directly,
+  // one buffer-sized block at a time so that a reader never needs an input
+  // buffer larger than the largest compressed block.
   // Note that at this point we have already deflated all existing input so
   // we do not need to backup next_in and avail_in.
-  next_in_ = const_cast<char*>(data.data());
-  avail_in_ = bytes_to_write;
+  const char* p = data.data();
+  while (bytes_to_write > 0) {
+    next_in_ = const_cast<char*>(p);
+    avail_in_ = std::min(bytes_to_write, input_buffer_capacity_);
+    p += avail_in_;
+    bytes_to_write -= avail_in_;
 
-  TF_RETURN_IF_ERROR(Deflate());
+    TF_RETURN_IF_ERROR(Deflate());
 
-  DCHECK(avail_in_ == 0);  // All input will be used up.
+    DCHECK(avail_in_ == 0);  // All input will be used up.
+  }
 
   next_in_ = input_buffer_.get();
 
   return Status::OK();
 }
 
+Status SnappyOutputBuffer::Append(const StringPiece& data) {
+  return Write(data);
+}
+
 Status SnappyOutputBuffer::Flush() {
   TF_RETURN_IF_ERROR(DeflateBuffered());
   TF_RETURN_IF_ERROR(FlushOutputBufferToFile());
   return Status::OK();
 }
 
+Status SnappyOutputBuffer::Close() { return Flush(); }
+
+Status SnappyOutputBuffer::Sync() {
+  TF_RETURN_IF_ERROR(Flush());
+  return file_->Sync();
+}
+
 int32 SnappyOutputBuffer::AvailableInputSpace() const {
   return input_buffer_capacity_ - avail_in_;
 }
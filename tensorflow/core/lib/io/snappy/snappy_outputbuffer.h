@@ -42,8 +42,9 @@ namespace io {
 // starts with a 4 byte header which stores the length (in bytes) of the
 // _compressed_ block _excluding_ this header. The compressed
 // block (excluding the 4 byte header) is a valid snappy block and can directly
-// be uncompressed using Snappy_Uncompress.
-class SnappyOutputBuffer {
+// be uncompressed using Snappy_Uncompress. No block holds more than
+// `input_buffer_bytes` bytes of uncompressed data.
+class SnappyOutputBuffer : public WritableFile {
  public:
   // Create an SnappyOutputBuffer for `file` with two buffers that cache the
   // 1. input data to be deflated
@@ -63,9 +64,18 @@ class SnappyOutputBuffer {
   // To immediately write contents to file call `Flush()`.
   Status Write(StringPiece data);
 
+  // Same as `Write()`.
+  Status Append(const StringPiece& data) override;
+
   // Compresses any cached input and writes all output to file. This must be
   // called before the destructor to avoid any data loss.
-  Status Flush();
+  Status Flush() override;
+
+  // Flushes any cached data. Does *not* close the underlying file.
+  Status Close() override;
+
+  // Flushes any cached data and syncs the underlying file.
+  Status Sync() override;
 
  private:
   // Appends `data` to `input_buffer_`.
@@ -372,6 +372,24 @@ seed: A scalar seed for the random number generator. If either seed or
 seed2: A second scalar seed to avoid seed collision.
 )doc");
 
+REGISTER_OP("PrefetchDataset")
+    .Input("input_dataset: resource")
+    .Input("buffer_size: int64")
+    .Output("handle: resource")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Creates a dataset that asynchronously prefetches elements from `input_dataset`.
+
+An iterator over a PrefetchDataset reads elements of `input_dataset` on a
+background thread, so that producing the next element overlaps with the
+computation that consumes the current one.
+
+buffer_size: The maximum number of elements to buffer in an iterator over
+  this dataset.
+)doc");
+
 REGISTER_OP("CacheDataset")
     .Input("input_dataset: resource")
     .Input("filename: string")
@@ -438,7 +456,8 @@ Creates a dataset that emits the records from one or more TFRecord files.
 filenames: A scalar or vector containing the name(s) of the file(s) to be
   read.
 compression_type: A scalar containing either (i) the empty string (no
-  compression), (ii) "ZLIB", or (iii) "GZIP".
+  compression), (ii) "ZLIB", (iii) "GZIP", (iv) "SNAPPY", or (v)
+  "SNAPPY_BLOCK".
 )doc");
 
 REGISTER_OP("Iterator")
@@ -536,6 +555,33 @@ REGISTER_OP("IteratorDispose")
 Releases any resources used by the given iterator.
 )doc");
 
+REGISTER_OP("SaveIterator")
+    .Input("iterator: resource")
+    .Input("prefix: string")
+    .SetShapeFn(shape_inference::NoOutputs)
+    .Doc(R"doc(
+Saves the state of the given iterator as a tensor bundle.
+
+The bundle uses the same format as the checkpoints written by SaveV2, and
+can be restored into an iterator over an identically-defined dataset with
+RestoreIterator.
+
+prefix: The prefix of the tensor bundle to write.
+)doc");
+
+REGISTER_OP("RestoreIterator")
+    .Input("iterator: resource")
+    .Input("prefix: string")
+    .SetShapeFn(shape_inference::NoOutputs)
+    .Doc(R"doc(
+Restores the state of the given iterator from a tensor bundle.
+
+The iterator must have been initialized with a dataset that is defined
+identically to the one whose iterator state was saved by SaveIterator.
+
+prefix: The prefix of the tensor bundle to read.
+)doc");
+
 REGISTER_OP("IteratorToStringHandle")
     .Input("resource_handle: resource")
     .Output("string_handle: string")
@@ -1809,6 +1809,99 @@ segment_ids: segment_ids passed to the corresponding SparseSegmentSqrtN op.
 output_dim0: dimension 0 of "data" passed to SparseSegmentSqrtN op.
 )doc");
 
+REGISTER_OP("FusedEmbeddingLookupSparse")
+    .Input("params: T")
+    .Input("ids: Tidx")
+    .Input("segment_ids: int32")
+    .Input("weights: T")
+    .Output("output: T")
+    .Attr("T: {float, double}")
+    .Attr("Tidx: {int32, int64} = DT_INT64")
+    .Attr("combiner: {'sum', 'mean', 'sqrtn'} = 'mean'")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle params_shape;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &params_shape));
+      ShapeHandle ids_shape;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &ids_shape));
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->Merge(c->input(2), ids_shape, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 1, &unused));
+
+      ShapeHandle subshape;
+      TF_RETURN_IF_ERROR(c->Subshape(params_shape, 1, &subshape));
+      ShapeHandle out;
+      TF_RETURN_IF_ERROR(c->Concatenate(
+          c->Vector(InferenceContext::kUnknownDim), subshape, &out));
+      c->set_output(0, out);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Looks up and combines the embeddings of sparse ids in a single pass.
+
+Computes the same result as gathering the rows of `params` selected by `ids`,
+multiplying them by `weights`, and reducing them along sorted segments with
+SparseSegmentSum, SparseSegmentMean or SparseSegmentSqrtN, without
+materializing the gathered rows. With weights, "mean" divides each segment by
+the sum of its weights and "sqrtn" by the square root of the sum of their
+squares.
+
+params: The embeddings, with one row per id.
+ids: A 1-D tensor of the ids to look up, in `[0, dim0(params))`.
+segment_ids: A 1-D tensor with the same size as `ids`. Values should be
+  sorted and can be repeated.
+weights: A 1-D tensor with the same size as `ids`, or an empty tensor for
+  weights of 1.
+combiner: How the weighted embeddings of each segment are combined.
+output: Has same shape as params, except for dimension 0 which has size `k`,
+  the number of segments.
+)doc");
+
+REGISTER_OP("FusedEmbeddingLookupSparseGrad")
+    .Input("grad: T")
+    .Input("ids: Tidx")
+    .Input("segment_ids: int32")
+    .Input("weights: T")
+    .Output("unique_ids: Tidx")
+    .Output("values: T")
+    .Attr("T: {float, double}")
+    .Attr("Tidx: {int32, int64} = DT_INT64")
+    .Attr("combiner: {'sum', 'mean', 'sqrtn'} = 'mean'")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle grad_shape;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 1, &grad_shape));
+      ShapeHandle ids_shape;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &ids_shape));
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->Merge(c->input(2), ids_shape, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 1, &unused));
+
+      ShapeHandle subshape;
+      TF_RETURN_IF_ERROR(c->Subshape(grad_shape, 1, &subshape));
+      ShapeHandle values;
+      TF_RETURN_IF_ERROR(c->Concatenate(
+          c->Vector(InferenceContext::kUnknownDim), subshape, &values));
+      c->set_output(0, c->Vector(InferenceContext::kUnknownDim));
+      c->set_output(1, values);
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes the gradient of FusedEmbeddingLookupSparse with respect to params.
+
+The gradient is returned as the rows `values` of the ids `unique_ids`, which
+are sorted and appear once each. The rows of params that are not looked up
+have a gradient of zero.
+
+grad: gradient propagated to the FusedEmbeddingLookupSparse op.
+ids: ids passed to the corresponding FusedEmbeddingLookupSparse op.
+segment_ids: segment_ids passed to the corresponding FusedEmbeddingLookupSparse
+  op.
+weights: weights passed to the corresponding FusedEmbeddingLookupSparse op.
+combiner: combiner of the corresponding FusedEmbeddingLookupSparse op.
+unique_ids: The ids that were looked up, without repeats.
+values: The gradient of the rows of params for `unique_ids`. Has same shape as
+  grad, except for dimension 0 which has the size of `unique_ids`.
+)doc");
+
 REGISTER_OP("All")
     .Input("input: bool")
     .Input("reduction_indices: Tidx")
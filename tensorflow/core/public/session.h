@@ -171,6 +171,36 @@ class Session {
                       const std::vector<string>& output_names,
                       std::vector<Tensor>* outputs);
 
+  /// \brief Handle to a feed/fetch signature that has been pre-resolved by
+  /// `MakeCallable()`.
+  typedef int64 CallableHandle;
+
+  /// \brief Pre-resolves the step signature given by `feed_names`,
+  /// `fetch_names` and `target_nodes` and returns a `handle` that can be
+  /// used to run it repeatedly with `RunCallable()`. Running a callable
+  /// avoids the per-step signature lookup and feed/fetch name resolution
+  /// performed by `Run()`.
+  /// NOTE: This API is still experimental and may change.
+  virtual Status MakeCallable(const std::vector<string>& feed_names,
+                              const std::vector<string>& fetch_names,
+                              const std::vector<string>& target_nodes,
+                              CallableHandle* handle);
+
+  /// \brief Runs the callable `handle`. `feed_tensors` must match the
+  /// `feed_names` passed to `MakeCallable()` one for one, and on success
+  /// `fetch_tensors` holds the values of the `fetch_names` in order.
+  /// `run_metadata` may be nullptr.
+  /// NOTE: This API is still experimental and may change.
+  virtual Status RunCallable(CallableHandle handle,
+                             const std::vector<Tensor>& feed_tensors,
+                             std::vector<Tensor>* fetch_tensors,
+                             RunMetadata* run_metadata);
+
+  /// \brief Releases the resources associated with the callable `handle`.
+  /// The handle must not be used after this call.
+  /// NOTE: This API is still experimental and may change.
+  virtual Status ReleaseCallable(CallableHandle handle);
+
   /// \brief List devices in the session.
   ///
   /// Retrieves the list of available devices within the session, and populates
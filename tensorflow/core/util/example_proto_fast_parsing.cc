@@ -21,9 +21,11 @@ limitations under the License.
 #include "tensorflow/core/framework/numeric_op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/casts.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/raw_coding.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
@@ -60,6 +62,89 @@ constexpr uint8 kVarintTag(uint32 tag) { return (tag << 3) | 0; }
 constexpr uint8 kDelimitedTag(uint32 tag) { return (tag << 3) | 2; }
 constexpr uint8 kFixed32Tag(uint32 tag) { return (tag << 3) | 5; }
 
+bool ParseString(protobuf::io::CodedInputStream* stream, StringPiece* result) {
+  DCHECK(stream != nullptr);
+  DCHECK(result != nullptr);
+  uint32 length;
+  if (!stream->ReadVarint32(&length)) return false;
+  if (length == 0) {
+    *result = StringPiece(nullptr, 0);
+    return true;
+  }
+  const void* stream_alias;
+  int stream_size;
+  if (!stream->GetDirectBufferPointer(&stream_alias, &stream_size)) {
+    return false;
+  }
+  if (static_cast<uint32>(stream_size) < length) return false;
+  *result = StringPiece(static_cast<const char*>(stream_alias), length);
+  stream->Skip(length);
+  return true;
+}
+
+// A list that only counts the values pushed to it. Parsing a feature into it
+// checks the feature and sizes its output without storing any value.
+class ValueCounter {
+ public:
+  template <typename T>
+  void push_back(T&&) {
+    ++size_;
+  }
+
+  size_t size() const { return size_; }
+
+ private:
+  size_t size_ = 0;
+};
+
+template <typename Result>
+void AppendBytes(StringPiece bytes, Result* bytes_list) {
+  bytes_list->push_back(bytes.ToString());
+}
+
+void AppendBytes(StringPiece bytes, ValueCounter* counter) {
+  counter->push_back(bytes);
+}
+
+// Decodes the varints packed in 'packed' and appends them to 'int64_list'.
+// Eight bytes are tested at a time, and the values of one byte they start with
+// are decoded without looking for the end of each varint. Ids, counts and
+// other small values are encoded as one byte, so this is the common case.
+template <typename Result>
+bool ParsePackedVarints(StringPiece packed, Result* int64_list) {
+  const uint64 kContinuationBits = 0x8080808080808080ULL;
+  const uint8* ptr = reinterpret_cast<const uint8*>(packed.data());
+  const uint8* end = ptr + packed.size();
+  while (ptr != end) {
+    if (end - ptr >= 8) {
+      const uint64 word =
+          core::DecodeFixed64(reinterpret_cast<const char*>(ptr));
+      const uint64 continuation = word & kContinuationBits;
+      // Number of bytes before the first one with a continuation bit.
+      const int num_bytes =
+          continuation == 0
+              ? 8
+              : Log2Floor64(continuation & (~continuation + 1)) / 8;
+      for (int i = 0; i < num_bytes; ++i) {
+        int64_list->push_back(static_cast<int64>((word >> (8 * i)) & 0x7f));
+      }
+      ptr += num_bytes;
+      if (num_bytes == 8) continue;
+    }
+    // Decode one varint byte by byte. Like CodedInputStream, reject varints of
+    // more than 10 bytes and drop the bits past the 64th.
+    uint64 n = 0;
+    for (int shift = 0;; shift += 7) {
+      if (ptr == end || shift >= 70) return false;
+      const uint8 byte = *ptr++;
+      n |= static_cast<uint64>(byte & 0x7f) << shift;
+      if (byte < 0x80) break;
+    }
+    int64_list->push_back(static_cast<int64>(n));
+  }
+  return true;
+}
+
 namespace parsed {
 
 // ParseDataType has to be called first, then appropriate ParseZzzzList.
@@ -109,11 +194,9 @@ class Feature {
     while (!stream.ExpectAtEnd()) {
       if (!stream.ExpectTag(kDelimitedTag(1))) return false;
       // parse string
-      uint32 bytes_length;
-      if (!stream.ReadVarint32(&bytes_length)) return false;
-      string bytes;
-      if (!stream.ReadString(&bytes, bytes_length)) return false;
-      bytes_list->push_back(std::move(bytes));
+      StringPiece bytes;
+      if (!ParseString(&stream, &bytes)) return false;
+      AppendBytes(bytes, bytes_list);
     }
     stream.PopLimit(limit);
     return true;
@@ -179,17 +262,9 @@ class Feature {
       }
       if (peek_tag == kDelimitedTag(1)) {                       // packed
         if (!stream.ExpectTag(kDelimitedTag(1))) return false;  // packed tag
-        uint32 packed_length;
-        if (!stream.ReadVarint32(&packed_length)) return false;
-        auto packed_limit = stream.PushLimit(packed_length);
-
-        while (!stream.ExpectAtEnd()) {
-          protobuf_uint64 n;  // There is no API for int64
-          if (!stream.ReadVarint64(&n)) return false;
-          int64_list->push_back(static_cast<int64>(n));
-        }
-
-        stream.PopLimit(packed_limit);
+        StringPiece packed;
+        if (!ParseString(&stream, &packed)) return false;
+        if (!ParsePackedVarints(packed, int64_list)) return false;
       } else {  // non-packed
         while (!stream.ExpectAtEnd()) {
           if (!stream.ExpectTag(kVarintTag(1))) return false;
@@ -240,26 +315,6 @@ inline bool SkipExtraneousTag(protobuf::io::CodedInputStream* stream) {
   return false;  // unrecognized tag type
 }
 
-bool ParseString(protobuf::io::CodedInputStream* stream, StringPiece* result) {
-  DCHECK(stream != nullptr);
-  DCHECK(result != nullptr);
-  uint32 length;
-  if (!stream->ReadVarint32(&length)) return false;
-  if (length == 0) {
-    *result = StringPiece(nullptr, 0);
-    return true;
-  }
-  const void* stream_alias;
-  int stream_size;
-  if (!stream->GetDirectBufferPointer(&stream_alias, &stream_size)) {
-    return false;
-  }
-  if (static_cast<uint32>(stream_size) < length) return false;
-  *result = StringPiece(static_cast<const char*>(stream_alias), length);
-  stream->Skip(length);
-  return true;
-}
-
 bool ParseFeatureMapEntry(protobuf::io::CodedInputStream* stream,
                           parsed::FeatureMapEntry* feature_map_entry) {
   DCHECK(stream != nullptr);
@@ -405,19 +460,29 @@ void ParallelFor(const std::function<void(size_t)>& f, size_t n,
 
 enum class Type { Sparse, Dense };
 
+// Sparse and variable length dense features are parsed in two passes. The
+// first one checks and counts the values of each example, so that the outputs
+// can be allocated with their final size, and the second one parses the values
+// straight into the outputs.
 struct SparseBuffer {
-  // Features are in one of the 3 vectors below depending on config's dtype.
-  // Other 2 vectors remain empty.
-  SmallVector<string> bytes_list;
-  SmallVector<float> float_list;
-  SmallVector<int64> int64_list;
+  // The feature of each example, with its data type already parsed. Examples
+  // that don't have the feature get an empty one.
+  std::vector<parsed::Feature> features;
 
   // Features of example i are elements with indices
-  // from example_end_indices[i-1] to example_end_indices[i]-1 on the
-  // appropriate xxxxx_list
+  // from example_end_indices[i-1] to example_end_indices[i]-1 in the output.
   std::vector<size_t> example_end_indices;
 };
 
+// Scratch space shared by the examples of a minibatch, so that parsing an
+// example doesn't allocate once the buffers have grown.
+struct MiniBatchScratch {
+  parsed::Example parsed_example;
+  // Index of the last example each feature was found in.
+  std::vector<int64> sparse_feature_last_example;
+  std::vector<int64> dense_feature_last_example;
+};
+
 struct SeededHasher {
   uint64 operator()(StringPiece s) const {
     return Hash64(s.data(), s.size(), seed);
@@ -447,22 +512,48 @@ class LimitedArraySlice {
   T* end_;
 };
 
+// Checks that 'feature' parses as a list of 'dtype' and counts its values.
+bool CountValues(parsed::Feature feature, DataType dtype, size_t* num_values) {
+  ValueCounter counter;
+  switch (dtype) {
+    case DT_INT64:
+      if (!feature.ParseInt64List(&counter)) return false;
+      break;
+    case DT_FLOAT:
+      if (!feature.ParseFloatList(&counter)) return false;
+      break;
+    case DT_STRING:
+      if (!feature.ParseBytesList(&counter)) return false;
+      break;
+    default:
+      CHECK(false) << "Should not happen.";
+  }
+  *num_values = counter.size();
+  return true;
+}
+
 Status FastParseSerializedExample(
     const string& serialized_example, const string& example_name,
     const size_t example_index, const Config& config,
     const PresizedCuckooMap<std::pair<size_t, Type>>& config_index,
-    SeededHasher hasher, std::vector<Tensor>* output_dense,
+    SeededHasher hasher, MiniBatchScratch* scratch,
+    std::vector<Tensor>* output_dense,
     std::vector<SparseBuffer>* output_varlen_dense,
     std::vector<SparseBuffer>* output_sparse) {
+  DCHECK(scratch != nullptr);
   DCHECK(output_dense != nullptr);
   DCHECK(output_sparse != nullptr);
-  parsed::Example parsed_example;
+  parsed::Example& parsed_example = scratch->parsed_example;
+  parsed_example.clear();
   if (!ParseExample(serialized_example, &parsed_example)) {
     return errors::InvalidArgument("Could not parse example input, value: '",
                                    serialized_example, "'");
   }
-  std::vector<int64> sparse_feature_last_example(config.sparse.size(), -1);
-  std::vector<int64> dense_feature_last_example(config.dense.size(), -1);
+  // Entries of other examples of the minibatch never match example_index.
+  std::vector<int64>& sparse_feature_last_example =
+      scratch->sparse_feature_last_example;
+  std::vector<int64>& dense_feature_last_example =
+      scratch->dense_feature_last_example;
 
   // Handle features present in the example.
   const size_t parsed_example_size = parsed_example.size();
@@ -594,46 +685,23 @@ Status FastParseSerializedExample(
               config.dense[d].shape.DebugString()));
         };
 
-        switch (config.dense[d].dtype) {
-          case DT_INT64: {
-            if (example_dtype != DT_INVALID) {
-              if (!feature.ParseInt64List(&out.int64_list)) {
-                return parse_error();
-              }
-              if (out.int64_list.size() % num_elements != 0) {
-                return shape_error(out.int64_list.size(), "int64");
-              }
-            }
-            out.example_end_indices.push_back(out.int64_list.size());
-            break;
-          }
-          case DT_FLOAT: {
-            if (example_dtype != DT_INVALID) {
-              if (!feature.ParseFloatList(&out.float_list)) {
-                return parse_error();
-              }
-              if (out.float_list.size() % num_elements != 0) {
-                return shape_error(out.float_list.size(), "float");
-              }
-            }
-            out.example_end_indices.push_back(out.float_list.size());
-            break;
-          }
-          case DT_STRING: {
-            if (example_dtype != DT_INVALID) {
-              if (!feature.ParseBytesList(&out.bytes_list)) {
-                return parse_error();
-              }
-              if (out.bytes_list.size() % num_elements != 0) {
-                return shape_error(out.bytes_list.size(), "bytes");
-              }
-            }
-            out.example_end_indices.push_back(out.bytes_list.size());
-            break;
-          }
-          default:
-            CHECK(false) << "Should not happen.";
+        size_t num_values = 0;
+        if (example_dtype != DT_INVALID &&
+            !CountValues(feature, config.dense[d].dtype, &num_values)) {
+          return parse_error();
+        }
+        const size_t end_index =
+            (out.example_end_indices.empty() ? 0
+                                             : out.example_end_indices.back()) +
+            num_values;
+        if (end_index % num_elements != 0) {
+          return shape_error(end_index,
+                             config.dense[d].dtype == DT_STRING
+                                 ? "bytes"
+                                 : DataTypeString(config.dense[d].dtype));
         }
+        out.features.push_back(feature);
+        out.example_end_indices.push_back(end_index);
       }
     } else {
       // If feature was already visited, skip.
@@ -660,37 +728,16 @@ Status FastParseSerializedExample(
             "Expected type: ", DataTypeString(config.sparse[d].dtype)));
       }
 
-      switch (config.sparse[d].dtype) {
-        case DT_INT64: {
-          if (example_dtype != DT_INVALID) {
-            if (!feature.ParseInt64List(&out.int64_list)) {
-              return parse_error();
-            }
-          }
-          out.example_end_indices.push_back(out.int64_list.size());
-          break;
-        }
-        case DT_FLOAT: {
-          if (example_dtype != DT_INVALID) {
-            if (!feature.ParseFloatList(&out.float_list)) {
-              return parse_error();
-            }
-          }
-          out.example_end_indices.push_back(out.float_list.size());
-          break;
-        }
-        case DT_STRING: {
-          if (example_dtype != DT_INVALID) {
-            if (!feature.ParseBytesList(&out.bytes_list)) {
-              return parse_error();
-            }
-          }
-          out.example_end_indices.push_back(out.bytes_list.size());
-          break;
-        }
-        default:
-          CHECK(false) << "Should not happen.";
+      size_t num_values = 0;
+      if (example_dtype != DT_INVALID &&
+          !CountValues(feature, config.sparse[d].dtype, &num_values)) {
+        return parse_error();
       }
+      out.features.push_back(feature);
+      out.example_end_indices.push_back(
+          (out.example_end_indices.empty() ? 0
+                                           : out.example_end_indices.back()) +
+          num_values);
     }
   }
 
@@ -737,6 +784,7 @@ Status FastParseSerializedExample(
     SparseBuffer& out = (*output_varlen_dense)[d];
     size_t prev_example_end_index =
         out.example_end_indices.empty() ? 0 : out.example_end_indices.back();
+    out.features.emplace_back();
     out.example_end_indices.push_back(prev_example_end_index);
   }
 
@@ -746,6 +794,7 @@ Status FastParseSerializedExample(
     SparseBuffer& out = (*output_sparse)[d];
     size_t prev_example_end_index =
         out.example_end_indices.empty() ? 0 : out.example_end_indices.back();
+    out.features.emplace_back();
     out.example_end_indices.push_back(prev_example_end_index);
   }
 
@@ -764,72 +813,55 @@ Status CheckConfigDataType(DataType dtype) {
   }
 }
 
-template <typename T>
-const SmallVector<T>& GetListFromBuffer(const SparseBuffer& buffer);
-
-template <>
-const SmallVector<int64>& GetListFromBuffer<int64>(const SparseBuffer& buffer) {
-  return buffer.int64_list;
+bool ParseValues(parsed::Feature* feature, LimitedArraySlice<int64>* values) {
+  return feature->ParseInt64List(values);
 }
-template <>
-const SmallVector<float>& GetListFromBuffer<float>(const SparseBuffer& buffer) {
-  return buffer.float_list;
+bool ParseValues(parsed::Feature* feature, LimitedArraySlice<float>* values) {
+  return feature->ParseFloatList(values);
 }
-template <>
-const SmallVector<string>& GetListFromBuffer<string>(
-    const SparseBuffer& buffer) {
-  return buffer.bytes_list;
+bool ParseValues(parsed::Feature* feature, LimitedArraySlice<string>* values) {
+  return feature->ParseBytesList(values);
 }
 
+// Parses the 'num_values' values of 'feature', which were counted by the
+// first pass, into 'values'.
 template <typename T>
-void CopyOrMoveBlock(const T* b, const T* e, T* t) {
-  std::copy(b, e, t);
+void ParseCountedValues(parsed::Feature feature, const size_t num_values,
+                        T* values) {
+  if (num_values == 0) return;
+  LimitedArraySlice<T> slice(values, num_values);
+  const bool parsed = ParseValues(&feature, &slice);
+  DCHECK(parsed);
+  DCHECK_EQ(slice.EndDistance(), 0);
 }
-template <>
-void CopyOrMoveBlock(const string* b, const string* e, string* t) {
-  std::move(b, e, t);
+
+// Parses the values of all the examples in 'buffer' one after the other.
+template <typename T>
+void CopySparseValues(const SparseBuffer& buffer, T* values) {
+  size_t start = 0;
+  for (size_t j = 0; j < buffer.features.size(); ++j) {
+    const size_t end = buffer.example_end_indices[j];
+    ParseCountedValues(buffer.features[j], end - start, values + start);
+    start = end;
+  }
 }
 
+// Parses the values of each example in 'buffer' into a row of
+// 'num_elements_per_example' elements, and pads the rest of the row with the
+// default value.
 template <typename T>
-void FillAndCopyVarLen(
-    const int d, const size_t num_elements,
-    const size_t num_elements_per_minibatch, const Config& config,
-    const std::vector<std::vector<SparseBuffer>>& varlen_dense_buffers,
-    Tensor* values) {
-  const Tensor& default_value = config.dense[d].default_value;
-
-  // Copy-fill the tensors (creating the zero/fill-padding)
-  std::fill(values->flat<T>().data(), values->flat<T>().data() + num_elements,
-            default_value.flat<T>()(0));
-
-  // Data is [batch_size, max_num_elements, data_stride_size]
-  //   and num_elements_per_minibatch = max_num_elements * data_stride_size
-  auto data = values->flat<T>().data();
-
-  // Iterate over minibatch elements
-  for (size_t i = 0; i < varlen_dense_buffers.size(); ++i) {
-    const SparseBuffer& buffer = varlen_dense_buffers[i][d];
-    // Number of examples being stored in this buffer
-    const auto& end_indices = buffer.example_end_indices;
-    const size_t examples_in_buffer = end_indices.size();
-    // const size_t stride_size = config.dense[d].elements_per_stride;
-
-    const auto& list = GetListFromBuffer<T>(buffer);
-    auto list_ptr = list.begin();
-
-    size_t elements_tally = 0;
-    // Iterate through all the examples stored in this buffer.
-    for (size_t j = 0; j < examples_in_buffer; ++j) {
-      // Number of elements stored for this example.
-      const size_t num_elems = end_indices[j] - elements_tally;
-      CopyOrMoveBlock(list_ptr, list_ptr + num_elems, data);
-      // Move forward this many elements in the varlen buffer.
-      list_ptr += num_elems;
-      // Move forward to the next minibatch entry in the values output.
-      data += num_elements_per_minibatch;
-      elements_tally = end_indices[j];
-    }
-    DCHECK(elements_tally == list.size());
+void FillAndCopyVarLen(const int d, const size_t num_elements_per_example,
+                       const Config& config, const SparseBuffer& buffer,
+                       T* values) {
+  const T& default_value = config.dense[d].default_value.flat<T>()(0);
+  size_t start = 0;
+  for (size_t j = 0; j < buffer.features.size(); ++j) {
+    const size_t end = buffer.example_end_indices[j];
+    ParseCountedValues(buffer.features[j], end - start, values);
+    std::fill(values + (end - start), values + num_elements_per_example,
+              default_value);
+    values += num_elements_per_example;
+    start = end;
   }
 }
 
@@ -928,15 +960,28 @@ Status FastParseExample(const Config& config,
   std::vector<std::vector<SparseBuffer>> varlen_dense_buffers(num_minibatches);
   std::vector<Status> status_of_minibatch(num_minibatches);
   auto ProcessMiniBatch = [&](size_t minibatch) {
-    sparse_buffers[minibatch].resize(config.sparse.size());
-    varlen_dense_buffers[minibatch].resize(config.dense.size());
     size_t start = first_example_of_minibatch(minibatch);
     size_t end = first_example_of_minibatch(minibatch + 1);
+    sparse_buffers[minibatch].resize(config.sparse.size());
+    for (SparseBuffer& buffer : sparse_buffers[minibatch]) {
+      buffer.features.reserve(end - start);
+      buffer.example_end_indices.reserve(end - start);
+    }
+    varlen_dense_buffers[minibatch].resize(config.dense.size());
+    for (size_t d = 0; d < config.dense.size(); ++d) {
+      if (!config.dense[d].variable_length) continue;
+      SparseBuffer& buffer = varlen_dense_buffers[minibatch][d];
+      buffer.features.reserve(end - start);
+      buffer.example_end_indices.reserve(end - start);
+    }
+    MiniBatchScratch scratch;
+    scratch.sparse_feature_last_example.resize(config.sparse.size(), -1);
+    scratch.dense_feature_last_example.resize(config.dense.size(), -1);
     for (size_t e = start; e < end; ++e) {
       status_of_minibatch[minibatch] = FastParseSerializedExample(
           serialized[e],
           (!example_names.empty() ? example_names[e] : "<unknown>"), e, config,
-          config_index, hasher, &fixed_dense_values,
+          config_index, hasher, &scratch, &fixed_dense_values,
           &varlen_dense_buffers[minibatch], &sparse_buffers[minibatch]);
       if (!status_of_minibatch[minibatch].ok()) break;
     }
@@ -952,14 +997,19 @@ Status FastParseExample(const Config& config,
     result->dense_values.push_back(std::move(fixed_dense_values[d]));
   }
 
-  // Merge SparseBuffers from all minibatches for every config.sparse.
-  auto MergeSparseMinibatches = [&](size_t d) {
+  // Allocate the outputs of every config.sparse, now that the first pass has
+  // counted their values.
+  // Offset in the outputs of sparse feature d of the first example of each
+  // minibatch.
+  std::vector<std::vector<size_t>> sparse_offsets(config.sparse.size());
+  auto AllocateSparse = [&](size_t d) {
     // Loop over minibatches
     size_t total_num_features = 0;
     size_t max_num_features = 0;
     for (auto& sparse_values_tmp : sparse_buffers) {
       const std::vector<size_t>& end_indices =
           sparse_values_tmp[d].example_end_indices;
+      sparse_offsets[d].push_back(total_num_features);
       total_num_features += end_indices.back();
       max_num_features = std::max(max_num_features, end_indices[0]);
       for (size_t i = 1; i < end_indices.size(); ++i) {
@@ -972,67 +1022,21 @@ Status FastParseExample(const Config& config,
     indices_shape.AddDim(total_num_features);
     indices_shape.AddDim(2);
     result->sparse_indices.emplace_back(DT_INT64, indices_shape);
-    Tensor* indices = &result->sparse_indices.back();
 
     TensorShape values_shape;
     values_shape.AddDim(total_num_features);
     result->sparse_values.emplace_back(config.sparse[d].dtype, values_shape);
-    Tensor* values = &result->sparse_values.back();
 
     result->sparse_shapes.emplace_back(DT_INT64, TensorShape({2}));
     auto shapes_shape_t = result->sparse_shapes.back().vec<int64>();
     shapes_shape_t(0) = serialized.size();
     shapes_shape_t(1) = max_num_features;
-
-    size_t offset = 0;
-    for (size_t i = 0; i < sparse_buffers.size(); ++i) {
-      const SparseBuffer& buffer = sparse_buffers[i][d];
-
-      // Update indices.
-      int64* ix_p = &indices->matrix<int64>()(offset, 0);
-      size_t delta = 0;
-      size_t example_index = first_example_of_minibatch(i);
-      for (size_t example_end_index : buffer.example_end_indices) {
-        size_t feature_index = 0;
-        for (; delta < example_end_index; ++delta) {
-          // Column 0: example index
-          *ix_p = example_index;
-          // Column 1: the feature index buffer example
-          *(ix_p + 1) = feature_index;
-          ix_p += 2;
-          ++feature_index;
-        }
-        ++example_index;
-      }
-
-      // Copy values over.
-      switch (config.sparse[d].dtype) {
-        case DT_INT64: {
-          std::copy(buffer.int64_list.begin(), buffer.int64_list.end(),
-                    values->flat<int64>().data() + offset);
-          break;
-        }
-        case DT_FLOAT: {
-          std::copy(buffer.float_list.begin(), buffer.float_list.end(),
-                    values->flat<float>().data() + offset);
-          break;
-        }
-        case DT_STRING: {
-          std::move(buffer.bytes_list.begin(), buffer.bytes_list.end(),
-                    values->flat<string>().data() + offset);
-          break;
-        }
-        default:
-          CHECK(false) << "Should not happen.";
-      }
-
-      offset += delta;
-    }
   };
 
-  // Merge SparseBuffers from all minibatches for every config.dense having
-  // variable_length.
-  auto MergeDenseVarLenMinibatches = [&](size_t d) {
+  // Allocate the outputs of every config.dense having variable_length.
+  // Number of elements of the output of dense feature d for each example.
+  std::vector<size_t> varlen_dense_elements_per_example(config.dense.size());
+  auto AllocateDenseVarLen = [&](size_t d) {
     if (!config.dense[d].variable_length) return;
 
     // Loop over minibatches
@@ -1057,43 +1061,97 @@ Status FastParseExample(const Config& config,
     for (int i = 1; i < config.dense[d].shape.dims(); ++i) {
       values_shape.AddDim(config.dense[d].shape.dim_size(i));
     }
-    Tensor values(config.dense[d].dtype, values_shape);
-    result->dense_values[d] = values;
-    const size_t num_elements = values.NumElements();
+    result->dense_values[d] = Tensor(config.dense[d].dtype, values_shape);
+    const size_t num_elements = result->dense_values[d].NumElements();
+    varlen_dense_elements_per_example[d] =
+        batch_size == 0 ? 0 : num_elements / batch_size;
+  };
 
-    // Nothing to write, exit early.
-    if (num_elements == 0) return;
+  for (size_t d = 0; d < config.dense.size(); ++d) {
+    AllocateDenseVarLen(d);
+  }
 
-    const size_t num_elements_per_minibatch = num_elements / batch_size;
+  for (size_t d = 0; d < config.sparse.size(); ++d) {
+    AllocateSparse(d);
+  }
 
-    switch (config.dense[d].dtype) {
-      case DT_INT64: {
-        FillAndCopyVarLen<int64>(d, num_elements, num_elements_per_minibatch,
-                                 config, varlen_dense_buffers, &values);
-        break;
+  // Second pass: parse the values of every minibatch straight into the
+  // outputs, in parallel.
+  auto FillMiniBatch = [&](size_t minibatch) {
+    const size_t first_example = first_example_of_minibatch(minibatch);
+
+    for (size_t d = 0; d < config.dense.size(); ++d) {
+      const size_t num_elements_per_example =
+          varlen_dense_elements_per_example[d];
+      // Nothing to write for fixed length features, or empty outputs.
+      if (num_elements_per_example == 0) continue;
+      const SparseBuffer& buffer = varlen_dense_buffers[minibatch][d];
+      Tensor& values = result->dense_values[d];
+      const size_t offset = first_example * num_elements_per_example;
+      switch (config.dense[d].dtype) {
+        case DT_INT64: {
+          FillAndCopyVarLen(d, num_elements_per_example, config, buffer,
+                            values.flat<int64>().data() + offset);
+          break;
+        }
+        case DT_FLOAT: {
+          FillAndCopyVarLen(d, num_elements_per_example, config, buffer,
+                            values.flat<float>().data() + offset);
+          break;
+        }
+        case DT_STRING: {
+          FillAndCopyVarLen(d, num_elements_per_example, config, buffer,
+                            values.flat<string>().data() + offset);
+          break;
+        }
+        default:
+          CHECK(false) << "Should not happen.";
       }
-      case DT_FLOAT: {
-        FillAndCopyVarLen<float>(d, num_elements, num_elements_per_minibatch,
-                                 config, varlen_dense_buffers, &values);
-        break;
+    }
+
+    for (size_t d = 0; d < config.sparse.size(); ++d) {
+      const SparseBuffer& buffer = sparse_buffers[minibatch][d];
+      const size_t offset = sparse_offsets[d][minibatch];
+
+      // Update indices.
+      int64* ix_p = result->sparse_indices[d].flat<int64>().data() + 2 * offset;
+      size_t delta = 0;
+      size_t example_index = first_example;
+      for (size_t example_end_index : buffer.example_end_indices) {
+        size_t feature_index = 0;
+        for (; delta < example_end_index; ++delta) {
+          // Column 0: example index
+          *ix_p = example_index;
+          // Column 1: the feature index buffer example
+          *(ix_p + 1) = feature_index;
+          ix_p += 2;
+          ++feature_index;
+        }
+        ++example_index;
       }
-      case DT_STRING: {
-        FillAndCopyVarLen<string>(d, num_elements, num_elements_per_minibatch,
-                                  config, varlen_dense_buffers, &values);
-        break;
+
+      // Parse values.
+      Tensor& values = result->sparse_values[d];
+      switch (config.sparse[d].dtype) {
+        case DT_INT64: {
+          CopySparseValues(buffer, values.flat<int64>().data() + offset);
+          break;
+        }
+        case DT_FLOAT: {
+          CopySparseValues(buffer, values.flat<float>().data() + offset);
+          break;
+        }
+        case DT_STRING: {
+          CopySparseValues(buffer, values.flat<string>().data() + offset);
+          break;
+        }
+        default:
+          CHECK(false) << "Should not happen.";
       }
-      default:
-        CHECK(false) << "Should not happen.";
     }
   };
 
-  for (size_t d = 0; d < config.dense.size(); ++d) {
-    MergeDenseVarLenMinibatches(d);
-  }
-
-  for (size_t d = 0; d < config.sparse.size(); ++d) {
-    MergeSparseMinibatches(d);
-  }
+  ParallelFor(FillMiniBatch, num_minibatches, thread_pool);
 
   return Status::OK();
 }
@@ -14,10 +14,16 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/util/example_proto_fast_parsing.h"
 
+#include <limits>
+
 #include "tensorflow/core/example/example.pb.h"
 #include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
@@ -166,6 +172,24 @@ TEST(FastParse, Packed) {
       "\x0a\x0d\x0a\x0b\x0a\x03\x61\x67\x65\x12\x04\x1a\x02\x08\x0d");
 }
 
+TEST(FastParse, PackedInt64OfMixedSizes) {
+  Example example;
+  Int64List* int64_list =
+      (*example.mutable_features()->mutable_feature())["int64_list"]
+          .mutable_int64_list();
+  // Runs of one byte values of various lengths, separated by longer values.
+  for (int run = 0; run < 20; ++run) {
+    for (int i = 0; i < run; ++i) {
+      int64_list->add_value(i * 7);
+    }
+    int64_list->add_value(128 << run);
+    int64_list->add_value(-run);
+  }
+  int64_list->add_value(std::numeric_limits<int64>::max());
+  int64_list->add_value(std::numeric_limits<int64>::min());
+  TestCorrectness(Serialize(example));
+}
+
 TEST(FastParse, EmptyFeatures) {
   Example example;
   example.mutable_features();
@@ -372,6 +396,74 @@ TEST(TestFastParseExample, Empty) {
   EXPECT_TRUE(status.ok()) << status;
 }
 
+TEST(TestFastParseExample, SparseAndVarLenDense) {
+  // Enough examples for several minibatches.
+  const int kNumExamples = 100;
+  std::vector<string> serialized(kNumExamples);
+  for (int i = 0; i < kNumExamples; ++i) {
+    Example example;
+    auto& fmap = *example.mutable_features()->mutable_feature();
+    for (int j = 0; j < i % 4; ++j) {
+      fmap[kSparseInt64Key].mutable_int64_list()->add_value(1000 * i + j);
+      fmap[kSparseStringKey].mutable_bytes_list()->add_value(
+          strings::StrCat("s", i, "_", j));
+    }
+    if (i % 3 != 0) {
+      for (int j = 0; j < 2 * (i % 3); ++j) {
+        fmap[kDenseFloatKey].mutable_float_list()->add_value(i + j / 10.0f);
+      }
+    }
+    serialized[i] = Serialize(example);
+  }
+
+  FastParseExampleConfig config;
+  config.sparse.push_back({kSparseInt64Key, DT_INT64});
+  config.sparse.push_back({kSparseStringKey, DT_STRING});
+  Tensor default_value(DT_FLOAT, TensorShape({}));
+  default_value.scalar<float>()() = -1;
+  config.dense.push_back({kDenseFloatKey, DT_FLOAT,
+                          PartialTensorShape({-1, 2}), default_value, true, 2});
+
+  Result result;
+  thread::ThreadPool thread_pool(Env::Default(), "test", 4);
+  TF_ASSERT_OK(FastParseExample(config, serialized, gtl::ArraySlice<string>(),
+                                &thread_pool, &result));
+
+  // Sparse features: example i has i % 4 values.
+  const int kNumSparse = 150;
+  ASSERT_EQ(kNumSparse, result.sparse_values[0].NumElements());
+  ASSERT_EQ(kNumSparse, result.sparse_values[1].NumElements());
+  EXPECT_EQ(kNumExamples, result.sparse_shapes[0].vec<int64>()(0));
+  EXPECT_EQ(3, result.sparse_shapes[0].vec<int64>()(1));
+  auto indices = result.sparse_indices[0].matrix<int64>();
+  auto int64_values = result.sparse_values[0].vec<int64>();
+  auto string_values = result.sparse_values[1].vec<string>();
+  int k = 0;
+  for (int i = 0; i < kNumExamples; ++i) {
+    for (int j = 0; j < i % 4; ++j, ++k) {
+      EXPECT_EQ(i, indices(k, 0));
+      EXPECT_EQ(j, indices(k, 1));
+      EXPECT_EQ(1000 * i + j, int64_values(k));
+      EXPECT_EQ(strings::StrCat("s", i, "_", j), string_values(k));
+    }
+  }
+  test::ExpectTensorEqual<int64>(result.sparse_indices[0],
+                                 result.sparse_indices[1]);
+
+  // Variable length dense feature: example i has i % 3 rows of 2 values,
+  // padded to 2 rows.
+  const Tensor& dense = result.dense_values[0];
+  ASSERT_EQ(TensorShape({kNumExamples, 2, 2}).DebugString(),
+            dense.shape().DebugString());
+  auto dense_values = dense.tensor<float, 3>();
+  for (int i = 0; i < kNumExamples; ++i) {
+    for (int j = 0; j < 4; ++j) {
+      const float expected = j < 2 * (i % 3) ? i + j / 10.0f : -1;
+      EXPECT_EQ(expected, dense_values(i, j / 2, j % 2));
+    }
+  }
+}
+
 }  // namespace
 
 }  // namespace example
@@ -15,10 +15,13 @@ limitations under the License.
 
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
+#include <string.h>
 #include <algorithm>
 #include <memory>
 #include <utility>
 
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor_shape.pb_text.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
@@ -256,6 +259,32 @@ Status CorruptFileError(const Status& in_status, const string& filename,
                       detail, "): ", in_status.error_message()));
 }
 
+// A read-only TensorBuffer that points into a memory-mapped data file.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(std::shared_ptr<ReadOnlyMemoryRegion> region,
+                     const char* data, size_t size)
+      : region_(std::move(region)), data_(data), size_(size) {}
+
+  void* data() const override { return const_cast<char*>(data_); }
+  size_t size() const override { return size_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocated_bytes(size_);
+    proto->set_allocator_name("BundleReaderMmap");
+  }
+
+  // The mapping is read-only, so kernels must never forward this buffer to
+  // an output that they write in place.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  const char* const data_;
+  const size_t size_;
+};
+
 table::Options TableBuilderOptions() {
   table::Options o;
   // Compressed tables cannot be read by TensorFlow releases prior to 1.1.
@@ -268,8 +297,10 @@ table::Options TableBuilderOptions() {
 
 }  // namespace
 
-BundleWriter::BundleWriter(Env* env, StringPiece prefix)
+BundleWriter::BundleWriter(Env* env, StringPiece prefix,
+                           const Options& options)
     : env_(env),
+      options_(options),
       prefix_(prefix.ToString()),
       tmp_metadata_path_(strings::StrCat(MetaFilename(prefix_), ".tempstate",
                                          random::New64())),
@@ -300,6 +331,18 @@ Status BundleWriter::Add(StringPiece key, const Tensor& val) {
     return status_;
   }
 
+  // Pads the data file so that numeric tensors start at an aligned offset.
+  if (options_.data_alignment > 1 && DataTypeCanUseMemcpy(val.dtype())) {
+    const int64 padding =
+        (options_.data_alignment - size_ % options_.data_alignment) %
+        options_.data_alignment;
+    if (padding > 0) {
+      status_ = out_->Append(string(padding, '\0'));
+      if (!status_.ok()) return status_;
+      size_ += padding;
+    }
+  }
+
   BundleEntryProto* entry = &entries_[key_string];
   entry->set_dtype(val.dtype());
   val.shape().AsProto(entry->mutable_shape());
@@ -592,9 +635,11 @@ Status MergeBundles(Env* env, gtl::ArraySlice<string> prefixes,
 
 // Interface for reading a tensor bundle.
 
-BundleReader::BundleReader(Env* env, StringPiece prefix)
+BundleReader::BundleReader(Env* env, StringPiece prefix,
+                           const Options& options)
     : env_(env),
       prefix_(prefix.ToString()),
+      options_(options),
       metadata_(nullptr),
       table_(nullptr),
       iter_(nullptr) {
@@ -672,9 +717,38 @@ Status BundleReader::GetBundleEntryProto(StringPiece key,
   return Status::OK();
 }
 
+Status BundleReader::GetDataFile(int32 shard_id,
+                                 io::InputBuffer** buffered_file) {
+  // Open the data file if it has not been opened.
+  *buffered_file = data_[shard_id];
+  if (*buffered_file == nullptr) {
+    std::unique_ptr<RandomAccessFile> file = nullptr;
+    TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(
+        DataFilename(prefix_, shard_id, num_shards_), &file));
+    *buffered_file =
+        new io::InputBuffer(file.release(), 256 << 10 /* 256KB buffer */);
+    // The InputBuffer and RandomAccessFile objects are both released in dtor.
+    data_[shard_id] = *buffered_file;
+  }
+  return Status::OK();
+}
+
 Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
-  Tensor* ret = val;
   const TensorShape stored_shape(TensorShape(entry.shape()));
+  if (options_.use_mmap && DataTypeCanUseMemcpy(entry.dtype())) {
+    // Checked before anything is allocated, since an aligned tensor is served
+    // straight from the mapping.
+    const int64 stored_bytes =
+        stored_shape.num_elements() * DataTypeSize(entry.dtype());
+    if (entry.size() != stored_bytes) {
+      return errors::DataLoss("Invalid size in bundle entry: key ", key(),
+                              "; stored size ", entry.size(),
+                              "; expected size ", stored_bytes);
+    }
+    return GetMappedValue(entry, stored_shape, val);
+  }
+
+  Tensor* ret = val;
   if (val->NumElements() == 0) {
     ret = new Tensor(entry.dtype(), stored_shape);
   }
@@ -701,18 +775,8 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
     }
   }
 
-  // Open the data file if it has not been opened.
-  io::InputBuffer* buffered_file = data_[entry.shard_id()];
-  if (buffered_file == nullptr) {
-    std::unique_ptr<RandomAccessFile> file = nullptr;
-    TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(
-        DataFilename(prefix_, entry.shard_id(), num_shards_), &file));
-    buffered_file =
-        new io::InputBuffer(file.release(), 256 << 10 /* 256KB buffer */);
-    // The InputBuffer and RandomAccessFile objects are both released in dtor.
-    data_[entry.shard_id()] = buffered_file;
-  }
-  CHECK(buffered_file != nullptr);
+  io::InputBuffer* buffered_file;
+  TF_RETURN_IF_ERROR(GetDataFile(entry.shard_id(), &buffered_file));
 
   TF_RETURN_IF_ERROR(buffered_file->Seek(entry.offset()));
   uint32 actual_crc32c = 0;
@@ -744,6 +808,58 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
   return Status::OK();
 }
 
+Status BundleReader::GetMappedValue(const BundleEntryProto& entry,
+                                    const TensorShape& stored_shape,
+                                    Tensor* val) {
+  std::shared_ptr<ReadOnlyMemoryRegion>& region =
+      mapped_data_[entry.shard_id()];
+  if (region == nullptr) {
+    const string filename =
+        DataFilename(prefix_, entry.shard_id(), num_shards_);
+    std::unique_ptr<ReadOnlyMemoryRegion> new_region;
+    const Status s =
+        env_->NewReadOnlyMemoryRegionFromFile(filename, &new_region);
+    if (!s.ok()) {
+      // Not every file system can map files; read them instead.
+      LOG(WARNING) << "Unable to memory-map " << filename << ": " << s
+                   << ". Falling back to reading the bundle.";
+      mapped_data_.erase(entry.shard_id());
+      options_.use_mmap = false;
+      return GetValue(entry, val);
+    }
+    region.reset(new_region.release());
+  }
+
+  if (entry.offset() + entry.size() > region->length()) {
+    return errors::DataLoss("Data file for shard ", entry.shard_id(),
+                            " of bundle ", prefix_, " has length ",
+                            region->length(), ", but tensor ", key(),
+                            " ends at ", entry.offset() + entry.size());
+  }
+  const char* data = static_cast<const char*>(region->data()) + entry.offset();
+  const uint32 actual_crc32c = crc32c::Value(data, entry.size());
+  if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+    return errors::DataLoss(
+        "Checksum does not match: stored ",
+        strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+        " vs. calculated on the restored bytes ", actual_crc32c);
+  }
+
+  if (entry.size() > 0 &&
+      reinterpret_cast<uintptr_t>(data) % Allocator::kAllocatorAlignment == 0) {
+    // Aliases the mapping.  The buffer keeps the region alive.
+    MappedTensorBuffer* buf =
+        new MappedTensorBuffer(region, data, entry.size());
+    *val = Tensor(entry.dtype(), stored_shape, buf);
+    buf->Unref();
+  } else {
+    // Tensors must be aligned, so unaligned data is copied.
+    if (val->NumElements() == 0) *val = Tensor(entry.dtype(), stored_shape);
+    memcpy(const_cast<char*>(val->tensor_data().data()), data, entry.size());
+  }
+  return Status::OK();
+}
+
 Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
@@ -758,6 +874,47 @@ Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   }
 }
 
+Status BundleReader::ReadTensorBytes(StringPiece key, uint64 offset,
+                                     uint64 size, char* destination) {
+  BundleEntryProto entry;
+  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+  if (!entry.slices().empty() || !DataTypeCanUseMemcpy(entry.dtype())) {
+    return errors::InvalidArgument(
+        "Cannot read the bytes of ", key, ", which has dtype ",
+        DataTypeString(entry.dtype()), " and ", entry.slices_size(),
+        " slices.");
+  }
+  if (offset + size > entry.size()) {
+    return errors::InvalidArgument("Bytes [", offset, ", ", offset + size,
+                                   ") are out of range for ", key,
+                                   ", which has ", entry.size(), " bytes.");
+  }
+  io::InputBuffer* buffered_file;
+  TF_RETURN_IF_ERROR(GetDataFile(entry.shard_id(), &buffered_file));
+  return ReadInputByChunk(buffered_file->file(), entry.offset() + offset, size,
+                          8 << 20 /* 8MB buffer */, destination);
+}
+
+Status BundleReader::VerifyChecksum(StringPiece key, const Tensor& val) {
+  BundleEntryProto entry;
+  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+  if (!DataTypeCanUseMemcpy(entry.dtype()) ||
+      entry.size() != val.TotalBytes()) {
+    return errors::InvalidArgument("Cannot verify the checksum of ", key,
+                                   " against a tensor of ", val.TotalBytes(),
+                                   " bytes.");
+  }
+  const uint32 actual_crc32c =
+      crc32c::Value(val.tensor_data().data(), entry.size());
+  if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+    return errors::DataLoss(
+        "Checksum does not match: stored ",
+        strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+        " vs. calculated on the restored bytes ", actual_crc32c);
+  }
+  return Status::OK();
+}
+
 Status BundleReader::ReadCurrent(Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
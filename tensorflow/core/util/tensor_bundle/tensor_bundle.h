@@ -64,6 +64,7 @@ limitations under the License.
 #include "tensorflow/core/protobuf/tensor_bundle.pb.h"
 
 #include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -107,7 +108,16 @@ extern const char* const kHeaderEntryKey;
 // All threads accessing the same BundleWriter must synchronize.
 class BundleWriter {
  public:
-  BundleWriter(Env* env, StringPiece prefix);
+  struct Options {
+    Options() {}
+    // Alignment, in bytes, of the offset of each tensor in the data file.
+    // Tensors of numeric types are preceded by zero padding as needed.  An
+    // alignment of at least Allocator::kAllocatorAlignment lets a
+    // BundleReader in mmap mode serve them without copying.
+    int64 data_alignment = 1;
+  };
+  BundleWriter(Env* env, StringPiece prefix,
+               const Options& options = Options());
 
   // Adds the tensor "val" under key "key".
   // Across calls "key" must be unique but can be added in any order.
@@ -140,6 +150,7 @@ class BundleWriter {
 
  private:
   Env* const env_;  // Not owned.
+  const Options options_;
   const string prefix_;
   const string tmp_metadata_path_;
   const string tmp_data_path_;
@@ -173,7 +184,19 @@ Status MergeBundles(Env* env, gtl::ArraySlice<string> prefixes,
 // All threads accessing the same BundleReader must synchronize.
 class BundleReader {
  public:
-  BundleReader(Env* const env, StringPiece prefix);
+  struct Options {
+    Options() {}
+    // If true, the data files are memory-mapped on first use instead of being
+    // read into freshly allocated buffers.  Lookups of numeric tensors whose
+    // data is suitably aligned in the file (see
+    // BundleWriter::Options::data_alignment) then return tensors that point
+    // directly into the read-only mapping, which stays alive as long as any
+    // such tensor does; other tensors are copied out of the mapping.  Falls
+    // back to regular reads if the file system does not support mapping.
+    bool use_mmap = false;
+  };
+  BundleReader(Env* const env, StringPiece prefix,
+               const Options& options = Options());
   ~BundleReader();
 
   // Is ok() iff the reader construction is successful (completed the read of
@@ -202,6 +225,9 @@ class BundleReader {
   // Caller must make sure "val" has the same shape and dtype as the
   // corresponding contents, so that its buffer can be filled without needing
   // extra allocation.  These can be queried via "LookupDtypeAndShape()".
+  // In mmap mode, an unpartitioned numeric tensor may instead be looked up
+  // into an empty "val" (e.g. a default-constructed Tensor): "val" then
+  // aliases the mapping if the data is aligned, so nothing is allocated.
   //
   // On error, "val" may contain nonsense data.  Returns a NotFound error if
   // tensor keyed by "key" does not exist in this bundle.
@@ -210,6 +236,22 @@ class BundleReader {
   // REQUIRES: status().ok()
   Status Lookup(StringPiece key, Tensor* val) TF_MUST_USE_RESULT;
 
+  // Reads bytes [offset, offset + size) of the stored value of the tensor
+  // keyed by "key" into "destination".  The tensor must not be partitioned,
+  // and its dtype must satisfy DataTypeCanUseMemcpy().  This lets a large
+  // tensor be read in pieces, e.g. concurrently with one reader per thread.
+  //
+  // Does not validate the checksum, which covers the whole value: callers
+  // should call VerifyChecksum() once all of the pieces have been read.
+  // REQUIRES: status().ok()
+  Status ReadTensorBytes(StringPiece key, uint64 offset, uint64 size,
+                         char* destination) TF_MUST_USE_RESULT;
+
+  // Validates the stored crc32c checksum of the unpartitioned tensor keyed
+  // by "key" against the contents of "val".
+  // REQUIRES: status().ok()
+  Status VerifyChecksum(StringPiece key, const Tensor& val) TF_MUST_USE_RESULT;
+
   // Looks up the tensor pointed to by the internal iterator.
   //
   // On error, "val" may contain nonsense data.
@@ -261,11 +303,21 @@ class BundleReader {
   Status GetBundleEntryProto(StringPiece key,
                              BundleEntryProto* entry) TF_MUST_USE_RESULT;
 
+  // Opens the data file of shard "shard_id" if it has not been opened.
+  Status GetDataFile(int32 shard_id,
+                     io::InputBuffer** buffered_file) TF_MUST_USE_RESULT;
+
   // Reads the tensor value described by the metadata proto "entry".
   // Usage for "val" follows the comment of "Lookup()".
   Status GetValue(const BundleEntryProto& entry,
                   Tensor* val) TF_MUST_USE_RESULT;
 
+  // Implements GetValue() for a numeric tensor when the data files are
+  // memory-mapped.  "stored_shape" is the shape recorded in "entry".
+  Status GetMappedValue(const BundleEntryProto& entry,
+                        const TensorShape& stored_shape,
+                        Tensor* val) TF_MUST_USE_RESULT;
+
   // Reads the slice described by "slice_spec".  The corresponding full tensor
   // has key "ful_tensor_key" and metadata proto "full_tensor_entry".
   // REQUIRES: full_tensor_entry.slices_size() > 0
@@ -276,6 +328,7 @@ class BundleReader {
 
   Env* env_;  // Not owned.
   const string prefix_;
+  Options options_;
 
   Status status_;
   RandomAccessFile* metadata_;  // Owned.
@@ -283,6 +336,10 @@ class BundleReader {
   table::Iterator* iter_;
   // Owned the InputBuffer objects and their underlying RandomAccessFile's.
   std::unordered_map<int32, io::InputBuffer*> data_;
+  // The mapped data files in mmap mode.  Shared with the tensors that point
+  // into them.
+  std::unordered_map<int32, std::shared_ptr<ReadOnlyMemoryRegion>>
+      mapped_data_;
 
   // Maps each partitioned tensor's key to its stored slices (represented in a
   // TensorSliceSet).  Populated on-demand.
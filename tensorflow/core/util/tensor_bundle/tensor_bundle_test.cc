@@ -18,6 +18,7 @@ limitations under the License.
 #include <random>
 #include <vector>
 
+#include "tensorflow/core/framework/tensor_description.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/framework/versions.pb.h"
@@ -26,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/table_builder.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 
@@ -695,4 +697,139 @@ TEST(TensorBundleTest, VersionTest) {
   }
 }
 
+// Returns true iff "val" points into the mapping of an mmap-mode reader.
+bool IsMapped(const Tensor& val) {
+  TensorDescription description;
+  val.FillDescription(&description);
+  return description.allocation_description().allocator_name() ==
+         "BundleReaderMmap";
+}
+
+TEST(TensorBundleTest, MmapAlignedTensors) {
+  BundleWriter::Options writer_options;
+  writer_options.data_alignment = 64;
+  {
+    BundleWriter writer(Env::Default(), Prefix("mmap_aligned"),
+                        writer_options);
+    // 2x3 floats take 24 bytes, so without padding the second and third
+    // tensors would be unaligned.
+    TF_EXPECT_OK(writer.Add("a", Constant_2x3<float>(1.0)));
+    TF_EXPECT_OK(writer.Add("b", test::AsTensor<string>({"x", "yz"})));
+    TF_EXPECT_OK(writer.Add("c", Constant_2x3<int64>(3)));
+    TF_EXPECT_OK(writer.Add("d", Constant_2x3<double>(4.0)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader::Options reader_options;
+  reader_options.use_mmap = true;
+  Tensor d;
+  {
+    BundleReader reader(Env::Default(), Prefix("mmap_aligned"),
+                        reader_options);
+    TF_ASSERT_OK(reader.status());
+    Expect<float>(&reader, "a", Constant_2x3<float>(1.0));
+    Expect<string>(&reader, "b", test::AsTensor<string>({"x", "yz"}));
+    Expect<int64>(&reader, "c", Constant_2x3<int64>(3));
+
+    Tensor c(DT_INT64, TensorShape({2, 3}));
+    TF_ASSERT_OK(reader.Lookup("c", &c));
+    EXPECT_TRUE(IsMapped(c));
+    // An empty tensor is pointed at the mapping without being allocated, and
+    // every lookup aliases the same bytes.
+    Tensor c2;
+    TF_ASSERT_OK(reader.Lookup("c", &c2));
+    EXPECT_TRUE(IsMapped(c2));
+    EXPECT_EQ(c.tensor_data().data(), c2.tensor_data().data());
+    TF_ASSERT_OK(reader.Lookup("d", &d));
+  }
+  // The mapping outlives the reader.
+  EXPECT_TRUE(IsMapped(d));
+  test::ExpectTensorEqual<double>(Constant_2x3<double>(4.0), d);
+}
+
+TEST(TensorBundleTest, MmapUnalignedTensors) {
+  {
+    BundleWriter writer(Env::Default(), Prefix("mmap_unaligned"));
+    TF_EXPECT_OK(writer.Add("a", Constant_2x3<float>(1.0)));
+    TF_EXPECT_OK(writer.Add("b", Constant_2x3<float>(2.0)));
+    TF_EXPECT_OK(writer.Add("c", Constant(3, TensorShape({7}))));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader::Options reader_options;
+  reader_options.use_mmap = true;
+  BundleReader reader(Env::Default(), Prefix("mmap_unaligned"),
+                      reader_options);
+  TF_ASSERT_OK(reader.status());
+  // The tensors after the first one are unaligned, and are copied out of the
+  // mapping.
+  Expect<float>(&reader, "a", Constant_2x3<float>(1.0));
+  Expect<float>(&reader, "b", Constant_2x3<float>(2.0));
+  Expect<int>(&reader, "c", Constant(3, TensorShape({7})));
+  Tensor b(DT_FLOAT, TensorShape({2, 3}));
+  TF_ASSERT_OK(reader.Lookup("b", &b));
+  EXPECT_FALSE(IsMapped(b));
+  // An empty tensor is allocated for the copy.
+  Tensor c;
+  TF_ASSERT_OK(reader.Lookup("c", &c));
+  EXPECT_FALSE(IsMapped(c));
+  test::ExpectTensorEqual<int>(Constant(3, TensorShape({7})), c);
+}
+
+TEST(TensorBundleTest, MmapChecksum) {
+  {
+    BundleWriter writer(Env::Default(), Prefix("mmap_checksum"));
+    TF_EXPECT_OK(writer.Add("foo", Constant_2x3<float>(1.0)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  // Flips a byte of the data file.
+  const string data_path = DataFilename(Prefix("mmap_checksum"), 0, 1);
+  string data;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), data_path, &data));
+  data[0] ^= 1;
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), data_path, data));
+
+  BundleReader::Options reader_options;
+  reader_options.use_mmap = true;
+  BundleReader reader(Env::Default(), Prefix("mmap_checksum"), reader_options);
+  TF_ASSERT_OK(reader.status());
+  Tensor val(DT_FLOAT, TensorShape({2, 3}));
+  Status s = reader.Lookup("foo", &val);
+  EXPECT_TRUE(errors::IsDataLoss(s)) << s;
+  EXPECT_TRUE(
+      StringPiece(s.error_message()).contains("Checksum does not match"));
+}
+
+// Restores every tensor of a bundle of 'kNumTensors' 4MB tensors, as
+// RestoreV2 does at startup, with or without mmap mode.
+static void BM_RestoreLargeBundle(int iters, int use_mmap) {
+  testing::StopTiming();
+  const int kNumTensors = 64;
+  const TensorShape kShape({1024, 1024});
+  const string prefix = Prefix("bm_restore_large_bundle");
+  {
+    BundleWriter::Options writer_options;
+    writer_options.data_alignment = Allocator::kAllocatorAlignment;
+    BundleWriter writer(Env::Default(), prefix, writer_options);
+    for (int i = 0; i < kNumTensors; ++i) {
+      TF_CHECK_OK(writer.Add(strings::StrCat("v", i),
+                             Constant(static_cast<float>(i), kShape)));
+    }
+    TF_CHECK_OK(writer.Finish());
+  }
+  BundleReader::Options reader_options;
+  reader_options.use_mmap = use_mmap != 0;
+  testing::BytesProcessed(static_cast<int64>(iters) * kNumTensors *
+                          kShape.num_elements() * sizeof(float));
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    BundleReader reader(Env::Default(), prefix, reader_options);
+    TF_CHECK_OK(reader.status());
+    for (int j = 0; j < kNumTensors; ++j) {
+      Tensor val(DT_FLOAT, kShape);
+      TF_CHECK_OK(reader.Lookup(strings::StrCat("v", j), &val));
+    }
+  }
+  testing::StopTiming();
+}
+BENCHMARK(BM_RestoreLargeBundle)->Arg(0)->Arg(1);
+
 }  // namespace tensorflow
@@ -0,0 +1,77 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for Grappler ArithmeticOptimizer."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from tensorflow.core.protobuf import config_pb2
+from tensorflow.core.protobuf import rewriter_config_pb2
+from tensorflow.python.client import session
+from tensorflow.python.framework import constant_op
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import math_ops
+from tensorflow.python.platform import test
+
+
+def _run_and_get_executed_nodes(fetch, rewrite_options):
+  """Runs fetch and returns its value and the names of the executed nodes."""
+  # Turn off the classic graph optimizations, whose common subexpression
+  # elimination would hide the work of the arithmetic optimizer.
+  graph_options = config_pb2.GraphOptions(
+      optimizer_options=config_pb2.OptimizerOptions(
+          opt_level=config_pb2.OptimizerOptions.L0),
+      rewrite_options=rewrite_options)
+  config = config_pb2.ConfigProto(graph_options=graph_options)
+  with session.Session(config=config) as sess:
+    run_options = config_pb2.RunOptions(
+        trace_level=config_pb2.RunOptions.FULL_TRACE)
+    metadata = config_pb2.RunMetadata()
+    value = sess.run(fetch, options=run_options, run_metadata=metadata)
+  nodes = [
+      node.node_name
+      for dev_stats in metadata.step_stats.dev_stats
+      for node in dev_stats.node_stats
+  ]
+  return value, nodes
+
+
+class ArithmeticOptimizerTest(test.TestCase):
+  """Tests the Grappler arithmetic optimizer."""
+
+  def testDedupInSession(self):
+    with ops.Graph().as_default():
+      x = constant_op.constant([1.0, 2.0], name='x')
+      y = constant_op.constant([3.0, 4.0], name='y')
+      a = math_ops.add(x, y, name='a')
+      b = math_ops.add(x, y, name='b')
+      output = math_ops.multiply(a, b, name='output')
+
+      value_ref, nodes_ref = _run_and_get_executed_nodes(
+          output, rewriter_config_pb2.RewriterConfig())
+      self.assertIn('a', nodes_ref)
+      self.assertIn('b', nodes_ref)
+
+      value, nodes = _run_and_get_executed_nodes(
+          output,
+          rewriter_config_pb2.RewriterConfig(arithmetic_optimization=True))
+      # One of the two identical additions is removed.
+      self.assertEqual(1, len([n for n in nodes if n in ('a', 'b')]))
+      self.assertAllClose(value_ref, value)
+
+
+if __name__ == '__main__':
+  test.main()
@@ -719,6 +719,51 @@ class EmbeddingLookupSparseTest(test.TestCase):
             x, x_shape, y, y_shape, x_init_value=x_init_value)
       self.assertLess(err, 1e-5 if dtype == dtypes.float64 else 2e-3)
 
+  def testFusedEmbeddingLookupSparse(self):
+    vocab_size = 13
+    batch_size = 10
+    param_shape = [2, 5]
+    sp_ids, sp_weights, _, _, _ = (self._RandomIdsAndWeights(
+        batch_size, vocab_size))
+
+    for combiner, dtype, ignore_weights in itertools.product(
+        ["sum", "mean", "sqrtn"], [dtypes.float32, dtypes.float64],
+        [True, False]):
+      with self.test_session():
+        params = constant_op.constant(
+            np.random.rand(vocab_size, *param_shape), dtype=dtype)
+        weights = None if ignore_weights else sp_weights
+        fused = embedding_ops.fused_embedding_lookup_sparse(
+            params, sp_ids, weights, combiner=combiner)
+        expected = embedding_ops.embedding_lookup_sparse(
+            params, sp_ids, weights, combiner=combiner)
+        self.assertEqual(fused.get_shape().as_list(), [None] + param_shape)
+        self.assertAllClose(expected.eval(), fused.eval())
+
+  def testGradientsFusedEmbeddingLookupSparse(self):
+    vocab_size = 12
+    batch_size = 4
+    param_shape = [2, 3]
+    sp_ids, sp_weights, _, _, _ = (self._RandomIdsAndWeights(
+        batch_size, vocab_size))
+
+    for combiner, dtype, ignore_weights in itertools.product(
+        ["sum", "mean", "sqrtn"], [dtypes.float32, dtypes.float64],
+        [True, False]):
+      with self.test_session():
+        x_shape = [vocab_size] + param_shape
+        x_init_value = np.random.rand(*x_shape)
+        x = constant_op.constant(x_init_value, dtype=dtype)
+        y = embedding_ops.fused_embedding_lookup_sparse(
+            x,
+            sp_ids,
+            None if ignore_weights else sp_weights,
+            combiner=combiner)
+        y_shape = [batch_size] + param_shape
+        err = gradient_checker.compute_gradient_error(
+            x, x_shape, y, y_shape, x_init_value=x_init_value)
+      self.assertLess(err, 1e-5 if dtype == dtypes.float64 else 2e-3)
+
   def testIncompatibleShapes(self):
     with self.test_session():
       x, _, _ = _EmbeddingParams(1, 10, dtype=dtypes.float32)
@@ -690,6 +690,36 @@ class TFRecordReaderTest(test.TestCase):
           self.assertTrue(compat.as_text(k).startswith("%s:" % gzip_files[i]))
           self.assertAllEqual(self._Record(i, j), v)
 
+  def _TestReadSnappyFiles(self, compression_type):
+    options = tf_record.TFRecordOptions(compression_type)
+    files = []
+    for i in range(self._num_files):
+      fn = os.path.join(self.get_temp_dir(), "tfrecord_%s.snappy" % i)
+      files.append(fn)
+      writer = tf_record.TFRecordWriter(fn, options=options)
+      for j in range(self._num_records):
+        writer.write(self._Record(i, j))
+      writer.close()
+
+    with self.test_session() as sess:
+      reader = io_ops.TFRecordReader(name="test_reader", options=options)
+      queue = data_flow_ops.FIFOQueue(99, [dtypes.string], shapes=())
+      key, value = reader.read(queue)
+
+      queue.enqueue_many([files]).run()
+      queue.close().run()
+      for i in range(self._num_files):
+        for j in range(self._num_records):
+          k, v = sess.run([key, value])
+          self.assertTrue(compat.as_text(k).startswith("%s:" % files[i]))
+          self.assertAllEqual(self._Record(i, j), v)
+
+  def testReadSnappyFiles(self):
+    self._TestReadSnappyFiles(TFRecordCompressionType.SNAPPY)
+
+  def testReadSnappyBlockFiles(self):
+    self._TestReadSnappyFiles(TFRecordCompressionType.SNAPPY_BLOCK)
+
 
 class TFRecordWriterZlibTest(test.TestCase):
 
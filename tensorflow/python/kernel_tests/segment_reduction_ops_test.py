@@ -233,6 +233,23 @@ class SegmentReductionOpTest(SegmentReductionHelper):
             delta=1)
       self.assertAllClose(jacob_t, jacob_n)
 
+  def testLargeValues(self):
+    # Enough segments and columns to be reduced on several threads.
+    num_rows, num_cols = 20000, 64
+    np_x = np.random.rand(num_rows, num_cols)
+    segment_ids = np.sort(np.random.randint(0, 4000, size=num_rows))
+    np_sum = np.zeros((segment_ids[-1] + 1, num_cols))
+    np.add.at(np_sum, segment_ids, np_x)
+    np_max = np.zeros((segment_ids[-1] + 1, num_cols))
+    present = np.unique(segment_ids)
+    np_max[present] = np.maximum.reduceat(
+        np_x, np.searchsorted(segment_ids, present))
+    with self.test_session(use_gpu=False):
+      tf_sum = math_ops.segment_sum(np_x, segment_ids).eval()
+      tf_max = math_ops.segment_max(np_x, segment_ids).eval()
+    self.assertAllClose(np_sum, tf_sum)
+    self.assertAllClose(np_max, tf_max)
+
 
 class UnsortedSegmentSumTest(SegmentReductionHelper):
 
@@ -256,6 +273,18 @@ class UnsortedSegmentSumTest(SegmentReductionHelper):
         self.assertAllClose(np_ans, tf_ans)
         self.assertShapeEqual(np_ans, s)
 
+  def testLargeValues(self):
+    # Enough rows and columns to be reduced on several threads.
+    num_rows, num_cols, num_segments = 20000, 100, 300
+    np_x = np.random.rand(num_rows, num_cols)
+    segment_ids = np.random.randint(0, num_segments, size=num_rows)
+    np_sum = np.zeros((num_segments, num_cols))
+    np.add.at(np_sum, segment_ids, np_x)
+    with self.test_session(use_gpu=False):
+      tf_sum = math_ops.unsorted_segment_sum(np_x, segment_ids,
+                                             num_segments).eval()
+    self.assertAllClose(np_sum, tf_sum)
+
   def testGradientSegmentSum(self):
     num_cols = 2
     indices_flat = np.array([0, 4, 0, 8, 3, 8, 4, 7, 7, 3])
@@ -543,6 +572,39 @@ class SparseSegmentReductionOpTest(SparseSegmentReductionHelper):
             delta=1)
       self.assertAllClose(jacob_t, jacob_n)
 
+  def testLargeValues(self):
+    # Enough segments and columns to be reduced on several threads.
+    num_rows, num_cols, num_indices = 1000, 64, 20000
+    np_x = np.random.rand(num_rows, num_cols)
+    indices = np.random.randint(0, num_rows, size=num_indices).astype(np.int32)
+    segment_ids = np.sort(np.random.randint(0, 4000, size=num_indices)).astype(
+        np.int32)
+    num_segments = segment_ids[-1] + 1
+    counts = np.maximum(np.bincount(segment_ids, minlength=num_segments), 1)
+    np_sum = np.zeros((num_segments, num_cols))
+    np.add.at(np_sum, segment_ids, np_x[indices])
+    with self.test_session(use_gpu=False):
+      tf_mean = math_ops.sparse_segment_mean(np_x, indices, segment_ids).eval()
+      tf_sqrt_n = math_ops.sparse_segment_sqrt_n(np_x, indices,
+                                                 segment_ids).eval()
+    self.assertAllClose(np_sum / counts[:, None], tf_mean)
+    self.assertAllClose(np_sum / np.sqrt(counts)[:, None], tf_sqrt_n)
+
+  def testLargeGradient(self):
+    num_rows, num_cols, num_indices = 1000, 64, 20000
+    indices = np.random.randint(0, num_rows, size=num_indices).astype(np.int32)
+    segment_ids = np.sort(np.random.randint(0, 4000, size=num_indices)).astype(
+        np.int32)
+    num_segments = segment_ids[-1] + 1
+    np_grad = np.random.rand(num_segments, num_cols)
+    counts = np.maximum(np.bincount(segment_ids, minlength=num_segments), 1)
+    np_mean_grad = np.zeros((num_rows, num_cols))
+    np.add.at(np_mean_grad, indices, (np_grad / counts[:, None])[segment_ids])
+    with self.test_session(use_gpu=False):
+      tf_mean_grad = math_ops.sparse_segment_mean_grad(
+          np_grad, indices, segment_ids, num_rows).eval()
+    self.assertAllClose(np_mean_grad, tf_mean_grad)
+
   def testGradientValid(self):
     # Baseline for the testGradient*Invalid* methods below.
     tf_x, _ = self._input([3, 4], dtype=dtypes_lib.float32)
@@ -49,6 +49,18 @@ class UniqueTest(test.TestCase):
     for i in range(len(x)):
       self.assertEqual(x[i], tf_y[tf_idx[i]].decode('ascii'))
 
+  def testInt64Large(self):
+    # Large enough to be deduplicated by sorting.
+    x = np.random.randint(-2**40, high=2**40, size=1 << 20)
+    x[::3] = np.random.randint(-5, high=5, size=len(x[::3]))
+    with self.test_session() as sess:
+      y, idx = array_ops.unique(x)
+      tf_y, tf_idx = sess.run([y, idx])
+
+    _, first = np.unique(x, return_index=True)
+    self.assertAllEqual(x[np.sort(first)], tf_y)
+    self.assertAllEqual(x, tf_y[tf_idx])
+
 
 class UniqueWithCountsTest(test.TestCase):
 
@@ -81,6 +93,17 @@ class UniqueWithCountsTest(test.TestCase):
       v = [1 if x[i] == value.decode('ascii') else 0 for i in range(7000)]
       self.assertEqual(count, sum(v))
 
+  def testInt32Large(self):
+    x = np.random.randint(0, high=1 << 16, size=1 << 20).astype(np.int32)
+    with self.test_session() as sess:
+      y, idx, count = array_ops.unique_with_counts(x)
+      tf_y, tf_idx, tf_count = sess.run([y, idx, count])
+
+    _, first = np.unique(x, return_index=True)
+    self.assertAllEqual(x[np.sort(first)], tf_y)
+    self.assertAllEqual(x, tf_y[tf_idx])
+    self.assertAllEqual(np.bincount(tf_idx), tf_count)
+
 
 if __name__ == '__main__':
   test.main()
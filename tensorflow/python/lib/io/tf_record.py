@@ -25,10 +25,17 @@ from tensorflow.python.util import compat
 
 
 class TFRecordCompressionType(object):
-  """The type of compression for the record."""
+  """The type of compression for the record.
+
+  `SNAPPY` compresses the whole stream of records, like `ZLIB` and `GZIP`.
+  `SNAPPY_BLOCK` compresses blocks of whole records, each of which is
+  checksummed once and can be uncompressed on its own.
+  """
   NONE = 0
   ZLIB = 1
   GZIP = 2
+  SNAPPY = 3
+  SNAPPY_BLOCK = 4
 
 
 # NOTE(vrv): This will eventually be converted into a proto.  to match
@@ -38,6 +45,8 @@ class TFRecordOptions(object):
   compression_type_map = {
       TFRecordCompressionType.ZLIB: "ZLIB",
       TFRecordCompressionType.GZIP: "GZIP",
+      TFRecordCompressionType.SNAPPY: "SNAPPY",
+      TFRecordCompressionType.SNAPPY_BLOCK: "SNAPPY_BLOCK",
       TFRecordCompressionType.NONE: ""
   }
 
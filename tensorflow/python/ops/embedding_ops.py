@@ -28,6 +28,7 @@ from tensorflow.python.ops import clip_ops
 # Imports gradient definitions.
 from tensorflow.python.ops import data_flow_grad  # pylint: disable=unused-import
 from tensorflow.python.ops import data_flow_ops
+from tensorflow.python.ops import gen_math_ops
 from tensorflow.python.ops import math_ops
 from tensorflow.python.ops import resource_variable_ops
 from tensorflow.python.ops import variables
@@ -461,3 +462,65 @@ def embedding_lookup_sparse(params,
         assert False, "Unrecognized combiner"
 
     return embeddings
+
+
+def fused_embedding_lookup_sparse(params, sp_ids, sp_weights, name=None,
+                                  combiner="mean"):
+  """Computes embeddings for the given ids and weights in a single op.
+
+  Computes the same result as `embedding_lookup_sparse` for a single `params`
+  tensor, but looks up and combines the embeddings of each row of `sp_ids`
+  without materializing the looked up embeddings. The gradient with respect
+  to `params` is an `IndexedSlices` with one row per distinct id. No gradient
+  is computed for `sp_weights`.
+
+  The rows of `sp_ids` must be in order, as they are for a `SparseTensor` in
+  the canonical row-major order.
+
+  Args:
+    params: A single tensor of embeddings, of type `float32` or `float64`.
+    sp_ids: N x M SparseTensor of int64 ids (typically from FeatureValueToId),
+      where N is typically batch size and M is arbitrary.
+    sp_weights: either a SparseTensor of float / double weights, or None to
+      indicate all weights should be taken to be 1. If specified, sp_weights
+      must have exactly the same shape and indices as sp_ids.
+    name: Optional name for the op.
+    combiner: A string specifying the reduction op. Currently "mean", "sqrtn"
+      and "sum" are supported.
+
+  Returns:
+    A dense tensor representing the combined embeddings for the
+    sparse ids. For each row in the dense tensor represented by sp_ids, the op
+    looks up the embeddings for all ids in that row, multiplies them by the
+    corresponding weight, and combines these embeddings as specified.
+
+  Raises:
+    TypeError: If sp_ids is not a SparseTensor, or if sp_weights is neither
+      None nor SparseTensor.
+    ValueError: If combiner is not one of {"mean", "sqrtn", "sum"}.
+  """
+  if combiner not in ("mean", "sqrtn", "sum"):
+    raise ValueError("combiner must be one of 'mean', 'sqrtn' or 'sum'")
+  if not isinstance(sp_ids, sparse_tensor.SparseTensor):
+    raise TypeError("sp_ids must be SparseTensor")
+  if sp_weights is not None:
+    if not isinstance(sp_weights, sparse_tensor.SparseTensor):
+      raise TypeError("sp_weights must be either None or SparseTensor")
+    sp_ids.values.get_shape().assert_is_compatible_with(
+        sp_weights.values.get_shape())
+
+  with ops.name_scope(name, "fused_embedding_lookup_sparse",
+                      [params, sp_ids]) as name:
+    params = ops.convert_to_tensor(params, name="params")
+    segment_ids = sp_ids.indices[:, 0]
+    if segment_ids.dtype != dtypes.int32:
+      segment_ids = math_ops.cast(segment_ids, dtypes.int32)
+    if sp_weights is None:
+      weights = array_ops.zeros([0], dtype=params.dtype)
+    else:
+      weights = sp_weights.values
+      if weights.dtype != params.dtype:
+        weights = math_ops.cast(weights, params.dtype)
+    return gen_math_ops._fused_embedding_lookup_sparse(
+        params, sp_ids.values, segment_ids, weights, combiner=combiner,
+        name=name)
@@ -190,6 +190,22 @@ def _SparseSegmentSqrtNGrad(op, grad):
                                               dim0), None, None)
 
 
+@ops.RegisterGradient("FusedEmbeddingLookupSparse")
+def _FusedEmbeddingLookupSparseGrad(op, grad):
+  """Gradient for FusedEmbeddingLookupSparse."""
+  # params can be large, so colocate the shape calculation with it.
+  params = op.inputs[0]
+  with ops.colocate_with(params):
+    params_shape = array_ops.shape(params, out_type=ops.dtypes.int64)
+    params_shape = math_ops.to_int32(params_shape)
+  unique_ids, values = gen_math_ops._fused_embedding_lookup_sparse_grad(
+      grad, op.inputs[1], op.inputs[2], op.inputs[3],
+      combiner=op.get_attr("combiner"))
+  # The weights only scale the lookups, no gradient is computed for them.
+  return (ops.IndexedSlices(values, unique_ids, params_shape), None, None,
+          None)
+
+
 def _SegmentMinOrMaxGrad(op, grad, is_sorted):
   """Gradient for SegmentMin and (unsorted) SegmentMax. They share similar code."""
   zeros = array_ops.zeros(array_ops.shape(op.inputs[0]),